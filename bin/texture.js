@@ -5,6 +5,7 @@
 /// processing.
 ///////////////////////////////////////////////////////////////////////////80*/
 var Filesystem        = require('fs');
+var OS                = require('os');
 var Path              = require('path');
 var Program           = require('commander');
 var DataCompiler      = require('datacompiler');
@@ -23,6 +24,21 @@ var application       = {
     args              : {},
     /// The data compiler version number.
     version           : 1,
+    /// The default maximum number of build requests waiting to start in
+    /// persistent mode.
+    DEFAULT_QUEUE_SIZE: 256
+};
+
+/// The state of the build requests received in persistent mode. Up to
+/// application.args.jobs builds run at once; the rest wait in pending.
+var build_queue       = {
+    /// The build inputs waiting to start, in the order they were received.
+    pending           : [],
+    /// The target paths of the builds currently running, used to keep two
+    /// builds from writing the same file at the same time.
+    active            : {},
+    /// The number of builds currently running.
+    activeCount       : 0
 };
 
 /// Constants representing the various application exit codes.
@@ -49,7 +65,25 @@ var texture_defaults  = {
     premultipliedAlpha: false,
     forcePowerOfTwo   : false,
     flipY             : true,
-    buildMipmaps      : false
+    buildMipmaps      : false,
+    container         : false,
+    quality           : 'NORMAL',
+    compression       : 'NONE',
+    chunkSize         : 65536,
+    levelOrder        : 'LARGEST_FIRST',
+    levelAlignment    : 1,
+    tileSize          : 0,
+    tileBorder        : 4,
+    hdrRange          : 0,
+    targetPSNR        : 0,
+    autoCompressed    : true
+};
+
+/// The default formats for texture types that have a more appropriate format
+/// than the default. Height maps use BC4 and normal maps use BC5.
+var type_formats      = {
+    HEIGHT            : 'BC4',
+    NORMAL            : 'BC5'
 };
 
 /// A handy utility function that prevents having to write the same
@@ -78,6 +112,8 @@ function command_line()
         .option('-i, --input [path]',  'Specify the source file.',           String, '')
         .option('-o, --output [path]', 'Specify the destination file.',      String, '')
         .option('-t, --target [name]', 'Specify the build target platform.', String, '')
+        .option('-j, --jobs [count]',  'Specify the number of concurrent builds in persistent mode.', Number, 0)
+        .option('-q, --queue [count]', 'Specify the number of builds that may wait to start.',       Number, application.DEFAULT_QUEUE_SIZE)
         .parse(process.argv);
 
     var defaultsPath = Path.join(
@@ -88,11 +124,16 @@ function command_line()
     if (Program.persistent)
     {
         // when running in persistent mode, command-line arguments are ignored.
+        // by default, one build runs per processor.
+        var jobs  = Math.floor(Program.jobs)  || OS.cpus().length || 1;
+        var queue = Math.floor(Program.queue);
         return {
             persistent : true,
             sourcePath : process.argv[1],
             targetPath : process.argv[1],
-            platform   : ''
+            platform   : '',
+            jobs       : Math.max(jobs,  1),
+            queueSize  : Math.max(queue >= 0 ? queue : application.DEFAULT_QUEUE_SIZE, 0)
         };
     }
 
@@ -129,7 +170,7 @@ function build_definition(object, defaults)
     var def                = defaults;
     var D                  = defaultValue;
     obj.type               = D(obj.type,               def.type);
-    obj.format             = D(obj.format,             def.format);
+    obj.format             = D(obj.format,             type_formats[obj.type] || def.format);
     obj.target             = D(obj.target,             def.target);
     obj.wrapModeS          = D(obj.wrapModeS,          def.wrapModeS);
     obj.wrapModeT          = D(obj.wrapModeT,          def.wrapModeT);
@@ -140,6 +181,17 @@ function build_definition(object, defaults)
     obj.forcePowerOfTwo    = D(obj.forcePowerOfTwo,    def.forcePowerOfTwo);
     obj.flipY              = D(obj.flipY,              def.flipY);
     obj.buildMipmaps       = D(obj.buildMipmaps,       def.buildMipmaps);
+    obj.container          = D(obj.container,          def.container);
+    obj.quality            = D(obj.quality,            def.quality);
+    obj.compression        = D(obj.compression,        def.compression);
+    obj.chunkSize          = D(obj.chunkSize,          def.chunkSize);
+    obj.levelOrder         = D(obj.levelOrder,         def.levelOrder);
+    obj.levelAlignment     = D(obj.levelAlignment,     def.levelAlignment);
+    obj.tileSize           = D(obj.tileSize,           def.tileSize);
+    obj.tileBorder         = D(obj.tileBorder,         def.tileBorder);
+    obj.hdrRange           = D(obj.hdrRange,           def.hdrRange);
+    obj.targetPSNR         = D(obj.targetPSNR,         def.targetPSNR);
+    obj.autoCompressed     = D(obj.autoCompressed,     def.autoCompressed);
     return obj;
 }
 
@@ -239,23 +291,70 @@ function load_texture_attributes(state, sourcePath, targetPath)
     }
 }
 
-/// Writes a JSON document specifying texture metadata to disk.
+/// Loads the texture metadata written by a previous build, if any.
+/// @param targetPath The path and filename of the .texture file.
+/// @return An object specifying texture metadata, or null.
+function load_texture_definition(targetPath)
+{
+    try
+    {
+        return JSON.parse(Filesystem.readFileSync(targetPath, 'utf8'));
+    }
+    catch (error)
+    {
+        // the file doesn't exist yet, or it isn't valid.
+        return null;
+    }
+}
+
+/// Writes a JSON document specifying texture metadata to disk. The file is
+/// not rewritten if its contents would be unchanged, so that file watchers
+/// and caches downstream of the build don't see a modification.
 /// @param targetPath The path and filename of the target file.
 /// @param texture An object specifying texture metadata.
 function save_texture_definition(targetPath, texture)
 {
     // @note: errors should not be caught here.
     var json = JSON.stringify(texture, null, '\t')+'\n';
+    try
+    {
+        if (Filesystem.readFileSync(targetPath, 'utf8') === json)
+            return;
+    }
+    catch (error)
+    {
+        // the file doesn't exist yet.
+    }
     Filesystem.writeFileSync(targetPath, json, 'utf8');
 }
 
-/// Implements the build process for the data compiler.
+/// Records an error for a build. When running stand-alone, the error is also
+/// output so the user knows that something went wrong, and the process exits.
+/// In persistent mode, the error is output for us by the build system.
+/// @param state The build state returned by DataCompiler.startBuild().
+/// @param error The error that occurred.
+function compiler_error(state, error)
+{
+    state.addError(error);
+    if (!application.args.persistent)
+    {
+        console.error('An error has occurred:');
+        console.error('  '+error);
+        console.error();
+        process.exit(exit_code.ERROR);
+    }
+}
+
+/// Implements the build process for the data compiler. The texture is
+/// compiled on the libuv thread pool, so several builds may be in flight.
 /// @param input An object describing the build environment.
 /// @param input.sourcePath The path of the input source file.
 /// @param input.targetPath The path of the target resource, without extension.
 /// @param input.platform The name of the current build target.
 /// @param input.isIPC Should be true if the build was triggered via IPC.
-function compiler_build(input)
+/// @param callback An optional function () called after the build has been
+/// reported through DataCompiler.finishBuild().
+function compiler_build(input, callback)
 {
     var state  = DataCompiler.startBuild(input);
     var rinfo  = DataCompiler.parseResourcePath(input.sourcePath);
@@ -265,27 +364,89 @@ function compiler_build(input)
     try
     {
         var ta = load_texture_attributes(state, apath, ppath);
-        var md = TextureCompiler.compile(ta);
-        save_texture_definition(mpath, md);
-        state.addOutput(mpath);
-        state.addOutput(ppath);
+        var pd = load_texture_definition(mpath);
+        if (pd && pd.pixelsHash !== undefined)
+        {
+            // the .pixels file is left alone if it would be unchanged.
+            ta.previousHash = pd.pixelsHash;
+            ta.previousSize = pd.pixelsSize;
+        }
+        TextureCompiler.compileAsync(ta, function (error, md)
+            {
+                try
+                {
+                    if (error) throw error;
+                    save_texture_definition(mpath, md);
+                    state.addOutput(mpath);
+                    state.addOutput(ppath);
+                }
+                catch (error)
+                {
+                    // add the error; build will be unsuccessful.
+                    compiler_error(state, error);
+                }
+                DataCompiler.finishBuild(state);
+                if (callback) callback();
+            });
     }
     catch (error)
     {
         // add the error; build will be unsuccessful.
-        state.addError(error);
-        // when running stand-alone, output the error so the user knows
-        // that something went wrong. in persistent mode, the error is
-        // output for us by the build system.
-        if (!application.args.persistent)
+        compiler_error(state, error);
+        DataCompiler.finishBuild(state);
+        if (callback) process.nextTick(callback);
+    }
+}
+
+/// Starts as many waiting builds as the concurrency limit allows. A build is
+/// held back while another build with the same target path is running.
+function dispatch_builds()
+{
+    var queue = build_queue;
+    for (var i = 0; i < queue.pending.length; /* empty */)
+    {
+        if (queue.activeCount >= application.args.jobs)
+            break;
+
+        var input = queue.pending[i];
+        if (queue.active[input.targetPath])
         {
-            console.error('An error has occurred:');
-            console.error('  '+error);
-            console.error();
-            process.exit(exit_code.ERROR);
+            ++i; // wait for the running build of this target to finish.
+            continue;
         }
+        queue.pending.splice(i, 1);
+        queue.active[input.targetPath] = true;
+        queue.activeCount++;
+        compiler_build(input, function (input)
+            {
+                return function ()
+                {
+                    delete queue.active[input.targetPath];
+                    queue.activeCount--;
+                    dispatch_builds();
+                };
+            }(input));
+    }
+}
+
+/// Accepts a build request received in persistent mode. The build starts
+/// immediately if fewer than application.args.jobs builds are running, or
+/// waits in a bounded queue otherwise. When the queue is full, the build is
+/// reported as failed right away.
+/// @param input An object describing the build environment, as for
+/// compiler_build().
+function queue_build(input)
+{
+    if (build_queue.pending.length >= application.args.queueSize &&
+        build_queue.activeCount    >= application.args.jobs)
+    {
+        var state = DataCompiler.startBuild(input);
+        state.addError(new Error('The build queue is full.'));
+        DataCompiler.finishBuild(state);
+        return;
     }
-    DataCompiler.finishBuild(state);
+    build_queue.pending.push(input);
+    dispatch_builds();
 }
 
 /// Override the default DataCompiler implementation to return the correct
@@ -306,7 +467,7 @@ DataCompiler.queryCompilerVersion = function ()
 /// or the string 'generic' indicates a platform-agnostic build.
 DataCompiler.on('build', function (data)
 {
-    compiler_build({
+    queue_build({
         sourcePath : data.sourcePath,
         targetPath : data.targetPath,
         platform   : data.platform,
@@ -343,6 +504,12 @@ var main = (function Main()
 {
     application.args = command_line();
     var ipcMode      = application.args.persistent;
+    if (ipcMode && process.env.UV_THREADPOOL_SIZE === undefined)
+    {
+        // size the libuv thread pool to match the number of concurrent
+        // builds. this has to happen before the first build is queued.
+        process.env.UV_THREADPOOL_SIZE = String(application.args.jobs);
+    }
     if (ipcMode    === false)
     {
         compiler_build({
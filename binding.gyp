@@ -14,6 +14,17 @@
             "sources"      : [
                 "src/libimage.cpp",
                 "src/compiler.cpp",
+                "src/container.cpp",
+                "src/compress.cpp",
+                "src/hash.cpp",
+                "src/parallel.cpp",
+                "src/encoder.cpp",
+                "src/encoder_bc.cpp",
+                "src/encoder_bc7.cpp",
+                "src/encoder_bc6h.cpp",
+                "src/encoder_etc.cpp",
+                "src/encoder_pvrtc.cpp",
+                "src/encoder_astc.cpp",
                 "src/v8module.cpp"
             ],
             "conditions"   : [
@@ -0,0 +1,124 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implements a small runtime decompressor for level data written
+/// with the `LZ4` compression option. Each level is stored as a sequence of
+/// independently compressed chunks, described by the `chunks` array of the
+/// level metadata, so a single level or chunk can be decompressed without
+/// reading the rest of the file. This file has no dependencies and can be
+/// loaded in a browser (or a web worker) or required from node.js.
+///////////////////////////////////////////////////////////////////////////80*/
+(function (exports)
+{
+    /// The shortest match encoded by an LZ4 sequence.
+    var MIN_MATCH = 4;
+
+    /// Decompresses a single LZ4 block.
+    /// @param src The source data.
+    /// @param src_offset The byte offset of the block within @a src.
+    /// @param src_size The size of the compressed block, in bytes.
+    /// @param dst The destination buffer.
+    /// @param dst_offset The byte offset at which to write the output.
+    /// @param dst_size The expected size of the decompressed data, in bytes.
+    function decompress_block(src, src_offset, src_size, dst, dst_offset, dst_size)
+    {
+        var ip     = src_offset;
+        var ip_end = src_offset + src_size;
+        var op     = dst_offset;
+        var op_end = dst_offset + dst_size;
+        while (ip < ip_end)
+        {
+            var token = src[ip++];
+            var len   = token >> 4;
+            if (len === 15)
+            {
+                var b;
+                do { b = src[ip++]; len += b; } while (b === 255 && ip < ip_end);
+            }
+            if (ip + len > ip_end || op + len > op_end)
+            {
+                throw new Error('Malformed LZ4 block (literal overrun).');
+            }
+            for (var i = 0; i < len; ++i) dst[op++] = src[ip++];
+            if (ip >= ip_end) break; // the final sequence has no match.
+
+            var offset = src[ip] | (src[ip + 1] << 8);
+            ip += 2;
+            if (offset === 0 || op - offset < dst_offset)
+            {
+                throw new Error('Malformed LZ4 block (bad match offset).');
+            }
+            len = token & 15;
+            if (len === 15)
+            {
+                var b;
+                do { b = src[ip++]; len += b; } while (b === 255 && ip < ip_end);
+            }
+            len += MIN_MATCH;
+            if (op + len > op_end)
+            {
+                throw new Error('Malformed LZ4 block (match overrun).');
+            }
+            // byte-by-byte, since the match may overlap the output.
+            for (var m = op - offset, i = 0; i < len; ++i) dst[op++] = dst[m++];
+        }
+        if (op !== op_end)
+        {
+            throw new Error('Malformed LZ4 block (size mismatch).');
+        }
+    }
+
+    /// Decompresses a single chunk of a level.
+    /// @param data A Uint8Array (or node.js Buffer) containing the .pixels
+    /// file, or the portion of it starting at byte offset 0.
+    /// @param chunk An entry of the `chunks` array of the level metadata.
+    /// @param dst Optional destination Uint8Array.
+    /// @param dst_offset Optional byte offset within @a dst.
+    /// @return The destination Uint8Array.
+    function decompress_chunk(data, chunk, dst, dst_offset)
+    {
+        dst        = dst || new Uint8Array(chunk.uncompressedSize);
+        dst_offset = dst_offset || 0;
+        if (chunk.byteSize === chunk.uncompressedSize)
+        {
+            // the chunk did not compress and is stored as-is.
+            for (var i = 0; i < chunk.byteSize; ++i)
+            {
+                dst[dst_offset + i] = data[chunk.byteOffset + i];
+            }
+        }
+        else
+        {
+            decompress_block(
+                data, chunk.byteOffset, chunk.byteSize,
+                dst,  dst_offset,       chunk.uncompressedSize);
+        }
+        return dst;
+    }
+
+    /// Decompresses all of the chunks of a level.
+    /// @param data A Uint8Array (or node.js Buffer) containing the .pixels
+    /// file, or the portion of it starting at byte offset 0.
+    /// @param level An entry of the `levels` array of the texture metadata.
+    /// @return A Uint8Array containing the uncompressed level data, suitable
+    /// for passing to texImage2D() or compressedTexImage2D().
+    function decompress_level(data, level)
+    {
+        if (!level.chunks)
+        {
+            // the level is not compressed.
+            return data.subarray ?
+                data.subarray(level.byteOffset, level.byteOffset + level.byteSize) :
+                data.slice   (level.byteOffset, level.byteOffset + level.byteSize);
+        }
+        var dst    = new Uint8Array(level.uncompressedSize);
+        var offset = 0;
+        for (var i = 0; i < level.chunks.length; ++i)
+        {
+            decompress_chunk(data, level.chunks[i], dst, offset);
+            offset += level.chunks[i].uncompressedSize;
+        }
+        return dst;
+    }
+
+    exports.decompress_chunk = decompress_chunk;
+    exports.decompress_level = decompress_level;
+})(typeof exports !== 'undefined' ? exports : (this.LZ4Decoder = {}));
@@ -220,6 +220,16 @@
 
 /*/////////////////////////////////////////////////////////////////////////80*/
 
+#ifndef CMN_HAVE_SSE2
+    #if defined(CMN_HAVE_EMMINTRIN_H)
+        #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+            #define CMN_HAVE_SSE2               1
+        #endif /* SSE2 code generation is enabled */
+    #endif /* defined(CMN_HAVE_EMMINTRIN_H) */
+#endif /* !defined(CMN_HAVE_SSE2) */
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
 /*//////////////////////////////////
 //   Public Types and Functions   //
 //////////////////////////////////*/
@@ -26,6 +26,7 @@
 #define CMN_HAVE_STDDEF_H
 #define CMN_HAVE_STDINT_H
 #define CMN_HAVE_INTTYPES_H
+#define CMN_HAVE_EMMINTRIN_H
 #define CMN_HAVE_TMMINTRIN_H
 
 /*/////////////////////////////////////////////////////////////////////////80*/
@@ -5,10 +5,17 @@
 /*////////////////
 //   Includes   //
 ////////////////*/
+#include <math.h>
 #include <stdlib.h>
+#include <string.h>
 #include "compiler.hpp"
+#include "parallel.hpp"
 #include "stb_image.c"
 
+#if CMN_HAVE_SSE2
+    #include <emmintrin.h>
+#endif
+
 /*//////////////////////////
 //   Using Declarations   //
 //////////////////////////*/
@@ -22,6 +29,40 @@
 #define NO_ERROR       ""
 #define OUT_OF_MEMORY  "Could not allocate the required amount of memory."
 
+/// The number of rows or columns of one channel resampled by a single task
+/// in resize_buffer().
+#define RESIZE_BAND_SIZE            32U
+
+/// The state shared by the tasks resampling an image. Each task resamples a
+/// band of rows (horizontal pass) or columns (vertical pass) of one channel.
+struct resize_job_t
+{
+    image::polyphase_kernel_1d_t *fx;          /// Horizontal filter weights.
+    image::polyphase_kernel_1d_t *fy;          /// Vertical filter weights.
+    image::buffer_t              *source;      /// The image to resample.
+    image::buffer_t              *temp;        /// Scaled horizontally only.
+    image::buffer_t              *target;      /// Scaled in both directions.
+    compile_progress_t           *progress;    /// Checked for cancellation.
+    int32_t                       border_mode; /// The border sample mode.
+    size_t                        row_bands;   /// Bands per channel, pass 1.
+    size_t                        col_bands;   /// Bands per channel, pass 2.
+    bool                          failed;      /// Set if memory ran out.
+};
+
+/// The state shared by the tasks building the mip-levels of an image. Each
+/// task builds one level from level 0.
+struct mipmap_job_t
+{
+    image::buffer_t              *level_0;     /// The linear-light level 0.
+    image::buffer_t              *level_data;  /// The levels to build.
+    bool volatile                *constant;    /// Is each level a solid color?
+    float                         tolerance;   /// The solid-color tolerance.
+    compile_progress_t           *progress;    /// Receives a step per level.
+    int32_t                       border_mode; /// The border sample mode.
+    size_t                        color_count; /// Channels in gamma space.
+    bool                          failed;      /// Set if memory ran out.
+};
+
 /*/////////////////////////////////////////////////////////////////////////80*/
 
 #if 0
@@ -489,6 +530,73 @@ void* buffer_to_pixels_4_32f(image::buffer_t *buffer)
 
 /*/////////////////////////////////////////////////////////////////////////80*/
 
+void compile_progress_init(
+    compile_progress_t *progress,
+    compile_progress_fn callback,
+    void               *context)
+{
+    if (progress)
+    {
+        progress->callback  = callback;
+        progress->context   = context;
+        progress->cancelled = 0;
+        progress->stage     = COMPILE_STAGE_LOAD;
+        progress->done      = 0;
+        progress->total     = 0;
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void compile_progress_begin(
+    compile_progress_t *progress,
+    int32_t             stage,
+    size_t              total)
+{
+    if (progress)
+    {
+        progress->stage = stage;
+        progress->total = total;
+        progress->done  = 0;
+        if (progress->callback)
+            progress->callback(stage, 0, total, progress->context);
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+bool compile_progress_step(compile_progress_t *progress)
+{
+    if (progress)
+    {
+        long done = parallel_atomic_add(&progress->done, 1);
+        if (progress->callback)
+        {
+            progress->callback(
+                progress->stage, (size_t) done,
+                progress->total, progress->context);
+        }
+        return (0 == progress->cancelled);
+    }
+    return true;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void compile_cancel(compile_progress_t *progress)
+{
+    if (progress) parallel_atomic_add(&progress->cancelled, 1);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+bool compile_cancelled(compile_progress_t *progress)
+{
+    return (progress && progress->cancelled != 0);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
 void texture_compiler_inputs_init(texture_compiler_inputs_t *inputs)
 {
     if (inputs)
@@ -500,8 +608,11 @@ void texture_compiler_inputs_init(texture_compiler_inputs_t *inputs)
         inputs->maximum_levels  = 0;
         inputs->build_mipmaps   = false;
         inputs->force_pow2      = false;
+        inputs->force_square    = false;
         inputs->premultiply_a   = false;
         inputs->flip_y          = false;
+        inputs->constant_tolerance = 0.0f;
+        inputs->progress        = NULL;
     }
 }
 
@@ -538,6 +649,15 @@ void texture_compiler_inputs_sanitize(texture_compiler_inputs_t *inputs)
                     target_height  <<= 1;
             }
         }
+        if (inputs->force_square)
+        {
+            // grow the shorter dimension to match the longer one. the
+            // source is resampled to the target size, so a non-square
+            // image is stretched, not padded. if both are pow2, the
+            // result will be pow2 also.
+            target_width  = CMN_MAX(target_width, target_height);
+            target_height = target_width;
+        }
         if (inputs->build_mipmaps)
         {
             // calculate the maximum number of mip-levels down to 1x1.
@@ -573,6 +693,11 @@ void texture_compiler_outputs_init(texture_compiler_outputs_t *outputs)
         outputs->error_message  = NO_ERROR;
         outputs->channel_count  = 0;
         outputs->level_count    = 0;
+        outputs->constant_level = 0;
+        for (size_t i = 0; i < MAX_IMAGE_CHANNELS; ++i)
+        {
+            outputs->constant_color[i] = 0.0f;
+        }
     }
 }
 
@@ -717,34 +842,181 @@ void copy_buffer_to_region(
 
 /*/////////////////////////////////////////////////////////////////////////80*/
 
-bool resize_buffer(
+/// Computes the index of a texel that may lie outside of an image.
+static inline size_t border_index(
+    size_t    width,
+    size_t    height,
+    ptrdiff_t at_x,
+    ptrdiff_t at_y,
+    int32_t   border_mode)
+{
+    switch (border_mode)
+    {
+        case image::BORDER_MODE_WRAP:
+            return image::index_wrap(width, height, at_x, at_y);
+        case image::BORDER_MODE_MIRROR:
+            return image::index_mirror(width, height, at_x, at_y);
+        default:
+            break;
+    }
+    return image::index_clamp(width, height, at_x, at_y);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void copy_region_with_border(
+    image::buffer_t *target,
     image::buffer_t *source,
-    size_t           new_width,
-    size_t           new_height,
-    int32_t          border_mode,
-    image::buffer_t *target)
+    ptrdiff_t        source_x,
+    ptrdiff_t        source_y,
+    int32_t          border_mode)
+{
+    size_t    source_w = source->channel_width;
+    size_t    source_h = source->channel_height;
+    size_t    target_w = target->channel_width;
+    size_t    target_h = target->channel_height;
+    ptrdiff_t inner_x0 = CMN_MAX(source_x, (ptrdiff_t) 0);
+    ptrdiff_t inner_x1 = CMN_MIN(source_x + (ptrdiff_t) target_w, (ptrdiff_t) source_w);
+
+    for (size_t y = 0; y < target_h; ++y)
+    {
+        ptrdiff_t sy  = source_y + (ptrdiff_t) y;
+        bool      row = sy >= 0 && sy < (ptrdiff_t) source_h;
+        for (size_t c = 0; c < target->channel_count; ++c)
+        {
+            float const *src = source->channels[c];
+            float       *dst = target->channels[c] + y * target_w;
+            if (row && inner_x0 < inner_x1)
+            {
+                // the span inside the source is copied directly, and only
+                // the columns on either side are sampled.
+                size_t dx = (size_t) (inner_x0 - source_x);
+                size_t n  = (size_t) (inner_x1 - inner_x0);
+                memcpy(dst + dx, src + (size_t) sy * source_w + inner_x0, n * sizeof(float));
+                for (size_t x = 0; x < dx; ++x)
+                {
+                    ptrdiff_t sx = source_x + (ptrdiff_t) x;
+                    dst[x] = src[border_index(source_w, source_h, sx, sy, border_mode)];
+                }
+                for (size_t x = dx + n; x < target_w; ++x)
+                {
+                    ptrdiff_t sx = source_x + (ptrdiff_t) x;
+                    dst[x] = src[border_index(source_w, source_h, sx, sy, border_mode)];
+                }
+            }
+            else
+            {
+                for (size_t x = 0; x < target_w; ++x)
+                {
+                    ptrdiff_t sx = source_x + (ptrdiff_t) x;
+                    dst[x] = src[border_index(source_w, source_h, sx, sy, border_mode)];
+                }
+            }
+        }
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Resamples a band of rows of one channel horizontally, from the source
+/// image into the temporary buffer.
+static void CMN_CALL_C resize_rows(size_t index, void *context)
+{
+    resize_job_t *job     = (resize_job_t*) context;
+    size_t        channel = index / job->row_bands;
+    size_t        src_w   = job->source->channel_width;
+    size_t        src_h   = job->source->channel_height;
+    size_t        dst_w   = job->target->channel_width;
+    size_t        y0      = (index % job->row_bands) * RESIZE_BAND_SIZE;
+    size_t        y1      = CMN_MIN(y0 + RESIZE_BAND_SIZE, src_h);
+    if (compile_cancelled(job->progress))
+    {
+        job->failed = true;
+        return;
+    }
+    for (size_t y = y0; y < y1; ++y)
+    {
+        image::apply_polyphase_horizontal_1d(
+            job->fx, job->border_mode, y,
+            src_w, src_h,
+            job->source->channels[channel],
+            job->temp->channels[channel] + y * dst_w);
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Resamples a band of columns of one channel vertically, from the temporary
+/// buffer into the target image.
+static void CMN_CALL_C resize_columns(size_t index, void *context)
+{
+    resize_job_t *job     = (resize_job_t*) context;
+    size_t        channel = index / job->col_bands;
+    size_t        src_h   = job->source->channel_height;
+    size_t        dst_w   = job->target->channel_width;
+    size_t        dst_h   = job->target->channel_height;
+    size_t        x0      = (index % job->col_bands) * RESIZE_BAND_SIZE;
+    size_t        x1      = CMN_MIN(x0 + RESIZE_BAND_SIZE, dst_w);
+    float        *sc      = job->temp->channels[channel];
+    float        *tc      = job->target->channels[channel];
+    if (compile_cancelled(job->progress))
+    {
+        job->failed = true;
+        return;
+    }
+
+    // allocate a small buffer to store a single image column.
+    float *tmp_cd = (float*) malloc(sizeof(float) * dst_h);
+    if (NULL == tmp_cd)
+    {
+        job->failed = true;
+        return;
+    }
+    for (size_t x = x0; x < x1; ++x)
+    {
+        image::apply_polyphase_vertical_1d(
+            job->fy, job->border_mode, x,
+            dst_w, src_h,
+            sc,    tmp_cd);
+        for (size_t y = 0; y  < dst_h; ++y)
+            tc[y * dst_w + x] = tmp_cd[y];
+    }
+    free(tmp_cd);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+bool resize_buffer(
+    image::buffer_t    *source,
+    size_t              new_width,
+    size_t              new_height,
+    int32_t             border_mode,
+    image::buffer_t    *target,
+    compile_progress_t *progress /* = NULL */)
 {
     image::buffer_t              tb;
     image::kaiser_args_t         fa;
     image::polyphase_kernel_1d_t fx;
     image::polyphase_kernel_1d_t fy;
+    resize_job_t                 job;
     float  width   = 1.0f; // filter width
     size_t samples = 32;   // sample count
     size_t src_w   = source->channel_width;
     size_t src_h   = source->channel_height;
     size_t dst_w   = new_width;
     size_t dst_h   = new_height;
+    size_t nc      = source->channel_count;
     size_t fx_size = image::polyphase_1d_init(src_w, dst_w, samples, width, &fx);
     size_t fy_size = image::polyphase_1d_init(src_h, dst_h, samples, width, &fy);
 
     // allocate a temporary buffer (dst_w, src_h) to hold the results scaled
     // in the horizontal dimension, and our final buffer (dst_w, dst_h).
-    if (!create_buffer(dst_w, dst_h, source->channel_count, target))
+    if (!create_buffer(dst_w, dst_h, nc, target))
     {
         // failed to allocate final result buffer.
         return false;
     }
-    if (!create_buffer(dst_w, src_h, source->channel_count, &tb))
+    if (!create_buffer(dst_w, src_h, nc, &tb))
     {
         // failed to allocate temporary buffer.
         free_buffer(target);
@@ -773,122 +1045,305 @@ bool resize_buffer(
     image::compute_polyphase_matrix_1d(image::kaiser_filter, &fa, &fx);
     image::compute_polyphase_matrix_1d(image::kaiser_filter, &fa, &fy);
 
-    // allocate a small buffer to store a single image column.
-    float *tmp_cd = (float*) malloc(sizeof(float) * dst_h);
-
-    // resample the image in each direction independently.
-    for (size_t c = 0; c < source->channel_count; ++c)
+    // resample the image in each direction independently. every band of
+    // every channel is independent within a pass.
+    job.fx          = &fx;
+    job.fy          = &fy;
+    job.source      = source;
+    job.temp        = &tb;
+    job.target      = target;
+    job.progress    = progress;
+    job.border_mode = border_mode;
+    job.row_bands   = (src_h + RESIZE_BAND_SIZE - 1) / RESIZE_BAND_SIZE;
+    job.col_bands   = (dst_w + RESIZE_BAND_SIZE - 1) / RESIZE_BAND_SIZE;
+    job.failed      = false;
+    parallel_for(nc * job.row_bands, resize_rows, &job);
+    if (!job.failed)
     {
-        // resize along the horizontal direction from source into tb.
-        for (size_t y = 0; y < src_h; ++y)
-        {
-            size_t od = y  * dst_w;
-            image::apply_polyphase_horizontal_1d(
-                &fx, border_mode, y,
-                src_w, src_h,
-                source->channels[c],
-                tb.channels[c] + od);
-        }
-        // resize along the vertical direction from tb into target.
-        for (size_t x = 0; x < dst_w; ++x)
-        {
-            float *sc = tb.channels[c];
-            float *tc = target->channels[c];
-            image::apply_polyphase_vertical_1d(
-                &fy, border_mode, x,
-                dst_w, src_h,
-                sc,    tmp_cd);
-            for (size_t y = 0; y  < dst_h; ++y)
-                tc[y * dst_w + x] = tmp_cd[y];
-        }
+        parallel_for(nc * job.col_bands, resize_columns, &job);
     }
 
     // clean up temporary resources.
-    free(tmp_cd);
     free(fy.filter_weights);
     free(fx.filter_weights);
     free_buffer(&tb);
+    if (job.failed)
+    {
+        free_buffer(target);
+        return false;
+    }
     return true;
 }
 
 /*/////////////////////////////////////////////////////////////////////////80*/
 
 bool build_level0(
-    image::buffer_t *source,
-    size_t           target_width,
-    size_t           target_height,
-    int32_t          border_mode,
-    image::buffer_t *target)
+    image::buffer_t    *source,
+    size_t              target_width,
+    size_t              target_height,
+    int32_t             border_mode,
+    image::buffer_t    *target,
+    compile_progress_t *progress /* = NULL */)
 {
     size_t width    = target_width;
     size_t height   = target_height;
     size_t channels = source->channel_count;
 
+    if (source->channel_width  != target_width  ||
+        source->channel_height != target_height)
+    {
+        // resize_buffer() allocates the target buffer.
+        return resize_buffer(source, width, height, border_mode, target, progress);
+    }
     if (!create_buffer(width, height, channels, target))
     {
         return false;
     }
-    if (source->channel_width  != target_width  ||
-        source->channel_height != target_height)
+    copy_buffer(target, source);
+    return true;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Allocates levels first_level through level_count - 1 and fills them with
+/// a solid color. If memory cannot be allocated, none of those levels are
+/// left allocated, and false is returned.
+static bool fill_constant_levels(
+    image::buffer_t *level_data,
+    size_t           first_level,
+    size_t           level_count,
+    size_t           level0_width,
+    size_t           level0_height,
+    float const     *color)
+{
+    size_t channels = level_data[0].channel_count;
+    for (size_t i = first_level; i < level_count; ++i)
     {
-        resize_buffer(source, width, height, border_mode, target);
+        size_t level_w = image::miplevel_width (level0_width,  i);
+        size_t level_h = image::miplevel_height(level0_height, i);
+        if (!create_buffer(level_w, level_h, channels, &level_data[i]))
+        {
+            for (size_t j = first_level; j < i; ++j)
+                free_buffer(&level_data[j]);
+            for (size_t j = i; j < level_count; ++j)
+                level_data[j].channel_data = NULL;
+            return false;
+        }
+        for (size_t c = 0; c < channels; ++c)
+        {
+            float *values = level_data[i].channels[c];
+            image::fill_channel(values, level_w, level_h, color[c]);
+        }
     }
-    else
+    return true;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+bool is_constant_buffer(image::buffer_t *buffer, float *out_color, float tolerance)
+{
+    size_t w = buffer->channel_width;
+    size_t h = buffer->channel_height;
+    for (size_t c = 0; c < buffer->channel_count; ++c)
     {
-        copy_buffer(target, source);
+        float lo = image::channel_minimum(buffer->channels[c], w, h);
+        float hi = image::channel_maximum(buffer->channels[c], w, h);
+        float mg = CMN_MAX(1.0f, CMN_MAX(fabsf(lo), fabsf(hi)));
+        if (hi - lo > tolerance * mg)
+            return false;
+        if (out_color)
+            out_color[c] = 0.5f * (lo + hi);
     }
     return true;
 }
 
 /*/////////////////////////////////////////////////////////////////////////80*/
 
+/// Builds a single mip-level from level 0 and converts it back to gamma
+/// space. Level 0 is only read, so every level can be built at once. A level
+/// smaller than one already found to be a solid color is skipped, and left
+/// with NULL channel_data, since build_mipmaps() replaces it with that color.
+static void CMN_CALL_C build_mipmap_level(size_t index, void *context)
+{
+    mipmap_job_t    *job   = (mipmap_job_t*) context;
+    size_t           i     = index + 1;
+    size_t           l0_w  = job->level_0->channel_width;
+    size_t           l0_h  = job->level_0->channel_height;
+    size_t           w     = image::miplevel_width (l0_w, i);
+    size_t           h     = image::miplevel_height(l0_h, i);
+    image::buffer_t *level = &job->level_data[i];
+    for (size_t j = 1; j < i; ++j)
+    {
+        // a flag set by another thread after this check only means the
+        // level is built for nothing; the result is the same.
+        if (job->constant[j])
+        {
+            level->channel_data = NULL;
+            compile_progress_step(job->progress);
+            return;
+        }
+    }
+    if (compile_cancelled(job->progress) ||
+       !resize_buffer(job->level_0, w, h, job->border_mode, level, job->progress))
+    {
+        level->channel_data = NULL;
+        job->failed         = true;
+        return;
+    }
+    image::gamma(level, 0, job->color_count);
+    job->constant[i] = (w * h > 1) && is_constant_buffer(level, NULL, job->tolerance);
+    compile_progress_step(job->progress);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
 bool build_mipmaps(
-    image::buffer_t *level_0,
-    int32_t          border_mode,
-    size_t           level_count,
-    image::buffer_t *level_data)
+    image::buffer_t    *level_0,
+    int32_t             border_mode,
+    size_t              level_count,
+    image::buffer_t    *level_data,
+    float               tolerance,
+    size_t             *out_constant_level /* = NULL */,
+    compile_progress_t *progress           /* = NULL */)
 {
     size_t   color_count = level_0->channel_count;
-    if (4 == color_count)
+    size_t   constant    = level_count;
+    float    color[MAX_IMAGE_CHANNELS];
+    if (2 == color_count || 4 == color_count)
     {
         // don't include the alpha channel when converting color spaces.
-        color_count = 3;
+        color_count = color_count - 1;
     }
 
     // store the data for the first mip-level.
     level_data[0] = *level_0;
+    size_t   l0_w = level_0->channel_width;
+    size_t   l0_h = level_0->channel_height;
 
+    // a solid-color image needs no resampling; every level has the
+    // same color as level_0, in either color space. level_0 is stored
+    // as that color, so every value must match exactly.
+    if (is_constant_buffer(level_0, color, 0.0f))
+    {
+        if (!fill_constant_levels(level_data, 1, level_count, l0_w, l0_h, color))
+            return false;
+        constant = 0;
+    }
     // build any additional levels from level_0.
-    if (level_count > 1)
+    else if (level_count > 1)
     {
-        size_t   l0_w = level_0->channel_width;
-        size_t   l0_h = level_0->channel_height;
-        size_t   l0_c = level_0->channel_count;
-        int32_t  mode = border_mode;
+        mipmap_job_t job;
+        job.level_0     = level_0;
+        job.level_data  = level_data;
+        job.constant    = (bool volatile*) malloc(level_count * sizeof(bool));
+        job.progress    = progress;
+        job.border_mode = border_mode;
+        job.color_count = color_count;
+        job.tolerance   = tolerance;
+        job.failed      = false;
+        if (NULL == job.constant)
+        {
+            return false;
+        }
+        for (size_t i = 0; i < level_count; ++i)
+        {
+            job.constant[i] = false;
+        }
 
         // convert level_0 to linear-light space before downsampling.
         // our mipmaps will be in this linear-light space after filtering.
         // http://number-none.com/product/Mipmapping,%20Part%202/index.html
         image::linear(level_0, 0, color_count);
         // generate the mipmaps, each using the level_0 image as the
-        // source to avoid propagation of artifacts.
-        for (size_t i = 1; i < level_count; ++i)
-        {
-            size_t level_w = image::miplevel_width (l0_w, i);
-            size_t level_h = image::miplevel_height(l0_h, i);
-            create_buffer(level_w, level_h, l0_c, &level_data[i]);
-            resize_buffer(level_0, level_w, level_h, mode, &level_data[i]);
-            image::gamma(&level_data[i], 0, color_count);
-        }
+        // source to avoid propagation of artifacts. the levels are
+        // independent, so they are all built at once.
+        compile_progress_begin(progress, COMPILE_STAGE_MIPMAPS, level_count - 1);
+        parallel_for(level_count - 1, build_mipmap_level, &job);
         // convert level_0 back to gamma-ramped space for storage and display.
         // http://number-none.com/product/Mipmapping,%20Part%202/index.html
         image::gamma(level_0, 0, color_count);
+
+        if (job.failed)
+        {
+            for (size_t i = 1; i < level_count; ++i)
+                free_buffer(&level_data[i]);
+            free((void*) job.constant);
+            return false;
+        }
+        // once a level has collapsed to a single color, so will every
+        // smaller level; replace them all with that color. levels that
+        // were skipped all follow the first solid-color level.
+        for (size_t i = 1; i < level_count; ++i)
+        {
+            if (job.constant[i] && is_constant_buffer(&level_data[i], color, tolerance))
+            {
+                for (size_t j = i; j < level_count; ++j)
+                    free_buffer(&level_data[j]);
+                if (!fill_constant_levels(level_data, i, level_count, l0_w, l0_h, color))
+                {
+                    for (size_t j = 1; j < i; ++j)
+                        free_buffer(&level_data[j]);
+                    free((void*) job.constant);
+                    return false;
+                }
+                constant = i;
+                break;
+            }
+        }
+        free((void*) job.constant);
     }
+    if (out_constant_level) *out_constant_level = constant;
     return true;
 }
 
 /*/////////////////////////////////////////////////////////////////////////80*/
 
+size_t prune_channels(image::buffer_t *buffer)
+{
+    size_t  channels = buffer->channel_count;
+    size_t  w        = buffer->channel_width;
+    size_t  h        = buffer->channel_height;
+    float  *alpha    = NULL;
+    float  *color[3] = { NULL, NULL, NULL };
+    size_t  ncolor   = 0;
+
+    // alpha is the last channel of two- and four-channel images.
+    if (2 == channels || 4 == channels)
+    {
+        alpha  = buffer->channels[channels - 1];
+        if (image::channel_minimum(alpha, w, h) >= 1.0f) alpha = NULL;
+        ncolor = channels - 1;
+    }
+    else ncolor = channels;
+    for (size_t i = 0; i < ncolor; ++i)
+    {
+        color[i] = buffer->channels[i];
+    }
+    if (3 == ncolor &&
+        image::channel_equal(color[0], color[1], w, h) &&
+        image::channel_equal(color[0], color[2], w, h))
+    {
+        ncolor = 1;
+    }
+
+    // move the remaining channels down. the channel memory is still owned
+    // by channel_data, so unused channels are simply forgotten.
+    channels = 0;
+    for (size_t i = 0; i < ncolor; ++i)
+    {
+        buffer->channels[channels++] = color[i];
+    }
+    if (alpha) buffer->channels[channels++] = alpha;
+    for (size_t i = channels; i < MAX_IMAGE_CHANNELS; ++i)
+    {
+        buffer->channels[i] = NULL;
+    }
+    buffer->channel_count = channels;
+    return channels;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
 bool compile_texture(
     texture_compiler_inputs_t  *inputs,
     texture_compiler_outputs_t *outputs)
@@ -901,23 +1356,40 @@ bool compile_texture(
     size_t           level_0_w   = inputs->target_width;
     size_t           level_0_h   = inputs->target_height;
     int32_t          mode        = inputs->border_mode;
-    build_level0(inputs->input_image, level_0_w, level_0_h, mode, &level_0);
+    compile_progress_t *progress = inputs->progress;
+    compile_progress_begin(progress, COMPILE_STAGE_RESIZE, 1);
+    if (!build_level0(inputs->input_image, level_0_w, level_0_h, mode, &level_0, progress))
+    {
+        outputs->error_message = compile_cancelled(progress) ?
+            TEXTURE_COMPILER_CANCELLED : OUT_OF_MEMORY;
+        return false;
+    }
+    compile_progress_step(progress);
     if (inputs->flip_y)  image::flip(&level_0);
 
     // generate mipmaps (or not, if level_count is 1).
     size_t           level_count = inputs->maximum_levels;
     image::buffer_t *level_data  = outputs->level_data;
-    build_mipmaps(&level_0, mode,  level_count, level_data);
+    size_t           constant    = level_count;
+    float            tolerance   = inputs->constant_tolerance;
+    if (!build_mipmaps(&level_0, mode, level_count, level_data, tolerance, &constant, progress))
+    {
+        free_buffer(&level_0);
+        outputs->error_message = compile_cancelled(progress) ?
+            TEXTURE_COMPILER_CANCELLED : OUT_OF_MEMORY;
+        return false;
+    }
 
-    // pre-multiply RGB color values by alpha, if desired  and
-    // if the image has four channels (one assumed to be alpha).
-    if (inputs->premultiply_a && 4 == level_0.channel_count)
+    // pre-multiply color values by alpha, if desired and if the
+    // image has two or four channels (the last assumed to be alpha).
+    size_t           nc          = level_0.channel_count;
+    if (inputs->premultiply_a && (2 == nc || 4 == nc))
     {
         for (size_t i = 0; i < level_count; ++i)
         {
             image::premultiply_alpha(
-                &level_data[i], 0, 3,
-                 level_data[i].channels[3]);
+                &level_data[i], 0, nc - 1,
+                 level_data[i].channels[nc - 1]);
         }
     }
 
@@ -925,6 +1397,16 @@ bool compile_texture(
     outputs->error_message  = NO_ERROR;
     outputs->channel_count  = level_0.channel_count;
     outputs->level_count    = inputs->maximum_levels;
+    outputs->constant_level = constant;
+    if (constant < level_count)
+    {
+        // read the color after any premultiplication.
+        image::buffer_t *level = &level_data[constant];
+        for (size_t c = 0; c < level->channel_count; ++c)
+        {
+            outputs->constant_color[c] = level->channels[c][0];
+        }
+    }
     return true;
 }
 
@@ -1018,6 +1500,500 @@ void* buffer_to_pixels_packed_5551(image::buffer_t *buffer)
 
 /*/////////////////////////////////////////////////////////////////////////80*/
 
+/// Converts a value in [0, 1] to an unsigned integer with a given maximum,
+/// rounding to nearest. Values outside [0, 1] are clamped.
+static inline uint32_t unorm_bits(float v, float max_value)
+{
+    v = (v > 0.0f) ? v : 0.0f;
+    v = (v < 1.0f) ? v : 1.0f;
+    return (uint32_t) (v * max_value + 0.5f);
+}
+
+#if CMN_HAVE_SSE2
+/// Converts four values in [0, 1] to unsigned integers with a given maximum,
+/// exactly as unorm_bits() does. _mm_max_ps() returns its second operand if
+/// either is NaN, so NaN becomes 0.
+static inline __m128i unorm_bits_sse2(float const *v, __m128 max_value)
+{
+    __m128 x = _mm_max_ps(_mm_loadu_ps(v), _mm_setzero_ps());
+    x        = _mm_min_ps(x, _mm_set1_ps(1.0f));
+    x        = _mm_add_ps(_mm_mul_ps(x, max_value), _mm_set1_ps(0.5f));
+    return _mm_cvttps_epi32(x);
+}
+
+/// Selects lanes of a where mask is set, and lanes of b elsewhere.
+static inline __m128i select_si128(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+#endif
+
+void* buffer_to_pixels_packed_rgb10a2(image::buffer_t *buffer)
+{
+    if (buffer->channel_count < 4)
+        return NULL;
+
+    size_t   bpp     = sizeof(uint32_t);
+    size_t   width   = buffer->channel_width;
+    size_t   height  = buffer->channel_height;
+    size_t   count   = width * height;
+    float   *source0 = buffer->channels[0];
+    float   *source1 = buffer->channels[1];
+    float   *source2 = buffer->channels[2];
+    float   *source3 = buffer->channels[3];
+    uint32_t *pixels = (uint32_t*) malloc(count * bpp);
+    size_t   i       = 0;
+    if (NULL == pixels)
+        return NULL;
+#if CMN_HAVE_SSE2
+    __m128   max_c   = _mm_set1_ps(1023.0f);
+    __m128   max_a   = _mm_set1_ps(   3.0f);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i r    = unorm_bits_sse2(source0 + i, max_c);
+        __m128i g    = unorm_bits_sse2(source1 + i, max_c);
+        __m128i b    = unorm_bits_sse2(source2 + i, max_c);
+        __m128i a    = unorm_bits_sse2(source3 + i, max_a);
+        __m128i p    = _mm_or_si128(
+            _mm_or_si128(r, _mm_slli_epi32(g, 10)),
+            _mm_or_si128(_mm_slli_epi32(b, 20), _mm_slli_epi32(a, 30)));
+        _mm_storeu_si128((__m128i*) (pixels + i), p);
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        uint32_t r   = unorm_bits(source0[i], 1023.0f);
+        uint32_t g   = unorm_bits(source1[i], 1023.0f);
+        uint32_t b   = unorm_bits(source2[i], 1023.0f);
+        uint32_t a   = unorm_bits(source3[i],    3.0f);
+        pixels[i]    = r | (g << 10) | (b << 20) | (a << 30);
+    }
+    return pixels;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+#define RGB9E5_MANTISSA_BITS    9
+#define RGB9E5_EXPONENT_BIAS    15
+#define RGB9E5_MAX_EXPONENT     31
+#define RGB9E5_MAX_VALUE        65408.0f    /// (511 / 512) * 2^16
+
+/// Packs an RGB value into the shared-exponent format, as specified by the
+/// EXT_texture_shared_exponent extension.
+static inline uint32_t pack_rgb9e5(float r, float g, float b)
+{
+    // clamp to the representable range; NaN compares false and becomes 0.
+    r = (r > 0.0f) ? ((r < RGB9E5_MAX_VALUE) ? r : RGB9E5_MAX_VALUE) : 0.0f;
+    g = (g > 0.0f) ? ((g < RGB9E5_MAX_VALUE) ? g : RGB9E5_MAX_VALUE) : 0.0f;
+    b = (b > 0.0f) ? ((b < RGB9E5_MAX_VALUE) ? b : RGB9E5_MAX_VALUE) : 0.0f;
+
+    // the shared exponent is chosen so that the largest channel fits in 9
+    // bits; frexp() returns e with max_c in [2^(e-1), 2^e).
+    float   max_c  = CMN_MAX(r, CMN_MAX(g, b));
+    int     e      = 0;
+    frexpf(max_c, &e);
+    int     exp_p  = CMN_MAX(-RGB9E5_EXPONENT_BIAS - 1, e - 1) + 1 + RGB9E5_EXPONENT_BIAS;
+    int     shift  = exp_p - RGB9E5_EXPONENT_BIAS - RGB9E5_MANTISSA_BITS;
+    int     max_s  = (int) floorf(ldexpf(max_c, -shift) + 0.5f);
+    if (max_s == (1 << RGB9E5_MANTISSA_BITS))
+    {
+        // rounding overflowed the mantissa; use the next exponent.
+        exp_p++;
+        shift++;
+    }
+    uint32_t rs = (uint32_t) floorf(ldexpf(r, -shift) + 0.5f);
+    uint32_t gs = (uint32_t) floorf(ldexpf(g, -shift) + 0.5f);
+    uint32_t bs = (uint32_t) floorf(ldexpf(b, -shift) + 0.5f);
+    return rs | (gs << 9) | (bs << 18) | ((uint32_t) exp_p << 27);
+}
+
+#if CMN_HAVE_SSE2
+/// Packs four RGB values into the shared-exponent format, with results
+/// identical to pack_rgb9e5(). The exponent returned by frexpf() is read
+/// directly from the bits of the largest channel, and the power-of-two
+/// scale applied by ldexpf() is built from its bits, so it is exact.
+static inline __m128i pack_rgb9e5_sse2(float const *r, float const *g, float const *b)
+{
+    __m128  zero   = _mm_setzero_ps();
+    __m128  max_v  = _mm_set1_ps(RGB9E5_MAX_VALUE);
+    __m128  half   = _mm_set1_ps(0.5f);
+    __m128  rc     = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(r), zero), max_v);
+    __m128  gc     = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(g), zero), max_v);
+    __m128  bc     = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(b), zero), max_v);
+    __m128  max_c  = _mm_max_ps(rc, _mm_max_ps(gc, bc));
+
+    // frexpf() returns e = 0 for zero. denormals get e = -126, which is
+    // clamped to the same exponent as their true (smaller) value.
+    __m128i bits   = _mm_castps_si128(max_c);
+    __m128i e      = _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(126));
+    e              = _mm_andnot_si128(_mm_cmpeq_epi32(bits, _mm_setzero_si128()), e);
+    __m128i e_min  = _mm_set1_epi32(-RGB9E5_EXPONENT_BIAS - 1);
+    __m128i e_m1   = _mm_sub_epi32(e, _mm_set1_epi32(1));
+    e_m1           = select_si128(_mm_cmpgt_epi32(e_min, e_m1), e_min, e_m1);
+    __m128i exp_p  = _mm_add_epi32(e_m1, _mm_set1_epi32(1 + RGB9E5_EXPONENT_BIAS));
+    __m128i shift  = _mm_sub_epi32(exp_p, _mm_set1_epi32(RGB9E5_EXPONENT_BIAS + RGB9E5_MANTISSA_BITS));
+
+    // scale = 2^-shift, built directly as a float. -shift is in [-8, 24].
+    __m128i bias   = _mm_set1_epi32(127);
+    __m128  scale  = _mm_castsi128_ps(_mm_slli_epi32(_mm_sub_epi32(bias, shift), 23));
+    __m128i max_s  = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(max_c, scale), half));
+    __m128i bump   = _mm_cmpeq_epi32(max_s, _mm_set1_epi32(1 << RGB9E5_MANTISSA_BITS));
+    exp_p          = _mm_sub_epi32(exp_p, bump); // bump is -1 where set.
+    shift          = _mm_sub_epi32(shift, bump);
+    scale          = _mm_castsi128_ps(_mm_slli_epi32(_mm_sub_epi32(bias, shift), 23));
+
+    __m128i rs     = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(rc, scale), half));
+    __m128i gs     = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(gc, scale), half));
+    __m128i bs     = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(bc, scale), half));
+    return _mm_or_si128(
+        _mm_or_si128(rs, _mm_slli_epi32(gs, 9)),
+        _mm_or_si128(_mm_slli_epi32(bs, 18), _mm_slli_epi32(exp_p, 27)));
+}
+#endif
+
+void* buffer_to_pixels_packed_rgb9e5(image::buffer_t *buffer)
+{
+    if (buffer->channel_count < 3)
+        return NULL;
+
+    size_t   bpp     = sizeof(uint32_t);
+    size_t   width   = buffer->channel_width;
+    size_t   height  = buffer->channel_height;
+    size_t   count   = width * height;
+    float   *source0 = buffer->channels[0];
+    float   *source1 = buffer->channels[1];
+    float   *source2 = buffer->channels[2];
+    uint32_t *pixels = (uint32_t*) malloc(count * bpp);
+    size_t   i       = 0;
+    if (NULL == pixels)
+        return NULL;
+#if CMN_HAVE_SSE2
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i p    = pack_rgb9e5_sse2(source0 + i, source1 + i, source2 + i);
+        _mm_storeu_si128((__m128i*) (pixels + i), p);
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        pixels[i]    = pack_rgb9e5(source0[i], source1[i], source2[i]);
+    }
+    return pixels;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Converts a value to an unsigned float with a 5-bit exponent (bias 15) and
+/// a mantissa of a given number of bits, rounding to nearest. Negative values
+/// and NaN become 0; values too large to represent become the largest finite
+/// value, and infinity is preserved.
+static inline uint32_t pack_ufloat(float v, uint32_t mantissa_bits)
+{
+    uint32_t x;
+    memcpy(&x, &v, sizeof(uint32_t));
+    if ((x & 0x80000000U) || ((x & 0x7F800000U) == 0x7F800000U && (x & 0x007FFFFFU)))
+        return 0;                                    // negative or NaN
+    uint32_t max_bits = (30U << mantissa_bits) | ((1U << mantissa_bits) - 1);
+    if ((x & 0x7F800000U) == 0x7F800000U)
+        return 31U << mantissa_bits;                 // infinity
+    int32_t  exponent = (int32_t) (x >> 23) - 127 + 15;
+    uint32_t mantissa = (x & 0x007FFFFFU) | 0x00800000U;
+    uint32_t drop     = 23 - mantissa_bits;
+    if (exponent <= 0)
+    {
+        // denormal: shift the implicit one into the mantissa.
+        drop += (uint32_t) (1 - exponent);
+        exponent = 0;
+        if (drop > 24) return 0;
+    }
+    // round to nearest; a carry out of the mantissa bumps the exponent.
+    uint32_t bits = (mantissa + (1U << (drop - 1))) >> drop;
+    if (exponent > 0)
+        bits = ((uint32_t) exponent << mantissa_bits) + (bits - (1U << mantissa_bits));
+    return (bits > max_bits) ? max_bits : bits;
+}
+
+#if CMN_HAVE_SSE2
+/// Converts four values as pack_ufloat() does. For normal results, rounding
+/// the mantissa is the same as rounding the rebiased float bits, so no
+/// per-lane shift is needed. SSE2 has no per-lane variable shift for the
+/// denormal results, so lanes that need one are flagged in @a slow instead.
+static inline __m128i pack_ufloat_sse2(
+    float const *v,
+    uint32_t     mantissa_bits,
+    int         *slow)
+{
+    int32_t  drop     = 23 - (int32_t) mantissa_bits;
+    __m128i  x        = _mm_castps_si128(_mm_loadu_ps(v));
+    __m128i  inf      = _mm_set1_epi32(0x7F800000);
+    __m128i  max_bits = _mm_set1_epi32((int32_t) ((30U << mantissa_bits) | ((1U << mantissa_bits) - 1)));
+
+    // negative values (sign set) and NaN (greater than infinity) become 0.
+    __m128i  zero     = _mm_or_si128(
+        _mm_cmplt_epi32(x, _mm_setzero_si128()), _mm_cmpgt_epi32(x, inf));
+    // values below 2^-(15 + mantissa_bits) round to 0 as denormals.
+    zero = _mm_or_si128(zero, _mm_cmplt_epi32(x, _mm_set1_epi32((112 - (int32_t) mantissa_bits) << 23)));
+    // values from there up to 2^-14 are denormal results.
+    __m128i  denormal = _mm_andnot_si128(zero, _mm_cmplt_epi32(x, _mm_set1_epi32(113 << 23)));
+    *slow = _mm_movemask_ps(_mm_castsi128_ps(denormal));
+
+    __m128i  bits     = _mm_add_epi32(
+        _mm_sub_epi32(x, _mm_set1_epi32(112 << 23)), _mm_set1_epi32(1 << (drop - 1)));
+    bits = _mm_srl_epi32(bits, _mm_cvtsi32_si128(drop));
+    bits = select_si128(_mm_cmpgt_epi32(bits, max_bits), max_bits, bits);
+    bits = select_si128(_mm_cmpeq_epi32(x, inf), _mm_set1_epi32((int32_t) (31U << mantissa_bits)), bits);
+    return _mm_andnot_si128(zero, bits);
+}
+#endif
+
+void* buffer_to_pixels_packed_r11g11b10f(image::buffer_t *buffer)
+{
+    if (buffer->channel_count < 3)
+        return NULL;
+
+    size_t   bpp     = sizeof(uint32_t);
+    size_t   width   = buffer->channel_width;
+    size_t   height  = buffer->channel_height;
+    size_t   count   = width * height;
+    float   *source0 = buffer->channels[0];
+    float   *source1 = buffer->channels[1];
+    float   *source2 = buffer->channels[2];
+    uint32_t *pixels = (uint32_t*) malloc(count * bpp);
+    size_t   i       = 0;
+    if (NULL == pixels)
+        return NULL;
+#if CMN_HAVE_SSE2
+    for (; i + 4 <= count; i += 4)
+    {
+        int     slow_r = 0, slow_g = 0, slow_b = 0;
+        __m128i r    = pack_ufloat_sse2(source0 + i, 6, &slow_r);
+        __m128i g    = pack_ufloat_sse2(source1 + i, 6, &slow_g);
+        __m128i b    = pack_ufloat_sse2(source2 + i, 5, &slow_b);
+        __m128i p    = _mm_or_si128(
+            _mm_or_si128(r, _mm_slli_epi32(g, 11)), _mm_slli_epi32(b, 22));
+        _mm_storeu_si128((__m128i*) (pixels + i), p);
+        if (slow_r | slow_g | slow_b)
+        {
+            // rare: redo the group if any channel has a denormal result.
+            for (size_t j = i; j < i + 4; ++j)
+            {
+                pixels[j] = pack_ufloat(source0[j], 6) |
+                           (pack_ufloat(source1[j], 6) << 11) |
+                           (pack_ufloat(source2[j], 5) << 22);
+            }
+        }
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        uint32_t r   = pack_ufloat(source0[i], 6);
+        uint32_t g   = pack_ufloat(source1[i], 6);
+        uint32_t b   = pack_ufloat(source2[i], 5);
+        pixels[i]    = r | (g << 11) | (b << 22);
+    }
+    return pixels;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+float hdr_range(image::buffer_t *buffer)
+{
+    float    range   = 1.0f;
+    size_t   width   = buffer->channel_width;
+    size_t   height  = buffer->channel_height;
+    size_t   count   = CMN_MIN(buffer->channel_count, (size_t) 3);
+    for (size_t c    = 0; c < count; ++c)
+    {
+        float m      = image::channel_maximum(buffer->channels[c], width, height);
+        range        = CMN_MAX(range, m);
+    }
+    return range;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// The smallest multiplier stored by RGBM, so black pixels don't divide by 0.
+#define RGBM_MIN_MULTIPLIER     (1.0f / 255.0f)
+
+#if CMN_HAVE_SSE2
+/// Quantizes four scaled channel values to 8 bits, as the scalar RGBM and
+/// RGBD loops do: (uint8_t) CMN_MIN(v * k + 0.5f, 255.0f).
+static inline __m128i quantize_u8_sse2(__m128 v, __m128 k)
+{
+    __m128 x = _mm_add_ps(_mm_mul_ps(v, k), _mm_set1_ps(0.5f));
+    return _mm_cvttps_epi32(_mm_min_ps(x, _mm_set1_ps(255.0f)));
+}
+
+/// Packs four pixels of 8-bit channel values into RGBA byte order.
+static inline __m128i pack_rgba8_sse2(__m128i r, __m128i g, __m128i b, __m128i a)
+{
+    return _mm_or_si128(
+        _mm_or_si128(r, _mm_slli_epi32(g, 8)),
+        _mm_or_si128(_mm_slli_epi32(b, 16), _mm_slli_epi32(a, 24)));
+}
+#endif
+
+void* buffer_to_pixels_rgbm(image::buffer_t *buffer, float range)
+{
+    if (buffer->channel_count < 3)
+        return NULL;
+
+    size_t   bpp     = sizeof(uint8_t) * 4;
+    size_t   width   = buffer->channel_width;
+    size_t   height  = buffer->channel_height;
+    size_t   count   = width * height;
+    float    scale   = 1.0f / range;
+    float   *source0 = buffer->channels[0];
+    float   *source1 = buffer->channels[1];
+    float   *source2 = buffer->channels[2];
+    uint8_t *pixels  = (uint8_t*) malloc(count * bpp);
+    size_t   i       = 0;
+    if (NULL == pixels)
+        return NULL;
+#if CMN_HAVE_SSE2
+    __m128   zero    = _mm_setzero_ps();
+    __m128   one     = _mm_set1_ps(1.0f);
+    __m128   s255    = _mm_set1_ps(255.0f);
+    __m128   vscale  = _mm_set1_ps(scale);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 r     = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(source0 + i), vscale), zero), one);
+        __m128 g     = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(source1 + i), vscale), zero), one);
+        __m128 b     = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(source2 + i), vscale), zero), one);
+        __m128 m     = _mm_max_ps(_mm_max_ps(r, g), _mm_max_ps(b, _mm_set1_ps(RGBM_MIN_MULTIPLIER)));
+        // ceilf() of a value in [1, 255]: truncate, then step up if inexact.
+        __m128 t     = _mm_mul_ps(m, s255);
+        __m128 tf    = _mm_cvtepi32_ps(_mm_cvttps_epi32(t));
+        __m128 a     = _mm_add_ps(tf, _mm_and_ps(_mm_cmplt_ps(tf, t), one));
+        __m128 k     = _mm_div_ps(_mm_set1_ps(255.0f * 255.0f), a);
+        __m128i p    = pack_rgba8_sse2(
+            quantize_u8_sse2(r, k), quantize_u8_sse2(g, k),
+            quantize_u8_sse2(b, k), _mm_cvttps_epi32(a));
+        _mm_storeu_si128((__m128i*) (pixels + i * 4), p);
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        // scale into [0, 1], then store the largest channel as a multiplier
+        // rounded up to the next 8-bit step so rgb / m stays within [0, 1].
+        float r      = CMN_MIN(CMN_MAX(source0[i] * scale, 0.0f), 1.0f);
+        float g      = CMN_MIN(CMN_MAX(source1[i] * scale, 0.0f), 1.0f);
+        float b      = CMN_MIN(CMN_MAX(source2[i] * scale, 0.0f), 1.0f);
+        float m      = CMN_MAX(CMN_MAX(r, g), CMN_MAX(b, RGBM_MIN_MULTIPLIER));
+        float a      = ceilf(m * 255.0f);
+        float k      = 255.0f * 255.0f / a;
+        pixels[i * 4 + 0] = (uint8_t) CMN_MIN(r * k + 0.5f, 255.0f);
+        pixels[i * 4 + 1] = (uint8_t) CMN_MIN(g * k + 0.5f, 255.0f);
+        pixels[i * 4 + 2] = (uint8_t) CMN_MIN(b * k + 0.5f, 255.0f);
+        pixels[i * 4 + 3] = (uint8_t) a;
+    }
+    return pixels;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void* buffer_to_pixels_rgbd(image::buffer_t *buffer, float range)
+{
+    if (buffer->channel_count < 3)
+        return NULL;
+
+    size_t   bpp     = sizeof(uint8_t) * 4;
+    size_t   width   = buffer->channel_width;
+    size_t   height  = buffer->channel_height;
+    size_t   count   = width * height;
+    float   *source0 = buffer->channels[0];
+    float   *source1 = buffer->channels[1];
+    float   *source2 = buffer->channels[2];
+    uint8_t *pixels  = (uint8_t*) malloc(count * bpp);
+    size_t   i       = 0;
+    if (NULL == pixels)
+        return NULL;
+#if CMN_HAVE_SSE2
+    __m128   zero    = _mm_setzero_ps();
+    __m128   one     = _mm_set1_ps(1.0f);
+    __m128   vrange  = _mm_set1_ps(range);
+    __m128   m_min   = _mm_set1_ps(range / 255.0f);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 r     = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(source0 + i), zero), vrange);
+        __m128 g     = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(source1 + i), zero), vrange);
+        __m128 b     = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(source2 + i), zero), vrange);
+        __m128 m     = _mm_max_ps(_mm_max_ps(r, g), _mm_max_ps(b, m_min));
+        // floorf() of a positive quotient is a truncation. the quotient is
+        // limited first so it fits in an integer; NaN is kept, converts to
+        // INT_MIN and is then clamped to 1, as in the scalar code.
+        __m128 q     = _mm_min_ps(_mm_set1_ps(256.0f), _mm_div_ps(vrange, m));
+        __m128 d     = _mm_cvtepi32_ps(_mm_cvttps_epi32(q));
+        d            = _mm_min_ps(_mm_max_ps(d, one), _mm_set1_ps(255.0f));
+        __m128 k     = _mm_div_ps(_mm_mul_ps(_mm_set1_ps(255.0f), d), vrange);
+        __m128i p    = pack_rgba8_sse2(
+            quantize_u8_sse2(r, k), quantize_u8_sse2(g, k),
+            quantize_u8_sse2(b, k), _mm_cvttps_epi32(d));
+        _mm_storeu_si128((__m128i*) (pixels + i * 4), p);
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        // the divisor d in [1, 255] is the largest integer that keeps the
+        // brightest channel within range after scaling by d / range.
+        float r      = CMN_MIN(CMN_MAX(source0[i], 0.0f), range);
+        float g      = CMN_MIN(CMN_MAX(source1[i], 0.0f), range);
+        float b      = CMN_MIN(CMN_MAX(source2[i], 0.0f), range);
+        float m      = CMN_MAX(CMN_MAX(r, g), CMN_MAX(b, range / 255.0f));
+        float d      = CMN_MIN(CMN_MAX(floorf(range / m), 1.0f), 255.0f);
+        float k      = 255.0f * d / range;
+        pixels[i * 4 + 0] = (uint8_t) CMN_MIN(r * k + 0.5f, 255.0f);
+        pixels[i * 4 + 1] = (uint8_t) CMN_MIN(g * k + 0.5f, 255.0f);
+        pixels[i * 4 + 2] = (uint8_t) CMN_MIN(b * k + 0.5f, 255.0f);
+        pixels[i * 4 + 3] = (uint8_t) d;
+    }
+    return pixels;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void quantize_buffer(
+    image::buffer_t *source,
+    size_t const    *channel_bits,
+    image::buffer_t *target)
+{
+    size_t count = source->channel_width * source->channel_height;
+    for (size_t c = 0; c < source->channel_count; ++c)
+    {
+        uint32_t     shift = (uint32_t) (8 - channel_bits[c]);
+        float        scale = 1.0f / (float) ((1U << channel_bits[c]) - 1);
+        float const *src   = source->channels[c];
+        float       *dst   = target->channels[c];
+        for (size_t i = 0; i < count; ++i)
+        {
+            float v = src[i];
+            v = (v > 0.0f) ? v : 0.0f;
+            v = (v < 1.0f) ? v : 1.0f;
+            dst[i]  = (float) (((uint32_t) (v * 255.0f)) >> shift) * scale;
+        }
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+double buffer_psnr(image::buffer_t *reference, image::buffer_t *test)
+{
+    size_t width    = reference->channel_width;
+    size_t height   = reference->channel_height;
+    size_t channels = reference->channel_count;
+    double total    = 0.0;
+    for (size_t c = 0; c < channels; ++c)
+    {
+        total += image::channel_squared_error(
+            reference->channels[c], test->channels[c], width, height);
+    }
+    double mse  = total / (double) (width * height * channels);
+    double psnr = (mse > 0.0) ? -10.0 * log10(mse) : TEXTURE_COMPILER_PSNR_IDENTICAL;
+    return CMN_MIN(psnr, TEXTURE_COMPILER_PSNR_IDENTICAL);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
 void* buffer_to_pixels_8i(image::buffer_t *buffer, size_t channel_count)
 {
     switch (channel_count)
@@ -1033,6 +2009,98 @@ void* buffer_to_pixels_8i(image::buffer_t *buffer, size_t channel_count)
 
 /*/////////////////////////////////////////////////////////////////////////80*/
 
+#if CMN_HAVE_SSE2
+/// Converts eight values in [0, 1] to 16-bit unsigned integers, exactly as
+/// the scalar loop does. SSE2 has no unsigned 32-to-16 bit pack, so the
+/// values are biased into the signed range, packed with _mm_packs_epi32()
+/// and the bias is removed by flipping the sign bit.
+static inline __m128i unorm16_sse2(float const *v)
+{
+    __m128  scale = _mm_set1_ps(65535.0f);
+    __m128i bias  = _mm_set1_epi32(32768);
+    __m128i lo    = _mm_sub_epi32(unorm_bits_sse2(v + 0, scale), bias);
+    __m128i hi    = _mm_sub_epi32(unorm_bits_sse2(v + 4, scale), bias);
+    return _mm_xor_si128(_mm_packs_epi32(lo, hi), _mm_set1_epi16((short) 0x8000));
+}
+#endif
+
+void* buffer_to_pixels_16i(image::buffer_t *buffer, size_t channel_count)
+{
+    if (channel_count == 0 || buffer->channel_count < channel_count)
+        return NULL;
+
+    size_t    bpp    = sizeof(uint16_t) * channel_count;
+    size_t    width  = buffer->channel_width;
+    size_t    height = buffer->channel_height;
+    size_t    count  = width * height;
+    uint16_t *pixels = (uint16_t*) malloc(count * bpp);
+    if (NULL == pixels)
+        return NULL;
+
+    size_t start = 0;
+#if CMN_HAVE_SSE2
+    // eight pixels at a time: convert each channel, then interleave them.
+    for (; start + 8 <= count; start += 8)
+    {
+        uint16_t *dest = pixels + start * channel_count;
+        __m128i   c0   = unorm16_sse2(buffer->channels[0] + start);
+        if (1 == channel_count)
+        {
+            _mm_storeu_si128((__m128i*) dest, c0);
+        }
+        else if (2 == channel_count)
+        {
+            __m128i c1 = unorm16_sse2(buffer->channels[1] + start);
+            _mm_storeu_si128((__m128i*) (dest + 0), _mm_unpacklo_epi16(c0, c1));
+            _mm_storeu_si128((__m128i*) (dest + 8), _mm_unpackhi_epi16(c0, c1));
+        }
+        else if (4 == channel_count)
+        {
+            __m128i c1 = unorm16_sse2(buffer->channels[1] + start);
+            __m128i c2 = unorm16_sse2(buffer->channels[2] + start);
+            __m128i c3 = unorm16_sse2(buffer->channels[3] + start);
+            __m128i lo = _mm_unpacklo_epi16(c0, c1);
+            __m128i hi = _mm_unpackhi_epi16(c0, c1);
+            __m128i la = _mm_unpacklo_epi16(c2, c3);
+            __m128i ha = _mm_unpackhi_epi16(c2, c3);
+            _mm_storeu_si128((__m128i*) (dest +  0), _mm_unpacklo_epi32(lo, la));
+            _mm_storeu_si128((__m128i*) (dest +  8), _mm_unpackhi_epi32(lo, la));
+            _mm_storeu_si128((__m128i*) (dest + 16), _mm_unpacklo_epi32(hi, ha));
+            _mm_storeu_si128((__m128i*) (dest + 24), _mm_unpackhi_epi32(hi, ha));
+        }
+        else
+        {
+            // three channels don't interleave evenly; store through scalar.
+            CMN_ALIGN_BEGIN(16) uint16_t values[8] CMN_ALIGN_END(16);
+            for (size_t c = 0; c < channel_count; ++c)
+            {
+                __m128i v = (0 == c) ? c0 : unorm16_sse2(buffer->channels[c] + start);
+                _mm_store_si128((__m128i*) values, v);
+                for (size_t j = 0; j < 8; ++j)
+                    dest[j * channel_count + c] = values[j];
+            }
+        }
+    }
+#endif
+
+    // convert the remaining pixels one channel at a time.
+    for (size_t c = 0; c < channel_count; ++c)
+    {
+        float const *source = buffer->channels[c];
+        uint16_t    *dest   = pixels + c;
+        for (size_t i = start; i < count; ++i)
+        {
+            float v = source[i];
+            v = (v > 0.0f) ? v : 0.0f;
+            v = (v < 1.0f) ? v : 1.0f;
+            dest[i * channel_count] = (uint16_t) (v * 65535.0f + 0.5f);
+        }
+    }
+    return pixels;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
 void* buffer_to_pixels_16f(image::buffer_t *buffer, size_t channel_count)
 {
     switch (channel_count)
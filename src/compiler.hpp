@@ -26,6 +26,58 @@
 #define TEXTURE_COMPILER_MAX_LEVELS    16U
 #endif /* !defined(TEXTURE_COMPILER_MAX_LEVELS) */
 
+/// Define the PSNR, in decibels, reported for two identical images.
+#ifndef TEXTURE_COMPILER_PSNR_IDENTICAL
+#define TEXTURE_COMPILER_PSNR_IDENTICAL 100.0
+#endif /* !defined(TEXTURE_COMPILER_PSNR_IDENTICAL) */
+
+/// Define the error message reported by a compile that was cancelled.
+#ifndef TEXTURE_COMPILER_CANCELLED
+#define TEXTURE_COMPILER_CANCELLED      "The compile was cancelled."
+#endif /* !defined(TEXTURE_COMPILER_CANCELLED) */
+
+/// Identifies the stage of a compile reported to a progress callback.
+enum compile_stage_e
+{
+    /// The source image is being loaded.
+    COMPILE_STAGE_LOAD              = 0,
+    /// The level 0 image is being resampled from the source image.
+    COMPILE_STAGE_RESIZE            = 1,
+    /// The remaining mip-levels are being built from level 0.
+    COMPILE_STAGE_MIPMAPS           = 2,
+    /// Levels, or rows of tiles, are being converted to the target format.
+    COMPILE_STAGE_ENCODE            = 3,
+    /// Levels are being written to the output file.
+    COMPILE_STAGE_WRITE             = 4,
+    /// Force the enumeration to 32 bits.
+    COMPILE_STAGE_FORCE_32BIT       = CMN_FORCE_32BIT
+};
+
+/// A function pointer type for a progress callback. The callback may be
+/// invoked concurrently from several threads, and must not block.
+/// @param stage One of the compile_stage_e values.
+/// @param done The number of units of work of the stage completed so far.
+/// @param total The number of units of work in the stage.
+/// @param context Opaque application data from the compile_progress_t.
+typedef void (CMN_CALL_C *compile_progress_fn)(
+    int32_t stage,
+    size_t  done,
+    size_t  total,
+    void   *context);
+
+/// Tracks the progress of a compile, and carries a request to cancel it.
+/// The compile checks for cancellation between levels, bands of rows and
+/// tiles, and stops as soon as it notices.
+struct compile_progress_t
+{
+    compile_progress_fn callback;    /// Called as work completes, or NULL.
+    void               *context;     /// Application data for the callback.
+    long volatile       cancelled;   /// Non-zero once cancel is requested.
+    int32_t volatile    stage;       /// The current compile_stage_e.
+    long volatile       done;        /// Units of the stage completed.
+    size_t volatile     total;       /// Units of work in the stage.
+};
+
 /// A structure used for passing arguments to the texture compiler.
 struct texture_compiler_inputs_t
 {
@@ -36,8 +88,11 @@ struct texture_compiler_inputs_t
     size_t           maximum_levels; /// Maximum number of mip-levels.
     bool             build_mipmaps;  /// Build mipmap chain?
     bool             force_pow2;     /// Force power-of-two dimensions?
+    bool             force_square;   /// Force width and height to be equal?
     bool             premultiply_a;  /// Output premultiplied alpha?
     bool             flip_y;         /// Flip image for bottom-left origin?
+    float            constant_tolerance; /// Solid-color spread; see build_mipmaps().
+    compile_progress_t *progress;    /// Progress and cancellation, or NULL.
 };
 
 /// A structure used for returning data from the texture compiler.
@@ -46,9 +101,46 @@ struct texture_compiler_outputs_t
     char const      *error_message;  /// Static error message string.
     size_t           channel_count;  /// Number of color channels.
     size_t           level_count;    /// Number of valid entries in level_data.
+    size_t           constant_level; /// First solid-color level, or level_count.
+    float            constant_color[MAX_IMAGE_CHANNELS]; /// Solid level color.
     image::buffer_t  level_data[TEXTURE_COMPILER_MAX_LEVELS];
 };
 
+/// Initializes a compile_progress_t structure.
+/// @param progress Pointer to the structure to initialize.
+/// @param callback The function to call as work completes, or NULL.
+/// @param context Opaque application data passed through to @a callback.
+CMN_PUBLIC void  compile_progress_init(
+    compile_progress_t *progress,
+    compile_progress_fn callback,
+    void               *context);
+
+/// Starts a new stage of a compile, and reports that none of its work has
+/// been done yet.
+/// @param progress The progress tracker. This parameter may be NULL.
+/// @param stage One of the compile_stage_e values.
+/// @param total The number of units of work in the stage.
+CMN_PUBLIC void  compile_progress_begin(
+    compile_progress_t *progress,
+    int32_t             stage,
+    size_t              total);
+
+/// Records that one unit of work of the current stage has been completed.
+/// This function may be called concurrently from several threads.
+/// @param progress The progress tracker. This parameter may be NULL.
+/// @return false if the compile has been cancelled.
+CMN_PUBLIC bool  compile_progress_step(compile_progress_t *progress);
+
+/// Requests that a compile stop as soon as possible. This function may be
+/// called from any thread.
+/// @param progress The progress tracker of the compile to cancel.
+CMN_PUBLIC void  compile_cancel(compile_progress_t *progress);
+
+/// Determines whether a compile has been cancelled.
+/// @param progress The progress tracker. This parameter may be NULL.
+/// @return true if compile_cancel() has been called.
+CMN_PUBLIC bool  compile_cancelled(compile_progress_t *progress);
+
 /// Initializes a texture_compiler_inputs_t structure to default values.
 /// @param inputs Pointer to the structure to initialize.
 CMN_PUBLIC void  texture_compiler_inputs_init(
@@ -115,6 +207,27 @@ CMN_PUBLIC void  copy_buffer_to_region(
     size_t           target_x,
     size_t           target_y);
 
+/// Copies a rectangular region of a source image buffer to a target image
+/// buffer. The region has the dimensions of the target and may extend past
+/// the edges of the source; texels outside of the source are sampled using
+/// the border mode, so the gutter around a tile matches what a sampler would
+/// read from the whole image.
+/// @param target The target image buffer. It must have the same number of
+/// channels as @a source.
+/// @param source The source image buffer.
+/// @param source_x The x-coordinate in @a source of the upper-left corner of
+/// the region. This value may be negative.
+/// @param source_y The y-coordinate in @a source of the upper-left corner of
+/// the region. This value may be negative.
+/// @param border_mode One of the image::border_mode_e constants describing how
+/// to sample outside of the source image.
+CMN_PUBLIC void  copy_region_with_border(
+    image::buffer_t *target,
+    image::buffer_t *source,
+    ptrdiff_t        source_x,
+    ptrdiff_t        source_y,
+    int32_t          border_mode);
+
 /// Resizes an image buffer using a 32-sample Kaiser filter.
 /// @param source Pointer to the structure representing the source image.
 /// @param new_width The desired width of the target image, in pixels.
@@ -123,14 +236,18 @@ CMN_PUBLIC void  copy_buffer_to_region(
 /// to perform sampling at the borders of the image.
 /// @param target Pointer to the buffer structure that will be allocated and
 /// initialized with the resized image.
+/// @param progress Checked for cancellation between bands of rows. This
+/// parameter may be NULL.
 /// @return true if the operation was successful, or false if the necessary
-/// memory could not be allocated or one or more parameters are invalid.
+/// memory could not be allocated, one or more parameters are invalid or the
+/// compile was cancelled. On failure, no buffer is allocated.
 CMN_PUBLIC bool  resize_buffer(
-    image::buffer_t *source,
-    size_t           new_width,
-    size_t           new_height,
-    int32_t          border_mode,
-    image::buffer_t *target);
+    image::buffer_t    *source,
+    size_t              new_width,
+    size_t              new_height,
+    int32_t             border_mode,
+    image::buffer_t    *target,
+    compile_progress_t *progress = NULL);
 
 /// Builds a level 0 version of a source image. The image is resized if
 /// necessary; otherwise, it is copied.
@@ -141,17 +258,24 @@ CMN_PUBLIC bool  resize_buffer(
 /// to perform sampling at the borders of the image.
 /// @param target Pointer to the buffer structure that will be allocated and
 /// initialized with the level 0 image data.
+/// @param progress Checked for cancellation while resizing. This parameter
+/// may be NULL.
 /// @return true if the operation was successful, or false if the necessary
-/// memory could not be allocated or one or more parameters are invalid.
+/// memory could not be allocated, one or more parameters are invalid or the
+/// compile was cancelled.
 CMN_PUBLIC bool  build_level0(
-    image::buffer_t *source,
-    size_t           target_width,
-    size_t           target_height,
-    int32_t          border_mode,
-    image::buffer_t *target);
+    image::buffer_t    *source,
+    size_t              target_width,
+    size_t              target_height,
+    int32_t             border_mode,
+    image::buffer_t    *target,
+    compile_progress_t *progress = NULL);
 
 /// Builds the mipmap chain for a given source image. Each dimension of the
-/// source image is reduced by 50% at each mip-level.
+/// source image is reduced by 50% at each mip-level. Once a level is found to
+/// be a single solid color, it and the remaining levels are filled with that
+/// color. Level 0 must be exactly a solid color; resampled levels may differ
+/// by up to @a tolerance, which absorbs rounding in the resampling filters.
 /// @param level_0 Pointer to the structure representing the level 0 image.
 /// @param border_mode One of the image::border_mode_e constants describing how
 /// to perform sampling at the borders of the image.
@@ -159,20 +283,81 @@ CMN_PUBLIC bool  build_level0(
 /// level 0 image. This value must be at least 1.
 /// @param level_data Pointer to an array of image buffer objects that will be
 /// populated with the data for each mip-level.
+/// @param tolerance The largest spread of the values of a channel, relative to
+/// their magnitude, for a resampled level to be treated as a solid color. This
+/// should be below the smallest step of the target format, or 0.
+/// @param out_constant_level On return, stores the index of the first level
+/// that is a single solid color, or @a level_count if no level is. This
+/// parameter may be NULL.
+/// @param progress Receives a COMPILE_STAGE_MIPMAPS step per level, and is
+/// checked for cancellation before each level. This parameter may be NULL.
 /// @return true if the operation was successful, or false if the necessary
-/// memory could not be allocated or one or more parameters are invalid.
+/// memory could not be allocated, one or more parameters are invalid or the
+/// compile was cancelled. On failure, levels 1 and up are not allocated.
 CMN_PUBLIC bool  build_mipmaps(
-    image::buffer_t *level_0,
-    int32_t          border_mode,
-    size_t           level_count,
-    image::buffer_t *level_data);
+    image::buffer_t    *level_0,
+    int32_t             border_mode,
+    size_t              level_count,
+    image::buffer_t    *level_data,
+    float               tolerance,
+    size_t             *out_constant_level = NULL,
+    compile_progress_t *progress           = NULL);
+
+/// Determines whether every pixel of an image buffer has the same color.
+/// @param buffer The image buffer to inspect.
+/// @param out_color On return, stores the value of each channel if the buffer
+/// is a solid color. This parameter may be NULL.
+/// @param tolerance The largest spread of the values of a channel, relative to
+/// their magnitude (or to 1, for values below 1), for the channel to count as
+/// a single value. Pass 0 to require every value to be exactly equal.
+/// @return true if @a buffer is a single solid color.
+CMN_PUBLIC bool  is_constant_buffer(
+    image::buffer_t *buffer,
+    float           *out_color,
+    float            tolerance);
+
+/// Removes channels that carry no information from an image buffer. An alpha
+/// channel that is fully opaque is removed, and red, green and blue channels
+/// with identical contents are reduced to a single luminance channel. The
+/// remaining channels are moved down in place; no pixel data is copied.
+/// @param buffer The image buffer to modify. The buffer must have been loaded
+/// with file_to_buffer() or have one to four channels in the usual order.
+/// @return The number of channels remaining in @a buffer.
+CMN_PUBLIC size_t prune_channels(image::buffer_t *buffer);
+
+/// Reproduces the values read back from an unsigned normalized format with a
+/// given number of bits per channel. Values are truncated to 8 bits and then
+/// to @a channel_bits, as done by the buffer_to_pixels_* conversions.
+/// @param source The buffer to quantize.
+/// @param channel_bits The number of bits stored for each channel of
+/// @a source, between 1 and 8.
+/// @param target The buffer that receives the quantized values. It must have
+/// the same dimensions and channel count as @a source.
+CMN_PUBLIC void  quantize_buffer(
+    image::buffer_t *source,
+    size_t const    *channel_bits,
+    image::buffer_t *target);
+
+/// Computes the peak signal-to-noise ratio of an image relative to a
+/// reference image, over all channels, with a peak value of 1.0.
+/// @param reference The reference image.
+/// @param test The image to measure. It must have the same dimensions and
+/// channel count as @a reference.
+/// @return The PSNR, in decibels, or TEXTURE_COMPILER_PSNR_IDENTICAL if the
+/// error is negligible. The result is negative if the mean squared error is
+/// above 1.0, which can happen for HDR images.
+CMN_PUBLIC double buffer_psnr(
+    image::buffer_t *reference,
+    image::buffer_t *test);
 
 /// Performs a series of operations on an input image to prepare it for
 /// runtime use as a texture.
 /// @param inputs The texture compiler inputs describing the operations to be
 /// performed on the input image.
 /// @param outputs Pointer to a structure used to store the result data.
-/// @return true if the operation completed successfully.
+/// @return true if the operation completed successfully. If the compile was
+/// cancelled through inputs->progress, the error message of @a outputs is
+/// TEXTURE_COMPILER_CANCELLED and no level data is returned.
 CMN_PUBLIC bool  compile_texture(
     texture_compiler_inputs_t  *inputs,
     texture_compiler_outputs_t *outputs);
@@ -195,6 +380,51 @@ CMN_PUBLIC void* buffer_to_pixels_packed_4444(image::buffer_t *buffer);
 /// @return A pointer to the interleaved pixel data.
 CMN_PUBLIC void* buffer_to_pixels_packed_5551(image::buffer_t *buffer);
 
+/// Converts an RGBA image buffer to a pixel array of 32 bits-per-pixel
+/// unsigned integer data, with 10 bits for each color channel and 2 bits for
+/// alpha. Red is stored in the least significant bits.
+/// @param buffer The buffer to convert. The buffer must have four channels.
+/// @return A pointer to the interleaved pixel data.
+CMN_PUBLIC void* buffer_to_pixels_packed_rgb10a2(image::buffer_t *buffer);
+
+/// Converts an RGB image buffer to a pixel array of 32 bits-per-pixel shared-
+/// exponent floating point data. Negative values are stored as zero.
+/// @param buffer The buffer to convert. The buffer must have three channels.
+/// @return A pointer to the interleaved pixel data.
+CMN_PUBLIC void* buffer_to_pixels_packed_rgb9e5(image::buffer_t *buffer);
+
+/// Converts an RGB image buffer to a pixel array of 32 bits-per-pixel packed
+/// unsigned floating point data, with 11 bits each for red and green and 10
+/// bits for blue. Negative values are stored as zero.
+/// @param buffer The buffer to convert. The buffer must have three channels.
+/// @return A pointer to the interleaved pixel data.
+CMN_PUBLIC void* buffer_to_pixels_packed_r11g11b10f(image::buffer_t *buffer);
+
+/// Computes the range used to encode an HDR image as RGBM or RGBD, which is
+/// the largest red, green or blue value in the image, and at least 1.
+/// @param buffer The buffer to inspect. The buffer must have three channels.
+/// @return The largest color value in @a buffer, or 1 if all values are
+/// less than 1.
+CMN_PUBLIC float hdr_range(image::buffer_t *buffer);
+
+/// Converts an HDR RGB image buffer to a pixel array of 8 bits-per-channel
+/// RGBM data. Decode in the shader with rgb * a * range.
+/// @param buffer The buffer to convert. The buffer must have three channels.
+/// Any alpha channel is ignored.
+/// @param range The largest value that can be represented. Larger values are
+/// clamped to @a range.
+/// @return A pointer to the interleaved pixel data.
+CMN_PUBLIC void* buffer_to_pixels_rgbm(image::buffer_t *buffer, float range);
+
+/// Converts an HDR RGB image buffer to a pixel array of 8 bits-per-channel
+/// RGBD data. Decode in the shader with rgb * (range / 255) / a.
+/// @param buffer The buffer to convert. The buffer must have three channels.
+/// Any alpha channel is ignored.
+/// @param range The largest value that can be represented. Larger values are
+/// clamped to @a range.
+/// @return A pointer to the interleaved pixel data.
+CMN_PUBLIC void* buffer_to_pixels_rgbd(image::buffer_t *buffer, float range);
+
 /// Converts an image buffer to a pixel array of 8 bits-per-channel unsigned
 /// integer data.
 /// @param buffer The buffer to convert.
@@ -204,6 +434,16 @@ CMN_PUBLIC void* buffer_to_pixels_8i(
     image::buffer_t *buffer,
     size_t           channel_count);
 
+/// Converts an image buffer to a pixel array of 16 bits-per-channel unsigned
+/// normalized integer data. Values outside [0, 1] are clamped.
+/// @param buffer The buffer to convert.
+/// @param channel_count The number of channels to read from @a buffer.
+/// @return A pointer to the interleaved pixel data, or NULL if @a buffer has
+/// fewer than @a channel_count channels.
+CMN_PUBLIC void* buffer_to_pixels_16i(
+    image::buffer_t *buffer,
+    size_t           channel_count);
+
 /// Converts an image buffer to a pixel array of 16 bits-per-channel half-
 /// precision floating point data.
 /// @param buffer The buffer to convert.
@@ -0,0 +1,335 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implements a greedy LZ4 block compressor and decompressor, and
+/// the parallel compression of data split into independent chunks.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////
+//   Includes   //
+////////////////*/
+#include <stdlib.h>
+#include <string.h>
+#include "compress.hpp"
+#include "parallel.hpp"
+
+/*//////////////////////////
+//   Using Declarations   //
+//////////////////////////*/
+
+/*//////////////////////
+//   Implementation   //
+//////////////////////*/
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+#define LZ4_MIN_MATCH       4       /// The shortest match that is encoded.
+#define LZ4_LAST_LITERALS   5       /// The last 5 bytes are always literals.
+#define LZ4_MF_LIMIT        12      /// No match may start in the last 12 bytes.
+#define LZ4_MAX_OFFSET      65535   /// The largest match offset.
+#define LZ4_HASH_BITS       14      /// The size of the match hash table.
+
+/// The state shared by the threads compressing the chunks of a data block.
+struct compress_job_t
+{
+    uint8_t const      *source;     /// The data to compress.
+    compressed_chunk_t *chunks;     /// The chunk descriptors.
+    uint8_t            *scratch;    /// Worst-case storage for each chunk.
+    size_t              stride;     /// The size of each chunk's scratch area.
+};
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static inline uint32_t read_u32(uint8_t const *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(uint32_t));
+    return v;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static inline uint32_t lz4_hash(uint32_t v)
+{
+    return (v * 2654435761U) >> (32 - LZ4_HASH_BITS);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Writes a length of 15 or more as a run of 255 bytes and a final byte.
+static inline uint8_t* lz4_put_length(uint8_t *op, size_t len)
+{
+    while (len >= 255)
+    {
+        *op++ = 255;
+        len  -= 255;
+    }
+    *op++ = (uint8_t) len;
+    return op;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Writes one sequence: a run of literals followed by a match. A match length
+/// of zero writes the final run of literals only.
+static uint8_t* lz4_put_sequence(
+    uint8_t       *op,
+    uint8_t       *op_end,
+    uint8_t const *literals,
+    size_t         literal_len,
+    size_t         offset,
+    size_t         match_len)
+{
+    // token, worst-case length bytes, literals and the offset.
+    size_t need = 1 + (literal_len / 255 + 1) + literal_len + 2 + (match_len / 255 + 1);
+    if ((size_t) (op_end - op) < need) return NULL;
+
+    uint8_t *token = op++;
+    *token = (uint8_t) ((literal_len < 15 ? literal_len : 15) << 4);
+    if (literal_len >= 15) op = lz4_put_length(op, literal_len - 15);
+    memcpy(op, literals, literal_len);
+    op += literal_len;
+    if (0 == match_len) return op;
+
+    *op++ = (uint8_t) (offset & 0xFF);
+    *op++ = (uint8_t) (offset >> 8);
+    match_len -= LZ4_MIN_MATCH;
+    *token |= (uint8_t) (match_len < 15 ? match_len : 15);
+    if (match_len >= 15) op = lz4_put_length(op, match_len - 15);
+    return op;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static void CMN_CALL_C compress_chunk(size_t index, void *context)
+{
+    compress_job_t     *job   = (compress_job_t*) context;
+    compressed_chunk_t *chunk = &job->chunks[index];
+    uint8_t const      *src   = job->source + chunk->source_offset;
+    uint8_t            *dst   = job->scratch + index * job->stride;
+    size_t              size  = lz4_compress_block(src, chunk->source_size, dst, job->stride);
+    if (0 == size || size >= chunk->source_size)
+    {
+        // store the chunk uncompressed.
+        memcpy(dst, src, chunk->source_size);
+        size = chunk->source_size;
+    }
+    chunk->data_size = size;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+size_t lz4_compress_bound(size_t source_size)
+{
+    return source_size + (source_size / 255) + 16;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+size_t lz4_compress_block(
+    void const *source,
+    size_t      source_size,
+    void       *dest,
+    size_t      dest_size)
+{
+    uint32_t       table[1 << LZ4_HASH_BITS];
+    uint8_t const *src    = (uint8_t const*) source;
+    uint8_t       *op     = (uint8_t*) dest;
+    uint8_t       *op_end = op + dest_size;
+    size_t         ip     = 0;
+    size_t         anchor = 0;
+
+    if (source_size > LZ4_MF_LIMIT)
+    {
+        size_t mf_limit    = source_size - LZ4_MF_LIMIT;
+        size_t match_limit = source_size - LZ4_LAST_LITERALS;
+        size_t misses      = 0;
+        memset(table, 0, sizeof(table));
+        while (ip < mf_limit)
+        {
+            uint32_t seq = read_u32(src + ip);
+            uint32_t h   = lz4_hash(seq);
+            size_t   ref = table[h];
+            table[h]     = (uint32_t) ip;
+            if (ref >= ip || ip - ref > LZ4_MAX_OFFSET || read_u32(src + ref) != seq)
+            {
+                // skip ahead faster through data that isn't compressing.
+                ip += 1 + (misses++ >> 6);
+                continue;
+            }
+            size_t len = LZ4_MIN_MATCH;
+            while (ip + len < match_limit && src[ref + len] == src[ip + len])
+                ++len;
+            while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1])
+            {
+                --ip; --ref; ++len;
+            }
+            op = lz4_put_sequence(op, op_end, src + anchor, ip - anchor, ip - ref, len);
+            if (NULL == op) return 0;
+            ip    += len;
+            anchor = ip;
+            misses = 0;
+            if (ip - 2 < mf_limit)
+            {
+                table[lz4_hash(read_u32(src + ip - 2))] = (uint32_t) (ip - 2);
+            }
+        }
+    }
+    op = lz4_put_sequence(op, op_end, src + anchor, source_size - anchor, 0, 0);
+    if (NULL == op) return 0;
+    return (size_t) (op - (uint8_t*) dest);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+size_t lz4_decompress_block(
+    void const *source,
+    size_t      source_size,
+    void       *dest,
+    size_t      dest_size)
+{
+    uint8_t const *ip     = (uint8_t const*) source;
+    uint8_t const *ip_end = ip + source_size;
+    uint8_t       *op     = (uint8_t*) dest;
+    uint8_t       *op_end = op + dest_size;
+
+    while (ip < ip_end)
+    {
+        uint8_t token = *ip++;
+        size_t  len   = token >> 4;
+        if (15 == len)
+        {
+            uint8_t b;
+            do
+            {
+                if (ip >= ip_end) return 0;
+                b    = *ip++;
+                len += b;
+            } while (255 == b);
+        }
+        if ((size_t) (ip_end - ip) < len || (size_t) (op_end - op) < len)
+            return 0;
+        memcpy(op, ip, len);
+        ip += len;
+        op += len;
+        if (ip >= ip_end) break; // the final sequence has no match.
+
+        if (ip_end - ip < 2) return 0;
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (0 == offset || offset > (size_t) (op - (uint8_t*) dest))
+            return 0;
+
+        len = token & 15;
+        if (15 == len)
+        {
+            uint8_t b;
+            do
+            {
+                if (ip >= ip_end) return 0;
+                b    = *ip++;
+                len += b;
+            } while (255 == b);
+        }
+        len += LZ4_MIN_MATCH;
+        if ((size_t) (op_end - op) < len) return 0;
+        // byte-by-byte, since the match may overlap the output.
+        uint8_t const *match = op - offset;
+        for (size_t i = 0; i < len; ++i)
+            op[i] = match[i];
+        op += len;
+    }
+    return (size_t) (op - (uint8_t*) dest);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void compressed_data_init(compressed_data_t *out)
+{
+    if (out)
+    {
+        out->chunk_count = 0;
+        out->chunks      = NULL;
+        out->data_size   = 0;
+        out->data        = NULL;
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+bool compress_chunks(
+    void const        *source,
+    size_t             source_size,
+    size_t             chunk_size,
+    compressed_data_t *out)
+{
+    compress_job_t job;
+    size_t         count  = 0;
+    size_t         stride = 0;
+
+    compressed_data_init(out);
+    if (0 == chunk_size) chunk_size = COMPRESS_DEFAULT_CHUNK_SIZE;
+    count  = (source_size + chunk_size - 1) / chunk_size;
+    stride = lz4_compress_bound(CMN_MIN(chunk_size, source_size));
+    if (0 == count) return true;
+
+    out->chunks = (compressed_chunk_t*) malloc(count * sizeof(compressed_chunk_t));
+    job.scratch = (uint8_t*) malloc(count * stride);
+    if (NULL == out->chunks || NULL == job.scratch)
+    {
+        free(job.scratch);
+        compressed_data_free(out);
+        return false;
+    }
+    out->chunk_count = count;
+    for (size_t i = 0; i < count; ++i)
+    {
+        size_t offset = i * chunk_size;
+        out->chunks[i].source_offset = offset;
+        out->chunks[i].source_size   = CMN_MIN(chunk_size, source_size - offset);
+        out->chunks[i].data_offset   = 0;
+        out->chunks[i].data_size     = 0;
+    }
+    job.source = (uint8_t const*) source;
+    job.chunks = out->chunks;
+    job.stride = stride;
+    parallel_for(count, compress_chunk, &job);
+
+    // pack the chunks back-to-back in order.
+    for (size_t i = 0; i < count; ++i)
+    {
+        out->chunks[i].data_offset = out->data_size;
+        out->data_size += out->chunks[i].data_size;
+    }
+    out->data = (uint8_t*) malloc(out->data_size > 0 ? out->data_size : 1);
+    if (NULL == out->data)
+    {
+        free(job.scratch);
+        compressed_data_free(out);
+        return false;
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        memcpy(out->data + out->chunks[i].data_offset,
+               job.scratch + i * stride,
+               out->chunks[i].data_size);
+    }
+    free(job.scratch);
+    return true;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void compressed_data_free(compressed_data_t *data)
+{
+    if (data)
+    {
+        free(data->chunks);
+        free(data->data);
+        compressed_data_init(data);
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/*/////////////////////////////////////////////////////////////////////////////
+//    $Id$
+///////////////////////////////////////////////////////////////////////////80*/
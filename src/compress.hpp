@@ -0,0 +1,122 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Defines the interface to the lossless compressor used for level
+/// data. Data is split into fixed-size chunks, each compressed independently
+/// in the LZ4 block format so that any chunk can be decompressed on its own.
+///////////////////////////////////////////////////////////////////////////80*/
+#ifndef TEXTURE_COMPILER_COMPRESS_HPP_INCLUDED
+#define TEXTURE_COMPILER_COMPRESS_HPP_INCLUDED
+
+/*////////////////
+//   Includes   //
+////////////////*/
+#include "commondefs.hpp"
+
+/*///////////////////////
+//   Namespace Begin   //
+///////////////////////*/
+
+/*////////////////////////////
+//   Forward Declarations   //
+////////////////////////////*/
+
+/*//////////////////////////////////
+//   Public Types and Functions   //
+//////////////////////////////////*/
+/// Define the default size of an uncompressed chunk, in bytes.
+#ifndef COMPRESS_DEFAULT_CHUNK_SIZE
+#define COMPRESS_DEFAULT_CHUNK_SIZE 65536U
+#endif /* !defined(COMPRESS_DEFAULT_CHUNK_SIZE) */
+
+/// Define the smallest uncompressed chunk size accepted from the caller.
+/// Smaller chunks compress poorly and need a descriptor per few bytes.
+#ifndef COMPRESS_MIN_CHUNK_SIZE
+#define COMPRESS_MIN_CHUNK_SIZE     4096U
+#endif /* !defined(COMPRESS_MIN_CHUNK_SIZE) */
+
+/// Define the largest uncompressed chunk size accepted from the caller.
+#ifndef COMPRESS_MAX_CHUNK_SIZE
+#define COMPRESS_MAX_CHUNK_SIZE     (16U * 1024U * 1024U)
+#endif /* !defined(COMPRESS_MAX_CHUNK_SIZE) */
+
+/// Describes a single independently-decodable chunk of compressed data. A
+/// chunk that does not compress is stored as-is, in which case data_size is
+/// equal to source_size.
+struct compressed_chunk_t
+{
+    size_t   source_offset;     /// Offset of the chunk in the source data.
+    size_t   source_size;       /// Size of the uncompressed chunk, in bytes.
+    size_t   data_offset;       /// Offset of the chunk in the stored data.
+    size_t   data_size;         /// Size of the stored chunk, in bytes.
+};
+
+/// Stores the chunks of a compressed block of data, back-to-back.
+struct compressed_data_t
+{
+    size_t              chunk_count; /// The number of chunks.
+    compressed_chunk_t *chunks;      /// Descriptors for each chunk.
+    size_t              data_size;   /// Total size of the stored chunks.
+    uint8_t            *data;        /// The stored chunk data.
+};
+
+/// Computes the maximum size of an LZ4 block for a given input size.
+/// @param source_size The size of the uncompressed data, in bytes.
+/// @return The worst-case size of the compressed data, in bytes.
+CMN_PUBLIC size_t lz4_compress_bound(size_t source_size);
+
+/// Compresses data into a single LZ4 block (without a frame header.)
+/// @param source The data to compress.
+/// @param source_size The size of the data to compress, in bytes.
+/// @param dest The buffer to receive the compressed data.
+/// @param dest_size The capacity of @a dest, in bytes.
+/// @return The size of the compressed data, or 0 if it does not fit.
+CMN_PUBLIC size_t lz4_compress_block(
+    void const *source,
+    size_t      source_size,
+    void       *dest,
+    size_t      dest_size);
+
+/// Decompresses a single LZ4 block.
+/// @param source The compressed data.
+/// @param source_size The size of the compressed data, in bytes.
+/// @param dest The buffer to receive the decompressed data.
+/// @param dest_size The capacity of @a dest, in bytes.
+/// @return The size of the decompressed data, or 0 if the block is malformed
+/// or does not fit in @a dest.
+CMN_PUBLIC size_t lz4_decompress_block(
+    void const *source,
+    size_t      source_size,
+    void       *dest,
+    size_t      dest_size);
+
+/// Initializes a compressed_data_t structure to empty.
+/// @param out Pointer to the structure to initialize.
+CMN_PUBLIC void  compressed_data_init(compressed_data_t *out);
+
+/// Splits data into chunks and compresses each chunk independently. Chunks
+/// are compressed in parallel using all available processors.
+/// @param source The data to compress.
+/// @param source_size The size of the data to compress, in bytes.
+/// @param chunk_size The size of each uncompressed chunk, in bytes. The last
+/// chunk may be smaller. Data smaller than one chunk forms a single chunk,
+/// and needs no more scratch memory than its own compressed size.
+/// @param out The structure to populate. Free with compressed_data_free().
+/// @return true if successful, or false if memory could not be allocated.
+CMN_PUBLIC bool  compress_chunks(
+    void const        *source,
+    size_t             source_size,
+    size_t             chunk_size,
+    compressed_data_t *out);
+
+/// Frees the memory associated with compressed data.
+/// @param data Pointer to the structure to free.
+CMN_PUBLIC void  compressed_data_free(compressed_data_t *data);
+
+/*/////////////////////
+//   Namespace End   //
+/////////////////////*/
+
+#endif /* TEXTURE_COMPILER_COMPRESS_HPP_INCLUDED */
+
+/*/////////////////////////////////////////////////////////////////////////////
+//    $Id$
+///////////////////////////////////////////////////////////////////////////80*/
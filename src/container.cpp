@@ -0,0 +1,300 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implements the memory-mapped image container file reader.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////
+//   Includes   //
+////////////////*/
+#include <stdlib.h>
+#include <string.h>
+#include "container.hpp"
+
+#if CMN_IS_WINDOWS
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <sys/types.h>
+    #include <sys/stat.h>
+    #include <sys/mman.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+/*//////////////////////////
+//   Using Declarations   //
+//////////////////////////*/
+
+/*//////////////////////
+//   Implementation   //
+//////////////////////*/
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+#define NO_ERROR       ""
+#define CANNOT_OPEN    "Cannot open the container file."
+#define CANNOT_MAP     "Cannot map the container file into memory."
+#define BAD_SIZE       "The container file is too small to hold a header."
+#define BAD_MAGIC      "The container file has an invalid header signature."
+#define BAD_FORMAT     "The container header specifies an unknown format."
+#define BAD_EXTENTS    "The container header specifies invalid dimensions."
+#define BAD_LEVELS     "The container header specifies invalid mip-levels."
+#define BAD_IMAGE_SIZE "The container header image_size is inconsistent."
+#define TRUNCATED      "The container file is truncated."
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static bool map_file(char const *path, void **out_data, size_t *out_size)
+{
+#if CMN_IS_WINDOWS
+    HANDLE        file = INVALID_HANDLE_VALUE;
+    HANDLE        fmap = NULL;
+    LARGE_INTEGER size;
+    void         *view = NULL;
+
+    file = CreateFileA(
+        path, GENERIC_READ, FILE_SHARE_READ, NULL,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (INVALID_HANDLE_VALUE == file)
+        return false;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0 ||
+        (uint64_t) size.QuadPart > (uint64_t) SIZE_MAX)
+    {
+        CloseHandle(file);
+        return false;
+    }
+    // PAGE_WRITECOPY so that writes to the view go to private pages.
+    fmap = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    if (NULL == fmap)
+    {
+        CloseHandle(file);
+        return false;
+    }
+    view = MapViewOfFile(fmap, FILE_MAP_COPY, 0, 0, 0);
+    // the view keeps the mapping and the file open; we don't need the
+    // handles anymore, and UnmapViewOfFile() releases everything.
+    CloseHandle(fmap);
+    CloseHandle(file);
+    if (NULL == view)
+        return false;
+    *out_data = view;
+    *out_size = (size_t) size.QuadPart;
+    return true;
+#else
+    struct stat st;
+    void       *view = NULL;
+    int         fd   = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0 ||
+        (uint64_t) st.st_size > (uint64_t) SIZE_MAX)
+    {
+        close(fd);
+        return false;
+    }
+    // MAP_PRIVATE so that writes to the view go to private pages.
+    view = mmap(NULL, (size_t) st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    // the mapping holds its own reference to the file.
+    close(fd);
+    if (MAP_FAILED == view)
+        return false;
+    *out_data = view;
+    *out_size = (size_t) st.st_size;
+    return true;
+#endif
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static void unmap_file(void *data, size_t size)
+{
+#if CMN_IS_WINDOWS
+    CMN_UNUSED(size);
+    UnmapViewOfFile(data);
+#else
+    munmap(data, size);
+#endif
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void container_file_init(container_file_t *file)
+{
+    if (file)
+    {
+        image::header_t header;
+        memset(&header, 0, sizeof(image::header_t));
+        file->error_message = NO_ERROR;
+        file->file_data     = NULL;
+        file->file_size     = 0;
+        file->header        = NULL;
+        image::container_from_header(&header, &file->container);
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+bool container_header_validate(
+    image::header_t const *header,
+    uint64_t               data_size,
+    char const           **out_error)
+{
+    char const *error = NO_ERROR;
+    uint64_t    total = 0;
+    size_t      expected_size = 0;
+    size_t      max_levels    = 0;
+
+    if (data_size < sizeof(image::header_t))
+    {
+        error = BAD_SIZE;
+        goto invalid;
+    }
+    if (header->reserved[0] != 'I' || header->reserved[1] != 'M' ||
+        header->reserved[2] != 'G' || header->reserved[3] != 'C' ||
+        header->reserved[4] != 'F')
+    {
+        error = BAD_MAGIC;
+        goto invalid;
+    }
+    if (0 == image::channel_count(header->format))
+    {
+        error = BAD_FORMAT;
+        goto invalid;
+    }
+    if (0 == header->items  || 0 == header->width ||
+        0 == header->height || 0 == header->slices)
+    {
+        error = BAD_EXTENTS;
+        goto invalid;
+    }
+    if ((header->flags & image::ATTRIBUTES_CUBEMAP) &&
+        (header->width != header->height))
+    {
+        error = BAD_EXTENTS;
+        goto invalid;
+    }
+    max_levels = image::miplevel_count(
+        header->width,
+        header->height,
+        header->slices);
+    if (0 == header->levels || header->levels > max_levels)
+    {
+        error = BAD_LEVELS;
+        goto invalid;
+    }
+    // the image_size recorded in the header must match the size computed
+    // from the dimensions, otherwise the level offsets can't be trusted.
+    expected_size = image::image_size(
+        header->format,
+        header->flags,
+        header->items,
+        header->width,
+        header->height,
+        header->slices,
+        header->levels);
+    if (header->image_size != (uint64_t) expected_size)
+    {
+        error = BAD_IMAGE_SIZE;
+        goto invalid;
+    }
+    total = sizeof(image::header_t) + header->image_size;
+    if (total < header->image_size || total + header->atlas_size < total ||
+        total + header->atlas_size > data_size)
+    {
+        error = TRUNCATED;
+        goto invalid;
+    }
+    if (out_error) *out_error = NO_ERROR;
+    return true;
+
+invalid:
+    if (out_error) *out_error = error;
+    return false;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+bool container_file_open(char const *path, container_file_t *file)
+{
+    void   *data = NULL;
+    size_t  size = 0;
+
+    container_file_init(file);
+    if (NULL == path)
+    {
+        file->error_message = CANNOT_OPEN;
+        return false;
+    }
+    if (!map_file(path, &data, &size))
+    {
+        file->error_message = CANNOT_MAP;
+        return false;
+    }
+
+    image::header_t *header = (image::header_t*) data;
+    if (!container_header_validate(header, size, &file->error_message))
+    {
+        unmap_file(data, size);
+        return false;
+    }
+
+    uint8_t *base = (uint8_t*) data;
+    size_t   ofs  = sizeof(image::header_t);
+    file->file_data = data;
+    file->file_size = size;
+    file->header    = header;
+    image::container_from_header(header, &file->container);
+    file->container.alloc_base = data;
+    file->container.image_data = base + ofs;
+    if (file->container.atlas_size > 0)
+        file->container.atlas_data = base + ofs + file->container.image_size;
+    return true;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void* container_level_data(
+    container_file_t *file,
+    size_t            image_index,
+    size_t            cface_index,
+    size_t            level_index,
+    size_t           *out_offset,
+    size_t           *out_size)
+{
+    image::container_t *c = &file->container;
+    if (NULL == c->image_data)                        return NULL;
+    if (image_index >= c->items)                      return NULL;
+    if (cface_index >= image::face_count(c->flags))   return NULL;
+    if (level_index >= c->levels)                     return NULL;
+
+    int32_t  f  = c->format;
+    int32_t  a  = c->flags;
+    size_t   w  = c->width;
+    size_t   h  = c->height;
+    size_t   d  = c->slices;
+    size_t   m  = c->levels;
+    size_t   io = image::subimage_offset(f, a, w, h, d, m, image_index);
+    size_t   fo = image::subimage_face_offset(f, w, h, d, m, cface_index);
+    size_t   mo = image::miplevel_offset(f, w, h, d, level_index);
+    size_t   ms = image::miplevel_size(f, w, h, d, level_index);
+    uint8_t *bp = (uint8_t*) c->image_data;
+    if (out_offset) *out_offset = sizeof(image::header_t) + io + fo + mo;
+    if (out_size)   *out_size   = ms;
+    return (bp + io + fo + mo);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void container_file_close(container_file_t *file)
+{
+    if (file && file->file_data)
+    {
+        unmap_file(file->file_data, file->file_size);
+        container_file_init(file);
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/*/////////////////////////////////////////////////////////////////////////////
+//    $Id$
+///////////////////////////////////////////////////////////////////////////80*/
@@ -0,0 +1,96 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Defines the interface for reading image container files. A file
+/// is mapped into the address space of the process and its header validated,
+/// after which the image data can be accessed in-place without copying.
+///////////////////////////////////////////////////////////////////////////80*/
+#ifndef TEXTURE_COMPILER_CONTAINER_HPP_INCLUDED
+#define TEXTURE_COMPILER_CONTAINER_HPP_INCLUDED
+
+/*////////////////
+//   Includes   //
+////////////////*/
+#include "libimage.hpp"
+
+/*///////////////////////
+//   Namespace Begin   //
+///////////////////////*/
+
+/*////////////////////////////
+//   Forward Declarations   //
+////////////////////////////*/
+
+/*//////////////////////////////////
+//   Public Types and Functions   //
+//////////////////////////////////*/
+/// A structure representing an image container file mapped into memory. The
+/// image_data and atlas_data fields of the container point into the mapping.
+struct container_file_t
+{
+    char const        *error_message; /// Static error message string.
+    void              *file_data;     /// Start of the mapped file view.
+    size_t             file_size;     /// Size of the mapped view, in bytes.
+    image::header_t   *header;        /// The header at the start of the file.
+    image::container_t container;     /// Container fields read from header.
+};
+
+/// Initializes a container_file_t structure to default values.
+/// @param file Pointer to the structure to initialize.
+CMN_PUBLIC void  container_file_init(container_file_t *file);
+
+/// Checks an image container header against the amount of data available to
+/// make sure that the fields are consistent and that all of the image data
+/// described by the header is present.
+/// @param header The image container header to check.
+/// @param data_size The number of bytes available, including the header.
+/// @param out_error On return, points to a static string describing the
+/// problem with the header, if any. This parameter may be NULL.
+/// @return true if the header is valid.
+CMN_PUBLIC bool  container_header_validate(
+    image::header_t const *header,
+    uint64_t               data_size,
+    char const           **out_error);
+
+/// Maps an image container file into memory and validates its header. The
+/// file is mapped copy-on-write, so writes to the mapped data are private to
+/// the process and never reach the file on disk.
+/// @param path The path of the container file to open.
+/// @param file Pointer to the structure to populate. On failure, the
+/// error_message field is set to a static string describing the error.
+/// @return true if the file was mapped and its header is valid.
+CMN_PUBLIC bool  container_file_open(
+    char const       *path,
+    container_file_t *file);
+
+/// Retrieves a pointer to the data for a single slice of a mip-level within
+/// a mapped image container, without copying.
+/// @param file The mapped image container file.
+/// @param image_index The zero-based index of the item in the image array.
+/// @param cface_index The zero-based index of the face within the item.
+/// @param level_index The zero-based index of the mip-level within the face.
+/// @param out_offset On return, stores the byte offset of the level data from
+/// the start of the file. This parameter may be NULL.
+/// @param out_size On return, stores the size of the level data, in bytes.
+/// This parameter may be NULL.
+/// @return A pointer to the level data, or NULL if an index is out of range.
+CMN_PUBLIC void* container_level_data(
+    container_file_t *file,
+    size_t            image_index,
+    size_t            cface_index,
+    size_t            level_index,
+    size_t           *out_offset,
+    size_t           *out_size);
+
+/// Unmaps an image container file. Any pointers into the image data are
+/// invalid after this function returns.
+/// @param file Pointer to the mapped file to release.
+CMN_PUBLIC void  container_file_close(container_file_t *file);
+
+/*/////////////////////
+//   Namespace End   //
+/////////////////////*/
+
+#endif /* TEXTURE_COMPILER_CONTAINER_HPP_INCLUDED */
+
+/*/////////////////////////////////////////////////////////////////////////////
+//    $Id$
+///////////////////////////////////////////////////////////////////////////80*/
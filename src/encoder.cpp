@@ -0,0 +1,262 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implements the routines shared by all of the compressed texture
+/// format encoders, including parallel dispatch of blocks to an encoder.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////
+//   Includes   //
+////////////////*/
+#include <float.h>
+#include <stdlib.h>
+#include "encoder.hpp"
+#include "parallel.hpp"
+
+#if CMN_HAVE_SSE2
+    #include <emmintrin.h>
+#endif
+
+/*//////////////////////////
+//   Using Declarations   //
+//////////////////////////*/
+
+/*//////////////////////
+//   Implementation   //
+//////////////////////*/
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// The state shared by the threads encoding rows of blocks for an image.
+struct encode_job_t
+{
+    image::buffer_t *buffer;        /// The source image buffer.
+    size_t           block_w;       /// The block width, in texels.
+    size_t           block_h;       /// The block height, in texels.
+    size_t           block_size;    /// The size of an encoded block, in bytes.
+    size_t           blocks_x;      /// The number of blocks in each row.
+    encoder_block_fn encode;        /// The block encoder.
+    int32_t          quality;       /// One of encoder_quality_e.
+    uint8_t         *output;        /// The start of the block data.
+};
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static void CMN_CALL_C encode_block_row(size_t row, void *context)
+{
+    encode_job_t    *job = (encode_job_t*) context;
+    encoder_block_t  block;
+    uint8_t         *out = job->output + (row * job->blocks_x * job->block_size);
+    for (size_t bx = 0; bx < job->blocks_x; ++bx)
+    {
+        encoder_fetch_block(
+            job->buffer,
+            bx  * job->block_w,
+            row * job->block_h,
+            job->block_w,
+            job->block_h,
+            &block);
+        job->encode(&block, job->quality, out);
+        out += job->block_size;
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void encoder_fetch_block(
+    image::buffer_t *buffer,
+    size_t           block_x,
+    size_t           block_y,
+    size_t           block_w,
+    size_t           block_h,
+    encoder_block_t *out_block)
+{
+    size_t  width    = buffer->channel_width;
+    size_t  height   = buffer->channel_height;
+    size_t  channels = buffer->channel_count;
+    float  *src[4];
+
+    // map the buffer channels onto RGBA. NULL means 'use 1.0'.
+    switch (channels)
+    {
+        case 1:
+            src[0] = src[1] = src[2] = buffer->channels[0];
+            src[3] = NULL;
+            break;
+        case 2:
+            src[0] = src[1] = src[2] = buffer->channels[0];
+            src[3] = buffer->channels[1];
+            break;
+        case 3:
+            src[0] = buffer->channels[0];
+            src[1] = buffer->channels[1];
+            src[2] = buffer->channels[2];
+            src[3] = NULL;
+            break;
+        default:
+            src[0] = buffer->channels[0];
+            src[1] = buffer->channels[1];
+            src[2] = buffer->channels[2];
+            src[3] = buffer->channels[3];
+            break;
+    }
+
+    out_block->width  = block_w;
+    out_block->height = block_h;
+    out_block->count  = block_w * block_h;
+    for (size_t y = 0; y < block_h; ++y)
+    {
+        size_t sy = CMN_MIN(block_y + y, height - 1);
+        for (size_t x = 0; x < block_w; ++x)
+        {
+            size_t sx = CMN_MIN(block_x + x, width - 1);
+            size_t si = sy * width + sx;
+            size_t di = y  * block_w + x;
+            for (size_t c = 0; c < 4; ++c)
+            {
+                out_block->texels[c][di] = src[c] ? src[c][si] : 1.0f;
+            }
+        }
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void* encode_blocks(
+    image::buffer_t *buffer,
+    size_t           block_w,
+    size_t           block_h,
+    size_t           block_size,
+    encoder_block_fn encode,
+    int32_t          quality,
+    size_t          *out_size)
+{
+    size_t   blocks_x = (buffer->channel_width  + block_w - 1) / block_w;
+    size_t   blocks_y = (buffer->channel_height + block_h - 1) / block_h;
+    size_t   nbytes   = blocks_x * blocks_y * block_size;
+    uint8_t *output   = (uint8_t*) malloc(nbytes);
+    if (out_size) *out_size = 0;
+    if (NULL == output)
+        return NULL;
+
+    encode_job_t job;
+    job.buffer     = buffer;
+    job.block_w    = block_w;
+    job.block_h    = block_h;
+    job.block_size = block_size;
+    job.blocks_x   = blocks_x;
+    job.encode     = encode;
+    job.quality    = quality;
+    job.output     = output;
+    parallel_for(blocks_y, encode_block_row, &job);
+    if (out_size) *out_size = nbytes;
+    return output;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void decode_blocks(
+    void const       *data,
+    size_t            block_w,
+    size_t            block_h,
+    size_t            block_size,
+    encoder_decode_fn decode,
+    image::buffer_t  *target)
+{
+    size_t          width    = target->channel_width;
+    size_t          height   = target->channel_height;
+    size_t          channels = target->channel_count;
+    size_t          blocks_x = (width  + block_w - 1) / block_w;
+    size_t          blocks_y = (height + block_h - 1) / block_h;
+    uint8_t const  *in       = (uint8_t const*) data;
+    encoder_block_t block;
+    size_t          plane[4];
+
+    // the inverse of the mapping in encoder_fetch_block().
+    switch (channels)
+    {
+        case 1:  plane[0] = 0; break;
+        case 2:  plane[0] = 0; plane[1] = 3; break;
+        default: plane[0] = 0; plane[1] = 1; plane[2] = 2; plane[3] = 3; break;
+    }
+    channels = CMN_MIN(channels, (size_t) 4);
+
+    for (size_t by = 0; by < blocks_y; ++by)
+    {
+        for (size_t bx = 0; bx < blocks_x; ++bx)
+        {
+            decode(in, &block);
+            in += block_size;
+            for (size_t y = 0; y < block_h && by * block_h + y < height; ++y)
+            {
+                size_t row = (by * block_h + y) * width;
+                for (size_t x = 0; x < block_w && bx * block_w + x < width; ++x)
+                {
+                    size_t di = row + bx * block_w + x;
+                    size_t si = y * block_w + x;
+                    for (size_t c = 0; c < channels; ++c)
+                    {
+                        target->channels[c][di] = block.texels[plane[c]][si];
+                    }
+                }
+            }
+        }
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+float encoder_select_scalar(
+    float const *values,
+    float const *pal,
+    uint8_t     *index)
+{
+#if CMN_HAVE_SSE2
+    __m128 total = _mm_setzero_ps();
+    for (size_t i = 0; i < 16; i += 4)
+    {
+        __m128  v    = _mm_loadu_ps(&values[i]);
+        __m128  best = _mm_set1_ps(FLT_MAX);
+        __m128i bidx = _mm_setzero_si128();
+        for (size_t p = 0; p < 8; ++p)
+        {
+            __m128  d  = _mm_sub_ps(v, _mm_set1_ps(pal[p]));
+            __m128  d2 = _mm_mul_ps(d, d);
+            __m128i m  = _mm_castps_si128(_mm_cmplt_ps(d2, best));
+            best       = _mm_min_ps(d2, best);
+            bidx       = _mm_or_si128(
+                _mm_and_si128(m, _mm_set1_epi32((int) p)),
+                _mm_andnot_si128(m, bidx));
+        }
+        CMN_ALIGN_BEGIN(16) int32_t ix[4] CMN_ALIGN_END(16);
+        _mm_store_si128((__m128i*) ix, bidx);
+        index[i + 0] = (uint8_t) ix[0];
+        index[i + 1] = (uint8_t) ix[1];
+        index[i + 2] = (uint8_t) ix[2];
+        index[i + 3] = (uint8_t) ix[3];
+        total = _mm_add_ps(total, best);
+    }
+    CMN_ALIGN_BEGIN(16) float sum[4] CMN_ALIGN_END(16);
+    _mm_store_ps(sum, total);
+    return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+#else
+    float total = 0.0f;
+    for (size_t i = 0; i < 16; ++i)
+    {
+        float   best = FLT_MAX;
+        uint8_t bidx = 0;
+        for (size_t p = 0; p < 8; ++p)
+        {
+            float d = values[i] - pal[p];
+            if (d * d < best) { best = d * d; bidx = (uint8_t) p; }
+        }
+        index[i] = bidx;
+        total   += best;
+    }
+    return total;
+#endif
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/*/////////////////////////////////////////////////////////////////////////////
+//    $Id$
+///////////////////////////////////////////////////////////////////////////80*/
@@ -0,0 +1,429 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Defines the interface to the compressed texture format encoders.
+/// Each encoder converts an image buffer into an array of compressed blocks
+/// laid out in row-major order, suitable for compressedTexImage2D().
+///////////////////////////////////////////////////////////////////////////80*/
+#ifndef TEXTURE_COMPILER_ENCODER_HPP_INCLUDED
+#define TEXTURE_COMPILER_ENCODER_HPP_INCLUDED
+
+/*////////////////
+//   Includes   //
+////////////////*/
+#include "libimage.hpp"
+
+/*///////////////////////
+//   Namespace Begin   //
+///////////////////////*/
+
+/*////////////////////////////
+//   Forward Declarations   //
+////////////////////////////*/
+
+/*//////////////////////////////////
+//   Public Types and Functions   //
+//////////////////////////////////*/
+/// Define the maximum number of texels in a single compressed block.
+#ifndef ENCODER_MAX_BLOCK_TEXELS
+#define ENCODER_MAX_BLOCK_TEXELS    144U
+#endif /* !defined(ENCODER_MAX_BLOCK_TEXELS) */
+
+/// An enumeration defining the trade-off between encoding speed and quality
+/// made by the block encoders.
+enum encoder_quality_e
+{
+    ENCODER_QUALITY_FAST        = 0,  /// 'FAST'
+    ENCODER_QUALITY_NORMAL      = 1,  /// 'NORMAL' (default)
+    ENCODER_QUALITY_HIGH        = 2,  /// 'HIGH'
+    ENCODER_QUALITY_FORCE_32BIT = CMN_FORCE_32BIT
+};
+
+/// The texels of a single block, stored as four planes of RGBA values. Image
+/// buffers with fewer than four channels are expanded, so that a luminance
+/// value is replicated into RGB and a missing alpha channel is set to 1.0.
+/// Values are taken from the image buffer as-is, so LDR data is in [0, 1].
+struct encoder_block_t
+{
+    size_t  width;                            /// Block width, in texels.
+    size_t  height;                           /// Block height, in texels.
+    size_t  count;                            /// width * height.
+    float   texels[4][ENCODER_MAX_BLOCK_TEXELS]; /// R, G, B and A planes.
+};
+
+/// A function pointer type for a routine that encodes a single block.
+/// @param block The block of texels to encode.
+/// @param quality One of the encoder_quality_e values.
+/// @param out_data The location where the encoded block will be written.
+typedef void (CMN_CALL_C *encoder_block_fn)(
+    encoder_block_t const *block,
+    int32_t                quality,
+    void                  *out_data);
+
+/// A function pointer type for a routine that decodes a single block.
+/// @param data The encoded block.
+/// @param out_block The block structure to populate with the decoded texels,
+/// as four planes of RGBA values in [0, 1].
+typedef void (CMN_CALL_C *encoder_decode_fn)(
+    void const            *data,
+    encoder_block_t       *out_block);
+
+/// Reads a single block of texels from an image buffer. Texels that fall
+/// outside of the image are clamped to the nearest edge texel.
+/// @param buffer The source image buffer.
+/// @param block_x The x-coordinate of the upper-left texel of the block.
+/// @param block_y The y-coordinate of the upper-left texel of the block.
+/// @param block_w The block width, in texels.
+/// @param block_h The block height, in texels.
+/// @param out_block The block structure to populate.
+CMN_PUBLIC void  encoder_fetch_block(
+    image::buffer_t *buffer,
+    size_t           block_x,
+    size_t           block_y,
+    size_t           block_w,
+    size_t           block_h,
+    encoder_block_t *out_block);
+
+/// Encodes an image buffer into a row-major array of fixed-size blocks. Rows
+/// of blocks are encoded in parallel using all available processors.
+/// @param buffer The source image buffer.
+/// @param block_w The block width, in texels.
+/// @param block_h The block height, in texels.
+/// @param block_size The size of a single encoded block, in bytes.
+/// @param encode The routine used to encode each block.
+/// @param quality One of the encoder_quality_e values.
+/// @param out_size On return, stores the number of bytes of block data.
+/// @return A pointer to the block data, or NULL if memory could not be
+/// allocated. Free the returned memory using free_pixels().
+CMN_PUBLIC void* encode_blocks(
+    image::buffer_t *buffer,
+    size_t           block_w,
+    size_t           block_h,
+    size_t           block_size,
+    encoder_block_fn encode,
+    int32_t          quality,
+    size_t          *out_size);
+
+/// Decodes a row-major array of fixed-size blocks into an image buffer, for
+/// measuring the error of an encoding. Decoded RGBA values are mapped onto
+/// the channels of @a target in the same way encoder_fetch_block() maps the
+/// channels onto RGBA, and texels outside of the image are discarded.
+/// @param data The block data, as returned by encode_blocks().
+/// @param block_w The block width, in texels.
+/// @param block_h The block height, in texels.
+/// @param block_size The size of a single encoded block, in bytes.
+/// @param decode The routine used to decode each block.
+/// @param target The image buffer to populate. Its dimensions and channel
+/// count determine the layout of @a data.
+CMN_PUBLIC void  decode_blocks(
+    void const       *data,
+    size_t            block_w,
+    size_t            block_h,
+    size_t            block_size,
+    encoder_decode_fn decode,
+    image::buffer_t  *target);
+
+/// Finds the nearest entry of an 8-entry palette for each of 16 values. This
+/// is the inner loop of the interpolated alpha and EAC encoders, and uses
+/// SSE2 to process four values at a time if available.
+/// @param values The 16 values to match.
+/// @param palette The 8 palette entries.
+/// @param out_index On return, stores the palette index for each value.
+/// @return The total squared error.
+CMN_PUBLIC float encoder_select_scalar(
+    float const           *values,
+    float const           *palette,
+    uint8_t               *out_index);
+
+/// Encodes 16 scalar values in [0, 255] as an 8-byte interpolated block, as
+/// used for BC3 alpha and for the channels of BC4 and BC5.
+/// @param values The 16 values to encode, in row-major order.
+/// @param quality One of the encoder_quality_e values.
+/// @param out_data The location where the 8-byte block will be written.
+CMN_PUBLIC void  encode_scalar_block(
+    float const           *values,
+    int32_t                quality,
+    uint8_t               *out_data);
+
+/// Encodes a single 4x4 block in BC1 (DXT1) format. Only RGB is stored.
+/// @param block The block of texels to encode.
+/// @param quality One of the encoder_quality_e values.
+/// @param out_data The location where the 8-byte block will be written.
+CMN_PUBLIC void  CMN_CALL_C encode_block_bc1(
+    encoder_block_t const *block,
+    int32_t                quality,
+    void                  *out_data);
+
+/// Encodes a single 4x4 block in BC3 (DXT5) format.
+/// @param block The block of texels to encode.
+/// @param quality One of the encoder_quality_e values.
+/// @param out_data The location where the 16-byte block will be written.
+CMN_PUBLIC void  CMN_CALL_C encode_block_bc3(
+    encoder_block_t const *block,
+    int32_t                quality,
+    void                  *out_data);
+
+/// Encodes a single 4x4 block in BC4 format, storing the red channel.
+/// @param block The block of texels to encode.
+/// @param quality One of the encoder_quality_e values. ENCODER_QUALITY_HIGH
+/// performs an exhaustive endpoint search around the range of the block.
+/// @param out_data The location where the 8-byte block will be written.
+CMN_PUBLIC void  CMN_CALL_C encode_block_bc4(
+    encoder_block_t const *block,
+    int32_t                quality,
+    void                  *out_data);
+
+/// Encodes a single 4x4 block in BC5 format, storing the red and green
+/// channels as two independent BC4 blocks.
+/// @param block The block of texels to encode.
+/// @param quality One of the encoder_quality_e values.
+/// @param out_data The location where the 16-byte block will be written.
+CMN_PUBLIC void  CMN_CALL_C encode_block_bc5(
+    encoder_block_t const *block,
+    int32_t                quality,
+    void                  *out_data);
+
+/// Converts an image buffer to BC1 (DXT1) compressed blocks.
+/// @param buffer The buffer to convert.
+/// @param quality One of the encoder_quality_e values.
+/// @return A pointer to the block data. Free with free_pixels().
+CMN_PUBLIC void* buffer_to_blocks_bc1(image::buffer_t *buffer, int32_t quality);
+
+/// Converts an image buffer to BC3 (DXT5) compressed blocks.
+/// @param buffer The buffer to convert.
+/// @param quality One of the encoder_quality_e values.
+/// @return A pointer to the block data. Free with free_pixels().
+CMN_PUBLIC void* buffer_to_blocks_bc3(image::buffer_t *buffer, int32_t quality);
+
+/// Converts an image buffer to BC4 compressed blocks.
+/// @param buffer The buffer to convert.
+/// @param quality One of the encoder_quality_e values.
+/// @return A pointer to the block data. Free with free_pixels().
+CMN_PUBLIC void* buffer_to_blocks_bc4(image::buffer_t *buffer, int32_t quality);
+
+/// Converts an image buffer to BC5 compressed blocks. The first two channels
+/// are stored in red and green, including for two-channel buffers.
+/// @param buffer The buffer to convert.
+/// @param quality One of the encoder_quality_e values.
+/// @return A pointer to the block data. Free with free_pixels().
+CMN_PUBLIC void* buffer_to_blocks_bc5(image::buffer_t *buffer, int32_t quality);
+
+/// Decodes a single BC1 (DXT1) block. Alpha is always 1.0.
+/// @param data The 8-byte block to decode.
+/// @param out_block The block structure to populate.
+CMN_PUBLIC void  CMN_CALL_C decode_block_bc1(
+    void const            *data,
+    encoder_block_t       *out_block);
+
+/// Decodes a single BC3 (DXT5) block.
+/// @param data The 16-byte block to decode.
+/// @param out_block The block structure to populate.
+CMN_PUBLIC void  CMN_CALL_C decode_block_bc3(
+    void const            *data,
+    encoder_block_t       *out_block);
+
+/// Decodes a single BC4 block. The red channel is replicated into green and
+/// blue, and alpha is 1.0.
+/// @param data The 8-byte block to decode.
+/// @param out_block The block structure to populate.
+CMN_PUBLIC void  CMN_CALL_C decode_block_bc4(
+    void const            *data,
+    encoder_block_t       *out_block);
+
+/// Decodes a single BC5 block into red and green. Blue is 0.0 and alpha is
+/// 1.0, as read back by the GPU.
+/// @param data The 16-byte block to decode.
+/// @param out_block The block structure to populate.
+CMN_PUBLIC void  CMN_CALL_C decode_block_bc5(
+    void const            *data,
+    encoder_block_t       *out_block);
+
+/// Encodes a single 4x4 block in BC7 format. The number of modes and
+/// partitions searched is determined by the quality setting.
+/// @param block The block of texels to encode.
+/// @param quality One of the encoder_quality_e values.
+/// @param out_data The location where the 16-byte block will be written.
+CMN_PUBLIC void  CMN_CALL_C encode_block_bc7(
+    encoder_block_t const *block,
+    int32_t                quality,
+    void                  *out_data);
+
+/// Converts an image buffer to BC7 compressed blocks.
+/// @param buffer The buffer to convert.
+/// @param quality One of the encoder_quality_e values.
+/// @return A pointer to the block data. Free with free_pixels().
+CMN_PUBLIC void* buffer_to_blocks_bc7(image::buffer_t *buffer, int32_t quality);
+
+/// Encodes a single 4x4 block in BC6H unsigned float format. Values are
+/// taken from the image buffer without clamping, except that negative
+/// values are stored as zero. Only RGB is stored.
+/// @param block The block of texels to encode.
+/// @param quality One of the encoder_quality_e values.
+/// @param out_data The location where the 16-byte block will be written.
+CMN_PUBLIC void  CMN_CALL_C encode_block_bc6h_uf16(
+    encoder_block_t const *block,
+    int32_t                quality,
+    void                  *out_data);
+
+/// Encodes a single 4x4 block in BC6H signed float format. Only RGB is
+/// stored.
+/// @param block The block of texels to encode.
+/// @param quality One of the encoder_quality_e values.
+/// @param out_data The location where the 16-byte block will be written.
+CMN_PUBLIC void  CMN_CALL_C encode_block_bc6h_sf16(
+    encoder_block_t const *block,
+    int32_t                quality,
+    void                  *out_data);
+
+/// Converts an image buffer to BC6H unsigned float compressed blocks.
+/// @param buffer The buffer to convert.
+/// @param quality One of the encoder_quality_e values. ENCODER_QUALITY_FAST
+/// uses a single block mode without refinement, for iteration builds.
+/// @return A pointer to the block data. Free with free_pixels().
+CMN_PUBLIC void* buffer_to_blocks_bc6h_uf16(image::buffer_t *buffer, int32_t quality);
+
+/// Converts an image buffer to BC6H signed float compressed blocks.
+/// @param buffer The buffer to convert.
+/// @param quality One of the encoder_quality_e values.
+/// @return A pointer to the block data. Free with free_pixels().
+CMN_PUBLIC void* buffer_to_blocks_bc6h_sf16(image::buffer_t *buffer, int32_t quality);
+
+/// Encodes a single 4x4 block in ETC1 format. Only RGB is stored.
+/// @param block The block of texels to encode.
+/// @param quality One of the encoder_quality_e values.
+/// @param out_data The location where the 8-byte block will be written.
+CMN_PUBLIC void  CMN_CALL_C encode_block_etc1(
+    encoder_block_t const *block,
+    int32_t                quality,
+    void                  *out_data);
+
+/// Encodes a single 4x4 block in ETC2 RGB8 format. Only RGB is stored.
+/// @param block The block of texels to encode.
+/// @param quality One of the encoder_quality_e values.
+/// @param out_data The location where the 8-byte block will be written.
+CMN_PUBLIC void  CMN_CALL_C encode_block_etc2_rgb(
+    encoder_block_t const *block,
+    int32_t                quality,
+    void                  *out_data);
+
+/// Encodes a single 4x4 block in ETC2 RGBA8 format, with EAC alpha.
+/// @param block The block of texels to encode.
+/// @param quality One of the encoder_quality_e values.
+/// @param out_data The location where the 16-byte block will be written.
+CMN_PUBLIC void  CMN_CALL_C encode_block_etc2_rgba(
+    encoder_block_t const *block,
+    int32_t                quality,
+    void                  *out_data);
+
+/// Converts an image buffer to ETC1 compressed blocks.
+/// @param buffer The buffer to convert.
+/// @param quality One of the encoder_quality_e values.
+/// @return A pointer to the block data. Free with free_pixels().
+CMN_PUBLIC void* buffer_to_blocks_etc1(image::buffer_t *buffer, int32_t quality);
+
+/// Converts an image buffer to ETC2 RGB8 compressed blocks.
+/// @param buffer The buffer to convert.
+/// @param quality One of the encoder_quality_e values.
+/// @return A pointer to the block data. Free with free_pixels().
+CMN_PUBLIC void* buffer_to_blocks_etc2_rgb(image::buffer_t *buffer, int32_t quality);
+
+/// Converts an image buffer to ETC2 RGBA8 compressed blocks with EAC alpha.
+/// @param buffer The buffer to convert.
+/// @param quality One of the encoder_quality_e values.
+/// @return A pointer to the block data. Free with free_pixels().
+CMN_PUBLIC void* buffer_to_blocks_etc2_rgba(image::buffer_t *buffer, int32_t quality);
+
+/// Encodes a single 4x4 block in the ETC1S intermediate format: an ETC1
+/// block in differential mode with a zero delta and the same modifier table
+/// in both halves. Only RGB is stored.
+/// @param block The block of texels to encode.
+/// @param quality One of the encoder_quality_e values.
+/// @param out_data The location where the 8-byte block will be written.
+CMN_PUBLIC void  CMN_CALL_C encode_block_etc1s(
+    encoder_block_t const *block,
+    int32_t                quality,
+    void                  *out_data);
+
+/// Encodes a single 4x4 block in the ETC1S intermediate format with alpha.
+/// The alpha channel is stored as a second ETC1S block, with alpha in each
+/// of R, G and B, preceding the color block.
+/// @param block The block of texels to encode.
+/// @param quality One of the encoder_quality_e values.
+/// @param out_data The location where the 16-byte block will be written.
+CMN_PUBLIC void  CMN_CALL_C encode_block_etc1s_rgba(
+    encoder_block_t const *block,
+    int32_t                quality,
+    void                  *out_data);
+
+/// Converts an image buffer to ETC1S intermediate blocks.
+/// @param buffer The buffer to convert.
+/// @param quality One of the encoder_quality_e values.
+/// @return A pointer to the block data. Free with free_pixels().
+CMN_PUBLIC void* buffer_to_blocks_etc1s(image::buffer_t *buffer, int32_t quality);
+
+/// Converts an image buffer to ETC1S intermediate blocks with alpha.
+/// @param buffer The buffer to convert.
+/// @param quality One of the encoder_quality_e values.
+/// @return A pointer to the block data. Free with free_pixels().
+CMN_PUBLIC void* buffer_to_blocks_etc1s_rgba(image::buffer_t *buffer, int32_t quality);
+
+/// Encodes a single block in ASTC LDR format. The block footprint is taken
+/// from the block dimensions, and must be 4x4, 6x6 or 8x8. Opaque blocks
+/// store RGB endpoints and translucent blocks store RGBA endpoints.
+/// @param block The block of texels to encode.
+/// @param quality One of the encoder_quality_e values. ENCODER_QUALITY_FAST
+/// tries a single weight grid, while ENCODER_QUALITY_HIGH tries every grid
+/// with additional refinement.
+/// @param out_data The location where the 16-byte block will be written.
+CMN_PUBLIC void  CMN_CALL_C encode_block_astc(
+    encoder_block_t const *block,
+    int32_t                quality,
+    void                  *out_data);
+
+/// Converts an image buffer to ASTC LDR compressed blocks.
+/// @param buffer The buffer to convert.
+/// @param block_w The block footprint width, in texels (4, 6 or 8.)
+/// @param block_h The block footprint height, in texels (4, 6 or 8.)
+/// @param quality One of the encoder_quality_e values.
+/// @return A pointer to the block data. Free with free_pixels().
+CMN_PUBLIC void* buffer_to_blocks_astc(
+    image::buffer_t *buffer,
+    size_t           block_w,
+    size_t           block_h,
+    int32_t          quality);
+
+/// Converts an image buffer to PVRTC 2bpp or 4bpp data. The image should
+/// have square, power-of-two dimensions; levels smaller than the minimum
+/// PVRTC size (16x8 for 2bpp, 8x8 for 4bpp) are padded.
+/// @param buffer The buffer to convert.
+/// @param bits_per_pixel Either 2 or 4.
+/// @param quality One of the encoder_quality_e values, which determines the
+/// number of refinement passes.
+/// @param out_size On return, stores the number of bytes of PVRTC data.
+/// @return A pointer to the PVRTC data, with blocks in twiddled order, or
+/// NULL if memory could not be allocated. Free with free_pixels().
+CMN_PUBLIC void* buffer_to_pvrtc(
+    image::buffer_t *buffer,
+    size_t           bits_per_pixel,
+    int32_t          quality,
+    size_t          *out_size);
+
+/// Converts an image buffer to PVRTC 2bpp data (image::FORMAT_PVRTC1).
+/// @param buffer The buffer to convert.
+/// @param quality One of the encoder_quality_e values.
+/// @return A pointer to the PVRTC data. Free with free_pixels().
+CMN_PUBLIC void* buffer_to_blocks_pvrtc2(image::buffer_t *buffer, int32_t quality);
+
+/// Converts an image buffer to PVRTC 4bpp data (image::FORMAT_PVRTC2).
+/// @param buffer The buffer to convert.
+/// @param quality One of the encoder_quality_e values.
+/// @return A pointer to the PVRTC data. Free with free_pixels().
+CMN_PUBLIC void* buffer_to_blocks_pvrtc4(image::buffer_t *buffer, int32_t quality);
+
+/*/////////////////////
+//   Namespace End   //
+/////////////////////*/
+
+#endif /* TEXTURE_COMPILER_ENCODER_HPP_INCLUDED */
+
+/*/////////////////////////////////////////////////////////////////////////////
+//    $Id$
+///////////////////////////////////////////////////////////////////////////80*/
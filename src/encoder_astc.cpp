@@ -0,0 +1,599 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implements an encoder for the LDR profile of the ASTC block
+/// format with 4x4, 6x6 and 8x8 block footprints. Blocks are encoded with a
+/// single partition and a single weight plane, using the direct RGB or RGBA
+/// color endpoint modes with 8-bit endpoints. The block is fit against one or
+/// more candidate weight grids, which may be smaller than the footprint and
+/// are bilinearly interpolated by the decoder.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////
+//   Includes   //
+////////////////*/
+#include <float.h>
+#include <math.h>
+#include <string.h>
+#include "encoder.hpp"
+
+/*//////////////////////////
+//   Using Declarations   //
+//////////////////////////*/
+
+/*//////////////////////
+//   Implementation   //
+//////////////////////*/
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+#define ASTC_MAX_WEIGHTS        64
+#define ASTC_CEM_LDR_RGB        8     /// LDR RGB, direct.
+#define ASTC_CEM_LDR_RGBA       12    /// LDR RGBA, direct.
+
+/// Describes a weight grid. Only weight ranges that are stored as plain bits
+/// are used, and the grids are chosen so that the remaining space in the
+/// block always selects 8-bit color endpoints.
+struct astc_grid_t
+{
+    size_t  width;                    /// The number of weights across.
+    size_t  height;                   /// The number of weights down.
+    size_t  bits;                     /// The bits per weight, 1 through 5.
+};
+
+/// The weight grids tried for opaque and translucent blocks at each block
+/// footprint, best first. Opaque blocks may use up to 63 bits of weights
+/// and translucent blocks up to 47, leaving room for six or eight 8-bit
+/// endpoint values alongside the 17 bits of block configuration.
+static astc_grid_t const ASTC_GRIDS_4x4_RGB[]  =
+{
+    { 4, 4, 3 }
+};
+static astc_grid_t const ASTC_GRIDS_4x4_RGBA[] =
+{
+    { 4, 4, 2 }
+};
+static astc_grid_t const ASTC_GRIDS_6x6_RGB[]  =
+{
+    { 6, 5, 2 }, { 5, 6, 2 }, { 5, 4, 3 }, { 4, 5, 3 }, { 5, 5, 2 }, { 4, 4, 3 }
+};
+static astc_grid_t const ASTC_GRIDS_6x6_RGBA[] =
+{
+    { 5, 4, 2 }, { 4, 5, 2 }, { 6, 5, 1 }, { 5, 6, 1 }, { 4, 4, 2 }
+};
+static astc_grid_t const ASTC_GRIDS_8x8_RGB[]  =
+{
+    { 6, 5, 2 }, { 5, 6, 2 }, { 5, 4, 3 }, { 4, 5, 3 }, { 7, 4, 2 }, { 4, 7, 2 },
+    { 8, 5, 1 }, { 5, 8, 1 }
+};
+static astc_grid_t const ASTC_GRIDS_8x8_RGBA[] =
+{
+    { 5, 4, 2 }, { 4, 5, 2 }, { 8, 5, 1 }, { 5, 8, 1 }, { 7, 5, 1 }, { 5, 7, 1 },
+    { 4, 4, 2 }
+};
+
+/// The amount of work done for each block at each quality setting.
+struct astc_budget_t
+{
+    size_t  grids;                    /// The number of weight grids to try.
+    size_t  refine;                   /// Least-squares refinement passes.
+    bool    polish;                   /// Adjust individual weights?
+};
+
+static astc_budget_t const ASTC_BUDGETS[3] =
+{
+    { 1,  1, false },                 /// ENCODER_QUALITY_FAST
+    { 2,  2, false },                 /// ENCODER_QUALITY_NORMAL
+    { 8,  3, true  }                  /// ENCODER_QUALITY_HIGH
+};
+
+/// The contribution of the weight grid to each texel of the block. Each
+/// texel is interpolated from up to four grid weights, with weights in
+/// sixteenths, as specified by the ASTC weight infill procedure.
+struct astc_infill_t
+{
+    uint8_t index[ENCODER_MAX_BLOCK_TEXELS][4];
+    uint8_t weight[ENCODER_MAX_BLOCK_TEXELS][4];
+};
+
+/// A candidate encoding of a block.
+struct astc_block_t
+{
+    astc_grid_t const *grid;          /// The weight grid.
+    size_t             channels;      /// 3 (CEM 8) or 4 (CEM 12).
+    int                endpoint[2][4];/// The 8-bit endpoints.
+    uint8_t            weights[ASTC_MAX_WEIGHTS]; /// Quantized grid weights.
+    float              error;         /// The total squared error.
+};
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static inline int clamp_int(int v, int lo, int hi)
+{
+    return (v < lo) ? lo : ((v > hi) ? hi : v);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Expands a quantized weight to the range [0, 64] by bit replication.
+static inline int astc_unquantize_weight(int q, size_t bits)
+{
+    int v = 0;
+    switch (bits)
+    {
+        case 1: v = q ? 63 : 0;                     break;
+        case 2: v = (q << 4) | (q << 2) | q;        break;
+        case 3: v = (q << 3) | q;                   break;
+        case 4: v = (q << 2) | (q >> 2);            break;
+        case 5: v = (q << 1) | (q >> 4);            break;
+        default:                                    break;
+    }
+    return (v > 32) ? v + 1 : v;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Computes the 11-bit block mode for a single-plane grid. Grids must be at
+/// most 11 wide and 5 high, or at most 5 wide and 11 high.
+static uint32_t astc_block_mode(astc_grid_t const *grid)
+{
+    static uint32_t const range_r[6] = { 0, 2, 4, 7, 4, 7 };
+    static uint32_t const range_h[6] = { 0, 0, 0, 0, 1, 1 };
+    uint32_t r  = range_r[grid->bits];
+    uint32_t gw = (uint32_t) grid->width;
+    uint32_t gh = (uint32_t) grid->height;
+    uint32_t m  = ((r >> 1) & 1) | (((r >> 2) & 1) << 1) | ((r & 1) << 4) |
+                  (range_h[grid->bits] << 9);
+
+    if (gw >= 4 && gw <= 7  && gh <= 5)  m |= (0 << 2) | ((gw - 4) << 7) | ((gh - 2) << 5);
+    else if (gw >= 8 && gh <= 5)         m |= (1 << 2) | ((gw - 8) << 7) | ((gh - 2) << 5);
+    else if (gh >= 8 && gw <= 5)         m |= (2 << 2) | ((gh - 8) << 7) | ((gw - 2) << 5);
+    else if (gh >= 6 && gw <= 5)         m |= (3 << 2) | ((gh - 6) << 7) | ((gw - 2) << 5);
+    else                                 m |= (3 << 2) | (1 << 8) | ((gw - 2) << 7) | ((gh - 2) << 5);
+    return m;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Builds the texel weight infill table for a grid on a block footprint.
+static void astc_build_infill(
+    astc_grid_t const *grid,
+    size_t             block_w,
+    size_t             block_h,
+    astc_infill_t     *out)
+{
+    int ds = (1024 + (int) block_w / 2) / ((int) block_w - 1);
+    int dt = (1024 + (int) block_h / 2) / ((int) block_h - 1);
+    int gw = (int) grid->width;
+    int gh = (int) grid->height;
+    for (size_t t = 0; t < block_h; ++t)
+    {
+        for (size_t s = 0; s < block_w; ++s)
+        {
+            size_t i   = t * block_w + s;
+            int    gs  = (ds * (int) s * (gw - 1) + 32) >> 6;
+            int    gt  = (dt * (int) t * (gh - 1) + 32) >> 6;
+            int    js  = gs >> 4, fs = gs & 0xF;
+            int    jt  = gt >> 4, ft = gt & 0xF;
+            int    js1 = (js + 1 < gw) ? js + 1 : js;
+            int    jt1 = (jt + 1 < gh) ? jt + 1 : jt;
+            int    w11 = (fs * ft + 8) >> 4;
+            out->index [i][0] = (uint8_t) (jt  * gw + js);
+            out->index [i][1] = (uint8_t) (jt  * gw + js1);
+            out->index [i][2] = (uint8_t) (jt1 * gw + js);
+            out->index [i][3] = (uint8_t) (jt1 * gw + js1);
+            out->weight[i][0] = (uint8_t) (16 - fs - ft + w11);
+            out->weight[i][1] = (uint8_t) (fs - w11);
+            out->weight[i][2] = (uint8_t) (ft - w11);
+            out->weight[i][3] = (uint8_t) (w11);
+        }
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Computes the decoded weight, in [0, 64], of every texel of the block.
+static void astc_texel_weights(
+    astc_block_t const  *blk,
+    astc_infill_t const *infill,
+    size_t               count,
+    int                 *out_weights)
+{
+    int grid[ASTC_MAX_WEIGHTS];
+    size_t n = blk->grid->width * blk->grid->height;
+    for (size_t j = 0; j < n; ++j)
+    {
+        grid[j] = astc_unquantize_weight(blk->weights[j], blk->grid->bits);
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint8_t const *x = infill->index[i];
+        uint8_t const *w = infill->weight[i];
+        out_weights[i]   = (grid[x[0]] * w[0] + grid[x[1]] * w[1] +
+                            grid[x[2]] * w[2] + grid[x[3]] * w[3] + 8) >> 4;
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Computes the error of a candidate exactly as the decoder reconstructs it,
+/// with 8-bit endpoints expanded to 16 bits before interpolation.
+static float astc_evaluate(
+    astc_block_t const    *blk,
+    astc_infill_t const   *infill,
+    encoder_block_t const *block,
+    float const           (*texels)[ENCODER_MAX_BLOCK_TEXELS])
+{
+    int    w[ENCODER_MAX_BLOCK_TEXELS];
+    float  error = 0.0f;
+    astc_texel_weights(blk, infill, block->count, w);
+    for (size_t c = 0; c < blk->channels; ++c)
+    {
+        int e0 = blk->endpoint[0][c] * 257;
+        int e1 = blk->endpoint[1][c] * 257;
+        for (size_t i = 0; i < block->count; ++i)
+        {
+            int   v = (e0 * (64 - w[i]) + e1 * w[i] + 32) >> 6;
+            float d = (float) v * (1.0f / 257.0f) - texels[c][i];
+            error  += d * d;
+        }
+    }
+    return error;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Quantizes the ideal texel weights onto the grid. Each grid weight is the
+/// average of the texels it contributes to, weighted by its contribution.
+static void astc_quantize_grid(
+    astc_block_t        *blk,
+    astc_infill_t const *infill,
+    size_t               count,
+    float const         *ideal)
+{
+    float  sum[ASTC_MAX_WEIGHTS];
+    float  den[ASTC_MAX_WEIGHTS];
+    size_t n      = blk->grid->width * blk->grid->height;
+    float  levels = (float) ((1 << blk->grid->bits) - 1);
+    for (size_t j = 0; j < n; ++j)
+    {
+        sum[j] = 0.0f;
+        den[j] = 0.0f;
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        for (size_t k = 0; k < 4; ++k)
+        {
+            float w = (float) infill->weight[i][k];
+            sum[infill->index[i][k]] += w * ideal[i];
+            den[infill->index[i][k]] += w;
+        }
+    }
+    for (size_t j = 0; j < n; ++j)
+    {
+        float u = (den[j] > 0.0f) ? sum[j] / den[j] : 0.5f;
+        blk->weights[j] = (uint8_t) clamp_int((int) floorf(u * levels + 0.5f), 0, (int) levels);
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Projects each texel onto the segment between the (unrounded) endpoints,
+/// producing the ideal weight in [0, 1] for each texel.
+static void astc_ideal_weights(
+    float const  *e0,
+    float const  *e1,
+    size_t        channels,
+    size_t        count,
+    float const (*texels)[ENCODER_MAX_BLOCK_TEXELS],
+    float        *out_ideal)
+{
+    float d[4]  = { 0.0f, 0.0f, 0.0f, 0.0f };
+    float dd    = 0.0f;
+    for (size_t c = 0; c < channels; ++c)
+    {
+        d[c] = e1[c] - e0[c];
+        dd  += d[c] * d[c];
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        float t = 0.0f;
+        if (dd > 0.0f)
+        {
+            for (size_t c = 0; c < channels; ++c)
+                t += (texels[c][i] - e0[c]) * d[c];
+            t /= dd;
+        }
+        out_ideal[i] = (t < 0.0f) ? 0.0f : ((t > 1.0f) ? 1.0f : t);
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Rounds floating-point endpoints to 8 bits.
+static void astc_round_endpoints(
+    astc_block_t *blk,
+    float const  *e0,
+    float const  *e1)
+{
+    for (size_t c = 0; c < 4; ++c)
+    {
+        blk->endpoint[0][c] = clamp_int((int) floorf(e0[c] + 0.5f), 0, 255);
+        blk->endpoint[1][c] = clamp_int((int) floorf(e1[c] + 0.5f), 0, 255);
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Fits a block to a single weight grid.
+static void astc_fit(
+    encoder_block_t const *block,
+    float const          (*texels)[ENCODER_MAX_BLOCK_TEXELS],
+    size_t                 channels,
+    astc_grid_t const     *grid,
+    astc_budget_t const   *budget,
+    astc_block_t          *out)
+{
+    astc_infill_t infill;
+    float         ideal[ENCODER_MAX_BLOCK_TEXELS];
+    int           tw[ENCODER_MAX_BLOCK_TEXELS];
+    float         mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    float         axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    float         cov[4][4];
+    float         e0[4], e1[4];
+    size_t        count = block->count;
+    float         inv_n = 1.0f / (float) count;
+
+    astc_build_infill(grid, block->width, block->height, &infill);
+    memset(out, 0, sizeof(astc_block_t));
+    out->grid     = grid;
+    out->channels = channels;
+    // alpha is always stored as 255 for opaque blocks.
+    out->endpoint[0][3] = 255;
+    out->endpoint[1][3] = 255;
+
+    // principal axis of the block by power iteration on the covariance.
+    for (size_t c = 0; c < channels; ++c)
+    {
+        for (size_t i = 0; i < count; ++i)
+            mean[c] += texels[c][i];
+        mean[c] *= inv_n;
+    }
+    for (size_t a = 0; a < channels; ++a)
+    {
+        for (size_t b = 0; b < channels; ++b)
+        {
+            float s = 0.0f;
+            for (size_t i = 0; i < count; ++i)
+                s += (texels[a][i] - mean[a]) * (texels[b][i] - mean[b]);
+            cov[a][b] = s;
+        }
+    }
+    for (size_t iter = 0; iter < 8; ++iter)
+    {
+        float next[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        float len     = 0.0f;
+        for (size_t a = 0; a < channels; ++a)
+        {
+            for (size_t b = 0; b < channels; ++b)
+                next[a] += cov[a][b] * axis[b];
+            len = (fabsf(next[a]) > len) ? fabsf(next[a]) : len;
+        }
+        if (len <= FLT_EPSILON) break;
+        for (size_t a = 0; a < channels; ++a)
+            axis[a] = next[a] / len;
+    }
+    {
+        float tmin = FLT_MAX, tmax = -FLT_MAX, al = 0.0f;
+        for (size_t c = 0; c < channels; ++c)
+            al += axis[c] * axis[c];
+        for (size_t i = 0; i < count; ++i)
+        {
+            float t = 0.0f;
+            for (size_t c = 0; c < channels; ++c)
+                t += (texels[c][i] - mean[c]) * axis[c];
+            tmin = (t < tmin) ? t : tmin;
+            tmax = (t > tmax) ? t : tmax;
+        }
+        if (al > 0.0f) { tmin /= al; tmax /= al; }
+        for (size_t c = 0; c < 4; ++c)
+        {
+            e0[c] = (c < channels) ? mean[c] + axis[c] * tmin : 255.0f;
+            e1[c] = (c < channels) ? mean[c] + axis[c] * tmax : 255.0f;
+        }
+    }
+
+    astc_ideal_weights(e0, e1, channels, count, texels, ideal);
+    astc_quantize_grid(out, &infill, count, ideal);
+    astc_round_endpoints(out, e0, e1);
+
+    // alternate between solving for the endpoints given the interpolated
+    // texel weights, and requantizing the weights given the endpoints.
+    for (size_t pass = 0; pass < budget->refine; ++pass)
+    {
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f, det;
+        astc_texel_weights(out, &infill, count, tw);
+        for (size_t i = 0; i < count; ++i)
+        {
+            float b = (float) tw[i] * (1.0f / 64.0f);
+            float a = 1.0f - b;
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+        }
+        det = aa * bb - ab * ab;
+        if (fabsf(det) <= FLT_EPSILON) break;
+        det = 1.0f / det;
+        for (size_t c = 0; c < channels; ++c)
+        {
+            float ax = 0.0f, bx = 0.0f;
+            for (size_t i = 0; i < count; ++i)
+            {
+                float b = (float) tw[i] * (1.0f / 64.0f);
+                ax += (1.0f - b) * texels[c][i];
+                bx += b * texels[c][i];
+            }
+            e0[c] = (bb * ax - ab * bx) * det;
+            e1[c] = (aa * bx - ab * ax) * det;
+        }
+        astc_block_t trial = *out;
+        astc_ideal_weights(e0, e1, channels, count, texels, ideal);
+        astc_quantize_grid(&trial, &infill, count, ideal);
+        astc_round_endpoints(&trial, e0, e1);
+        trial.error = astc_evaluate(&trial, &infill, block, texels);
+        out->error  = astc_evaluate(out,    &infill, block, texels);
+        if (trial.error < out->error) *out = trial;
+    }
+
+    // nudge each grid weight up or down while that reduces the error.
+    out->error = astc_evaluate(out, &infill, block, texels);
+    if (budget->polish)
+    {
+        size_t n   = grid->width * grid->height;
+        int    top = (1 << grid->bits) - 1;
+        for (size_t j = 0; j < n; ++j)
+        {
+            for (int dir = -1; dir <= 1; dir += 2)
+            {
+                int q = (int) out->weights[j] + dir;
+                if (q < 0 || q > top) continue;
+                astc_block_t trial = *out;
+                trial.weights[j]   = (uint8_t) q;
+                trial.error        = astc_evaluate(&trial, &infill, block, texels);
+                if (trial.error < out->error) *out = trial;
+            }
+        }
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static inline void astc_put_bits(uint8_t *out, size_t pos, uint32_t value, size_t count)
+{
+    for (size_t i = 0; i < count; ++i, ++pos)
+    {
+        if (value & (1U << i)) out[pos >> 3] |= (uint8_t) (1U << (pos & 7));
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Writes a candidate as a 128-bit ASTC block.
+static void astc_write_block(astc_block_t *blk, uint8_t *out)
+{
+    astc_grid_t const *grid = blk->grid;
+    size_t             n    = grid->width * grid->height;
+    int                top  = (1 << grid->bits) - 1;
+    int                s0   = 0;
+    int                s1   = 0;
+    size_t             pos  = 17;
+
+    // the decoder applies blue-contraction and swaps the endpoints when the
+    // second endpoint is darker than the first; order them to avoid that.
+    for (size_t c = 0; c < 3; ++c)
+    {
+        s0 += blk->endpoint[0][c];
+        s1 += blk->endpoint[1][c];
+    }
+    if (s1 < s0)
+    {
+        for (size_t c = 0; c < 4; ++c)
+        {
+            int t = blk->endpoint[0][c];
+            blk->endpoint[0][c] = blk->endpoint[1][c];
+            blk->endpoint[1][c] = t;
+        }
+        for (size_t j = 0; j < n; ++j)
+            blk->weights[j] = (uint8_t) (top - blk->weights[j]);
+    }
+
+    memset(out, 0, 16);
+    astc_put_bits(out, 0,  astc_block_mode(grid), 11);
+    astc_put_bits(out, 11, 0, 2); // one partition
+    astc_put_bits(out, 13, (blk->channels == 4) ? ASTC_CEM_LDR_RGBA : ASTC_CEM_LDR_RGB, 4);
+    for (size_t c = 0; c < blk->channels; ++c)
+    {
+        astc_put_bits(out, pos, (uint32_t) blk->endpoint[0][c], 8); pos += 8;
+        astc_put_bits(out, pos, (uint32_t) blk->endpoint[1][c], 8); pos += 8;
+    }
+    // weights are stored bit-reversed, starting from the top of the block.
+    for (size_t j = 0; j < n; ++j)
+    {
+        for (size_t b = 0; b < grid->bits; ++b)
+        {
+            size_t bit = 127 - (j * grid->bits + b);
+            if (blk->weights[j] & (1U << b)) out[bit >> 3] |= (uint8_t) (1U << (bit & 7));
+        }
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void CMN_CALL_C encode_block_astc(
+    encoder_block_t const *block,
+    int32_t                quality,
+    void                  *out_data)
+{
+    float                texels[4][ENCODER_MAX_BLOCK_TEXELS];
+    astc_budget_t const *budget = &ASTC_BUDGETS[clamp_int(quality, 0, 2)];
+    astc_grid_t   const *grids  = NULL;
+    size_t               ngrids = 0;
+    size_t               chans  = 3;
+    astc_block_t         best;
+    astc_block_t         trial;
+
+    for (size_t c = 0; c < 4; ++c)
+    {
+        for (size_t i = 0; i < block->count; ++i)
+        {
+            float v = block->texels[c][i] * 255.0f;
+            texels[c][i] = (v < 0.0f) ? 0.0f : ((v > 255.0f) ? 255.0f : v);
+            if (c == 3 && texels[c][i] < 254.5f) chans = 4;
+        }
+    }
+
+#define ASTC_SELECT_GRIDS(list)                                                \
+    grids  = list;                                                             \
+    ngrids = sizeof(list) / sizeof(list[0])
+
+    if (block->width == 4 && block->height == 4)
+    {
+        if (chans == 4) { ASTC_SELECT_GRIDS(ASTC_GRIDS_4x4_RGBA); }
+        else            { ASTC_SELECT_GRIDS(ASTC_GRIDS_4x4_RGB);  }
+    }
+    else if (block->width == 6 && block->height == 6)
+    {
+        if (chans == 4) { ASTC_SELECT_GRIDS(ASTC_GRIDS_6x6_RGBA); }
+        else            { ASTC_SELECT_GRIDS(ASTC_GRIDS_6x6_RGB);  }
+    }
+    else
+    {
+        if (chans == 4) { ASTC_SELECT_GRIDS(ASTC_GRIDS_8x8_RGBA); }
+        else            { ASTC_SELECT_GRIDS(ASTC_GRIDS_8x8_RGB);  }
+    }
+#undef ASTC_SELECT_GRIDS
+
+    if (ngrids > budget->grids) ngrids = budget->grids;
+    astc_fit(block, texels, chans, &grids[0], budget, &best);
+    for (size_t g = 1; g < ngrids && best.error > 0.0f; ++g)
+    {
+        astc_fit(block, texels, chans, &grids[g], budget, &trial);
+        if (trial.error < best.error) best = trial;
+    }
+    astc_write_block(&best, (uint8_t*) out_data);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void* buffer_to_blocks_astc(
+    image::buffer_t *buffer,
+    size_t           block_w,
+    size_t           block_h,
+    int32_t          quality)
+{
+    return encode_blocks(buffer, block_w, block_h, 16, encode_block_astc, quality, NULL);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/*/////////////////////////////////////////////////////////////////////////////
+//    $Id$
+///////////////////////////////////////////////////////////////////////////80*/
@@ -0,0 +1,895 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implements encoders for the S3TC/DXT and RGTC (BC4/BC5) families
+/// of block-compressed formats. Color endpoints are found with a principal
+/// component fit, refined with a least-squares solve and, for high-quality
+/// output, a local search in the quantized endpoint space. Scalar endpoints
+/// are refined greedily or found by exhaustive search around the value range.
+/// Texel-to-palette matching uses SSE2 if present.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////
+//   Includes   //
+////////////////*/
+#include <float.h>
+#include <math.h>
+#include <string.h>
+#include "encoder.hpp"
+
+#if CMN_HAVE_SSE2
+    #include <emmintrin.h>
+#endif
+
+/*//////////////////////////
+//   Using Declarations   //
+//////////////////////////*/
+
+/*//////////////////////
+//   Implementation   //
+//////////////////////*/
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+#define BC_BLOCK_TEXELS     16
+
+/// A 4x4 block of RGB values stored as planes, with values in [0, 255].
+struct bc_color_block_t
+{
+    float   r[BC_BLOCK_TEXELS];
+    float   g[BC_BLOCK_TEXELS];
+    float   b[BC_BLOCK_TEXELS];
+};
+
+/// A candidate encoding of a BC1 color block.
+struct bc_color_fit_t
+{
+    uint16_t c0;                        /// The first RGB565 endpoint.
+    uint16_t c1;                        /// The second RGB565 endpoint.
+    bool     four;                      /// true for 4-color mode.
+    float    error;                     /// The squared error of the fit.
+    uint8_t  index[BC_BLOCK_TEXELS];    /// Palette index for each texel.
+};
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static inline float clamp_255(float v)
+{
+    v = v * 255.0f;
+    if (v <   0.0f) return   0.0f;
+    if (v > 255.0f) return 255.0f;
+    return v;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static inline int quantize_bits(float v, int max_value)
+{
+    int q = (int) (v * max_value / 255.0f + 0.5f);
+    if (q < 0)         return 0;
+    if (q > max_value) return max_value;
+    return q;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static inline uint16_t pack_565(float const *rgb)
+{
+    int r = quantize_bits(rgb[0], 31);
+    int g = quantize_bits(rgb[1], 63);
+    int b = quantize_bits(rgb[2], 31);
+    return (uint16_t) ((r << 11) | (g << 5) | b);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static inline void unpack_565(uint16_t c, float *rgb)
+{
+    int r = (c >> 11) & 0x1F;
+    int g = (c >>  5) & 0x3F;
+    int b = (c >>  0) & 0x1F;
+    rgb[0] = (float) ((r << 3) | (r >> 2));
+    rgb[1] = (float) ((g << 2) | (g >> 4));
+    rgb[2] = (float) ((b << 3) | (b >> 2));
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static void color_palette(uint16_t c0, uint16_t c1, bool four, float pal[4][3])
+{
+    unpack_565(c0, pal[0]);
+    unpack_565(c1, pal[1]);
+    for (size_t i = 0; i < 3; ++i)
+    {
+        if (four)
+        {
+            pal[2][i] = (2.0f * pal[0][i] + pal[1][i]) / 3.0f;
+            pal[3][i] = (pal[0][i] + 2.0f * pal[1][i]) / 3.0f;
+        }
+        else
+        {
+            pal[2][i] = (pal[0][i] + pal[1][i]) * 0.5f;
+            pal[3][i] =  0.0f;
+        }
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Finds the nearest palette entry for each texel and returns the total
+/// squared error. The 4-wide SSE2 path processes four texels at a time.
+static float select_color_indices(
+    bc_color_block_t const *block,
+    float                   pal[4][3],
+    size_t                  npal,
+    uint8_t                *index)
+{
+#if CMN_HAVE_SSE2
+    __m128 total = _mm_setzero_ps();
+    for (size_t i = 0; i < BC_BLOCK_TEXELS; i += 4)
+    {
+        __m128  r    = _mm_loadu_ps(&block->r[i]);
+        __m128  g    = _mm_loadu_ps(&block->g[i]);
+        __m128  b    = _mm_loadu_ps(&block->b[i]);
+        __m128  best = _mm_set1_ps(FLT_MAX);
+        __m128i bidx = _mm_setzero_si128();
+        for (size_t p = 0; p < npal; ++p)
+        {
+            __m128  dr   = _mm_sub_ps(r, _mm_set1_ps(pal[p][0]));
+            __m128  dg   = _mm_sub_ps(g, _mm_set1_ps(pal[p][1]));
+            __m128  db   = _mm_sub_ps(b, _mm_set1_ps(pal[p][2]));
+            __m128  d    = _mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+            __m128i m    = _mm_castps_si128(_mm_cmplt_ps(d, best));
+            __m128i pi   = _mm_set1_epi32((int) p);
+            best         = _mm_min_ps(d, best);
+            bidx         = _mm_or_si128(_mm_and_si128(m, pi), _mm_andnot_si128(m, bidx));
+        }
+        CMN_ALIGN_BEGIN(16) int32_t ix[4] CMN_ALIGN_END(16);
+        _mm_store_si128((__m128i*) ix, bidx);
+        index[i + 0] = (uint8_t) ix[0];
+        index[i + 1] = (uint8_t) ix[1];
+        index[i + 2] = (uint8_t) ix[2];
+        index[i + 3] = (uint8_t) ix[3];
+        total = _mm_add_ps(total, best);
+    }
+    CMN_ALIGN_BEGIN(16) float sum[4] CMN_ALIGN_END(16);
+    _mm_store_ps(sum, total);
+    return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+#else
+    float total = 0.0f;
+    for (size_t i = 0; i < BC_BLOCK_TEXELS; ++i)
+    {
+        float   best = FLT_MAX;
+        uint8_t bidx = 0;
+        for (size_t p = 0; p < npal; ++p)
+        {
+            float dr = block->r[i] - pal[p][0];
+            float dg = block->g[i] - pal[p][1];
+            float db = block->b[i] - pal[p][2];
+            float d  = dr * dr + dg * dg + db * db;
+            if (d < best) { best = d; bidx = (uint8_t) p; }
+        }
+        index[i] = bidx;
+        total   += best;
+    }
+    return total;
+#endif
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static void evaluate_color_fit(
+    bc_color_block_t const *block,
+    bc_color_fit_t         *fit)
+{
+    float pal[4][3];
+    color_palette(fit->c0, fit->c1, fit->four, pal);
+    fit->error = select_color_indices(block, pal, fit->four ? 4 : 3, fit->index);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Computes endpoints along the principal axis of the block colors.
+static void principal_endpoints(
+    bc_color_block_t const *block,
+    float                  *e0,
+    float                  *e1)
+{
+    float mean[3] = { 0.0f, 0.0f, 0.0f };
+    float cov[6]  = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    for (size_t i = 0; i < BC_BLOCK_TEXELS; ++i)
+    {
+        mean[0] += block->r[i];
+        mean[1] += block->g[i];
+        mean[2] += block->b[i];
+    }
+    mean[0] /= BC_BLOCK_TEXELS;
+    mean[1] /= BC_BLOCK_TEXELS;
+    mean[2] /= BC_BLOCK_TEXELS;
+    for (size_t i = 0; i < BC_BLOCK_TEXELS; ++i)
+    {
+        float r  = block->r[i] - mean[0];
+        float g  = block->g[i] - mean[1];
+        float b  = block->b[i] - mean[2];
+        cov[0]  += r * r; cov[1] += r * g; cov[2] += r * b;
+        cov[3]  += g * g; cov[4] += g * b; cov[5] += b * b;
+    }
+
+    // power iteration to find the dominant eigenvector.
+    float axis[3] = { 1.0f, 1.0f, 1.0f };
+    for (size_t iter = 0; iter < 8; ++iter)
+    {
+        float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+        float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+        float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+        float m = CMN_MAX(fabsf(x), CMN_MAX(fabsf(y), fabsf(z)));
+        if (m < FLT_EPSILON) break;
+        axis[0] = x / m; axis[1] = y / m; axis[2] = z / m;
+    }
+    float len2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+    float tmin = 0.0f;
+    float tmax = 0.0f;
+    for (size_t i = 0; i < BC_BLOCK_TEXELS; ++i)
+    {
+        float t = (block->r[i] - mean[0]) * axis[0] +
+                  (block->g[i] - mean[1]) * axis[1] +
+                  (block->b[i] - mean[2]) * axis[2];
+        if (t < tmin) tmin = t;
+        if (t > tmax) tmax = t;
+    }
+    if (len2 > FLT_EPSILON)
+    {
+        tmin /= len2;
+        tmax /= len2;
+    }
+    for (size_t i = 0; i < 3; ++i)
+    {
+        e0[i] = mean[i] + axis[i] * tmax;
+        e1[i] = mean[i] + axis[i] * tmin;
+        e0[i] = CMN_MAX(0.0f, CMN_MIN(255.0f, e0[i]));
+        e1[i] = CMN_MAX(0.0f, CMN_MIN(255.0f, e1[i]));
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Solves for the endpoints minimizing the squared error given fixed indices.
+/// @return false if the system is singular (all texels use one weight.)
+static bool least_squares_endpoints(
+    bc_color_block_t const *block,
+    bc_color_fit_t const   *fit,
+    float                  *e0,
+    float                  *e1)
+{
+    static float const w4[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+    static float const w3[4] = { 1.0f, 0.0f, 0.5f, 0.0f };
+    float const *w   = fit->four ? w4 : w3;
+    float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+    float ax[3] = { 0.0f, 0.0f, 0.0f };
+    float bx[3] = { 0.0f, 0.0f, 0.0f };
+    for (size_t i = 0; i < BC_BLOCK_TEXELS; ++i)
+    {
+        float a = w[fit->index[i]];
+        float b = 1.0f - a;
+        aa += a * a; ab += a * b; bb += b * b;
+        ax[0] += a * block->r[i]; bx[0] += b * block->r[i];
+        ax[1] += a * block->g[i]; bx[1] += b * block->g[i];
+        ax[2] += a * block->b[i]; bx[2] += b * block->b[i];
+    }
+    float det = aa * bb - ab * ab;
+    if (fabsf(det) < 1e-6f)
+        return false;
+    float inv = 1.0f / det;
+    for (size_t i = 0; i < 3; ++i)
+    {
+        e0[i] = (ax[i] * bb - bx[i] * ab) * inv;
+        e1[i] = (bx[i] * aa - ax[i] * ab) * inv;
+        e0[i] = CMN_MAX(0.0f, CMN_MIN(255.0f, e0[i]));
+        e1[i] = CMN_MAX(0.0f, CMN_MIN(255.0f, e1[i]));
+    }
+    return true;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static void refine_least_squares(
+    bc_color_block_t const *block,
+    bc_color_fit_t         *fit,
+    size_t                  iterations)
+{
+    for (size_t iter = 0; iter < iterations; ++iter)
+    {
+        bc_color_fit_t trial = *fit;
+        float          e0[3];
+        float          e1[3];
+        if (!least_squares_endpoints(block, fit, e0, e1))
+            break;
+        trial.c0 = pack_565(e0);
+        trial.c1 = pack_565(e1);
+        if (trial.c0 == fit->c0 && trial.c1 == fit->c1)
+            break;
+        evaluate_color_fit(block, &trial);
+        if (trial.error >= fit->error)
+            break;
+        *fit = trial;
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static inline uint16_t step_565(uint16_t c, size_t channel, int delta)
+{
+    static int const shift[3] = { 11, 5, 0 };
+    static int const limit[3] = { 31, 63, 31 };
+    int v = (c >> shift[channel]) & limit[channel];
+    v    += delta;
+    if (v < 0 || v > limit[channel]) return c;
+    c     = (uint16_t) (c & ~(limit[channel] << shift[channel]));
+    return (uint16_t) (c | (v << shift[channel]));
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Greedy search of the quantized endpoint neighborhood. Each candidate is
+/// scored with the vectorized index selection.
+static void refine_local_search(
+    bc_color_block_t const *block,
+    bc_color_fit_t         *fit)
+{
+    for (size_t pass = 0; pass < 16; ++pass)
+    {
+        bool improved = false;
+        for (size_t e = 0; e < 2; ++e)
+        {
+            for (size_t c = 0; c < 3; ++c)
+            {
+                for (int d = -1; d <= 1; d += 2)
+                {
+                    bc_color_fit_t trial = *fit;
+                    if (0 == e) trial.c0 = step_565(fit->c0, c, d);
+                    else        trial.c1 = step_565(fit->c1, c, d);
+                    if (trial.c0 == fit->c0 && trial.c1 == fit->c1)
+                        continue;
+                    evaluate_color_fit(block, &trial);
+                    if (trial.error < fit->error)
+                    {
+                        *fit     = trial;
+                        improved = true;
+                    }
+                }
+            }
+        }
+        if (!improved) break;
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static void fit_color_block(
+    bc_color_block_t const *block,
+    int32_t                 quality,
+    bool                    allow_three,
+    bc_color_fit_t         *out_fit)
+{
+    bc_color_fit_t fit;
+    float          e0[3];
+    float          e1[3];
+
+    principal_endpoints(block, e0, e1);
+    fit.c0   = pack_565(e0);
+    fit.c1   = pack_565(e1);
+    fit.four = true;
+    evaluate_color_fit(block, &fit);
+
+    if (quality >= ENCODER_QUALITY_NORMAL)
+    {
+        refine_least_squares(block, &fit, quality >= ENCODER_QUALITY_HIGH ? 8 : 2);
+    }
+    if (quality >= ENCODER_QUALITY_HIGH)
+    {
+        refine_local_search(block, &fit);
+        if (allow_three)
+        {
+            // 3-color mode can represent some blocks better, since the
+            // midpoint is exact. index 3 is never selected for opaque data.
+            bc_color_fit_t three = fit;
+            three.four = false;
+            evaluate_color_fit(block, &three);
+            refine_least_squares(block, &three, 8);
+            refine_local_search (block, &three);
+            if (three.error < fit.error)
+                fit = three;
+        }
+    }
+    *out_fit = fit;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Writes a fitted color block, ordering the endpoints as required by the
+/// mode: c0 > c1 selects 4-color mode and c0 <= c1 selects 3-color mode.
+static void write_color_block(bc_color_fit_t *fit, uint8_t *out)
+{
+    uint16_t c0 = fit->c0;
+    uint16_t c1 = fit->c1;
+    if (c0 == c1)
+    {
+        // both modes decode index 0 as c0.
+        memset(fit->index, 0, sizeof(fit->index));
+    }
+    else if ((fit->four && c0 < c1) || (!fit->four && c0 > c1))
+    {
+        // swap the endpoints; indices 0/1 swap, and in 4-color mode
+        // indices 2/3 swap as well. in 3-color mode 2 is the midpoint.
+        c0 = fit->c1;
+        c1 = fit->c0;
+        for (size_t i = 0; i < BC_BLOCK_TEXELS; ++i)
+        {
+            if (fit->four || fit->index[i] < 2)
+                fit->index[i] ^= 1;
+        }
+    }
+    uint32_t bits = 0;
+    for (size_t i = 0; i < BC_BLOCK_TEXELS; ++i)
+    {
+        bits |= (uint32_t) fit->index[i] << (2 * i);
+    }
+    out[0] = (uint8_t) (c0 & 0xFF);
+    out[1] = (uint8_t) (c0 >> 8);
+    out[2] = (uint8_t) (c1 & 0xFF);
+    out[3] = (uint8_t) (c1 >> 8);
+    out[4] = (uint8_t) ((bits >>  0) & 0xFF);
+    out[5] = (uint8_t) ((bits >>  8) & 0xFF);
+    out[6] = (uint8_t) ((bits >> 16) & 0xFF);
+    out[7] = (uint8_t) ((bits >> 24) & 0xFF);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static void color_block_from_texels(
+    encoder_block_t const *block,
+    bc_color_block_t      *out_block)
+{
+    for (size_t i = 0; i < BC_BLOCK_TEXELS; ++i)
+    {
+        out_block->r[i] = clamp_255(block->texels[0][i]);
+        out_block->g[i] = clamp_255(block->texels[1][i]);
+        out_block->b[i] = clamp_255(block->texels[2][i]);
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static void scalar_palette(int a0, int a1, float *pal)
+{
+    pal[0] = (float) a0;
+    pal[1] = (float) a1;
+    if (a0 > a1)
+    {
+        // 8-value mode; six interpolated values.
+        for (int i = 2; i < 8; ++i)
+            pal[i] = ((8 - i) * a0 + (i - 1) * a1) / 7.0f;
+    }
+    else
+    {
+        // 6-value mode; four interpolated values plus 0 and 255.
+        for (int i = 2; i < 6; ++i)
+            pal[i] = ((6 - i) * a0 + (i - 1) * a1) / 5.0f;
+        pal[6] =   0.0f;
+        pal[7] = 255.0f;
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static float evaluate_scalar_fit(
+    float const *values,
+    int          a0,
+    int          a1,
+    uint8_t     *index)
+{
+    float pal[8];
+    scalar_palette(a0, a1, pal);
+    return encoder_select_scalar(values, pal, index);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static inline int round_255(float v)
+{
+    int i = (int) (v + 0.5f);
+    return CMN_MAX(0, CMN_MIN(255, i));
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// The state of the endpoint search for a scalar block.
+struct bc_scalar_fit_t
+{
+    int     a0;                         /// The first endpoint.
+    int     a1;                         /// The second endpoint.
+    float   error;                      /// The squared error of the fit.
+    uint8_t index[BC_BLOCK_TEXELS];     /// Palette index for each value.
+};
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static inline bool try_scalar_fit(
+    float const     *values,
+    int              a0,
+    int              a1,
+    bc_scalar_fit_t *best)
+{
+    uint8_t index[BC_BLOCK_TEXELS];
+    float   error = evaluate_scalar_fit(values, a0, a1, index);
+    if (error < best->error)
+    {
+        best->a0    = a0;
+        best->a1    = a1;
+        best->error = error;
+        memcpy(best->index, index, sizeof(index));
+        return true;
+    }
+    return false;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Greedy search of the endpoint neighborhood, keeping the current mode.
+static void scalar_local_search(
+    float const     *values,
+    bc_scalar_fit_t *fit,
+    size_t           passes)
+{
+    for (size_t pass = 0; pass < passes && fit->error > 0.0f; ++pass)
+    {
+        bool improved = false;
+        for (int e = 0; e < 2; ++e)
+        {
+            for (int d = -1; d <= 1; d += 2)
+            {
+                int t0 = fit->a0 + (0 == e ? d : 0);
+                int t1 = fit->a1 + (1 == e ? d : 0);
+                if (t0 < 0 || t0 > 255 || t1 < 0 || t1 > 255)
+                    continue;
+                if ((fit->a0 > fit->a1) != (t0 > t1))
+                    continue;
+                if (try_scalar_fit(values, t0, t1, fit))
+                    improved = true;
+            }
+        }
+        if (!improved) break;
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Tries every endpoint pair within a window around the value range, in both
+/// the 8-value (a0 > a1) and 6-value (a0 <= a1) modes.
+static void scalar_exhaustive_search(
+    float const     *values,
+    float            lo8,
+    float            hi8,
+    float            lo6,
+    float            hi6,
+    bc_scalar_fit_t *fit)
+{
+    static int const window = 8;
+    for (int mode = 0; mode < 2 && fit->error > 0.0f; ++mode)
+    {
+        int lo  = round_255(0 == mode ? lo8 : lo6);
+        int hi  = round_255(0 == mode ? hi8 : hi6);
+        int l0  = CMN_MAX(lo - window, 0);
+        int l1  = CMN_MIN(lo + window, 255);
+        int h0  = CMN_MAX(hi - window, 0);
+        int h1  = CMN_MIN(hi + window, 255);
+        for (int h = h0; h <= h1; ++h)
+        {
+            for (int l = l0; l <= l1; ++l)
+            {
+                if (0 == mode && h > l)  try_scalar_fit(values, h, l, fit);
+                if (1 == mode && l <= h) try_scalar_fit(values, l, h, fit);
+            }
+        }
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void encode_scalar_block(float const *values, int32_t quality, uint8_t *out)
+{
+    bc_scalar_fit_t fit;
+    float           vmin = values[0];
+    float           vmax = values[0];
+    for (size_t i = 1; i < BC_BLOCK_TEXELS; ++i)
+    {
+        vmin = CMN_MIN(vmin, values[i]);
+        vmax = CMN_MAX(vmax, values[i]);
+    }
+
+    // 8-value mode with the range endpoints; requires a0 > a1.
+    fit.a0    = round_255(vmax);
+    fit.a1    = round_255(vmin);
+    fit.error = 0.0f;
+    if (fit.a0 == fit.a1)
+    {
+        memset(fit.index, 0, sizeof(fit.index));
+    }
+    else
+    {
+        fit.error = evaluate_scalar_fit(values, fit.a0, fit.a1, fit.index);
+    }
+
+    if (fit.error > 0.0f && quality >= ENCODER_QUALITY_NORMAL)
+    {
+        // 6-value mode covers the range of values excluding exact 0 and
+        // 255, which it represents exactly. requires a0 <= a1.
+        float imin = 255.0f;
+        float imax =   0.0f;
+        for (size_t i = 0; i < BC_BLOCK_TEXELS; ++i)
+        {
+            if (values[i] >= 0.5f && values[i] < 254.5f)
+            {
+                imin = CMN_MIN(imin, values[i]);
+                imax = CMN_MAX(imax, values[i]);
+            }
+        }
+        if (imin > imax) { imin = 0.0f; imax = 255.0f; }
+
+        if (quality >= ENCODER_QUALITY_HIGH)
+        {
+            scalar_exhaustive_search(values, vmin, vmax, imin, imax, &fit);
+        }
+        else
+        {
+            try_scalar_fit(values, round_255(imin), round_255(imax), &fit);
+            scalar_local_search(values, &fit, 2);
+        }
+    }
+
+    uint64_t bits = 0;
+    for (size_t i = 0; i < BC_BLOCK_TEXELS; ++i)
+    {
+        bits |= (uint64_t) fit.index[i] << (3 * i);
+    }
+    out[0] = (uint8_t) fit.a0;
+    out[1] = (uint8_t) fit.a1;
+    for (size_t i = 0; i < 6; ++i)
+    {
+        out[2 + i] = (uint8_t) ((bits >> (8 * i)) & 0xFF);
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void CMN_CALL_C encode_block_bc1(
+    encoder_block_t const *block,
+    int32_t                quality,
+    void                  *out_data)
+{
+    bc_color_block_t color;
+    bc_color_fit_t   fit;
+    color_block_from_texels(block, &color);
+    fit_color_block(&color, quality, true, &fit);
+    write_color_block(&fit, (uint8_t*) out_data);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void CMN_CALL_C encode_block_bc3(
+    encoder_block_t const *block,
+    int32_t                quality,
+    void                  *out_data)
+{
+    bc_color_block_t color;
+    bc_color_fit_t   fit;
+    float            alpha[BC_BLOCK_TEXELS];
+    uint8_t         *out = (uint8_t*) out_data;
+    for (size_t i = 0; i < BC_BLOCK_TEXELS; ++i)
+    {
+        alpha[i] = clamp_255(block->texels[3][i]);
+    }
+    encode_scalar_block(alpha, quality, out);
+
+    // the BC3 color block is always decoded in 4-color mode.
+    color_block_from_texels(block, &color);
+    fit_color_block(&color, quality, false, &fit);
+    write_color_block(&fit, out + 8);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void CMN_CALL_C encode_block_bc4(
+    encoder_block_t const *block,
+    int32_t                quality,
+    void                  *out_data)
+{
+    float values[BC_BLOCK_TEXELS];
+    for (size_t i = 0; i < BC_BLOCK_TEXELS; ++i)
+    {
+        values[i] = clamp_255(block->texels[0][i]);
+    }
+    encode_scalar_block(values, quality, (uint8_t*) out_data);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void CMN_CALL_C encode_block_bc5(
+    encoder_block_t const *block,
+    int32_t                quality,
+    void                  *out_data)
+{
+    float    values[BC_BLOCK_TEXELS];
+    uint8_t *out = (uint8_t*) out_data;
+    for (size_t c = 0; c < 2; ++c)
+    {
+        for (size_t i = 0; i < BC_BLOCK_TEXELS; ++i)
+        {
+            values[i] = clamp_255(block->texels[c][i]);
+        }
+        encode_scalar_block(values, quality, out + (c * 8));
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Encodes a BC5 block from a two-channel buffer. encoder_fetch_block() maps
+/// the second channel to alpha, which is stored as green.
+static void CMN_CALL_C encode_block_bc5_la(
+    encoder_block_t const *block,
+    int32_t                quality,
+    void                  *out_data)
+{
+    static size_t const planes[2] = { 0, 3 };
+    float    values[BC_BLOCK_TEXELS];
+    uint8_t *out = (uint8_t*) out_data;
+    for (size_t c = 0; c < 2; ++c)
+    {
+        for (size_t i = 0; i < BC_BLOCK_TEXELS; ++i)
+        {
+            values[i] = clamp_255(block->texels[planes[c]][i]);
+        }
+        encode_scalar_block(values, quality, out + (c * 8));
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Decodes a BC1 color block into the RGB planes of a block. BC3 color blocks
+/// are always decoded in 4-color mode.
+static void read_color_block(uint8_t const *data, bool bc1, encoder_block_t *out_block)
+{
+    float    pal[4][3];
+    uint16_t c0   = (uint16_t) (data[0] | (data[1] << 8));
+    uint16_t c1   = (uint16_t) (data[2] | (data[3] << 8));
+    uint32_t bits = (uint32_t) data[4]         | ((uint32_t) data[5] <<  8) |
+                   ((uint32_t) data[6] << 16)  | ((uint32_t) data[7] << 24);
+    color_palette(c0, c1, !bc1 || c0 > c1, pal);
+    for (size_t i = 0; i < BC_BLOCK_TEXELS; ++i)
+    {
+        size_t p = (bits >> (2 * i)) & 3;
+        out_block->texels[0][i] = pal[p][0] / 255.0f;
+        out_block->texels[1][i] = pal[p][1] / 255.0f;
+        out_block->texels[2][i] = pal[p][2] / 255.0f;
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Decodes an interpolated scalar block into one plane of a block.
+static void read_scalar_block(uint8_t const *data, float *out_values)
+{
+    float    pal[8];
+    uint64_t bits = 0;
+    for (size_t i = 0; i < 6; ++i)
+    {
+        bits |= (uint64_t) data[2 + i] << (8 * i);
+    }
+    scalar_palette(data[0], data[1], pal);
+    for (size_t i = 0; i < BC_BLOCK_TEXELS; ++i)
+    {
+        out_values[i] = pal[(bits >> (3 * i)) & 7] / 255.0f;
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static void init_decoded_block(encoder_block_t *out_block)
+{
+    out_block->width  = 4;
+    out_block->height = 4;
+    out_block->count  = BC_BLOCK_TEXELS;
+    for (size_t i = 0; i < BC_BLOCK_TEXELS; ++i)
+    {
+        out_block->texels[3][i] = 1.0f;
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void CMN_CALL_C decode_block_bc1(
+    void const            *data,
+    encoder_block_t       *out_block)
+{
+    init_decoded_block(out_block);
+    read_color_block((uint8_t const*) data, true, out_block);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void CMN_CALL_C decode_block_bc3(
+    void const            *data,
+    encoder_block_t       *out_block)
+{
+    uint8_t const *in = (uint8_t const*) data;
+    init_decoded_block(out_block);
+    read_scalar_block(in, out_block->texels[3]);
+    read_color_block(in + 8, false, out_block);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void CMN_CALL_C decode_block_bc4(
+    void const            *data,
+    encoder_block_t       *out_block)
+{
+    init_decoded_block(out_block);
+    read_scalar_block((uint8_t const*) data, out_block->texels[0]);
+    for (size_t i = 0; i < BC_BLOCK_TEXELS; ++i)
+    {
+        out_block->texels[1][i] = out_block->texels[0][i];
+        out_block->texels[2][i] = out_block->texels[0][i];
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void CMN_CALL_C decode_block_bc5(
+    void const            *data,
+    encoder_block_t       *out_block)
+{
+    uint8_t const *in = (uint8_t const*) data;
+    init_decoded_block(out_block);
+    read_scalar_block(in,     out_block->texels[0]);
+    read_scalar_block(in + 8, out_block->texels[1]);
+    for (size_t i = 0; i < BC_BLOCK_TEXELS; ++i)
+    {
+        out_block->texels[2][i] = 0.0f;
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void* buffer_to_blocks_bc1(image::buffer_t *buffer, int32_t quality)
+{
+    return encode_blocks(buffer, 4, 4, 8, encode_block_bc1, quality, NULL);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void* buffer_to_blocks_bc3(image::buffer_t *buffer, int32_t quality)
+{
+    return encode_blocks(buffer, 4, 4, 16, encode_block_bc3, quality, NULL);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void* buffer_to_blocks_bc4(image::buffer_t *buffer, int32_t quality)
+{
+    return encode_blocks(buffer, 4, 4, 8, encode_block_bc4, quality, NULL);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void* buffer_to_blocks_bc5(image::buffer_t *buffer, int32_t quality)
+{
+    if (buffer->channel_count == 2)
+        return encode_blocks(buffer, 4, 4, 16, encode_block_bc5_la, quality, NULL);
+    else
+        return encode_blocks(buffer, 4, 4, 16, encode_block_bc5, quality, NULL);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/*/////////////////////////////////////////////////////////////////////////////
+//    $Id$
+///////////////////////////////////////////////////////////////////////////80*/
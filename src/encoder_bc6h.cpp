@@ -0,0 +1,535 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implements an encoder for the BC6H (BPTC float) HDR block format,
+/// in both its unsigned and signed variants. Texels are taken directly from
+/// the floating-point image buffer and converted to half-precision, and the
+/// endpoints are fit in the half-precision bit domain that the hardware
+/// interpolates in. The single-region modes are generated; palette index
+/// selection uses SSE2 if present.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////
+//   Includes   //
+////////////////*/
+#include <float.h>
+#include <math.h>
+#include <string.h>
+#include "encoder.hpp"
+
+#if CMN_HAVE_SSE2
+    #include <emmintrin.h>
+#endif
+
+/*//////////////////////////
+//   Using Declarations   //
+//////////////////////////*/
+
+/*//////////////////////
+//   Implementation   //
+//////////////////////*/
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+#define BC6H_BLOCK_TEXELS       16
+#define BC6H_MAX_HALF           0x7BFF  /// The largest finite half, 65504.
+
+/// Describes the layout of one of the single-region BC6H modes.
+struct bc6h_mode_t
+{
+    uint32_t mode_bits;               /// The 5-bit mode value.
+    size_t   endpoint_bits;           /// The precision of the endpoints.
+    size_t   delta_bits;              /// Bits of the second endpoint's delta,
+                                      /// or 0 if it is stored directly.
+};
+
+/// The single-region modes (11 through 14 in the D3D numbering.)
+static bc6h_mode_t const BC6H_MODES[4] =
+{
+    { 0x03, 10, 0 },
+    { 0x07, 11, 9 },
+    { 0x0B, 12, 8 },
+    { 0x0F, 16, 4 }
+};
+
+/// The interpolation weights for 4-bit indices, out of 64.
+static int const BC6H_WEIGHTS[16] =
+{
+    0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64
+};
+
+/// The amount of work done for each block at each quality setting.
+struct bc6h_budget_t
+{
+    size_t  modes;                    /// The number of modes to try.
+    size_t  refine;                   /// Least-squares refinement passes.
+};
+
+static bc6h_budget_t const BC6H_BUDGETS[3] =
+{
+    { 1, 0 },                         /// ENCODER_QUALITY_FAST
+    { 4, 1 },                         /// ENCODER_QUALITY_NORMAL
+    { 4, 3 }                          /// ENCODER_QUALITY_HIGH
+};
+
+/// A 4x4 block of RGB values stored as planes of half-precision bit patterns.
+/// Signed values are stored as sign and magnitude, as in the decoder output.
+struct bc6h_texels_t
+{
+    CMN_ALIGN_BEGIN(16) float h[3][BC6H_BLOCK_TEXELS] CMN_ALIGN_END(16);
+};
+
+/// A candidate encoding of a block.
+struct bc6h_block_t
+{
+    size_t  mode;                     /// Index into BC6H_MODES.
+    int     q[2][3];                  /// The quantized endpoints.
+    uint8_t index[BC6H_BLOCK_TEXELS]; /// The palette index of each texel.
+    float   error;                    /// The squared error.
+};
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static inline int clamp_int(int v, int lo, int hi)
+{
+    return (v < lo) ? lo : ((v > hi) ? hi : v);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Converts a value to the nearest half-precision bit pattern, clamped to the
+/// finite range. For the unsigned format, negative values become zero.
+/// @return The magnitude of the half, negated for negative values.
+static int bc6h_half(float v, bool is_signed)
+{
+    float a = fabsf(v);
+    int   h = 0;
+    if (!(a == a)) a = 0.0f;          // NaN becomes zero.
+    if (a >= 65504.0f)
+    {
+        h = BC6H_MAX_HALF;
+    }
+    else if (a >= 6.103515625e-05f)
+    {
+        // normal: round the mantissa to 10 bits.
+        int   e = 0;
+        float m = frexpf(a, &e);      // a = m * 2^e, m in [0.5, 1).
+        int   f = (int) floorf(m * 2048.0f + 0.5f);
+        if (f == 2048) { f = 1024; e++; }
+        h = ((e + 14) << 10) | (f - 1024);
+        h = CMN_MIN(h, BC6H_MAX_HALF);
+    }
+    else
+    {
+        // denormal: units of 2^-24.
+        h = (int) floorf(a * 16777216.0f + 0.5f);
+    }
+    if (v < 0.0f)
+        return is_signed ? -h : 0;
+    return h;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Expands a quantized endpoint to the 16 or 17-bit interpolation domain.
+static inline int bc6h_unquantize(int q, size_t bits, bool is_signed)
+{
+    if (!is_signed)
+    {
+        if (bits >= 15) return q;
+        if (q == 0) return 0;
+        if (q == (1 << bits) - 1) return 0xFFFF;
+        return ((q << 16) + 0x8000) >> bits;
+    }
+    if (bits >= 16) return q;
+    bool neg = q < 0;
+    int  v   = neg ? -q : q;
+    if (v == 0)
+        return 0;
+    if (v >= (1 << (bits - 1)) - 1)
+        v = 0x7FFF;
+    else
+        v = ((v << 15) + 0x4000) >> (bits - 1);
+    return neg ? -v : v;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Scales an interpolated value to a half-precision bit pattern.
+static inline int bc6h_finish(int v, bool is_signed)
+{
+    if (!is_signed) return (v * 31) >> 6;
+    return (v < 0) ? -(((-v) * 31) >> 5) : ((v * 31) >> 5);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Finds the quantized endpoint value that decodes nearest to a half value.
+static int bc6h_quantize(float h, size_t bits, bool is_signed)
+{
+    int   lo, hi;
+    float guess;
+    if (is_signed)
+    {
+        hi    = (1 << (bits - 1)) - 1;
+        lo    = -hi;
+        guess = h * (32.0f / 31.0f) * (float) (1 << (bits - 1)) / 32768.0f;
+    }
+    else
+    {
+        hi    = (1 << bits) - 1;
+        lo    = 0;
+        guess = h * (64.0f / 31.0f) * (float) (1 << bits) / 65536.0f;
+    }
+    int   g     = (int) floorf(guess + 0.5f);
+    int   best  = clamp_int(g, lo, hi);
+    float bestd = FLT_MAX;
+    for (int q = g - 1; q <= g + 1; ++q)
+    {
+        int   c = clamp_int(q, lo, hi);
+        float d = fabsf(h - (float) bc6h_finish(bc6h_unquantize(c, bits, is_signed), is_signed));
+        if (d < bestd) { bestd = d; best = c; }
+    }
+    return best;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Builds the 16-entry palette for a pair of quantized endpoints.
+static void bc6h_palette(
+    int const q[2][3],
+    size_t    bits,
+    bool      is_signed,
+    float     pal[16][3])
+{
+    for (size_t c = 0; c < 3; ++c)
+    {
+        int u0 = bc6h_unquantize(q[0][c], bits, is_signed);
+        int u1 = bc6h_unquantize(q[1][c], bits, is_signed);
+        for (size_t i = 0; i < 16; ++i)
+        {
+            int w = BC6H_WEIGHTS[i];
+            int v = (u0 * (64 - w) + u1 * w + 32) >> 6;
+            pal[i][c] = (float) bc6h_finish(v, is_signed);
+        }
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Selects the nearest palette entry for each texel.
+/// @return The total squared error, in half-precision bit units.
+static float bc6h_select(
+    bc6h_texels_t const *blk,
+    float const          pal[16][3],
+    uint8_t             *index)
+{
+#if CMN_HAVE_SSE2
+    __m128 total = _mm_setzero_ps();
+    for (size_t i = 0; i < BC6H_BLOCK_TEXELS; i += 4)
+    {
+        __m128  r    = _mm_load_ps(&blk->h[0][i]);
+        __m128  g    = _mm_load_ps(&blk->h[1][i]);
+        __m128  b    = _mm_load_ps(&blk->h[2][i]);
+        __m128  best = _mm_set1_ps(FLT_MAX);
+        __m128i bidx = _mm_setzero_si128();
+        for (int p = 0; p < 16; ++p)
+        {
+            __m128  dr = _mm_sub_ps(r, _mm_set1_ps(pal[p][0]));
+            __m128  dg = _mm_sub_ps(g, _mm_set1_ps(pal[p][1]));
+            __m128  db = _mm_sub_ps(b, _mm_set1_ps(pal[p][2]));
+            __m128  d  = _mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+            __m128i m  = _mm_castps_si128(_mm_cmplt_ps(d, best));
+            best       = _mm_min_ps(d, best);
+            bidx       = _mm_or_si128(
+                _mm_and_si128(m, _mm_set1_epi32(p)),
+                _mm_andnot_si128(m, bidx));
+        }
+        CMN_ALIGN_BEGIN(16) int32_t ix[4] CMN_ALIGN_END(16);
+        _mm_store_si128((__m128i*) ix, bidx);
+        index[i + 0] = (uint8_t) ix[0];
+        index[i + 1] = (uint8_t) ix[1];
+        index[i + 2] = (uint8_t) ix[2];
+        index[i + 3] = (uint8_t) ix[3];
+        total = _mm_add_ps(total, best);
+    }
+    CMN_ALIGN_BEGIN(16) float sum[4] CMN_ALIGN_END(16);
+    _mm_store_ps(sum, total);
+    return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+#else
+    float total = 0.0f;
+    for (size_t i = 0; i < BC6H_BLOCK_TEXELS; ++i)
+    {
+        float   best = FLT_MAX;
+        uint8_t bidx = 0;
+        for (int p = 0; p < 16; ++p)
+        {
+            float dr = blk->h[0][i] - pal[p][0];
+            float dg = blk->h[1][i] - pal[p][1];
+            float db = blk->h[2][i] - pal[p][2];
+            float d  = dr * dr + dg * dg + db * db;
+            if (d < best) { best = d; bidx = (uint8_t) p; }
+        }
+        index[i] = bidx;
+        total   += best;
+    }
+    return total;
+#endif
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Quantizes a pair of endpoints for a mode and selects the indices. For the
+/// transformed modes, the second endpoint is clamped so that its difference
+/// from the first fits the delta field in either order.
+static void bc6h_evaluate(
+    bc6h_texels_t const *blk,
+    size_t               mode,
+    bool                 is_signed,
+    float const         *lo,
+    float const         *hi,
+    bc6h_block_t        *out)
+{
+    bc6h_mode_t const *info = &BC6H_MODES[mode];
+    float              pal[16][3];
+    out->mode = mode;
+    for (size_t c = 0; c < 3; ++c)
+    {
+        out->q[0][c] = bc6h_quantize(lo[c], info->endpoint_bits, is_signed);
+        out->q[1][c] = bc6h_quantize(hi[c], info->endpoint_bits, is_signed);
+        if (info->delta_bits)
+        {
+            int limit    = (1 << (info->delta_bits - 1)) - 1;
+            out->q[1][c] = clamp_int(out->q[1][c], out->q[0][c] - limit, out->q[0][c] + limit);
+        }
+    }
+    bc6h_palette(out->q, info->endpoint_bits, is_signed, pal);
+    out->error = bc6h_select(blk, pal, out->index);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Fits a block in one mode, starting from the principal axis of the texels
+/// and refining the endpoints by least squares.
+static void bc6h_fit(
+    bc6h_texels_t const *blk,
+    size_t               mode,
+    bool                 is_signed,
+    size_t               refine,
+    bc6h_block_t        *out)
+{
+    float mean[3] = { 0.0f, 0.0f, 0.0f };
+    float cov[6]  = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    float axis[3] = { 0.0f, 0.0f, 0.0f };
+    float lo[3], hi[3];
+    for (size_t c = 0; c < 3; ++c)
+    {
+        float vmin = FLT_MAX, vmax = -FLT_MAX;
+        for (size_t i = 0; i < BC6H_BLOCK_TEXELS; ++i)
+        {
+            mean[c] += blk->h[c][i];
+            vmin     = CMN_MIN(vmin, blk->h[c][i]);
+            vmax     = CMN_MAX(vmax, blk->h[c][i]);
+        }
+        mean[c] /= BC6H_BLOCK_TEXELS;
+        axis[c]  = vmax - vmin;
+    }
+    for (size_t i = 0; i < BC6H_BLOCK_TEXELS; ++i)
+    {
+        float r = blk->h[0][i] - mean[0];
+        float g = blk->h[1][i] - mean[1];
+        float b = blk->h[2][i] - mean[2];
+        cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+        cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+    }
+    for (size_t iter = 0; iter < 8; ++iter)
+    {
+        float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+        float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+        float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+        float m = CMN_MAX(fabsf(x), CMN_MAX(fabsf(y), fabsf(z)));
+        if (m < FLT_EPSILON) break;
+        axis[0] = x / m; axis[1] = y / m; axis[2] = z / m;
+    }
+    float len2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+    float tmin = 0.0f, tmax = 0.0f;
+    for (size_t i = 0; i < BC6H_BLOCK_TEXELS && len2 > FLT_EPSILON; ++i)
+    {
+        float t = (blk->h[0][i] - mean[0]) * axis[0] +
+                  (blk->h[1][i] - mean[1]) * axis[1] +
+                  (blk->h[2][i] - mean[2]) * axis[2];
+        tmin = CMN_MIN(tmin, t);
+        tmax = CMN_MAX(tmax, t);
+    }
+    if (len2 > FLT_EPSILON)
+    {
+        tmin /= len2;
+        tmax /= len2;
+    }
+    for (size_t c = 0; c < 3; ++c)
+    {
+        lo[c] = mean[c] + axis[c] * tmin;
+        hi[c] = mean[c] + axis[c] * tmax;
+    }
+    bc6h_evaluate(blk, mode, is_signed, lo, hi, out);
+
+    for (size_t pass = 0; pass < refine && out->error > 0.0f; ++pass)
+    {
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        float ax[3] = { 0.0f, 0.0f, 0.0f };
+        float bx[3] = { 0.0f, 0.0f, 0.0f };
+        for (size_t i = 0; i < BC6H_BLOCK_TEXELS; ++i)
+        {
+            float b = BC6H_WEIGHTS[out->index[i]] / 64.0f;
+            float a = 1.0f - b;
+            aa += a * a; ab += a * b; bb += b * b;
+            for (size_t c = 0; c < 3; ++c)
+            {
+                ax[c] += a * blk->h[c][i];
+                bx[c] += b * blk->h[c][i];
+            }
+        }
+        float det = aa * bb - ab * ab;
+        if (fabsf(det) < 1e-6f)
+            break;
+        float inv = 1.0f / det;
+        for (size_t c = 0; c < 3; ++c)
+        {
+            lo[c] = (ax[c] * bb - bx[c] * ab) * inv;
+            hi[c] = (bx[c] * aa - ax[c] * ab) * inv;
+        }
+        bc6h_block_t trial;
+        bc6h_evaluate(blk, mode, is_signed, lo, hi, &trial);
+        if (trial.error >= out->error)
+            break;
+        *out = trial;
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static inline void bc6h_put_bits(uint8_t *out, size_t *pos, uint32_t value, size_t count)
+{
+    for (size_t i = 0; i < count; ++i, ++(*pos))
+    {
+        out[*pos >> 3] |= (uint8_t) (((value >> i) & 1) << (*pos & 7));
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Writes the 128-bit encoding of a block.
+static void bc6h_write_block(bc6h_block_t *blk, uint8_t *out)
+{
+    bc6h_mode_t const *info = &BC6H_MODES[blk->mode];
+    size_t             bits = info->endpoint_bits;
+    size_t             pos  = 0;
+
+    // the first index has an implicit most-significant bit of zero.
+    if (blk->index[0] & 8)
+    {
+        for (size_t c = 0; c < 3; ++c)
+        {
+            int t        = blk->q[0][c];
+            blk->q[0][c] = blk->q[1][c];
+            blk->q[1][c] = t;
+        }
+        for (size_t i = 0; i < BC6H_BLOCK_TEXELS; ++i)
+        {
+            blk->index[i] = (uint8_t) (15 - blk->index[i]);
+        }
+    }
+
+    memset(out, 0, 16);
+    bc6h_put_bits(out, &pos, info->mode_bits, 5);
+    for (size_t c = 0; c < 3; ++c)
+    {
+        bc6h_put_bits(out, &pos, (uint32_t) blk->q[0][c], 10);
+    }
+    for (size_t c = 0; c < 3; ++c)
+    {
+        if (info->delta_bits == 0)
+        {
+            bc6h_put_bits(out, &pos, (uint32_t) blk->q[1][c], 10);
+            continue;
+        }
+        // the delta, then the high bits of the base from most-significant
+        // to least-significant; these modes store them bit-reversed.
+        bc6h_put_bits(out, &pos, (uint32_t) (blk->q[1][c] - blk->q[0][c]), info->delta_bits);
+        for (size_t b = bits - 1; b >= 10; --b)
+        {
+            bc6h_put_bits(out, &pos, (uint32_t) blk->q[0][c] >> b, 1);
+        }
+    }
+    for (size_t i = 0; i < BC6H_BLOCK_TEXELS; ++i)
+    {
+        bc6h_put_bits(out, &pos, blk->index[i], i == 0 ? 3 : 4);
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static void bc6h_encode_block(
+    encoder_block_t const *block,
+    int32_t                quality,
+    bool                   is_signed,
+    uint8_t               *out)
+{
+    bc6h_texels_t        blk;
+    bc6h_block_t         best;
+    bc6h_block_t         trial;
+    bc6h_budget_t const *budget = &BC6H_BUDGETS[clamp_int(quality, 0, 2)];
+    for (size_t c = 0; c < 3; ++c)
+    {
+        for (size_t i = 0; i < BC6H_BLOCK_TEXELS; ++i)
+        {
+            blk.h[c][i] = (float) bc6h_half(block->texels[c][i], is_signed);
+        }
+    }
+    bc6h_fit(&blk, 0, is_signed, budget->refine, &best);
+    for (size_t mode = 1; mode < budget->modes && best.error > 0.0f; ++mode)
+    {
+        bc6h_fit(&blk, mode, is_signed, budget->refine, &trial);
+        if (trial.error < best.error) best = trial;
+    }
+    bc6h_write_block(&best, out);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void CMN_CALL_C encode_block_bc6h_uf16(
+    encoder_block_t const *block,
+    int32_t                quality,
+    void                  *out_data)
+{
+    bc6h_encode_block(block, quality, false, (uint8_t*) out_data);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void CMN_CALL_C encode_block_bc6h_sf16(
+    encoder_block_t const *block,
+    int32_t                quality,
+    void                  *out_data)
+{
+    bc6h_encode_block(block, quality, true, (uint8_t*) out_data);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void* buffer_to_blocks_bc6h_uf16(image::buffer_t *buffer, int32_t quality)
+{
+    return encode_blocks(buffer, 4, 4, 16, encode_block_bc6h_uf16, quality, NULL);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void* buffer_to_blocks_bc6h_sf16(image::buffer_t *buffer, int32_t quality)
+{
+    return encode_blocks(buffer, 4, 4, 16, encode_block_bc6h_sf16, quality, NULL);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/*/////////////////////////////////////////////////////////////////////////////
+//    $Id$
+///////////////////////////////////////////////////////////////////////////80*/
@@ -0,0 +1,1006 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implements an encoder for the BC7 (BPTC) RGBA block compression
+/// format. Each block is tried in several of the eight BC7 modes; for the
+/// multi-subset modes, every partition is ranked by a cheap line-fit error
+/// estimate and only the most promising partitions are fully encoded. The
+/// number of candidates examined is set by the quality setting. Palette
+/// index selection uses SSE2 if present.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////
+//   Includes   //
+////////////////*/
+#include <float.h>
+#include <math.h>
+#include <string.h>
+#include "encoder.hpp"
+
+#if CMN_HAVE_SSE2
+    #include <emmintrin.h>
+#endif
+
+/*//////////////////////////
+//   Using Declarations   //
+//////////////////////////*/
+
+/*//////////////////////
+//   Implementation   //
+//////////////////////*/
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+#define BC7_BLOCK_TEXELS        16
+#define BC7_MAX_SUBSETS         3
+#define BC7_MAX_CANDIDATES      64
+
+/// Identifies how a mode stores the least-significant bit of its endpoints.
+enum bc7_pbit_e
+{
+    BC7_PBIT_NONE               = 0,  /// No p-bits.
+    BC7_PBIT_SHARED             = 1,  /// One p-bit shared by both endpoints.
+    BC7_PBIT_ENDPOINT           = 2   /// One p-bit for each endpoint.
+};
+
+/// Describes the layout of a block encoded in one of the BC7 modes.
+struct bc7_mode_t
+{
+    size_t  subsets;                  /// The number of subsets.
+    size_t  partition_bits;           /// Bits used to store the partition.
+    size_t  rotation_bits;            /// Bits used to store the rotation.
+    size_t  index_mode_bits;          /// Bits used to store the index mode.
+    size_t  color_bits;               /// Bits per RGB endpoint component.
+    size_t  alpha_bits;               /// Bits per alpha endpoint component.
+    size_t  pbits;                    /// One of bc7_pbit_e.
+    size_t  index_bits;               /// Bits per primary index.
+    size_t  index2_bits;              /// Bits per secondary index.
+};
+
+/// The layout of each of the eight BC7 modes.
+static bc7_mode_t const BC7_MODES[8] =
+{
+    { 3, 4, 0, 0, 4, 0, BC7_PBIT_ENDPOINT, 3, 0 },
+    { 2, 6, 0, 0, 6, 0, BC7_PBIT_SHARED,   3, 0 },
+    { 3, 6, 0, 0, 5, 0, BC7_PBIT_NONE,     2, 0 },
+    { 2, 6, 0, 0, 7, 0, BC7_PBIT_ENDPOINT, 2, 0 },
+    { 1, 0, 2, 1, 5, 6, BC7_PBIT_NONE,     2, 3 },
+    { 1, 0, 2, 0, 7, 8, BC7_PBIT_NONE,     2, 2 },
+    { 1, 0, 0, 0, 7, 7, BC7_PBIT_ENDPOINT, 4, 0 },
+    { 2, 6, 0, 0, 5, 5, BC7_PBIT_ENDPOINT, 2, 0 }
+};
+
+/// The two-subset partitions. Bit i is set if pixel i belongs to subset 1.
+static uint16_t const BC7_PARTITIONS2[64] =
+{
+    0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+    0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+    0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+    0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+    0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+    0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+    0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+    0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22
+};
+
+/// The three-subset partitions. Bits 2i and 2i+1 store the subset of pixel i.
+static uint32_t const BC7_PARTITIONS3[64] =
+{
+    0xAA685050, 0x6A5A5040, 0x5A5A4200, 0x5450A0A8,
+    0xA5A50000, 0xA0A05050, 0x5555A0A0, 0x5A5A5050,
+    0xAA550000, 0xAA555500, 0xAAAA5500, 0x90909090,
+    0x94949494, 0xA4A4A4A4, 0xA9A59450, 0x2A0A4250,
+    0xA5945040, 0x0A425054, 0xA5A5A500, 0x55A0A0A0,
+    0xA8A85454, 0x6A6A4040, 0xA4A45000, 0x1A1A0500,
+    0x0050A4A4, 0xAAA59090, 0x14696914, 0x69691400,
+    0xA08585A0, 0xAA821414, 0x50A4A450, 0x6A5A0200,
+    0xA9A58000, 0x5090A0A8, 0xA8A09050, 0x24242424,
+    0x00AA5500, 0x24924924, 0x24499224, 0x50A50A50,
+    0x500AA550, 0xAAAA4444, 0x66660000, 0xA5A0A5A0,
+    0x50A050A0, 0x69286928, 0x44AAAA44, 0x66666600,
+    0xAA444444, 0x54A854A8, 0x95809580, 0x96969600,
+    0xA85454A8, 0x80959580, 0xAA141414, 0x96960000,
+    0xAAAA1414, 0xA05050A0, 0xA0A5A5A0, 0x96000000,
+    0x40804080, 0xA9A8A9A8, 0xAAAAAA44, 0x2A4A5254
+};
+
+/// The anchor pixel of subset 1 for the two-subset partitions.
+static uint8_t const BC7_ANCHOR2[64] =
+{
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+    15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+     6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15
+};
+
+/// The anchor pixel of subset 1 for the three-subset partitions.
+static uint8_t const BC7_ANCHOR3_1[64] =
+{
+     3,  3, 15, 15,  8,  3, 15, 15,  8,  8,  6,  6,  6,  5,  3,  3,
+     3,  3,  8, 15,  3,  3,  6, 10,  5,  8,  8,  6,  8,  5, 15, 15,
+     8, 15,  3,  5,  6, 10,  8, 15, 15,  3, 15,  5, 15, 15, 15, 15,
+     3, 15,  5,  5,  5,  8,  5, 10,  5, 10,  8, 13, 15, 12,  3,  3
+};
+
+/// The anchor pixel of subset 2 for the three-subset partitions.
+static uint8_t const BC7_ANCHOR3_2[64] =
+{
+    15,  8,  8,  3, 15, 15,  3,  8, 15, 15, 15, 15, 15, 15, 15,  8,
+    15,  8, 15,  3, 15,  8, 15,  8,  3, 15,  6, 10, 15, 15, 10,  8,
+    15,  3, 15, 10, 10,  8,  9, 10,  6, 15,  8, 15,  3,  6,  6,  8,
+    15,  3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,  3, 15, 15,  8
+};
+
+/// The interpolation weights for 2, 3 and 4-bit indices, out of 64.
+static int const BC7_WEIGHTS2[4]  = { 0, 21, 43, 64 };
+static int const BC7_WEIGHTS3[8]  = { 0, 9, 18, 27, 37, 46, 55, 64 };
+static int const BC7_WEIGHTS4[16] =
+{
+    0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64
+};
+
+/// The amount of work done for each block at each quality setting.
+struct bc7_budget_t
+{
+    size_t  partitions2;              /// Two-subset partitions to encode.
+    size_t  partitions3;              /// Three-subset partitions to encode.
+    size_t  refine;                   /// Least-squares refinement passes.
+    bool    all_pbits;                /// Evaluate every p-bit combination?
+    bool    all_modes;                /// Try modes 3 and 4?
+    bool    all_rotations;            /// Try every channel rotation?
+};
+
+static bc7_budget_t const BC7_BUDGETS[3] =
+{
+    {  1, 0, 0, false, false, false }, /// ENCODER_QUALITY_FAST
+    {  4, 2, 1, true,  true,  false }, /// ENCODER_QUALITY_NORMAL
+    { 16, 8, 2, true,  true,  true  }  /// ENCODER_QUALITY_HIGH
+};
+
+/// A 4x4 block of RGBA values stored as planes, with values in [0, 255].
+struct bc7_texels_t
+{
+    CMN_ALIGN_BEGIN(16) float px[4][BC7_BLOCK_TEXELS] CMN_ALIGN_END(16);
+};
+
+/// The parameters for fitting one set of endpoints to a set of texels.
+struct bc7_fit_t
+{
+    size_t  channel;                  /// The first channel to fit.
+    size_t  channel_count;            /// The number of channels to fit.
+    size_t  bits;                     /// Bits per endpoint component.
+    size_t  pbits;                    /// One of bc7_pbit_e.
+    size_t  index_bits;               /// Bits per index.
+    size_t  refine;                   /// Least-squares refinement passes.
+    bool    all_pbits;                /// Evaluate every p-bit combination?
+};
+
+/// The quantized endpoints of one subset, or of the alpha channel.
+struct bc7_endpoints_t
+{
+    int     q[2][4];                  /// Quantized components, without p-bit.
+    int     p[2];                     /// The p-bit of each endpoint.
+};
+
+/// A candidate encoding of a complete block.
+struct bc7_block_t
+{
+    size_t          mode;             /// The BC7 mode, 0-7.
+    size_t          partition;        /// The partition number.
+    size_t          rotation;         /// The channel rotation (modes 4, 5.)
+    size_t          index_mode;       /// The index mode (mode 4.)
+    bc7_endpoints_t color[BC7_MAX_SUBSETS];
+    bc7_endpoints_t alpha;            /// Alpha endpoints (modes 4, 5.)
+    uint8_t         index[BC7_BLOCK_TEXELS];  /// Color indices.
+    uint8_t         index2[BC7_BLOCK_TEXELS]; /// Alpha indices (modes 4, 5.)
+    float           error;            /// The squared error.
+};
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static inline float clamp_255(float v)
+{
+    v = v * 255.0f;
+    if (v <   0.0f) return   0.0f;
+    if (v > 255.0f) return 255.0f;
+    return v;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static inline int clamp_int(int v, int lo, int hi)
+{
+    return (v < lo) ? lo : ((v > hi) ? hi : v);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static inline int const* bc7_weights(size_t index_bits)
+{
+    switch (index_bits)
+    {
+        case 2:  return BC7_WEIGHTS2;
+        case 3:  return BC7_WEIGHTS3;
+        default: break;
+    }
+    return BC7_WEIGHTS4;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Returns the subset of a pixel within a partition.
+static inline size_t bc7_subset(size_t subsets, size_t partition, size_t pixel)
+{
+    switch (subsets)
+    {
+        case 2:  return (BC7_PARTITIONS2[partition] >> pixel) & 1;
+        case 3:  return (BC7_PARTITIONS3[partition] >> (pixel * 2)) & 3;
+        default: break;
+    }
+    return 0;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Returns the anchor pixel of a subset, whose index has an implicit
+/// most-significant bit of zero.
+static inline size_t bc7_anchor(size_t subsets, size_t partition, size_t subset)
+{
+    if (subset == 0)  return 0;
+    if (subsets == 2) return BC7_ANCHOR2[partition];
+    return (subset == 1) ? BC7_ANCHOR3_1[partition] : BC7_ANCHOR3_2[partition];
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Expands a quantized endpoint component, including any p-bit, to 8 bits.
+static inline int bc7_expand(int q, size_t bits)
+{
+    q <<= (8 - bits);
+    return q | (q >> bits);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Returns the 8-bit value of an endpoint component.
+static inline int bc7_unquantize(int q, int p, size_t bits, bool has_pbit)
+{
+    return has_pbit ? bc7_expand((q << 1) | p, bits + 1) : bc7_expand(q, bits);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Finds the quantized value nearest to v for a given p-bit.
+static inline int bc7_quantize(float v, int p, size_t bits, bool has_pbit)
+{
+    int   top   = (1 << bits) - 1;
+    int   guess = has_pbit ?
+        (int) floorf(((v * ((2 << bits) - 1) / 255.0f) - p) * 0.5f + 0.5f) :
+        (int) floorf(v * top / 255.0f + 0.5f);
+    int   best  = clamp_int(guess, 0, top);
+    float bestd = FLT_MAX;
+    for (int q = guess - 1; q <= guess + 1; ++q)
+    {
+        int   c = clamp_int(q, 0, top);
+        float d = fabsf(v - bc7_unquantize(c, p, bits, has_pbit));
+        if (d < bestd) { bestd = d; best = c; }
+    }
+    return best;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Builds the palette for a set of endpoints.
+static void bc7_palette(
+    bc7_endpoints_t const *ep,
+    bc7_fit_t const       *fit,
+    float                  pal[16][4])
+{
+    bool       has_p = fit->pbits != BC7_PBIT_NONE;
+    size_t     count = size_t(1) << fit->index_bits;
+    int const *w     = bc7_weights(fit->index_bits);
+    int        e0[4] = { 0, 0, 0, 0 };
+    int        e1[4] = { 0, 0, 0, 0 };
+    for (size_t c = fit->channel; c < fit->channel + fit->channel_count; ++c)
+    {
+        e0[c] = bc7_unquantize(ep->q[0][c], ep->p[0], fit->bits, has_p);
+        e1[c] = bc7_unquantize(ep->q[1][c], ep->p[1], fit->bits, has_p);
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        for (size_t c = 0; c < 4; ++c)
+        {
+            pal[i][c] = (float) (((64 - w[i]) * e0[c] + w[i] * e1[c] + 32) >> 6);
+        }
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Selects the nearest palette entry for each texel of a subset.
+/// @param x The subset texels, as planes padded to a multiple of 4 texels.
+/// @return The total squared error over the fitted channels.
+static float bc7_select(
+    float const      x[4][BC7_BLOCK_TEXELS],
+    size_t           count,
+    bc7_fit_t const *fit,
+    float const      pal[16][4],
+    uint8_t         *index)
+{
+    size_t npal = size_t(1) << fit->index_bits;
+    size_t c0   = fit->channel;
+    size_t c1   = fit->channel + fit->channel_count;
+#if CMN_HAVE_SSE2
+    CMN_ALIGN_BEGIN(16) float   err[BC7_BLOCK_TEXELS] CMN_ALIGN_END(16);
+    CMN_ALIGN_BEGIN(16) int32_t ix[BC7_BLOCK_TEXELS]  CMN_ALIGN_END(16);
+    for (size_t i = 0; i < count; i += 4)
+    {
+        __m128  best = _mm_set1_ps(FLT_MAX);
+        __m128i bidx = _mm_setzero_si128();
+        for (size_t p = 0; p < npal; ++p)
+        {
+            __m128 d = _mm_setzero_ps();
+            for (size_t c = c0; c < c1; ++c)
+            {
+                __m128 t = _mm_sub_ps(_mm_loadu_ps(&x[c][i]), _mm_set1_ps(pal[p][c]));
+                d = _mm_add_ps(d, _mm_mul_ps(t, t));
+            }
+            __m128i m = _mm_castps_si128(_mm_cmplt_ps(d, best));
+            best      = _mm_min_ps(d, best);
+            bidx      = _mm_or_si128(
+                _mm_and_si128(m, _mm_set1_epi32((int) p)),
+                _mm_andnot_si128(m, bidx));
+        }
+        _mm_store_ps(&err[i], best);
+        _mm_store_si128((__m128i*) &ix[i], bidx);
+    }
+    float total = 0.0f;
+    for (size_t i = 0; i < count; ++i)
+    {
+        index[i] = (uint8_t) ix[i];
+        total   += err[i];
+    }
+    return total;
+#else
+    float total = 0.0f;
+    for (size_t i = 0; i < count; ++i)
+    {
+        float   best = FLT_MAX;
+        uint8_t bidx = 0;
+        for (size_t p = 0; p < npal; ++p)
+        {
+            float d = 0.0f;
+            for (size_t c = c0; c < c1; ++c)
+            {
+                float t = x[c][i] - pal[p][c];
+                d += t * t;
+            }
+            if (d < best) { best = d; bidx = (uint8_t) p; }
+        }
+        index[i] = bidx;
+        total   += best;
+    }
+    return total;
+#endif
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Quantizes a pair of endpoints, choosing p-bits, and selects indices.
+/// @return The squared error of the quantized endpoints.
+static float bc7_quantize_endpoints(
+    float const      x[4][BC7_BLOCK_TEXELS],
+    size_t           count,
+    bc7_fit_t const *fit,
+    float const     *lo,
+    float const     *hi,
+    bc7_endpoints_t *out_ep,
+    uint8_t         *out_index)
+{
+    static int const combos[4][2] = { { 0, 0 }, { 1, 1 }, { 0, 1 }, { 1, 0 } };
+    size_t  c0     = fit->channel;
+    size_t  c1     = fit->channel + fit->channel_count;
+    bool    has_p  = fit->pbits != BC7_PBIT_NONE;
+    size_t  ncombo = 1;
+    float   best   = FLT_MAX;
+    float   pal[16][4];
+    uint8_t index[BC7_BLOCK_TEXELS];
+
+    if (fit->pbits == BC7_PBIT_SHARED)   ncombo = 2;
+    if (fit->pbits == BC7_PBIT_ENDPOINT) ncombo = 4;
+    if (has_p && !fit->all_pbits)
+    {
+        // choose the p-bits giving the smallest endpoint quantization error,
+        // and evaluate only that combination.
+        float  d[2][2];
+        for (size_t e = 0; e < 2; ++e)
+        {
+            float const *v = e ? hi : lo;
+            for (int p = 0; p < 2; ++p)
+            {
+                d[e][p] = 0.0f;
+                for (size_t c = c0; c < c1; ++c)
+                {
+                    int   q = bc7_quantize(v[c], p, fit->bits, true);
+                    float t = v[c] - bc7_unquantize(q, p, fit->bits, true);
+                    d[e][p] += t * t;
+                }
+            }
+        }
+        size_t pick = 0;
+        float  pbest = FLT_MAX;
+        for (size_t k = 0; k < ncombo; ++k)
+        {
+            float t = d[0][combos[k][0]] + d[1][combos[k][1]];
+            if (t < pbest) { pbest = t; pick = k; }
+        }
+        for (size_t c = c0; c < c1; ++c)
+        {
+            out_ep->q[0][c] = bc7_quantize(lo[c], combos[pick][0], fit->bits, true);
+            out_ep->q[1][c] = bc7_quantize(hi[c], combos[pick][1], fit->bits, true);
+        }
+        out_ep->p[0] = combos[pick][0];
+        out_ep->p[1] = combos[pick][1];
+        bc7_palette(out_ep, fit, pal);
+        return bc7_select(x, count, fit, pal, out_index);
+    }
+
+    for (size_t k = 0; k < ncombo; ++k)
+    {
+        bc7_endpoints_t ep;
+        memset(&ep, 0, sizeof(ep));
+        ep.p[0] = has_p ? combos[k][0] : 0;
+        ep.p[1] = has_p ? combos[k][1] : 0;
+        for (size_t c = c0; c < c1; ++c)
+        {
+            ep.q[0][c] = bc7_quantize(lo[c], ep.p[0], fit->bits, has_p);
+            ep.q[1][c] = bc7_quantize(hi[c], ep.p[1], fit->bits, has_p);
+        }
+        bc7_palette(&ep, fit, pal);
+        float err = bc7_select(x, count, fit, pal, index);
+        if (err < best)
+        {
+            best    = err;
+            *out_ep = ep;
+            memcpy(out_index, index, count);
+        }
+    }
+    return best;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Fits quantized endpoints and indices to the texels of one subset, using
+/// the principal axis as a starting point followed by least-squares passes.
+/// @return The squared error of the fit.
+static float bc7_fit_subset(
+    float const      x[4][BC7_BLOCK_TEXELS],
+    size_t           count,
+    bc7_fit_t const *fit,
+    bc7_endpoints_t *out_ep,
+    uint8_t         *out_index)
+{
+    size_t c0      = fit->channel;
+    size_t c1      = fit->channel + fit->channel_count;
+    float  mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    float  cov[4][4];
+    float  axis[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    float  lo[4]   = { 0.0f, 0.0f, 0.0f, 0.0f };
+    float  hi[4]   = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    memset(out_ep, 0, sizeof(bc7_endpoints_t));
+    memset(cov, 0, sizeof(cov));
+    for (size_t c = c0; c < c1; ++c)
+    {
+        float vmin = FLT_MAX, vmax = -FLT_MAX;
+        for (size_t i = 0; i < count; ++i)
+        {
+            mean[c] += x[c][i];
+            vmin     = CMN_MIN(vmin, x[c][i]);
+            vmax     = CMN_MAX(vmax, x[c][i]);
+        }
+        mean[c] /= (float) count;
+        axis[c]  = vmax - vmin;
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        for (size_t a = c0; a < c1; ++a)
+        {
+            for (size_t b = c0; b < c1; ++b)
+            {
+                cov[a][b] += (x[a][i] - mean[a]) * (x[b][i] - mean[b]);
+            }
+        }
+    }
+
+    // power iteration for the dominant eigenvector, starting from the
+    // extents of the subset so that a single channel converges at once.
+    for (size_t iter = 0; iter < 6; ++iter)
+    {
+        float v[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        float m    = 0.0f;
+        for (size_t a = c0; a < c1; ++a)
+        {
+            for (size_t b = c0; b < c1; ++b) v[a] += cov[a][b] * axis[b];
+            m = CMN_MAX(m, fabsf(v[a]));
+        }
+        if (m < FLT_EPSILON) break;
+        for (size_t a = c0; a < c1; ++a) axis[a] = v[a] / m;
+    }
+    float len2 = 0.0f, tmin = 0.0f, tmax = 0.0f;
+    for (size_t c = c0; c < c1; ++c) len2 += axis[c] * axis[c];
+    for (size_t i = 0; i < count && len2 > FLT_EPSILON; ++i)
+    {
+        float t = 0.0f;
+        for (size_t c = c0; c < c1; ++c) t += (x[c][i] - mean[c]) * axis[c];
+        tmin = CMN_MIN(tmin, t);
+        tmax = CMN_MAX(tmax, t);
+    }
+    if (len2 > FLT_EPSILON)
+    {
+        tmin /= len2;
+        tmax /= len2;
+    }
+    for (size_t c = c0; c < c1; ++c)
+    {
+        lo[c] = CMN_MAX(0.0f, CMN_MIN(255.0f, mean[c] + axis[c] * tmin));
+        hi[c] = CMN_MAX(0.0f, CMN_MIN(255.0f, mean[c] + axis[c] * tmax));
+    }
+
+    bc7_endpoints_t ep;
+    uint8_t         index[BC7_BLOCK_TEXELS];
+    int const      *w    = bc7_weights(fit->index_bits);
+    memset(&ep, 0, sizeof(ep));
+    float           best = bc7_quantize_endpoints(x, count, fit, lo, hi, out_ep, out_index);
+    memcpy(index, out_index, count);
+    for (size_t pass = 0; pass < fit->refine && best > 0.0f; ++pass)
+    {
+        // solve for the endpoints minimizing the error with fixed weights.
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        float ax[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        float bx[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        for (size_t i = 0; i < count; ++i)
+        {
+            float b = w[index[i]] / 64.0f;
+            float a = 1.0f - b;
+            aa += a * a; ab += a * b; bb += b * b;
+            for (size_t c = c0; c < c1; ++c)
+            {
+                ax[c] += a * x[c][i];
+                bx[c] += b * x[c][i];
+            }
+        }
+        float det = aa * bb - ab * ab;
+        if (fabsf(det) < 1e-6f)
+            break;
+        float inv = 1.0f / det;
+        for (size_t c = c0; c < c1; ++c)
+        {
+            lo[c] = (ax[c] * bb - bx[c] * ab) * inv;
+            hi[c] = (bx[c] * aa - ax[c] * ab) * inv;
+            lo[c] = CMN_MAX(0.0f, CMN_MIN(255.0f, lo[c]));
+            hi[c] = CMN_MAX(0.0f, CMN_MIN(255.0f, hi[c]));
+        }
+        float err = bc7_quantize_endpoints(x, count, fit, lo, hi, &ep, index);
+        if (err >= best)
+            break;
+        best    = err;
+        *out_ep = ep;
+        memcpy(out_index, index, count);
+    }
+    return best;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Ranks the partitions of a multi-subset mode by the residual of a line fit
+/// to each subset, ignoring quantization.
+/// @param limit The number of partitions the mode can address.
+/// @param count The number of partitions to return.
+/// @param out_partitions On return, the best partitions in ascending order
+/// of estimated error.
+/// @return The number of partitions stored in out_partitions.
+static size_t bc7_rank_partitions(
+    bc7_texels_t const *blk,
+    size_t              subsets,
+    size_t              limit,
+    size_t              channels,
+    size_t              count,
+    size_t             *out_partitions)
+{
+    float  estimate[BC7_MAX_CANDIDATES];
+    size_t order[BC7_MAX_CANDIDATES];
+    for (size_t part = 0; part < limit; ++part)
+    {
+        float sum[BC7_MAX_SUBSETS][4];
+        float sum2[BC7_MAX_SUBSETS][4][4];
+        float n[BC7_MAX_SUBSETS] = { 0.0f, 0.0f, 0.0f };
+        memset(sum,  0, sizeof(sum));
+        memset(sum2, 0, sizeof(sum2));
+        for (size_t i = 0; i < BC7_BLOCK_TEXELS; ++i)
+        {
+            size_t s = bc7_subset(subsets, part, i);
+            n[s]    += 1.0f;
+            for (size_t a = 0; a < channels; ++a)
+            {
+                sum[s][a] += blk->px[a][i];
+                for (size_t b = a; b < channels; ++b)
+                    sum2[s][a][b] += blk->px[a][i] * blk->px[b][i];
+            }
+        }
+        float total = 0.0f;
+        for (size_t s = 0; s < subsets; ++s)
+        {
+            if (n[s] < 2.0f) continue;
+            float cov[4][4];
+            float axis[4]  = { 1.0f, 1.0f, 1.0f, 1.0f };
+            float trace    = 0.0f;
+            float lambda   = 0.0f;
+            for (size_t a = 0; a < channels; ++a)
+            {
+                for (size_t b = a; b < channels; ++b)
+                {
+                    cov[a][b] = sum2[s][a][b] - sum[s][a] * sum[s][b] / n[s];
+                    cov[b][a] = cov[a][b];
+                }
+                trace += cov[a][a];
+            }
+            for (size_t iter = 0; iter < 4; ++iter)
+            {
+                float v[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+                float m    = 0.0f;
+                for (size_t a = 0; a < channels; ++a)
+                {
+                    for (size_t b = 0; b < channels; ++b) v[a] += cov[a][b] * axis[b];
+                    m = CMN_MAX(m, fabsf(v[a]));
+                }
+                if (m < FLT_EPSILON) break;
+                for (size_t a = 0; a < channels; ++a) axis[a] = v[a] / m;
+            }
+            float num = 0.0f, den = 0.0f;
+            for (size_t a = 0; a < channels; ++a)
+            {
+                float v = 0.0f;
+                for (size_t b = 0; b < channels; ++b) v += cov[a][b] * axis[b];
+                num += axis[a] * v;
+                den += axis[a] * axis[a];
+            }
+            if (den > FLT_EPSILON) lambda = num / den;
+            total += CMN_MAX(0.0f, trace - lambda);
+        }
+        estimate[part] = total;
+        order[part]    = part;
+    }
+
+    // partial selection sort; count is small compared to limit.
+    count = CMN_MIN(count, limit);
+    for (size_t i = 0; i < count; ++i)
+    {
+        size_t best = i;
+        for (size_t j = i + 1; j < limit; ++j)
+        {
+            if (estimate[order[j]] < estimate[order[best]]) best = j;
+        }
+        size_t t          = order[i];
+        order[i]          = order[best];
+        order[best]       = t;
+        out_partitions[i] = order[i];
+    }
+    return count;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Encodes a block in one of the partitioned modes (0, 1, 2, 3, 6 and 7.)
+static void bc7_encode_partitioned(
+    bc7_texels_t const *blk,
+    size_t              mode,
+    size_t              partition,
+    bc7_budget_t const *budget,
+    bc7_block_t        *out)
+{
+    bc7_mode_t const *info = &BC7_MODES[mode];
+    bc7_fit_t         fit;
+    fit.channel       = 0;
+    fit.channel_count = info->alpha_bits ? 4 : 3;
+    fit.bits          = info->color_bits;
+    fit.pbits         = info->pbits;
+    fit.index_bits    = info->index_bits;
+    fit.refine        = budget->refine;
+    fit.all_pbits     = budget->all_pbits;
+
+    out->mode         = mode;
+    out->partition    = partition;
+    out->rotation     = 0;
+    out->index_mode   = 0;
+    out->error        = 0.0f;
+    memset(&out->alpha, 0, sizeof(out->alpha));
+    memset(out->index2, 0, sizeof(out->index2));
+    for (size_t s = 0; s < info->subsets; ++s)
+    {
+        CMN_ALIGN_BEGIN(16) float x[4][BC7_BLOCK_TEXELS] CMN_ALIGN_END(16);
+        uint8_t pixel[BC7_BLOCK_TEXELS];
+        uint8_t index[BC7_BLOCK_TEXELS];
+        size_t  n = 0;
+        memset(x, 0, sizeof(x));
+        for (size_t i = 0; i < BC7_BLOCK_TEXELS; ++i)
+        {
+            if (bc7_subset(info->subsets, partition, i) != s) continue;
+            for (size_t c = 0; c < 4; ++c) x[c][n] = blk->px[c][i];
+            pixel[n++] = (uint8_t) i;
+        }
+        if (n == 0)
+        {
+            memset(&out->color[s], 0, sizeof(bc7_endpoints_t));
+            continue;
+        }
+        out->error += bc7_fit_subset(x, n, &fit, &out->color[s], index);
+        for (size_t i = 0; i < n; ++i) out->index[pixel[i]] = index[i];
+    }
+    if (info->alpha_bits == 0)
+    {
+        // modes without alpha always decode to an opaque block.
+        for (size_t i = 0; i < BC7_BLOCK_TEXELS; ++i)
+        {
+            float d     = 255.0f - blk->px[3][i];
+            out->error += d * d;
+        }
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Encodes a block in one of the separate alpha modes (4 and 5.)
+static void bc7_encode_separate(
+    bc7_texels_t const *blk,
+    size_t              mode,
+    size_t              rotation,
+    size_t              index_mode,
+    bc7_budget_t const *budget,
+    bc7_block_t        *out)
+{
+    bc7_mode_t const *info = &BC7_MODES[mode];
+    CMN_ALIGN_BEGIN(16) float x[4][BC7_BLOCK_TEXELS] CMN_ALIGN_END(16);
+    memcpy(x, blk->px, sizeof(x));
+    if (rotation > 0)
+    {
+        // the decoder swaps alpha with channel (rotation - 1).
+        memcpy(x[rotation - 1], blk->px[3], sizeof(x[3]));
+        memcpy(x[3], blk->px[rotation - 1], sizeof(x[3]));
+    }
+
+    bc7_fit_t color;
+    color.channel       = 0;
+    color.channel_count = 3;
+    color.bits          = info->color_bits;
+    color.pbits         = BC7_PBIT_NONE;
+    color.index_bits    = index_mode ? info->index2_bits : info->index_bits;
+    color.refine        = budget->refine;
+    color.all_pbits     = false;
+
+    bc7_fit_t alpha     = color;
+    alpha.channel       = 3;
+    alpha.channel_count = 1;
+    alpha.bits          = info->alpha_bits;
+    alpha.index_bits    = index_mode ? info->index_bits : info->index2_bits;
+
+    out->mode       = mode;
+    out->partition  = 0;
+    out->rotation   = rotation;
+    out->index_mode = index_mode;
+    memset(out->color, 0, sizeof(out->color));
+    out->error      = bc7_fit_subset(x, BC7_BLOCK_TEXELS, &color, &out->color[0], out->index);
+    out->error     += bc7_fit_subset(x, BC7_BLOCK_TEXELS, &alpha, &out->alpha, out->index2);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static inline void bc7_keep(bc7_block_t *best, bc7_block_t const *trial)
+{
+    if (trial->error < best->error) *best = *trial;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static inline void bc7_put_bits(uint8_t *out, size_t *pos, uint32_t value, size_t count)
+{
+    for (size_t i = 0; i < count; ++i, ++(*pos))
+    {
+        out[*pos >> 3] |= (uint8_t) (((value >> i) & 1) << (*pos & 7));
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Swaps the endpoints of a subset and inverts its indices if required so
+/// that the anchor index has a most-significant bit of zero.
+static void bc7_fix_anchor(
+    bc7_endpoints_t *ep,
+    uint8_t         *index,
+    size_t           index_bits,
+    size_t           subsets,
+    size_t           partition,
+    size_t           subset)
+{
+    size_t top    = (size_t(1) << index_bits) - 1;
+    size_t anchor = bc7_anchor(subsets, partition, subset);
+    if ((index[anchor] >> (index_bits - 1)) == 0)
+        return;
+    for (size_t c = 0; c < 4; ++c)
+    {
+        int t       = ep->q[0][c];
+        ep->q[0][c] = ep->q[1][c];
+        ep->q[1][c] = t;
+    }
+    int t    = ep->p[0];
+    ep->p[0] = ep->p[1];
+    ep->p[1] = t;
+    for (size_t i = 0; i < BC7_BLOCK_TEXELS; ++i)
+    {
+        if (bc7_subset(subsets, partition, i) == subset)
+            index[i] = (uint8_t) (top - index[i]);
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Writes the 128-bit encoding of a block.
+static void bc7_write_block(bc7_block_t *blk, uint8_t *out)
+{
+    bc7_mode_t const *info   = &BC7_MODES[blk->mode];
+    size_t            nsub   = info->subsets;
+    size_t            ibits  = info->index_bits;
+    size_t            ibits2 = info->index2_bits;
+    size_t            pos    = 0;
+    uint8_t          *idx    = blk->index;
+    uint8_t          *idx2   = blk->index2;
+
+    if (blk->index_mode)
+    {
+        // the color channels use the secondary (3-bit) index array.
+        idx  = blk->index2;
+        idx2 = blk->index;
+    }
+    for (size_t s = 0; s < nsub; ++s)
+    {
+        size_t bits = blk->index_mode ? ibits2 : ibits;
+        bc7_fix_anchor(&blk->color[s], blk->index, bits, nsub, blk->partition, s);
+    }
+    if (ibits2)
+    {
+        size_t bits = blk->index_mode ? ibits : ibits2;
+        bc7_fix_anchor(&blk->alpha, blk->index2, bits, 1, 0, 0);
+    }
+
+    memset(out, 0, 16);
+    bc7_put_bits(out, &pos, 1U << blk->mode, blk->mode + 1);
+    bc7_put_bits(out, &pos, (uint32_t) blk->partition,  info->partition_bits);
+    bc7_put_bits(out, &pos, (uint32_t) blk->rotation,   info->rotation_bits);
+    bc7_put_bits(out, &pos, (uint32_t) blk->index_mode, info->index_mode_bits);
+    for (size_t c = 0; c < 3; ++c)
+    {
+        for (size_t s = 0; s < nsub; ++s)
+        {
+            bc7_put_bits(out, &pos, blk->color[s].q[0][c], info->color_bits);
+            bc7_put_bits(out, &pos, blk->color[s].q[1][c], info->color_bits);
+        }
+    }
+    if (info->alpha_bits)
+    {
+        bc7_endpoints_t *a = ibits2 ? &blk->alpha : blk->color;
+        size_t           n = ibits2 ? 1 : nsub;
+        for (size_t s = 0; s < n; ++s)
+        {
+            bc7_put_bits(out, &pos, a[s].q[0][3], info->alpha_bits);
+            bc7_put_bits(out, &pos, a[s].q[1][3], info->alpha_bits);
+        }
+    }
+    for (size_t s = 0; s < nsub; ++s)
+    {
+        if (info->pbits == BC7_PBIT_ENDPOINT)
+        {
+            bc7_put_bits(out, &pos, blk->color[s].p[0], 1);
+            bc7_put_bits(out, &pos, blk->color[s].p[1], 1);
+        }
+        else if (info->pbits == BC7_PBIT_SHARED)
+        {
+            bc7_put_bits(out, &pos, blk->color[s].p[0], 1);
+        }
+    }
+    for (size_t i = 0; i < BC7_BLOCK_TEXELS; ++i)
+    {
+        size_t s      = bc7_subset(nsub, blk->partition, i);
+        bool   anchor = bc7_anchor(nsub, blk->partition, s) == i;
+        bc7_put_bits(out, &pos, idx[i], anchor ? ibits - 1 : ibits);
+    }
+    for (size_t i = 0; i < BC7_BLOCK_TEXELS && ibits2; ++i)
+    {
+        bc7_put_bits(out, &pos, idx2[i], i == 0 ? ibits2 - 1 : ibits2);
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void CMN_CALL_C encode_block_bc7(
+    encoder_block_t const *block,
+    int32_t                quality,
+    void                  *out_data)
+{
+    bc7_texels_t        blk;
+    bc7_block_t         best;
+    bc7_block_t         trial;
+    size_t              parts[BC7_MAX_CANDIDATES];
+    size_t              count;
+    bool                opaque = true;
+    bc7_budget_t const *budget = &BC7_BUDGETS[clamp_int(quality, 0, 2)];
+
+    for (size_t i = 0; i < BC7_BLOCK_TEXELS; ++i)
+    {
+        for (size_t c = 0; c < 4; ++c)
+        {
+            blk.px[c][i] = clamp_255(block->texels[c][i]);
+        }
+        if (blk.px[3][i] < 254.5f) opaque = false;
+    }
+
+    // mode 6 handles smooth blocks with or without alpha well, and is the
+    // baseline against which the other modes are compared.
+    bc7_encode_partitioned(&blk, 6, 0, budget, &best);
+
+    if (opaque)
+    {
+        count = bc7_rank_partitions(&blk, 2, 64, 3, budget->partitions2, parts);
+        for (size_t i = 0; i < count && best.error > 0.0f; ++i)
+        {
+            bc7_encode_partitioned(&blk, 1, parts[i], budget, &trial);
+            bc7_keep(&best, &trial);
+            if (!budget->all_modes) continue;
+            bc7_encode_partitioned(&blk, 3, parts[i], budget, &trial);
+            bc7_keep(&best, &trial);
+        }
+        count = bc7_rank_partitions(&blk, 3, 64, 3, budget->partitions3, parts);
+        for (size_t i = 0; i < count && best.error > 0.0f; ++i)
+        {
+            bc7_encode_partitioned(&blk, 2, parts[i], budget, &trial);
+            bc7_keep(&best, &trial);
+        }
+        count = bc7_rank_partitions(&blk, 3, 16, 3, budget->partitions3, parts);
+        for (size_t i = 0; i < count && best.error > 0.0f; ++i)
+        {
+            bc7_encode_partitioned(&blk, 0, parts[i], budget, &trial);
+            bc7_keep(&best, &trial);
+        }
+    }
+    else
+    {
+        size_t nrot = budget->all_rotations ? 4 : 1;
+        for (size_t rot = 0; rot < nrot && best.error > 0.0f; ++rot)
+        {
+            bc7_encode_separate(&blk, 5, rot, 0, budget, &trial);
+            bc7_keep(&best, &trial);
+            if (!budget->all_modes) continue;
+            bc7_encode_separate(&blk, 4, rot, 0, budget, &trial);
+            bc7_keep(&best, &trial);
+            bc7_encode_separate(&blk, 4, rot, 1, budget, &trial);
+            bc7_keep(&best, &trial);
+        }
+        count = bc7_rank_partitions(&blk, 2, 64, 4, budget->partitions2, parts);
+        for (size_t i = 0; i < count && best.error > 0.0f; ++i)
+        {
+            bc7_encode_partitioned(&blk, 7, parts[i], budget, &trial);
+            bc7_keep(&best, &trial);
+        }
+    }
+    bc7_write_block(&best, (uint8_t*) out_data);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void* buffer_to_blocks_bc7(image::buffer_t *buffer, int32_t quality)
+{
+    return encode_blocks(buffer, 4, 4, 16, encode_block_bc7, quality, NULL);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/*/////////////////////////////////////////////////////////////////////////////
+//    $Id$
+///////////////////////////////////////////////////////////////////////////80*/
@@ -0,0 +1,899 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implements encoders for the Ericsson texture compression formats:
+/// ETC1, ETC2 RGB8 and ETC2 RGBA8 with EAC alpha. Color blocks are encoded in
+/// the individual and differential modes for both sub-block orientations, and
+/// ETC2 blocks additionally try the planar mode. The ETC1S intermediate format
+/// restricts ETC1 to one base color and table per block for transcoding.
+/// Sub-block error evaluation uses SSE2 if present.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////
+//   Includes   //
+////////////////*/
+#include <float.h>
+#include <string.h>
+#include "encoder.hpp"
+
+#if CMN_HAVE_SSE2
+    #include <emmintrin.h>
+#endif
+
+/*//////////////////////////
+//   Using Declarations   //
+//////////////////////////*/
+
+/*//////////////////////
+//   Implementation   //
+//////////////////////*/
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+#define ETC_BLOCK_TEXELS        16
+#define ETC_SUBBLOCK_TEXELS     8
+
+/// The intensity modifier tables for ETC1/ETC2 color sub-blocks. Pixel index
+/// 0 and 1 select +small and +large; 2 and 3 select -small and -large.
+static int const ETC_MODIFIERS[8][2] =
+{
+    {  2,   8 }, {  5,  17 }, {  9,  29 }, { 13,  42 },
+    { 18,  60 }, { 24,  80 }, { 33, 106 }, { 47, 183 }
+};
+
+/// The modifier tables for EAC alpha blocks.
+static int const EAC_MODIFIERS[16][8] =
+{
+    { -3, -6,  -9, -15, 2, 5, 8, 14 },
+    { -3, -7, -10, -13, 2, 6, 9, 12 },
+    { -2, -5,  -8, -13, 1, 4, 7, 12 },
+    { -2, -4,  -6, -13, 1, 3, 5, 12 },
+    { -3, -6,  -8, -12, 2, 5, 7, 11 },
+    { -3, -7,  -9, -11, 2, 6, 8, 10 },
+    { -4, -7,  -8, -11, 3, 6, 7, 10 },
+    { -3, -5,  -8, -11, 2, 4, 7, 10 },
+    { -2, -6,  -8, -10, 1, 5, 7,  9 },
+    { -2, -5,  -8, -10, 1, 4, 7,  9 },
+    { -2, -4,  -8, -10, 1, 3, 7,  9 },
+    { -2, -5,  -7, -10, 1, 4, 6,  9 },
+    { -3, -4,  -7, -10, 2, 3, 6,  9 },
+    { -1, -2,  -3, -10, 0, 1, 2,  9 },
+    { -4, -6,  -8,  -9, 3, 5, 7,  8 },
+    { -3, -5,  -7,  -9, 2, 4, 6,  8 }
+};
+
+/// The texels of one 2x4 or 4x2 sub-block, with values in [0, 255].
+struct etc_subblock_t
+{
+    float   r[ETC_SUBBLOCK_TEXELS];
+    float   g[ETC_SUBBLOCK_TEXELS];
+    float   b[ETC_SUBBLOCK_TEXELS];
+    uint8_t pixel[ETC_SUBBLOCK_TEXELS]; /// Pixel number, x * 4 + y.
+};
+
+/// The encoding of one sub-block.
+struct etc_half_t
+{
+    int     q[3];                       /// The quantized base color.
+    int     table;                      /// The modifier table index.
+    float   error;                      /// The squared error.
+    uint8_t index[ETC_SUBBLOCK_TEXELS]; /// The pixel index for each texel.
+};
+
+/// A complete encoded color block and its error.
+struct etc_block_t
+{
+    float   error;                      /// The squared error.
+    uint8_t data[8];                    /// The encoded block.
+};
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static inline int clamp_int(int v, int lo, int hi)
+{
+    return (v < lo) ? lo : ((v > hi) ? hi : v);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static inline float clamp_255(float v)
+{
+    v = v * 255.0f;
+    if (v <   0.0f) return   0.0f;
+    if (v > 255.0f) return 255.0f;
+    return v;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static inline int quantize_bits(float v, int max_value)
+{
+    return clamp_int((int) (v * max_value / 255.0f + 0.5f), 0, max_value);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static inline int expand_bits(int v, int bits)
+{
+    switch (bits)
+    {
+        case 4:  return (v << 4) | v;
+        case 5:  return (v << 3) | (v >> 2);
+        case 6:  return (v << 2) | (v >> 4);
+        case 7:  return (v << 1) | (v >> 6);
+        default: break;
+    }
+    return v;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Copies the texels of one sub-block. A flipped block is split into top and
+/// bottom 4x2 halves; otherwise it is split into left and right 2x4 halves.
+static void etc_gather_subblock(
+    float const     rgb[3][ETC_BLOCK_TEXELS],
+    bool            flip,
+    size_t          half,
+    etc_subblock_t *out)
+{
+    size_t n = 0;
+    for (size_t y = 0; y < 4; ++y)
+    {
+        for (size_t x = 0; x < 4; ++x)
+        {
+            size_t h = flip ? (y >> 1) : (x >> 1);
+            if (h != half) continue;
+            out->r[n]     = rgb[0][y * 4 + x];
+            out->g[n]     = rgb[1][y * 4 + x];
+            out->b[n]     = rgb[2][y * 4 + x];
+            out->pixel[n] = (uint8_t) (x * 4 + y);
+            n++;
+        }
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Computes the error of a sub-block for a base color and modifier table,
+/// selecting the best modifier for each texel.
+static float etc_subblock_error(
+    etc_subblock_t const *sb,
+    int const            *base,
+    int                   table,
+    uint8_t              *index)
+{
+    float cand[4][3];
+    for (int m = 0; m < 4; ++m)
+    {
+        int mod = ETC_MODIFIERS[table][m & 1];
+        if (m & 2) mod = -mod;
+        cand[m][0] = (float) clamp_int(base[0] + mod, 0, 255);
+        cand[m][1] = (float) clamp_int(base[1] + mod, 0, 255);
+        cand[m][2] = (float) clamp_int(base[2] + mod, 0, 255);
+    }
+#if CMN_HAVE_SSE2
+    __m128 total = _mm_setzero_ps();
+    for (size_t i = 0; i < ETC_SUBBLOCK_TEXELS; i += 4)
+    {
+        __m128  r    = _mm_loadu_ps(&sb->r[i]);
+        __m128  g    = _mm_loadu_ps(&sb->g[i]);
+        __m128  b    = _mm_loadu_ps(&sb->b[i]);
+        __m128  best = _mm_set1_ps(FLT_MAX);
+        __m128i bidx = _mm_setzero_si128();
+        for (int m = 0; m < 4; ++m)
+        {
+            __m128  dr = _mm_sub_ps(r, _mm_set1_ps(cand[m][0]));
+            __m128  dg = _mm_sub_ps(g, _mm_set1_ps(cand[m][1]));
+            __m128  db = _mm_sub_ps(b, _mm_set1_ps(cand[m][2]));
+            __m128  d  = _mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+            __m128i k  = _mm_castps_si128(_mm_cmplt_ps(d, best));
+            best       = _mm_min_ps(d, best);
+            bidx       = _mm_or_si128(
+                _mm_and_si128(k, _mm_set1_epi32(m)),
+                _mm_andnot_si128(k, bidx));
+        }
+        CMN_ALIGN_BEGIN(16) int32_t ix[4] CMN_ALIGN_END(16);
+        _mm_store_si128((__m128i*) ix, bidx);
+        index[i + 0] = (uint8_t) ix[0];
+        index[i + 1] = (uint8_t) ix[1];
+        index[i + 2] = (uint8_t) ix[2];
+        index[i + 3] = (uint8_t) ix[3];
+        total = _mm_add_ps(total, best);
+    }
+    CMN_ALIGN_BEGIN(16) float sum[4] CMN_ALIGN_END(16);
+    _mm_store_ps(sum, total);
+    return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+#else
+    float total = 0.0f;
+    for (size_t i = 0; i < ETC_SUBBLOCK_TEXELS; ++i)
+    {
+        float   best = FLT_MAX;
+        uint8_t bidx = 0;
+        for (int m = 0; m < 4; ++m)
+        {
+            float dr = sb->r[i] - cand[m][0];
+            float dg = sb->g[i] - cand[m][1];
+            float db = sb->b[i] - cand[m][2];
+            float d  = dr * dr + dg * dg + db * db;
+            if (d < best) { best = d; bidx = (uint8_t) m; }
+        }
+        index[i] = bidx;
+        total   += best;
+    }
+    return total;
+#endif
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Finds the best modifier table for a quantized base color.
+static void etc_half_fit(
+    etc_subblock_t const *sb,
+    int const            *q,
+    int                   bits,
+    etc_half_t           *out)
+{
+    uint8_t index[ETC_SUBBLOCK_TEXELS];
+    int     base[3];
+    base[0]    = expand_bits(q[0], bits);
+    base[1]    = expand_bits(q[1], bits);
+    base[2]    = expand_bits(q[2], bits);
+    out->q[0]  = q[0];
+    out->q[1]  = q[1];
+    out->q[2]  = q[2];
+    out->error = FLT_MAX;
+    for (int t = 0; t < 8; ++t)
+    {
+        float e = etc_subblock_error(sb, base, t, index);
+        if (e < out->error)
+        {
+            out->error = e;
+            out->table = t;
+            memcpy(out->index, index, sizeof(index));
+        }
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Tests whether a quantized base color is representable. In differential
+/// mode the second color must be within [-4, 3] of the reference color.
+static inline bool etc_valid_base(int const *q, int bits, int const *ref)
+{
+    int limit = (1 << bits) - 1;
+    for (size_t c = 0; c < 3; ++c)
+    {
+        if (q[c] < 0 || q[c] > limit) return false;
+        if (ref && (q[c] - ref[c] < -4 || q[c] - ref[c] > 3)) return false;
+    }
+    return true;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Refines the base color of a sub-block in the quantized color space.
+/// ENCODER_QUALITY_HIGH tries every color within one step of the current
+/// color before a greedy per-channel search.
+static void etc_half_refine(
+    etc_subblock_t const *sb,
+    int                   bits,
+    int                   quality,
+    int const            *ref,
+    etc_half_t           *best)
+{
+    etc_half_t trial;
+    int        q[3];
+    if (quality >= ENCODER_QUALITY_HIGH)
+    {
+        int c0[3] = { best->q[0], best->q[1], best->q[2] };
+        for (int dr = -1; dr <= 1; ++dr)
+        for (int dg = -1; dg <= 1; ++dg)
+        for (int db = -1; db <= 1; ++db)
+        {
+            if (0 == dr && 0 == dg && 0 == db) continue;
+            q[0] = c0[0] + dr; q[1] = c0[1] + dg; q[2] = c0[2] + db;
+            if (!etc_valid_base(q, bits, ref)) continue;
+            etc_half_fit(sb, q, bits, &trial);
+            if (trial.error < best->error) *best = trial;
+        }
+    }
+    size_t passes = (quality >= ENCODER_QUALITY_HIGH) ? 8 : 4;
+    for (size_t pass = 0; pass < passes && best->error > 0.0f; ++pass)
+    {
+        bool improved = false;
+        for (size_t c = 0; c < 3; ++c)
+        {
+            for (int d = -1; d <= 1; d += 2)
+            {
+                q[0] = best->q[0]; q[1] = best->q[1]; q[2] = best->q[2];
+                q[c] += d;
+                if (!etc_valid_base(q, bits, ref)) continue;
+                etc_half_fit(sb, q, bits, &trial);
+                if (trial.error < best->error)
+                {
+                    *best    = trial;
+                    improved = true;
+                }
+            }
+        }
+        if (!improved) break;
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static void etc_average(etc_subblock_t const *sb, float *avg)
+{
+    avg[0] = avg[1] = avg[2] = 0.0f;
+    for (size_t i = 0; i < ETC_SUBBLOCK_TEXELS; ++i)
+    {
+        avg[0] += sb->r[i];
+        avg[1] += sb->g[i];
+        avg[2] += sb->b[i];
+    }
+    avg[0] /= ETC_SUBBLOCK_TEXELS;
+    avg[1] /= ETC_SUBBLOCK_TEXELS;
+    avg[2] /= ETC_SUBBLOCK_TEXELS;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static void etc_write_block(
+    bool                  diff,
+    bool                  flip,
+    etc_subblock_t const *sb,
+    etc_half_t const     *half,
+    etc_block_t          *out)
+{
+    uint8_t *data = out->data;
+    if (diff)
+    {
+        for (size_t c = 0; c < 3; ++c)
+        {
+            int d   = half[1].q[c] - half[0].q[c];
+            data[c] = (uint8_t) ((half[0].q[c] << 3) | (d & 7));
+        }
+    }
+    else
+    {
+        for (size_t c = 0; c < 3; ++c)
+        {
+            data[c] = (uint8_t) ((half[0].q[c] << 4) | half[1].q[c]);
+        }
+    }
+    data[3] = (uint8_t) (
+        (half[0].table << 5) |
+        (half[1].table << 2) |
+        (diff ? 2 : 0)       |
+        (flip ? 1 : 0));
+
+    uint32_t msb = 0;
+    uint32_t lsb = 0;
+    for (size_t h = 0; h < 2; ++h)
+    {
+        for (size_t i = 0; i < ETC_SUBBLOCK_TEXELS; ++i)
+        {
+            uint32_t k = sb[h].pixel[i];
+            msb |= (uint32_t) ((half[h].index[i] >> 1) & 1) << k;
+            lsb |= (uint32_t) ((half[h].index[i] >> 0) & 1) << k;
+        }
+    }
+    data[4]    = (uint8_t) (msb >> 8);
+    data[5]    = (uint8_t) (msb & 0xFF);
+    data[6]    = (uint8_t) (lsb >> 8);
+    data[7]    = (uint8_t) (lsb & 0xFF);
+    out->error = half[0].error + half[1].error;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Encodes a color block in the ETC1 individual and differential modes for
+/// both orientations, keeping the encoding with the lowest error.
+static void etc1_fit_block(
+    float const  rgb[3][ETC_BLOCK_TEXELS],
+    int32_t      quality,
+    etc_block_t *best)
+{
+    best->error = FLT_MAX;
+    for (int f = 0; f < 2; ++f)
+    {
+        etc_subblock_t sb[2];
+        etc_half_t     half[2];
+        etc_block_t    block;
+        float          avg[2][3];
+        int            q[3];
+        bool           flip = (f != 0);
+        etc_gather_subblock(rgb, flip, 0, &sb[0]);
+        etc_gather_subblock(rgb, flip, 1, &sb[1]);
+        etc_average(&sb[0], avg[0]);
+        etc_average(&sb[1], avg[1]);
+
+        // individual mode: two independent RGB444 base colors.
+        for (size_t h = 0; h < 2; ++h)
+        {
+            q[0] = quantize_bits(avg[h][0], 15);
+            q[1] = quantize_bits(avg[h][1], 15);
+            q[2] = quantize_bits(avg[h][2], 15);
+            etc_half_fit(&sb[h], q, 4, &half[h]);
+            if (quality >= ENCODER_QUALITY_NORMAL)
+                etc_half_refine(&sb[h], 4, quality, NULL, &half[h]);
+        }
+        etc_write_block(false, flip, sb, half, &block);
+        if (block.error < best->error) *best = block;
+
+        // differential mode: an RGB555 base color and a 3-bit delta.
+        q[0] = quantize_bits(avg[0][0], 31);
+        q[1] = quantize_bits(avg[0][1], 31);
+        q[2] = quantize_bits(avg[0][2], 31);
+        etc_half_fit(&sb[0], q, 5, &half[0]);
+        if (quality >= ENCODER_QUALITY_NORMAL)
+            etc_half_refine(&sb[0], 5, quality, NULL, &half[0]);
+        for (size_t c = 0; c < 3; ++c)
+        {
+            int v = quantize_bits(avg[1][c], 31);
+            q[c]  = clamp_int(v, half[0].q[c] - 4, half[0].q[c] + 3);
+        }
+        etc_half_fit(&sb[1], q, 5, &half[1]);
+        if (quality >= ENCODER_QUALITY_NORMAL)
+            etc_half_refine(&sb[1], 5, quality, half[0].q, &half[1]);
+        etc_write_block(true, flip, sb, half, &block);
+        if (block.error < best->error) *best = block;
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Finds the best modifier table for an ETC1S block, in which both halves
+/// share the same RGB555 base color and modifier table.
+static void etc1s_fit(
+    etc_subblock_t const *sb,
+    int const            *q,
+    etc_half_t           *out)
+{
+    etc_half_t trial[2];
+    int        base[3];
+    base[0] = expand_bits(q[0], 5);
+    base[1] = expand_bits(q[1], 5);
+    base[2] = expand_bits(q[2], 5);
+    out[0].error = out[1].error = FLT_MAX;
+    for (int t = 0; t < 8; ++t)
+    {
+        trial[0].error = etc_subblock_error(&sb[0], base, t, trial[0].index);
+        trial[1].error = etc_subblock_error(&sb[1], base, t, trial[1].index);
+        if (trial[0].error + trial[1].error < out[0].error + out[1].error)
+        {
+            for (size_t h = 0; h < 2; ++h)
+            {
+                trial[h].q[0]  = q[0];
+                trial[h].q[1]  = q[1];
+                trial[h].q[2]  = q[2];
+                trial[h].table = t;
+                out[h]         = trial[h];
+            }
+        }
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Encodes a color block in the ETC1S subset of ETC1: differential mode with
+/// a zero delta and one modifier table, so that the whole block has a single
+/// base color. Blocks in this form are valid ETC1 and can be converted to
+/// other formats at load time without searching.
+static void etc1s_fit_block(
+    float const  rgb[3][ETC_BLOCK_TEXELS],
+    int32_t      quality,
+    etc_block_t *best)
+{
+    etc_subblock_t sb[2];
+    etc_half_t     half[2];
+    etc_half_t     trial[2];
+    float          avg[2][3];
+    int            q[3];
+    etc_gather_subblock(rgb, false, 0, &sb[0]);
+    etc_gather_subblock(rgb, false, 1, &sb[1]);
+    etc_average(&sb[0], avg[0]);
+    etc_average(&sb[1], avg[1]);
+    for (size_t c = 0; c < 3; ++c)
+    {
+        q[c] = quantize_bits((avg[0][c] + avg[1][c]) * 0.5f, 31);
+    }
+    etc1s_fit(sb, q, half);
+
+    // greedy per-channel search over the base color; ENCODER_QUALITY_HIGH
+    // first tries every color within one step of the average.
+    if (quality >= ENCODER_QUALITY_HIGH)
+    {
+        int c0[3] = { half[0].q[0], half[0].q[1], half[0].q[2] };
+        for (int dr = -1; dr <= 1; ++dr)
+        for (int dg = -1; dg <= 1; ++dg)
+        for (int db = -1; db <= 1; ++db)
+        {
+            if (0 == dr && 0 == dg && 0 == db) continue;
+            q[0] = c0[0] + dr; q[1] = c0[1] + dg; q[2] = c0[2] + db;
+            if (!etc_valid_base(q, 5, NULL)) continue;
+            etc1s_fit(sb, q, trial);
+            if (trial[0].error + trial[1].error < half[0].error + half[1].error)
+            {
+                half[0] = trial[0];
+                half[1] = trial[1];
+            }
+        }
+    }
+    size_t passes = (quality >= ENCODER_QUALITY_HIGH) ? 8 : 4;
+    if (quality < ENCODER_QUALITY_NORMAL) passes = 0;
+    for (size_t pass = 0; pass < passes; ++pass)
+    {
+        bool improved = false;
+        for (size_t c = 0; c < 3; ++c)
+        {
+            for (int d = -1; d <= 1; d += 2)
+            {
+                q[0] = half[0].q[0]; q[1] = half[0].q[1]; q[2] = half[0].q[2];
+                q[c] += d;
+                if (!etc_valid_base(q, 5, NULL)) continue;
+                etc1s_fit(sb, q, trial);
+                if (trial[0].error + trial[1].error < half[0].error + half[1].error)
+                {
+                    half[0]  = trial[0];
+                    half[1]  = trial[1];
+                    improved = true;
+                }
+            }
+        }
+        if (!improved) break;
+    }
+    etc_write_block(true, false, sb, half, best);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Computes the error of an ETC2 planar block with quantized RGB676 colors
+/// at the origin (o), the horizontal (h) and the vertical (v) corners.
+static float etc_planar_error(
+    float const  rgb[3][ETC_BLOCK_TEXELS],
+    int const   *o,
+    int const   *h,
+    int const   *v)
+{
+    static int const bits[3] = { 6, 7, 6 };
+    float error = 0.0f;
+    for (size_t c = 0; c < 3; ++c)
+    {
+        int co = expand_bits(o[c], bits[c]);
+        int ch = expand_bits(h[c], bits[c]);
+        int cv = expand_bits(v[c], bits[c]);
+        for (int y = 0; y < 4; ++y)
+        {
+            for (int x = 0; x < 4; ++x)
+            {
+                int   p = (x * (ch - co) + y * (cv - co) + 4 * co + 2);
+                float d = rgb[c][y * 4 + x] - (float) clamp_int(p / 4, 0, 255);
+                error  += d * d;
+            }
+        }
+    }
+    return error;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Encodes a color block in the ETC2 planar mode, which represents smooth
+/// gradients well. The plane is found with a least-squares fit.
+static void etc2_planar_block(
+    float const  rgb[3][ETC_BLOCK_TEXELS],
+    int32_t      quality,
+    etc_block_t *out)
+{
+    static int const limit[3] = { 63, 127, 63 };
+    int col[3][3]; // [corner: o, h, v][channel]
+    for (size_t c = 0; c < 3; ++c)
+    {
+        // fit c(x, y) = a + b * x + d * y over the 4x4 grid.
+        float mean = 0.0f, sx = 0.0f, sy = 0.0f;
+        for (int y = 0; y < 4; ++y)
+        {
+            for (int x = 0; x < 4; ++x)
+            {
+                float v = rgb[c][y * 4 + x];
+                mean   += v;
+                sx     += (x - 1.5f) * v;
+                sy     += (y - 1.5f) * v;
+            }
+        }
+        float b = sx / 20.0f;
+        float d = sy / 20.0f;
+        float a = mean / 16.0f - 1.5f * (b + d);
+        col[0][c] = quantize_bits(a,            limit[c]);
+        col[1][c] = quantize_bits(a + 4.0f * b, limit[c]);
+        col[2][c] = quantize_bits(a + 4.0f * d, limit[c]);
+    }
+    float error = etc_planar_error(rgb, col[0], col[1], col[2]);
+    if (quality >= ENCODER_QUALITY_NORMAL)
+    {
+        size_t passes = (quality >= ENCODER_QUALITY_HIGH) ? 8 : 2;
+        for (size_t pass = 0; pass < passes && error > 0.0f; ++pass)
+        {
+            bool improved = false;
+            for (size_t k = 0; k < 3; ++k)
+            {
+                for (size_t c = 0; c < 3; ++c)
+                {
+                    for (int d = -1; d <= 1; d += 2)
+                    {
+                        int old = col[k][c];
+                        if (old + d < 0 || old + d > limit[c]) continue;
+                        col[k][c] = old + d;
+                        float e = etc_planar_error(rgb, col[0], col[1], col[2]);
+                        if (e < error) { error = e; improved = true; }
+                        else col[k][c] = old;
+                    }
+                }
+            }
+            if (!improved) break;
+        }
+    }
+
+    int ro = col[0][0], go = col[0][1], bo = col[0][2];
+    int rh = col[1][0], gh = col[1][1], bh = col[1][2];
+    int rv = col[2][0], gv = col[2][1], bv = col[2][2];
+    uint8_t *data = out->data;
+    data[0] = (uint8_t) ((ro << 1) | (go >> 6));
+    data[1] = (uint8_t) (((go & 0x3F) << 1) | (bo >> 5));
+    data[2] = (uint8_t) ((bo & 0x18) | ((bo >> 1) & 0x03));
+    data[3] = (uint8_t) (((bo & 1) << 7) | ((rh >> 1) << 2) | 2 | (rh & 1));
+    data[4] = (uint8_t) ((gh << 1) | (bh >> 5));
+    data[5] = (uint8_t) (((bh & 0x1F) << 3) | (rv >> 3));
+    data[6] = (uint8_t) (((rv & 0x07) << 5) | (gv >> 2));
+    data[7] = (uint8_t) (((gv & 0x03) << 6) | bv);
+
+    // the planar mode is signaled by a differential-mode block where the red
+    // and green channels are in range and the blue channel overflows. set
+    // the unused bits 63, 55, 47-45 and 42 to produce that pattern.
+    int r = data[0] >> 3, dr = (data[0] & 3) - (data[0] & 4);
+    if (r + dr < 0 || r + dr > 31) data[0] |= 0x80;
+    int g = data[1] >> 3, dg = (data[1] & 3) - (data[1] & 4);
+    if (g + dg < 0 || g + dg > 31) data[1] |= 0x80;
+    int bh2 = (data[2] >> 3) & 3, bl2 = data[2] & 3;
+    if (bh2 + bl2 > 3) data[2] |= 0xE0; // b >= 28, db >= 0; sum > 31.
+    else               data[2] |= 0x04; // b <= 3, db < 0; sum < 0.
+    out->error = error;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static void etc_color_from_texels(
+    encoder_block_t const *block,
+    float                  rgb[3][ETC_BLOCK_TEXELS])
+{
+    for (size_t i = 0; i < ETC_BLOCK_TEXELS; ++i)
+    {
+        rgb[0][i] = clamp_255(block->texels[0][i]);
+        rgb[1][i] = clamp_255(block->texels[1][i]);
+        rgb[2][i] = clamp_255(block->texels[2][i]);
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static void etc2_fit_block(
+    float const  rgb[3][ETC_BLOCK_TEXELS],
+    int32_t      quality,
+    etc_block_t *best)
+{
+    etc_block_t planar;
+    etc1_fit_block(rgb, quality, best);
+    if (best->error > 0.0f)
+    {
+        etc2_planar_block(rgb, quality, &planar);
+        if (planar.error < best->error) *best = planar;
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static float eac_palette_error(
+    float const *values,
+    int          base,
+    int          mul,
+    int          table,
+    uint8_t     *index)
+{
+    float pal[8];
+    for (size_t i = 0; i < 8; ++i)
+    {
+        pal[i] = (float) clamp_int(base + EAC_MODIFIERS[table][i] * mul, 0, 255);
+    }
+    return encoder_select_scalar(values, pal, index);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Encodes 16 alpha values in [0, 255] as a 64-bit EAC block. For each table,
+/// the multiplier and base are derived from the value range; higher quality
+/// settings search a window around those values.
+static void eac_encode_block(float const *values, int32_t quality, uint8_t *out)
+{
+    uint8_t index[ETC_BLOCK_TEXELS];
+    uint8_t best_index[ETC_BLOCK_TEXELS];
+    float   vmin = values[0];
+    float   vmax = values[0];
+    for (size_t i = 1; i < ETC_BLOCK_TEXELS; ++i)
+    {
+        vmin = CMN_MIN(vmin, values[i]);
+        vmax = CMN_MAX(vmax, values[i]);
+    }
+    int   mul_window  = (quality >= ENCODER_QUALITY_HIGH) ? 2 : ((quality >= ENCODER_QUALITY_NORMAL) ? 1 : 0);
+    int   base_window = (quality >= ENCODER_QUALITY_HIGH) ? 4 : ((quality >= ENCODER_QUALITY_NORMAL) ? 1 : 0);
+    float best        = FLT_MAX;
+    int   best_base   = 0;
+    int   best_mul    = 1;
+    int   best_table  = 0;
+    for (int t = 0; t < 16 && best > 0.0f; ++t)
+    {
+        int   lo  = EAC_MODIFIERS[t][3];
+        int   hi  = EAC_MODIFIERS[t][7];
+        int   mul = clamp_int((int) ((vmax - vmin) / (hi - lo) + 0.5f), 1, 15);
+        int   bas = clamp_int((int) (vmin - lo * mul + 0.5f), 0, 255);
+        for (int m = mul - mul_window; m <= mul + mul_window; ++m)
+        {
+            if (m < 1 || m > 15) continue;
+            for (int b = bas - base_window; b <= bas + base_window; ++b)
+            {
+                if (b < 0 || b > 255) continue;
+                float e = eac_palette_error(values, b, m, t, index);
+                if (e < best)
+                {
+                    best       = e;
+                    best_base  = b;
+                    best_mul   = m;
+                    best_table = t;
+                    memcpy(best_index, index, sizeof(index));
+                }
+            }
+        }
+    }
+
+    // the 48 index bits are stored MSB-first in pixel order x * 4 + y.
+    uint64_t bits = 0;
+    for (size_t y = 0; y < 4; ++y)
+    {
+        for (size_t x = 0; x < 4; ++x)
+        {
+            size_t k = x * 4 + y;
+            bits    |= (uint64_t) best_index[y * 4 + x] << (45 - 3 * k);
+        }
+    }
+    out[0] = (uint8_t) best_base;
+    out[1] = (uint8_t) ((best_mul << 4) | best_table);
+    for (size_t i = 0; i < 6; ++i)
+    {
+        out[2 + i] = (uint8_t) ((bits >> (40 - 8 * i)) & 0xFF);
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void CMN_CALL_C encode_block_etc1(
+    encoder_block_t const *block,
+    int32_t                quality,
+    void                  *out_data)
+{
+    float       rgb[3][ETC_BLOCK_TEXELS];
+    etc_block_t best;
+    etc_color_from_texels(block, rgb);
+    etc1_fit_block(rgb, quality, &best);
+    memcpy(out_data, best.data, 8);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void CMN_CALL_C encode_block_etc2_rgb(
+    encoder_block_t const *block,
+    int32_t                quality,
+    void                  *out_data)
+{
+    float       rgb[3][ETC_BLOCK_TEXELS];
+    etc_block_t best;
+    etc_color_from_texels(block, rgb);
+    etc2_fit_block(rgb, quality, &best);
+    memcpy(out_data, best.data, 8);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void CMN_CALL_C encode_block_etc2_rgba(
+    encoder_block_t const *block,
+    int32_t                quality,
+    void                  *out_data)
+{
+    float       rgb[3][ETC_BLOCK_TEXELS];
+    float       alpha[ETC_BLOCK_TEXELS];
+    etc_block_t best;
+    uint8_t    *out = (uint8_t*) out_data;
+    for (size_t i = 0; i < ETC_BLOCK_TEXELS; ++i)
+    {
+        alpha[i] = clamp_255(block->texels[3][i]);
+    }
+    eac_encode_block(alpha, quality, out);
+    etc_color_from_texels(block, rgb);
+    etc2_fit_block(rgb, quality, &best);
+    memcpy(out + 8, best.data, 8);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void CMN_CALL_C encode_block_etc1s(
+    encoder_block_t const *block,
+    int32_t                quality,
+    void                  *out_data)
+{
+    float       rgb[3][ETC_BLOCK_TEXELS];
+    etc_block_t best;
+    etc_color_from_texels(block, rgb);
+    etc1s_fit_block(rgb, quality, &best);
+    memcpy(out_data, best.data, 8);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void CMN_CALL_C encode_block_etc1s_rgba(
+    encoder_block_t const *block,
+    int32_t                quality,
+    void                  *out_data)
+{
+    float       rgb[3][ETC_BLOCK_TEXELS];
+    etc_block_t best;
+    uint8_t    *out = (uint8_t*) out_data;
+
+    // the alpha block is an ETC1S block with alpha replicated into RGB.
+    for (size_t i = 0; i < ETC_BLOCK_TEXELS; ++i)
+    {
+        rgb[0][i] = rgb[1][i] = rgb[2][i] = clamp_255(block->texels[3][i]);
+    }
+    etc1s_fit_block(rgb, quality, &best);
+    memcpy(out, best.data, 8);
+    etc_color_from_texels(block, rgb);
+    etc1s_fit_block(rgb, quality, &best);
+    memcpy(out + 8, best.data, 8);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void* buffer_to_blocks_etc1(image::buffer_t *buffer, int32_t quality)
+{
+    return encode_blocks(buffer, 4, 4, 8, encode_block_etc1, quality, NULL);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void* buffer_to_blocks_etc2_rgb(image::buffer_t *buffer, int32_t quality)
+{
+    return encode_blocks(buffer, 4, 4, 8, encode_block_etc2_rgb, quality, NULL);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void* buffer_to_blocks_etc2_rgba(image::buffer_t *buffer, int32_t quality)
+{
+    return encode_blocks(buffer, 4, 4, 16, encode_block_etc2_rgba, quality, NULL);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void* buffer_to_blocks_etc1s(image::buffer_t *buffer, int32_t quality)
+{
+    return encode_blocks(buffer, 4, 4, 8, encode_block_etc1s, quality, NULL);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void* buffer_to_blocks_etc1s_rgba(image::buffer_t *buffer, int32_t quality)
+{
+    return encode_blocks(buffer, 4, 4, 16, encode_block_etc1s_rgba, quality, NULL);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/*/////////////////////////////////////////////////////////////////////////////
+//    $Id$
+///////////////////////////////////////////////////////////////////////////80*/
@@ -0,0 +1,653 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implements an encoder for the PowerVR PVRTC 2bpp and 4bpp formats.
+/// PVRTC stores two low-resolution color images that are bilinearly upscaled
+/// and blended per-pixel by a full-resolution modulation image. The encoder
+/// builds the low-resolution images from per-block color ranges, selects the
+/// modulation for every pixel, and then refines the low-resolution colors
+/// with a least-squares solve, processing rows of blocks in parallel.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////
+//   Includes   //
+////////////////*/
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "encoder.hpp"
+#include "parallel.hpp"
+
+/*//////////////////////////
+//   Using Declarations   //
+//////////////////////////*/
+
+/*//////////////////////
+//   Implementation   //
+//////////////////////*/
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// The state shared by the passes of the PVRTC encoder. Texel data is copied
+/// into a padded RGBA image with values in [0, 255].
+struct pvrtc_job_t
+{
+    size_t    width;            /// The padded image width, in pixels.
+    size_t    height;           /// The padded image height, in pixels.
+    size_t    block_w;          /// The block width: 8 for 2bpp, 4 for 4bpp.
+    size_t    block_h;          /// The block height, always 4.
+    size_t    blocks_x;         /// The number of blocks in each row.
+    size_t    blocks_y;         /// The number of rows of blocks.
+    int32_t   quality;          /// One of encoder_quality_e.
+    float    *texels[4];        /// The padded RGBA image planes.
+    uint16_t *color_a;          /// The packed color A of each block.
+    uint16_t *color_b;          /// The packed color B of each block.
+    uint16_t *next_a;           /// Refined color A, written in parallel.
+    uint16_t *next_b;           /// Refined color B, written in parallel.
+    uint8_t  *modulation;       /// The modulation index of each pixel.
+    float    *row_error;        /// The squared error of each row of blocks.
+};
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static inline int clamp_int(int v, int lo, int hi)
+{
+    return (v < lo) ? lo : ((v > hi) ? hi : v);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static inline int quantize_bits(float v, int max_value)
+{
+    return clamp_int((int) (v * max_value / 255.0f + 0.5f), 0, max_value);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Packs color A. Opaque colors are stored as RGB554; translucent colors as
+/// ARGB3443. Bit 0 is the modulation mode flag and is always zero.
+static uint16_t pack_color_a(float const *c)
+{
+    int a = quantize_bits(c[3], 7);
+    if (7 == a)
+    {
+        return (uint16_t) (0x8000 |
+            (quantize_bits(c[0], 31) << 10) |
+            (quantize_bits(c[1], 31) <<  5) |
+            (quantize_bits(c[2], 15) <<  1));
+    }
+    return (uint16_t) ((a << 12) |
+        (quantize_bits(c[0], 15) << 8) |
+        (quantize_bits(c[1], 15) << 4) |
+        (quantize_bits(c[2],  7) << 1));
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Packs color B. Opaque colors are stored as RGB555; translucent colors as
+/// ARGB3444.
+static uint16_t pack_color_b(float const *c)
+{
+    int a = quantize_bits(c[3], 7);
+    if (7 == a)
+    {
+        return (uint16_t) (0x8000 |
+            (quantize_bits(c[0], 31) << 10) |
+            (quantize_bits(c[1], 31) <<  5) |
+            (quantize_bits(c[2], 31) <<  0));
+    }
+    return (uint16_t) ((a << 12) |
+        (quantize_bits(c[0], 15) << 8) |
+        (quantize_bits(c[1], 15) << 4) |
+        (quantize_bits(c[2], 15) << 0));
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Unpacks color A to 5-bit RGB and 4-bit alpha, as the hardware does.
+static void unpack_color_a(uint16_t c, int *out)
+{
+    if (c & 0x8000)
+    {
+        out[0] = (c >> 10) & 0x1F;
+        out[1] = (c >>  5) & 0x1F;
+        out[2] = (c & 0x1E) | ((c & 0x1E) >> 4);
+        out[3] = 0x0F;
+    }
+    else
+    {
+        out[0] = ((c >> 7) & 0x1E) | ((c >> 11) & 1);
+        out[1] = ((c >> 3) & 0x1E) | ((c >>  7) & 1);
+        out[2] = ((c << 1) & 0x1C) | ((c >>  2) & 3);
+        out[3] = (c >> 11) & 0x0E;
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Unpacks color B to 5-bit RGB and 4-bit alpha, as the hardware does.
+static void unpack_color_b(uint16_t c, int *out)
+{
+    if (c & 0x8000)
+    {
+        out[0] = (c >> 10) & 0x1F;
+        out[1] = (c >>  5) & 0x1F;
+        out[2] = (c >>  0) & 0x1F;
+        out[3] = 0x0F;
+    }
+    else
+    {
+        out[0] = ((c >> 7) & 0x1E) | ((c >> 11) & 1);
+        out[1] = ((c >> 3) & 0x1E) | ((c >>  7) & 1);
+        out[2] = ((c << 1) & 0x1E) | ((c >>  3) & 1);
+        out[3] = (c >> 11) & 0x0E;
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Unpacks a color to floating-point values in [0, 255].
+static void unpack_color_f(uint16_t c, bool is_b, float *out)
+{
+    int v[4];
+    if (is_b) unpack_color_b(c, v);
+    else      unpack_color_a(c, v);
+    out[0] = v[0] * (255.0f / 31.0f);
+    out[1] = v[1] * (255.0f / 31.0f);
+    out[2] = v[2] * (255.0f / 31.0f);
+    out[3] = v[3] * (255.0f / 15.0f);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// The four blocks contributing to a pixel and their bilinear weights. The
+/// low-resolution images wrap around at the edges of the texture.
+struct pvrtc_footprint_t
+{
+    size_t block[4];            /// Block indices: (0,0), (1,0), (0,1), (1,1).
+    int    weight[4];           /// Integer weights, summing to block_w * 4.
+};
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static void pvrtc_footprint(
+    pvrtc_job_t const *job,
+    size_t             px,
+    size_t             py,
+    pvrtc_footprint_t *out)
+{
+    // block centers are at (block_w / 2, block_h / 2) within each block.
+    size_t bw  = job->block_w;
+    size_t bh  = job->block_h;
+    size_t fx  = (px + job->width  - bw / 2) % job->width;
+    size_t fy  = (py + job->height - bh / 2) % job->height;
+    size_t bx0 =  fx / bw;
+    size_t by0 =  fy / bh;
+    size_t bx1 = (bx0 + 1) % job->blocks_x;
+    size_t by1 = (by0 + 1) % job->blocks_y;
+    int    wx  = (int) (fx - bx0 * bw);
+    int    wy  = (int) (fy - by0 * bh);
+    int    nw  = (int)  bw;
+    int    nh  = (int)  bh;
+    out->block[0]  = by0 * job->blocks_x + bx0;
+    out->block[1]  = by0 * job->blocks_x + bx1;
+    out->block[2]  = by1 * job->blocks_x + bx0;
+    out->block[3]  = by1 * job->blocks_x + bx1;
+    out->weight[0] = (nw - wx) * (nh - wy);
+    out->weight[1] = (wx)      * (nh - wy);
+    out->weight[2] = (nw - wx) * (wy);
+    out->weight[3] = (wx)      * (wy);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Computes the 8-bit upscaled A and B colors at a pixel, matching the
+/// integer arithmetic of the decoder.
+static void pvrtc_upscale(
+    pvrtc_job_t const       *job,
+    pvrtc_footprint_t const *fp,
+    int                     *out_a,
+    int                     *out_b)
+{
+    int sa[4] = { 0, 0, 0, 0 };
+    int sb[4] = { 0, 0, 0, 0 };
+    for (size_t k = 0; k < 4; ++k)
+    {
+        int ca[4], cb[4];
+        unpack_color_a(job->color_a[fp->block[k]], ca);
+        unpack_color_b(job->color_b[fp->block[k]], cb);
+        for (size_t c = 0; c < 4; ++c)
+        {
+            sa[c] += ca[c] * fp->weight[k];
+            sb[c] += cb[c] * fp->weight[k];
+        }
+    }
+    if (8 == job->block_w)
+    {
+        for (size_t c = 0; c < 3; ++c)
+        {
+            out_a[c] = (sa[c] >> 7) + (sa[c] >> 2);
+            out_b[c] = (sb[c] >> 7) + (sb[c] >> 2);
+        }
+        out_a[3] = (sa[3] >> 5) + (sa[3] >> 1);
+        out_b[3] = (sb[3] >> 5) + (sb[3] >> 1);
+    }
+    else
+    {
+        for (size_t c = 0; c < 3; ++c)
+        {
+            out_a[c] = (sa[c] >> 6) + (sa[c] >> 1);
+            out_b[c] = (sb[c] >> 6) + (sb[c] >> 1);
+        }
+        out_a[3] = (sa[3] >> 4) + sa[3];
+        out_b[3] = (sb[3] >> 4) + sb[3];
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Returns the modulation weights (out of 8) for the encoding mode in use.
+/// The 4bpp mode stores 2 bits per pixel; the 2bpp mode stores 1 bit.
+static inline size_t pvrtc_weights(pvrtc_job_t const *job, int const **out)
+{
+    static int const w4[4] = { 0, 3, 5, 8 };
+    static int const w2[2] = { 0, 8 };
+    if (8 == job->block_w) { *out = w2; return 2; }
+    else                   { *out = w4; return 4; }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Computes the initial low-resolution colors of a row of blocks from the
+/// extent of the block texels along their principal axis.
+static void CMN_CALL_C pvrtc_init_row(size_t row, void *context)
+{
+    pvrtc_job_t *job = (pvrtc_job_t*) context;
+    size_t       bw  = job->block_w;
+    size_t       bh  = job->block_h;
+    size_t       n   = bw * bh;
+    for (size_t bx = 0; bx < job->blocks_x; ++bx)
+    {
+        float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        float axis[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        float cov[4][4];
+        memset(cov, 0, sizeof(cov));
+        for (size_t y = 0; y < bh; ++y)
+        {
+            for (size_t x = 0; x < bw; ++x)
+            {
+                size_t i = (row * bh + y) * job->width + (bx * bw + x);
+                for (size_t c = 0; c < 4; ++c)
+                    mean[c] += job->texels[c][i];
+            }
+        }
+        for (size_t c = 0; c < 4; ++c)
+            mean[c] /= (float) n;
+        for (size_t y = 0; y < bh; ++y)
+        {
+            for (size_t x = 0; x < bw; ++x)
+            {
+                size_t i = (row * bh + y) * job->width + (bx * bw + x);
+                float  d[4];
+                for (size_t c = 0; c < 4; ++c)
+                    d[c] = job->texels[c][i] - mean[c];
+                for (size_t r = 0; r < 4; ++r)
+                    for (size_t c = 0; c < 4; ++c)
+                        cov[r][c] += d[r] * d[c];
+            }
+        }
+        // power iteration for the dominant axis.
+        axis[0] = axis[1] = axis[2] = 1.0f;
+        for (size_t iter = 0; iter < 8; ++iter)
+        {
+            float v[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            float m    = 0.0f;
+            for (size_t r = 0; r < 4; ++r)
+            {
+                for (size_t c = 0; c < 4; ++c)
+                    v[r] += cov[r][c] * axis[c];
+                m = CMN_MAX(m, fabsf(v[r]));
+            }
+            if (m < FLT_EPSILON) break;
+            for (size_t c = 0; c < 4; ++c)
+                axis[c] = v[c] / m;
+        }
+        float len2 = 0.0f;
+        float tmin = 0.0f;
+        float tmax = 0.0f;
+        for (size_t c = 0; c < 4; ++c)
+            len2 += axis[c] * axis[c];
+        for (size_t y = 0; y < bh; ++y)
+        {
+            for (size_t x = 0; x < bw; ++x)
+            {
+                size_t i = (row * bh + y) * job->width + (bx * bw + x);
+                float  t = 0.0f;
+                for (size_t c = 0; c < 4; ++c)
+                    t += (job->texels[c][i] - mean[c]) * axis[c];
+                tmin = CMN_MIN(tmin, t);
+                tmax = CMN_MAX(tmax, t);
+            }
+        }
+        if (len2 > FLT_EPSILON)
+        {
+            tmin /= len2;
+            tmax /= len2;
+        }
+        float ca[4], cb[4];
+        for (size_t c = 0; c < 4; ++c)
+        {
+            ca[c] = CMN_MAX(0.0f, CMN_MIN(255.0f, mean[c] + axis[c] * tmin));
+            cb[c] = CMN_MAX(0.0f, CMN_MIN(255.0f, mean[c] + axis[c] * tmax));
+        }
+        job->color_a[row * job->blocks_x + bx] = pack_color_a(ca);
+        job->color_b[row * job->blocks_x + bx] = pack_color_b(cb);
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Selects the modulation value for every pixel in a row of blocks, given
+/// the current low-resolution colors, and records the error of the row.
+static void CMN_CALL_C pvrtc_modulate_row(size_t row, void *context)
+{
+    pvrtc_job_t *job     = (pvrtc_job_t*) context;
+    int const   *weights = NULL;
+    size_t       count   = pvrtc_weights(job, &weights);
+    float        error   = 0.0f;
+    for (size_t py = row * job->block_h; py < (row + 1) * job->block_h; ++py)
+    {
+        for (size_t px = 0; px < job->width; ++px)
+        {
+            pvrtc_footprint_t fp;
+            size_t            i = py * job->width + px;
+            int               a[4], b[4];
+            float             best = FLT_MAX;
+            uint8_t           bidx = 0;
+            pvrtc_footprint(job, px, py, &fp);
+            pvrtc_upscale(job, &fp, a, b);
+            for (size_t m = 0; m < count; ++m)
+            {
+                float e = 0.0f;
+                for (size_t c = 0; c < 4; ++c)
+                {
+                    int   v = (a[c] * (8 - weights[m]) + b[c] * weights[m]) / 8;
+                    float d = job->texels[c][i] - (float) v;
+                    e += d * d;
+                }
+                if (e < best) { best = e; bidx = (uint8_t) m; }
+            }
+            job->modulation[i] = bidx;
+            error += best;
+        }
+    }
+    job->row_error[row] = error;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Solves for the colors of each block in a row minimizing the error over
+/// all pixels the block contributes to, holding the neighboring blocks and
+/// the modulation fixed. Results are written to next_a and next_b.
+static void CMN_CALL_C pvrtc_refine_row(size_t row, void *context)
+{
+    pvrtc_job_t *job     = (pvrtc_job_t*) context;
+    int const   *weights = NULL;
+    size_t       bw      = job->block_w;
+    size_t       bh      = job->block_h;
+    float        total   = (float) (bw * bh);
+    pvrtc_weights(job, &weights);
+    for (size_t bx = 0; bx < job->blocks_x; ++bx)
+    {
+        size_t cur = row * job->blocks_x + bx;
+        float  aa  = 0.0f, ab = 0.0f, bb = 0.0f;
+        float  ar[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        float  br[4]= { 0.0f, 0.0f, 0.0f, 0.0f };
+        float  old_a[4], old_b[4];
+        unpack_color_f(job->color_a[cur], false, old_a);
+        unpack_color_f(job->color_b[cur], true,  old_b);
+
+        // visit the pixels within one block of the block center.
+        size_t cx = bx  * bw + bw / 2 + job->width;
+        size_t cy = row * bh + bh / 2 + job->height;
+        for (size_t oy = 0; oy < 2 * bh - 1; ++oy)
+        {
+            for (size_t ox = 0; ox < 2 * bw - 1; ++ox)
+            {
+                pvrtc_footprint_t fp;
+                size_t px = (cx + ox - (bw - 1)) % job->width;
+                size_t py = (cy + oy - (bh - 1)) % job->height;
+                size_t i  = py * job->width + px;
+                float  m  = weights[job->modulation[i]] / 8.0f;
+                float  wc = 0.0f;
+                float  r[4];
+                pvrtc_footprint(job, px, py, &fp);
+                for (size_t c = 0; c < 4; ++c)
+                    r[c] = job->texels[c][i];
+                for (size_t k = 0; k < 4; ++k)
+                {
+                    float w = fp.weight[k] / total;
+                    if (fp.block[k] == cur)
+                    {
+                        wc += w;
+                        continue;
+                    }
+                    float ca[4], cb[4];
+                    unpack_color_f(job->color_a[fp.block[k]], false, ca);
+                    unpack_color_f(job->color_b[fp.block[k]], true,  cb);
+                    for (size_t c = 0; c < 4; ++c)
+                        r[c] -= w * ((1.0f - m) * ca[c] + m * cb[c]);
+                }
+                float wa = wc * (1.0f - m);
+                float wb = wc * m;
+                aa += wa * wa; ab += wa * wb; bb += wb * wb;
+                for (size_t c = 0; c < 4; ++c)
+                {
+                    ar[c] += wa * r[c];
+                    br[c] += wb * r[c];
+                }
+            }
+        }
+
+        float new_a[4], new_b[4];
+        float det = aa * bb - ab * ab;
+        for (size_t c = 0; c < 4; ++c)
+        {
+            if (fabsf(det) > 1e-6f)
+            {
+                new_a[c] = (ar[c] * bb - br[c] * ab) / det;
+                new_b[c] = (br[c] * aa - ar[c] * ab) / det;
+            }
+            else
+            {
+                // only one of the colors is in use; solve for it alone.
+                new_a[c] = (aa > 1e-6f) ? (ar[c] - ab * old_b[c]) / aa : old_a[c];
+                new_b[c] = (bb > 1e-6f) ? (br[c] - ab * old_a[c]) / bb : old_b[c];
+            }
+            new_a[c] = CMN_MAX(0.0f, CMN_MIN(255.0f, new_a[c]));
+            new_b[c] = CMN_MAX(0.0f, CMN_MIN(255.0f, new_b[c]));
+        }
+        job->next_a[cur] = pack_color_a(new_a);
+        job->next_b[cur] = pack_color_b(new_b);
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static float pvrtc_modulate(pvrtc_job_t *job)
+{
+    float error = 0.0f;
+    parallel_for(job->blocks_y, pvrtc_modulate_row, job);
+    for (size_t i = 0; i < job->blocks_y; ++i)
+        error += job->row_error[i];
+    return error;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Computes the position of a block in the Morton (twiddled) block order
+/// used by PVRTC. Y occupies the low bit of each pair; bits beyond the
+/// smaller dimension come from the larger dimension.
+static size_t pvrtc_twiddle(size_t bx, size_t by, size_t nx, size_t ny)
+{
+    size_t min_dim = CMN_MIN(nx, ny);
+    size_t index   = 0;
+    size_t shift   = 0;
+    for (size_t bit = 1; bit < min_dim; bit <<= 1, ++shift)
+    {
+        if (by & bit) index |= (size_t) 1 << (2 * shift);
+        if (bx & bit) index |= (size_t) 1 << (2 * shift + 1);
+    }
+    size_t rest = (nx > ny) ? (bx >> shift) : (by >> shift);
+    return index | (rest << (2 * shift));
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static void pvrtc_pack(pvrtc_job_t const *job, uint8_t *output)
+{
+    for (size_t by = 0; by < job->blocks_y; ++by)
+    {
+        for (size_t bx = 0; bx < job->blocks_x; ++bx)
+        {
+            size_t   b   = by * job->blocks_x + bx;
+            uint32_t mod = 0;
+            uint32_t col = ((uint32_t) job->color_b[b] << 16) | (job->color_a[b] & 0xFFFE);
+            for (size_t y = 0; y < job->block_h; ++y)
+            {
+                for (size_t x = 0; x < job->block_w; ++x)
+                {
+                    size_t   i = (by * job->block_h + y) * job->width + (bx * job->block_w + x);
+                    uint32_t m = job->modulation[i];
+                    if (8 == job->block_w) mod |= m << (y * 8 + x);
+                    else                   mod |= m << (2 * (y * 4 + x));
+                }
+            }
+            size_t   t = pvrtc_twiddle(bx, by, job->blocks_x, job->blocks_y);
+            uint8_t *o = output + t * 8;
+            o[0] = (uint8_t) (mod      );  o[1] = (uint8_t) (mod >>  8);
+            o[2] = (uint8_t) (mod >> 16);  o[3] = (uint8_t) (mod >> 24);
+            o[4] = (uint8_t) (col      );  o[5] = (uint8_t) (col >>  8);
+            o[6] = (uint8_t) (col >> 16);  o[7] = (uint8_t) (col >> 24);
+        }
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void* buffer_to_pvrtc(
+    image::buffer_t *buffer,
+    size_t           bits_per_pixel,
+    int32_t          quality,
+    size_t          *out_size)
+{
+    pvrtc_job_t job;
+    size_t      bw     = (2 == bits_per_pixel) ? 8 : 4;
+    size_t      width  = CMN_MAX(buffer->channel_width,  bw * 2);
+    size_t      height = CMN_MAX(buffer->channel_height, (size_t) 8);
+    width  = ((width  + bw - 1) / bw) * bw;
+    height = ((height + 3) / 4) * 4;
+    size_t      npix   = width * height;
+    if (out_size) *out_size = 0;
+
+    job.width     = width;
+    job.height    = height;
+    job.block_w   = bw;
+    job.block_h   = 4;
+    job.blocks_x  = width  / job.block_w;
+    job.blocks_y  = height / job.block_h;
+    job.quality   = quality;
+
+    size_t nblocks = job.blocks_x * job.blocks_y;
+    size_t nbytes  = nblocks * 8;
+    float   *planes = (float*)    malloc(npix * 4 * sizeof(float));
+    uint16_t*colors = (uint16_t*) malloc(nblocks * 4 * sizeof(uint16_t));
+    uint8_t *mod    = (uint8_t*)  malloc(npix);
+    float   *rerr   = (float*)    malloc(job.blocks_y * sizeof(float));
+    uint8_t *output = (uint8_t*)  malloc(nbytes);
+    if (!planes || !colors || !mod || !rerr || !output)
+    {
+        free(planes); free(colors); free(mod); free(rerr); free(output);
+        return NULL;
+    }
+    job.color_a    = colors;
+    job.color_b    = colors + nblocks;
+    job.next_a     = colors + nblocks * 2;
+    job.next_b     = colors + nblocks * 3;
+    job.modulation = mod;
+    job.row_error  = rerr;
+
+    // copy the source into the padded RGBA image. levels smaller than the
+    // minimum PVRTC dimensions are padded by repeating the edge texels.
+    for (size_t c = 0; c < 4; ++c)
+        job.texels[c] = planes + c * npix;
+    for (size_t y = 0; y < height; ++y)
+    {
+        size_t sy = CMN_MIN(y, buffer->channel_height - 1);
+        for (size_t x = 0; x < width; ++x)
+        {
+            encoder_block_t texel;
+            size_t          sx = CMN_MIN(x, buffer->channel_width - 1);
+            encoder_fetch_block(buffer, sx, sy, 1, 1, &texel);
+            for (size_t c = 0; c < 4; ++c)
+            {
+                float v = texel.texels[c][0] * 255.0f;
+                job.texels[c][y * width + x] = CMN_MAX(0.0f, CMN_MIN(255.0f, v));
+            }
+        }
+    }
+
+    // build the low-resolution images, then alternate between selecting the
+    // modulation and refining the low-resolution colors.
+    parallel_for(job.blocks_y, pvrtc_init_row, &job);
+    float  error = pvrtc_modulate(&job);
+    size_t iters = 0;
+    switch (quality)
+    {
+        case ENCODER_QUALITY_FAST:   iters = 1; break;
+        case ENCODER_QUALITY_NORMAL: iters = 3; break;
+        default:                     iters = 8; break;
+    }
+    for (size_t i = 0; i < iters && error > 0.0f; ++i)
+    {
+        uint16_t *old_a = job.color_a;
+        uint16_t *old_b = job.color_b;
+        parallel_for(job.blocks_y, pvrtc_refine_row, &job);
+        job.color_a = job.next_a; job.next_a = old_a;
+        job.color_b = job.next_b; job.next_b = old_b;
+        float e = pvrtc_modulate(&job);
+        if (e >= error)
+        {
+            // no improvement; restore the previous colors and modulation.
+            job.next_a  = job.color_a; job.color_a = old_a;
+            job.next_b  = job.color_b; job.color_b = old_b;
+            pvrtc_modulate(&job);
+            break;
+        }
+        error = e;
+    }
+    pvrtc_pack(&job, output);
+
+    free(planes); free(colors); free(mod); free(rerr);
+    if (out_size) *out_size = nbytes;
+    return output;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void* buffer_to_blocks_pvrtc2(image::buffer_t *buffer, int32_t quality)
+{
+    return buffer_to_pvrtc(buffer, 2, quality, NULL);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void* buffer_to_blocks_pvrtc4(image::buffer_t *buffer, int32_t quality)
+{
+    return buffer_to_pvrtc(buffer, 4, quality, NULL);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/*/////////////////////////////////////////////////////////////////////////////
+//    $Id$
+///////////////////////////////////////////////////////////////////////////80*/
@@ -0,0 +1,145 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implements the XXH64 content hash. See the reference at
+/// https://github.com/Cyan4973/xxHash for a description of the algorithm.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////
+//   Includes   //
+////////////////*/
+#include <stdio.h>
+#include <string.h>
+#include "hash.hpp"
+
+/*//////////////////////////
+//   Using Declarations   //
+//////////////////////////*/
+
+/*//////////////////////
+//   Implementation   //
+//////////////////////*/
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+#define XXH_PRIME64_1   UINT64_C(11400714785074694791)
+#define XXH_PRIME64_2   UINT64_C(14029467366897019727)
+#define XXH_PRIME64_3   UINT64_C( 1609587929392839161)
+#define XXH_PRIME64_4   UINT64_C( 9650029242287828579)
+#define XXH_PRIME64_5   UINT64_C( 2870177450012600261)
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static inline uint64_t rotl64(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Reads a little-endian value; all supported platforms are little-endian.
+static inline uint64_t read_u64(uint8_t const *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(uint64_t));
+    return v;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static inline uint32_t read_u32(uint8_t const *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(uint32_t));
+    return v;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static inline uint64_t xxh_round(uint64_t acc, uint64_t input)
+{
+    acc += input * XXH_PRIME64_2;
+    acc  = rotl64(acc, 31);
+    return acc * XXH_PRIME64_1;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static inline uint64_t xxh_merge_round(uint64_t acc, uint64_t val)
+{
+    acc ^= xxh_round(0, val);
+    return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+uint64_t content_hash(void const *data, size_t size, uint64_t seed)
+{
+    uint8_t const *p   = (uint8_t const*) data;
+    uint8_t const *end = p + size;
+    uint64_t       h   = 0;
+
+    if (size >= 32)
+    {
+        // four independent lanes, 32 bytes per stripe.
+        uint8_t const *limit = end - 32;
+        uint64_t v1 = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+        uint64_t v2 = seed + XXH_PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - XXH_PRIME64_1;
+        do
+        {
+            v1 = xxh_round(v1, read_u64(p)); p += 8;
+            v2 = xxh_round(v2, read_u64(p)); p += 8;
+            v3 = xxh_round(v3, read_u64(p)); p += 8;
+            v4 = xxh_round(v4, read_u64(p)); p += 8;
+        } while (p <= limit);
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = xxh_merge_round(h, v1);
+        h = xxh_merge_round(h, v2);
+        h = xxh_merge_round(h, v3);
+        h = xxh_merge_round(h, v4);
+    }
+    else h = seed + XXH_PRIME64_5;
+
+    h += (uint64_t) size;
+    while (p + 8 <= end)
+    {
+        h ^= xxh_round(0, read_u64(p));
+        h  = rotl64(h, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+        p += 8;
+    }
+    if (p + 4 <= end)
+    {
+        h ^= (uint64_t) read_u32(p) * XXH_PRIME64_1;
+        h  = rotl64(h, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+        p += 4;
+    }
+    while (p < end)
+    {
+        h ^= (uint64_t) (*p++) * XXH_PRIME64_5;
+        h  = rotl64(h, 11) * XXH_PRIME64_1;
+    }
+
+    // final avalanche.
+    h ^= h >> 33;
+    h *= XXH_PRIME64_2;
+    h ^= h >> 29;
+    h *= XXH_PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+char* content_hash_string(uint64_t hash, char *out_str)
+{
+    unsigned long hi = (unsigned long) (hash >> 32);
+    unsigned long lo = (unsigned long) (hash & 0xFFFFFFFFU);
+    sprintf(out_str, "%08lx%08lx", hi, lo);
+    return out_str;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/*/////////////////////////////////////////////////////////////////////////////
+//    $Id$
+///////////////////////////////////////////////////////////////////////////80*/
@@ -0,0 +1,59 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Defines the interface to the content hash used to identify level
+/// data, so that unchanged outputs can be detected without comparing bytes.
+///////////////////////////////////////////////////////////////////////////80*/
+#ifndef TEXTURE_COMPILER_HASH_HPP_INCLUDED
+#define TEXTURE_COMPILER_HASH_HPP_INCLUDED
+
+/*////////////////
+//   Includes   //
+////////////////*/
+#include "commondefs.hpp"
+
+/*///////////////////////
+//   Namespace Begin   //
+///////////////////////*/
+
+/*////////////////////////////
+//   Forward Declarations   //
+////////////////////////////*/
+
+/*//////////////////////////////////
+//   Public Types and Functions   //
+//////////////////////////////////*/
+/// Define the number of characters in a hash string, excluding the nul.
+#ifndef CONTENT_HASH_STRING_LENGTH
+#define CONTENT_HASH_STRING_LENGTH  16U
+#endif /* !defined(CONTENT_HASH_STRING_LENGTH) */
+
+/// Computes the 64-bit XXH64 hash of a block of data. Data written in several
+/// pieces can be hashed by passing the hash of the previous piece as the seed
+/// for the next; the result depends on how the data is split.
+/// @param data The data to hash.
+/// @param size The size of the data, in bytes.
+/// @param seed The seed value, or the hash of the preceding data.
+/// @return The hash value.
+CMN_PUBLIC uint64_t content_hash(
+    void const *data,
+    size_t      size,
+    uint64_t    seed);
+
+/// Formats a hash value as a string of hexadecimal digits. JavaScript numbers
+/// cannot represent every 64-bit value, so hashes are exchanged as strings.
+/// @param hash The hash value.
+/// @param out_str The buffer to receive the string, which must hold at least
+/// CONTENT_HASH_STRING_LENGTH + 1 characters.
+/// @return The @a out_str buffer.
+CMN_PUBLIC char*    content_hash_string(
+    uint64_t    hash,
+    char       *out_str);
+
+/*/////////////////////
+//   Namespace End   //
+/////////////////////*/
+
+#endif /* TEXTURE_COMPILER_HASH_HPP_INCLUDED */
+
+/*/////////////////////////////////////////////////////////////////////////////
+//    $Id$
+///////////////////////////////////////////////////////////////////////////80*/
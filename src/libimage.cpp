@@ -14,6 +14,10 @@
 #include <string.h>
 #include "libimage.hpp"
 
+#if CMN_HAVE_SSE2
+    #include <emmintrin.h>
+#endif
+
 /*//////////////////////////
 //   Using Declarations   //
 //////////////////////////*/
@@ -72,8 +76,11 @@ static const float Sobel_9x9[] =
 
 static inline ptrdiff_t repeat_remainder(int32_t a, size_t b)
 {
-    if (a >= 0) return (a % b);
-    return (a + 1) % b + b - 1;
+    // use signed arithmetic; a negative a would otherwise be converted to
+    // a huge unsigned value before the remainder is taken.
+    ptrdiff_t n = (ptrdiff_t) b;
+    if (a >= 0) return (a % n);
+    return (a + 1) % n + n - 1;
 }
 
 /*/////////////////////////////////////////////////////////////////////////80*/
@@ -116,9 +123,11 @@ bool image::is_plain_format(int32_t image_format)
         case image::FORMAT_RGBA16:
         case image::FORMAT_R16F:
         case image::FORMAT_RG16F:
+        case image::FORMAT_RGB16F:
         case image::FORMAT_RGBA16F:
         case image::FORMAT_R32F:
         case image::FORMAT_RG32F:
+        case image::FORMAT_RGB32F:
         case image::FORMAT_RGBA32F:
             return true;
 
@@ -135,9 +144,11 @@ bool image::is_float_format(int32_t image_format)
     {
         case image::FORMAT_R16F:
         case image::FORMAT_RG16F:
+        case image::FORMAT_RGB16F:
         case image::FORMAT_RGBA16F:
         case image::FORMAT_R32F:
         case image::FORMAT_RG32F:
+        case image::FORMAT_RGB32F:
         case image::FORMAT_RGBA32F:
             return true;
 
@@ -153,6 +164,11 @@ bool image::is_packed_format(int32_t image_format)
     switch (image_format)
     {
         case image::FORMAT_RGB10A2:
+        case image::FORMAT_RGB9E5:
+        case image::FORMAT_R11G11B10F:
+        case image::FORMAT_RGB565:
+        case image::FORMAT_RGBA4444:
+        case image::FORMAT_RGBA5551:
             return true;
 
         case image::FORMAT_PVRTC1:
@@ -183,6 +199,17 @@ bool image::is_compressed_format(int32_t image_format)
         case image::FORMAT_BC5:
         case image::FORMAT_BC5_XY:
         case image::FORMAT_ATI2N_DXT5:
+        case image::FORMAT_ETC1:
+        case image::FORMAT_ETC2_RGB8:
+        case image::FORMAT_ETC2_RGBA8_EAC:
+        case image::FORMAT_ETC1S:
+        case image::FORMAT_ETC1S_RGBA:
+        case image::FORMAT_BC7:
+        case image::FORMAT_BC6H_UF16:
+        case image::FORMAT_BC6H_SF16:
+        case image::FORMAT_ASTC_4x4:
+        case image::FORMAT_ASTC_6x6:
+        case image::FORMAT_ASTC_8x8:
         case image::FORMAT_PVRTC1:
         case image::FORMAT_PVRTC2:
             return true;
@@ -211,6 +238,14 @@ bool image::is_block_compressed_format(int32_t image_format)
         case image::FORMAT_BC5:
         case image::FORMAT_BC5_XY:
         case image::FORMAT_ATI2N_DXT5:
+        case image::FORMAT_ETC1:
+        case image::FORMAT_ETC2_RGB8:
+        case image::FORMAT_ETC2_RGBA8_EAC:
+        case image::FORMAT_ETC1S:
+        case image::FORMAT_ETC1S_RGBA:
+        case image::FORMAT_BC7:
+        case image::FORMAT_BC6H_UF16:
+        case image::FORMAT_BC6H_SF16:
             return true;
 
         default: break;
@@ -235,6 +270,22 @@ bool image::is_pvrtc_compressed_format(int32_t image_format)
 
 /*/////////////////////////////////////////////////////////////////////////80*/
 
+bool image::is_astc_compressed_format(int32_t image_format)
+{
+    switch (image_format)
+    {
+        case image::FORMAT_ASTC_4x4:
+        case image::FORMAT_ASTC_6x6:
+        case image::FORMAT_ASTC_8x8:
+            return true;
+
+        default: break;
+    }
+    return false;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
 size_t image::face_count(int32_t attributes)
 {
     return (attributes & image::ATTRIBUTES_CUBEMAP) ? 6 : 1;
@@ -267,11 +318,21 @@ size_t image::channel_count(int32_t image_format)
             return 2;
 
         case image::FORMAT_RGB8:
+        case image::FORMAT_RGB16F:
+        case image::FORMAT_RGB32F:
+        case image::FORMAT_RGB565:
         case image::FORMAT_BC3_XGBR:
         case image::FORMAT_BC3_RXBG:
         case image::FORMAT_BC3_RBXG:
         case image::FORMAT_BC3_XRBG:
         case image::FORMAT_BC3_RGXB:
+        case image::FORMAT_ETC1:
+        case image::FORMAT_ETC2_RGB8:
+        case image::FORMAT_ETC1S:
+        case image::FORMAT_BC6H_UF16:
+        case image::FORMAT_BC6H_SF16:
+        case image::FORMAT_RGB9E5:
+        case image::FORMAT_R11G11B10F:
             return 3;
 
         case image::FORMAT_RGBA8:
@@ -279,9 +340,17 @@ size_t image::channel_count(int32_t image_format)
         case image::FORMAT_RGBA16F:
         case image::FORMAT_RGBA32F:
         case image::FORMAT_RGB10A2:
+        case image::FORMAT_RGBA4444:
+        case image::FORMAT_RGBA5551:
         case image::FORMAT_BC1:
         case image::FORMAT_BC2:
         case image::FORMAT_BC3:
+        case image::FORMAT_ETC2_RGBA8_EAC:
+        case image::FORMAT_ETC1S_RGBA:
+        case image::FORMAT_BC7:
+        case image::FORMAT_ASTC_4x4:
+        case image::FORMAT_ASTC_6x6:
+        case image::FORMAT_ASTC_8x8:
         case image::FORMAT_PVRTC1:
         case image::FORMAT_PVRTC2:
             return 4;
@@ -295,12 +364,15 @@ size_t image::channel_count(int32_t image_format)
 
 size_t image::bytes_per_block(int32_t image_format)
 {
-    // @note: 1 block is 4x4 = 16 pixels
-    // @note: dimensions must be evenly divisible by four (mip levels included)
+    // @note: 1 block is 4x4 = 16 pixels, except for ASTC formats.
+    // @note: see image::block_dimensions() for the block footprint.
     switch (image_format)
     {
         case image::FORMAT_BC1:
         case image::FORMAT_BC4:
+        case image::FORMAT_ETC1:
+        case image::FORMAT_ETC2_RGB8:
+        case image::FORMAT_ETC1S:
             return 8;
 
         case image::FORMAT_BC2:
@@ -314,6 +386,14 @@ size_t image::bytes_per_block(int32_t image_format)
         case image::FORMAT_BC5:
         case image::FORMAT_BC5_XY:
         case image::FORMAT_ATI2N_DXT5:
+        case image::FORMAT_ETC2_RGBA8_EAC:
+        case image::FORMAT_ETC1S_RGBA:
+        case image::FORMAT_BC7:
+        case image::FORMAT_BC6H_UF16:
+        case image::FORMAT_BC6H_SF16:
+        case image::FORMAT_ASTC_4x4:
+        case image::FORMAT_ASTC_6x6:
+        case image::FORMAT_ASTC_8x8:
             return 16;
 
         default:
@@ -323,6 +403,32 @@ size_t image::bytes_per_block(int32_t image_format)
 
 /*/////////////////////////////////////////////////////////////////////////80*/
 
+void image::block_dimensions(
+    int32_t image_format,
+    size_t *out_width,
+    size_t *out_height)
+{
+    switch (image_format)
+    {
+        case image::FORMAT_ASTC_6x6:
+            *out_width  = 6;
+            *out_height = 6;
+            break;
+
+        case image::FORMAT_ASTC_8x8:
+            *out_width  = 8;
+            *out_height = 8;
+            break;
+
+        default:
+            *out_width  = 4;
+            *out_height = 4;
+            break;
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
 size_t image::bytes_per_pixel(int32_t image_format)
 {
     switch (image_format)
@@ -333,16 +439,27 @@ size_t image::bytes_per_pixel(int32_t image_format)
         case image::FORMAT_R16:
         case image::FORMAT_R16F:
         case image::FORMAT_RG8:
+        case image::FORMAT_RGB565:
+        case image::FORMAT_RGBA4444:
+        case image::FORMAT_RGBA5551:
             return 2;
 
         case image::FORMAT_RGB8:
             return 3;
 
+        case image::FORMAT_RGB16F:
+            return 6;
+
+        case image::FORMAT_RGB32F:
+            return 12;
+
         case image::FORMAT_R32F:
         case image::FORMAT_RG16:
         case image::FORMAT_RG16F:
         case image::FORMAT_RGBA8:
         case image::FORMAT_RGB10A2:
+        case image::FORMAT_RGB9E5:
+        case image::FORMAT_R11G11B10F:
             return 4;
 
         case image::FORMAT_RG32F:
@@ -374,12 +491,14 @@ size_t image::bytes_per_channel(int32_t image_format)
         case image::FORMAT_R16F:
         case image::FORMAT_RG16:
         case image::FORMAT_RG16F:
+        case image::FORMAT_RGB16F:
         case image::FORMAT_RGBA16:
         case image::FORMAT_RGBA16F:
             return 2;
 
         case image::FORMAT_R32F:
         case image::FORMAT_RG32F:
+        case image::FORMAT_RGB32F:
         case image::FORMAT_RGBA32F:
             return 4;
 
@@ -486,12 +605,16 @@ size_t image::miplevel_slice_size(
         }
         else
         {
-            // @note: block-compressed textures operate on 4x4 blocks
-            // of pixels, so they are padded to be evenly divisible by
-            // four. account for that behavior when calculating size.
+            // @note: block-compressed textures operate on blocks of
+            // pixels (4x4, or the ASTC footprint), so they are padded to
+            // a whole number of blocks. account for that behavior when
+            // calculating size.
+            size_t block_w = 4;
+            size_t block_h = 4;
+            image::block_dimensions(image_format, &block_w, &block_h);
             level_size =
-                ((level_width  + 3) >> 2) *
-                ((level_height + 3) >> 2) *
+                ((level_width  + block_w - 1) / block_w) *
+                ((level_height + block_h - 1) / block_h) *
                 image::bytes_per_block(image_format);
         }
     }
@@ -1588,6 +1711,22 @@ float image::channel_minimum(
     float   channel_min   = std::numeric_limits<float>::max();
     size_t  channel_els   = channel_width   * channel_height;
     float  *channel_end   = channel_values  + channel_els;
+#if CMN_HAVE_SSE2
+    // _mm_min_ps() returns its second operand if either is NaN, so NaN
+    // values are skipped the same way as in the scalar comparison.
+    __m128  acc           = _mm_set1_ps(channel_min);
+    while  (channel_end  - channel_values >= 4)
+    {
+        acc = _mm_min_ps(_mm_loadu_ps(channel_values), acc);
+        channel_values += 4;
+    }
+    CMN_ALIGN_BEGIN(16) float lanes[4] CMN_ALIGN_END(16);
+    _mm_store_ps(lanes, acc);
+    for (size_t i = 0; i < 4; ++i)
+    {
+        if (lanes[i] < channel_min) channel_min = lanes[i];
+    }
+#endif
     while  (channel_end  != channel_values)
     {
         float v = *channel_values++;
@@ -1603,19 +1742,108 @@ float image::channel_maximum(
     size_t  channel_width,
     size_t  channel_height)
 {
-    float   channel_max   = std::numeric_limits<float>::min();
+    // numeric_limits<float>::min() is the smallest positive value.
+    float   channel_max   =-std::numeric_limits<float>::max();
     size_t  channel_els   = channel_width   * channel_height;
     float  *channel_end   = channel_values  + channel_els;
+#if CMN_HAVE_SSE2
+    __m128  acc           = _mm_set1_ps(channel_max);
+    while  (channel_end  - channel_values >= 4)
+    {
+        acc = _mm_max_ps(_mm_loadu_ps(channel_values), acc);
+        channel_values += 4;
+    }
+    CMN_ALIGN_BEGIN(16) float lanes[4] CMN_ALIGN_END(16);
+    _mm_store_ps(lanes, acc);
+    for (size_t i = 0; i < 4; ++i)
+    {
+        if (lanes[i] > channel_max) channel_max = lanes[i];
+    }
+#endif
     while  (channel_end  != channel_values)
     {
         float v = *channel_values++;
-        if   (v <  channel_max) channel_max = v;
+        if   (v >  channel_max) channel_max = v;
     }
     return channel_max;
 }
 
 /*/////////////////////////////////////////////////////////////////////////80*/
 
+bool image::channel_equal(
+    float const *channel_a,
+    float const *channel_b,
+    size_t       channel_width,
+    size_t       channel_height)
+{
+    size_t  channel_els   = channel_width   * channel_height;
+    size_t  row_els       = channel_width;
+    // compare a row at a time without branching, but stop at the first
+    // row that differs. NaN compares unequal to everything, as in C.
+    for (size_t i = 0; i < channel_els; i += row_els)
+    {
+        float const *a    = channel_a + i;
+        float const *b    = channel_b + i;
+        int          diff = 0;
+        size_t       j    = 0;
+#if CMN_HAVE_SSE2
+        __m128 ne = _mm_setzero_ps();
+        for (; j + 4 <= row_els; j += 4)
+        {
+            ne = _mm_or_ps(ne, _mm_cmpneq_ps(_mm_loadu_ps(a + j), _mm_loadu_ps(b + j)));
+        }
+        diff = _mm_movemask_ps(ne);
+#endif
+        for (; j < row_els; ++j)
+        {
+            diff |= (a[j] != b[j]);
+        }
+        if (diff) return false;
+    }
+    return true;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+double image::channel_squared_error(
+    float const *channel_a,
+    float const *channel_b,
+    size_t       channel_width,
+    size_t       channel_height)
+{
+    size_t  row_els = channel_width;
+    double  total   = 0.0;
+    // accumulate in single precision within a row and in double precision
+    // across rows, so large images don't lose the small per-row sums.
+    for (size_t y = 0; y < channel_height; ++y)
+    {
+        float const *a   = channel_a + y * row_els;
+        float const *b   = channel_b + y * row_els;
+        float        sum = 0.0f;
+        size_t       x   = 0;
+#if CMN_HAVE_SSE2
+        __m128 acc = _mm_setzero_ps();
+        for (; x + 4 <= row_els; x += 4)
+        {
+            __m128 d = _mm_sub_ps(_mm_loadu_ps(a + x), _mm_loadu_ps(b + x));
+            acc      = _mm_add_ps(acc, _mm_mul_ps(d, d));
+        }
+        CMN_ALIGN_BEGIN(16) float lanes[4] CMN_ALIGN_END(16);
+        _mm_store_ps(lanes, acc);
+        sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+        for (; x < row_els; ++x)
+        {
+            float d = a[x] - b[x];
+            sum    += d * d;
+        }
+        total += sum;
+    }
+    return total;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
 float image::channel_average(
     float  *channel_values,
     size_t  channel_width,
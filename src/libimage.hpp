@@ -133,6 +133,73 @@ enum format_e
     /// A compressed PowerVR 4-bpp format containing four channels of data and
     /// suitable for encoding ARGB images.
     FORMAT_PVRTC2           = 29,
+    /// The image contains three channels of data, tightly packed into 16 bits
+    /// with 5 bits for red, 6 bits for green and 5 bits for blue.
+    FORMAT_RGB565           = 30,
+    /// The image contains four channels of data, tightly packed into 16 bits
+    /// with 4 bits for each of red, green, blue and alpha.
+    FORMAT_RGBA4444         = 31,
+    /// The image contains four channels of data, tightly packed into 16 bits
+    /// with 5 bits for each of red, green and blue and 1 bit of alpha.
+    FORMAT_RGBA5551         = 32,
+    /// The image contains three channels of data, with elements stored as
+    /// 16-bit half-precision floating-point values.
+    FORMAT_RGB16F           = 33,
+    /// The image contains three channels of data, with elements stored as
+    /// 32-bit full-precision floating-point values.
+    FORMAT_RGB32F           = 34,
+    /// Each element consists of a block of 4x4 pixels stored in the ETC1
+    /// compressed format, consuming a total of 64 bits. Only RGB information
+    /// can be encoded.
+    FORMAT_ETC1             = 35,
+    /// Each element consists of a block of 4x4 pixels stored in the ETC2 RGB8
+    /// compressed format, consuming a total of 64 bits. ETC2 decoders also
+    /// accept ETC1 data. Only RGB information can be encoded.
+    FORMAT_ETC2_RGB8        = 36,
+    /// Each element consists of a block of 4x4 pixels stored in the ETC2
+    /// RGBA8 format, consuming a total of 128 bits: a 64-bit EAC alpha block
+    /// followed by a 64-bit ETC2 RGB8 color block.
+    FORMAT_ETC2_RGBA8_EAC   = 37,
+    /// Each element consists of a block of 4x4 pixels stored in the BC7
+    /// (BPTC) format, consuming a total of 128 bits. RGBA information is
+    /// encoded using one of eight block modes.
+    FORMAT_BC7              = 38,
+    /// Each element consists of a block of 4x4 pixels stored in the BC6H
+    /// unsigned floating-point format, consuming a total of 128 bits. Only
+    /// RGB information can be encoded.
+    FORMAT_BC6H_UF16        = 39,
+    /// Each element consists of a block of 4x4 pixels stored in the BC6H
+    /// signed floating-point format, consuming a total of 128 bits. Only
+    /// RGB information can be encoded.
+    FORMAT_BC6H_SF16        = 40,
+    /// Each element consists of a block of 4x4 pixels stored in the ASTC LDR
+    /// format, consuming a total of 128 bits (8 bits per pixel.)
+    FORMAT_ASTC_4x4         = 41,
+    /// Each element consists of a block of 6x6 pixels stored in the ASTC LDR
+    /// format, consuming a total of 128 bits (3.56 bits per pixel.)
+    FORMAT_ASTC_6x6         = 42,
+    /// Each element consists of a block of 8x8 pixels stored in the ASTC LDR
+    /// format, consuming a total of 128 bits (2 bits per pixel.)
+    FORMAT_ASTC_8x8         = 43,
+    /// Each element consists of a block of 4x4 pixels stored in the ETC1S
+    /// intermediate format, consuming a total of 64 bits. ETC1S blocks are
+    /// valid ETC1 blocks with one base color and modifier table, and can be
+    /// transcoded to BC1 or ETC1 at load time. Only RGB can be encoded.
+    FORMAT_ETC1S            = 44,
+    /// Each element consists of a block of 4x4 pixels stored in the ETC1S
+    /// intermediate format with alpha, consuming a total of 128 bits: a 64-
+    /// bit ETC1S alpha block followed by a 64-bit ETC1S color block. Can be
+    /// transcoded to BC3, or to ETC1 with a separate alpha texture.
+    FORMAT_ETC1S_RGBA       = 45,
+    /// The image contains three channels of unsigned floating-point data,
+    /// tightly packed into 32 bits as a 9-bit mantissa for each of red, green
+    /// and blue and a 5-bit exponent shared by all three.
+    FORMAT_RGB9E5           = 46,
+    /// The image contains three channels of unsigned floating-point data,
+    /// tightly packed into 32 bits with 11 bits each for red and green (5-bit
+    /// exponent, 6-bit mantissa) and 10 bits for blue (5-bit exponent, 5-bit
+    /// mantissa.)
+    FORMAT_R11G11B10F       = 47,
     /// Forces the storage size of enumeration values to 32-bits.
     FORMAT_FORCE_32BIT      = CMN_FORCE_32BIT
 };
@@ -425,7 +492,7 @@ CMN_PUBLIC bool is_packed_format(int32_t image_format);
 CMN_PUBLIC bool is_compressed_format(int32_t image_format);
 
 /// Determines whether a particular image::format_e value stores data in a
-/// block-compressed (DXT/S3TC) format.
+/// format compressed as fixed-size 4x4 blocks (DXT/S3TC, RGTC or ETC).
 ///
 /// @param image_format One of the values of the image::format_e enumeration.
 /// @return true if @a image_format specifies a block-compressed image data
@@ -440,6 +507,14 @@ CMN_PUBLIC bool is_block_compressed_format(int32_t image_format);
 /// format.
 CMN_PUBLIC bool is_pvrtc_compressed_format(int32_t image_format);
 
+/// Determines whether a particular image::format_e value stores data in the
+/// ASTC compressed format, which uses blocks of varying footprint.
+///
+/// @param image_format One of the values of the image::format_e enumeration.
+/// @return true if @a image_format specifies an ASTC compressed image data
+/// format.
+CMN_PUBLIC bool is_astc_compressed_format(int32_t image_format);
+
 /// Examines image attributes to determine the number of faces that should be
 /// present in an image.
 ///
@@ -462,6 +537,19 @@ CMN_PUBLIC size_t channel_count(int32_t image_format);
 /// @return The number of bytes-per-block for @a image_format.
 CMN_PUBLIC size_t bytes_per_block(int32_t image_format);
 
+/// Determines the dimensions of a single block of pixel data in a block-
+/// compressed format image. Most formats use 4x4 blocks; ASTC formats use
+/// the block footprint encoded in the format.
+///
+/// @param image_format One of the values of the image::format_e enumeration.
+/// This should specify a block-compressed image format.
+/// @param out_width On return, stores the block width, in pixels.
+/// @param out_height On return, stores the block height, in pixels.
+CMN_PUBLIC void block_dimensions(
+    int32_t image_format,
+    size_t *out_width,
+    size_t *out_height);
+
 /// Determines the number of bytes used to encode a single pixel in a non-
 /// compressed format image.
 ///
@@ -1389,6 +1477,34 @@ CMN_PUBLIC float channel_maximum(
     size_t  channel_width,
     size_t  channel_height);
 
+/// Compares two channel buffers of the same dimensions element by element.
+///
+/// @param channel_a A pointer to the first image channel buffer.
+/// @param channel_b A pointer to the second image channel buffer.
+/// @param channel_width The number of columns in the image.
+/// @param channel_height The number of rows in the image.
+/// @return true if every element of @a channel_a is equal to the element at
+/// the same location in @a channel_b.
+CMN_PUBLIC bool channel_equal(
+    float const *channel_a,
+    float const *channel_b,
+    size_t       channel_width,
+    size_t       channel_height);
+
+/// Computes the sum of the squared differences between two channel buffers of
+/// the same dimensions, as used by error metrics such as MSE and PSNR.
+///
+/// @param channel_a A pointer to the first image channel buffer.
+/// @param channel_b A pointer to the second image channel buffer.
+/// @param channel_width The number of columns in the image.
+/// @param channel_height The number of rows in the image.
+/// @return The sum of (a - b)^2 over all elements.
+CMN_PUBLIC double channel_squared_error(
+    float const *channel_a,
+    float const *channel_b,
+    size_t       channel_width,
+    size_t       channel_height);
+
 /// Examines each element in a channel buffer to determine the average value.
 ///
 /// @param channel_values A pointer to the image channel buffer.
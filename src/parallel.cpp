@@ -0,0 +1,613 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implements parallel execution of independent work items using a
+/// pool of native threads on Windows and POSIX platforms. Each participating
+/// thread owns a deque of ranges of work items. A thread splits the range it
+/// is working on, pushing the upper halves onto the bottom of its deque, and
+/// idle threads steal the largest remaining ranges from the top of the deques
+/// of busy threads.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////
+//   Includes   //
+////////////////*/
+#include "parallel.hpp"
+
+#if CMN_IS_WINDOWS
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+    #include <process.h>
+#else
+    #include <pthread.h>
+    #include <sched.h>
+    #include <unistd.h>
+#endif
+
+/*//////////////////////////
+//   Using Declarations   //
+//////////////////////////*/
+
+/*//////////////////////
+//   Implementation   //
+//////////////////////*/
+#if CMN_IS_WINDOWS
+    #define PARALLEL_THREAD_LOCAL   __declspec(thread)
+    typedef CRITICAL_SECTION        parallel_mutex_t;
+    typedef CONDITION_VARIABLE      parallel_cond_t;
+    typedef volatile LONG           parallel_atomic_t;
+#else
+    #define PARALLEL_THREAD_LOCAL   __thread
+    typedef pthread_mutex_t         parallel_mutex_t;
+    typedef pthread_cond_t          parallel_cond_t;
+    typedef volatile long           parallel_atomic_t;
+#endif
+
+/// The number of ranges each deque can hold. A thread that finds its deque
+/// full stops splitting and runs the rest of its range itself.
+#define PARALLEL_DEQUE_SIZE     256U
+
+/// The total number of deques: one per pool thread and one per thread that
+/// calls parallel_for() from outside of the pool.
+#define PARALLEL_MAX_SLOTS      (PARALLEL_MAX_THREADS + PARALLEL_MAX_CALLERS)
+
+/// The deepest nesting of parallel_for() calls on a pool thread at which the
+/// thread still steals unrelated work while it waits. Deeper waits, and all
+/// waits on threads outside of the pool, only run ranges of the loop being
+/// waited on and of the loops nested within it, which bounds the stack depth
+/// of each thread and keeps callers from being held up by unrelated work.
+#define PARALLEL_MAX_DEPTH      4U
+
+/// The number of times an idle thread looks for work before sleeping.
+#define PARALLEL_SPIN_COUNT     64U
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// The state of a single parallel_for() call.
+struct parallel_loop_t
+{
+    parallel_loop_t   *parent;          /// The loop whose item started this one.
+    parallel_task_fn   task;            /// The work item callback.
+    void              *context;         /// Application data for the callback.
+    parallel_atomic_t  remaining;       /// The number of unfinished items.
+};
+
+/// A range of work items [begin, end) of a parallel_for() call.
+struct parallel_range_t
+{
+    parallel_loop_t   *loop;            /// The loop the items belong to.
+    size_t             begin;           /// The first work item.
+    size_t             end;             /// One past the last work item.
+};
+
+/// A double-ended queue of ranges. The owning thread pushes and pops at the
+/// bottom; other threads steal from the top. The top and bottom indices only
+/// ever increase, and are reduced modulo PARALLEL_DEQUE_SIZE on access.
+struct parallel_deque_t
+{
+    parallel_mutex_t   lock;            /// Protects the fields below.
+    volatile size_t    top;             /// The index of the oldest range.
+    volatile size_t    bottom;          /// One past the newest range.
+    parallel_range_t   items[PARALLEL_DEQUE_SIZE];
+};
+
+/// The state shared by all of the threads participating in parallel work.
+/// The pool threads are started on first use and live until the process
+/// exits.
+struct parallel_pool_t
+{
+    parallel_atomic_t  state;           /// 0 = stopped, 1 = starting, 2 = running.
+    size_t             worker_count;    /// The number of pool threads.
+    parallel_atomic_t  slot_count;      /// The number of deques handed out.
+    parallel_atomic_t  sleepers;        /// The number of sleeping threads.
+    parallel_atomic_t  waiters;         /// The number of sleeping parallel_for() callers.
+    parallel_mutex_t   sleep_lock;      /// Protects the wake condition.
+    parallel_cond_t    wake;            /// Signaled when work is pushed or a loop completes.
+    parallel_deque_t   deques[PARALLEL_MAX_SLOTS];
+};
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// The global thread pool.
+static parallel_pool_t             pool;
+
+/// One plus the index of the deque owned by the current thread, or zero if
+/// the thread hasn't claimed a deque yet.
+static PARALLEL_THREAD_LOCAL size_t thread_slot = 0;
+
+/// The number of parallel_for() calls the current thread is waiting on.
+static PARALLEL_THREAD_LOCAL size_t wait_depth  = 0;
+
+/// The loop whose work item the current thread is running, if any.
+static PARALLEL_THREAD_LOCAL parallel_loop_t *current_loop = NULL;
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+#if CMN_IS_WINDOWS
+static inline void mutex_init(parallel_mutex_t *m)   { InitializeCriticalSection(m); }
+static inline void mutex_lock(parallel_mutex_t *m)   { EnterCriticalSection(m); }
+static inline void mutex_unlock(parallel_mutex_t *m) { LeaveCriticalSection(m); }
+static inline void cond_init(parallel_cond_t *c)     { InitializeConditionVariable(c); }
+static inline void cond_broadcast(parallel_cond_t *c){ WakeAllConditionVariable(c); }
+static inline void yield_thread(void)                { SwitchToThread(); }
+static inline void memory_barrier(void)              { MemoryBarrier(); }
+
+static inline void cond_wait(parallel_cond_t *c, parallel_mutex_t *m)
+{
+    SleepConditionVariableCS(c, m, INFINITE);
+}
+
+static inline long atomic_add(parallel_atomic_t *p, long v)
+{
+    return (long) InterlockedExchangeAdd(p, (LONG) v) + v;
+}
+
+static inline bool atomic_cas(parallel_atomic_t *p, long expected, long desired)
+{
+    return InterlockedCompareExchange(p, (LONG) desired, (LONG) expected) == (LONG) expected;
+}
+#else
+static inline void mutex_init(parallel_mutex_t *m)   { pthread_mutex_init(m, NULL); }
+static inline void mutex_lock(parallel_mutex_t *m)   { pthread_mutex_lock(m); }
+static inline void mutex_unlock(parallel_mutex_t *m) { pthread_mutex_unlock(m); }
+static inline void cond_init(parallel_cond_t *c)     { pthread_cond_init(c, NULL); }
+static inline void cond_broadcast(parallel_cond_t *c){ pthread_cond_broadcast(c); }
+static inline void yield_thread(void)                { sched_yield(); }
+static inline void memory_barrier(void)              { __sync_synchronize(); }
+
+static inline void cond_wait(parallel_cond_t *c, parallel_mutex_t *m)
+{
+    pthread_cond_wait(c, m);
+}
+
+static inline long atomic_add(parallel_atomic_t *p, long v)
+{
+    return __sync_add_and_fetch(p, v);
+}
+
+static inline bool atomic_cas(parallel_atomic_t *p, long expected, long desired)
+{
+    return __sync_bool_compare_and_swap(p, expected, desired);
+}
+#endif
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static bool deque_push(parallel_deque_t *d, parallel_range_t const *range)
+{
+    bool pushed = false;
+    mutex_lock(&d->lock);
+    if (d->bottom - d->top < PARALLEL_DEQUE_SIZE)
+    {
+        d->items[d->bottom % PARALLEL_DEQUE_SIZE] = *range;
+        d->bottom++;
+        pushed = true;
+    }
+    mutex_unlock(&d->lock);
+    return pushed;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Takes the newest range from a deque, as long as it was pushed at or after
+/// index floor. A thread waiting on a loop uses this to take only the ranges
+/// pushed since the loop started.
+static bool deque_pop(parallel_deque_t *d, size_t floor, parallel_range_t *out)
+{
+    bool popped = false;
+    mutex_lock(&d->lock);
+    if (d->bottom > d->top && d->bottom > floor)
+    {
+        d->bottom--;
+        *out   = d->items[d->bottom % PARALLEL_DEQUE_SIZE];
+        popped = true;
+    }
+    mutex_unlock(&d->lock);
+    return popped;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Determines whether a loop is the same as, or nested within, another.
+/// The ancestors of a loop with unfinished items are all still running.
+static bool loop_within(parallel_loop_t const *loop, parallel_loop_t const *outer)
+{
+    for ( ; loop != NULL; loop = loop->parent)
+    {
+        if (loop == outer)
+            return true;
+    }
+    return false;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Takes the oldest range from a deque.
+/// @param d The deque to steal from.
+/// @param within If not NULL, the range is taken only if it belongs to this
+/// loop or to a loop nested within it.
+/// @param out On return, the range to run.
+/// @return true if a range was taken.
+static bool deque_steal(parallel_deque_t *d, parallel_loop_t const *within, parallel_range_t *out)
+{
+    bool stolen = false;
+    if (d->bottom == d->top) return false; // don't take the lock for nothing.
+    mutex_lock(&d->lock);
+    if (d->bottom > d->top && (NULL == within ||
+        loop_within(d->items[d->top % PARALLEL_DEQUE_SIZE].loop, within)))
+    {
+        *out   = d->items[d->top % PARALLEL_DEQUE_SIZE];
+        d->top++;
+        stolen = true;
+    }
+    mutex_unlock(&d->lock);
+    return stolen;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static size_t active_slots(void)
+{
+    size_t count = (size_t) pool.slot_count;
+    return CMN_MIN(count, (size_t) PARALLEL_MAX_SLOTS);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Determines whether another thread's deque has a range waiting to be run.
+/// @param self The index of the calling thread's deque, or PARALLEL_MAX_SLOTS.
+/// @param within If not NULL, only ranges belonging to this loop or to a loop
+/// nested within it are considered.
+static bool work_available(size_t self, parallel_loop_t const *within)
+{
+    size_t count = active_slots();
+    for (size_t i = 0; i < count; ++i)
+    {
+        parallel_deque_t *d = &pool.deques[i];
+        if (i == self || d->bottom == d->top)
+            continue;
+        if (NULL == within)
+            return true;
+
+        bool found = false;
+        mutex_lock(&d->lock);
+        if (d->bottom > d->top)
+            found = loop_within(d->items[d->top % PARALLEL_DEQUE_SIZE].loop, within);
+        mutex_unlock(&d->lock);
+        if (found)
+            return true;
+    }
+    return false;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Wakes any sleeping pool threads after a range has been pushed.
+static void wake_workers(void)
+{
+    // pairs with the increment of sleepers in sleep_until_work(); either
+    // this thread sees the sleeper, or the sleeper sees the pushed range.
+    memory_barrier();
+    if (pool.sleepers > 0)
+    {
+        mutex_lock(&pool.sleep_lock);
+        cond_broadcast(&pool.wake);
+        mutex_unlock(&pool.sleep_lock);
+    }
+}
+
+/// Wakes any threads sleeping in parallel_for() after a loop has completed.
+static void wake_waiters(void)
+{
+    // pairs with the increment of waiters in sleep_until_work(); either
+    // this thread sees the waiter, or the waiter sees the completed loop.
+    memory_barrier();
+    if (pool.waiters > 0)
+    {
+        mutex_lock(&pool.sleep_lock);
+        cond_broadcast(&pool.wake);
+        mutex_unlock(&pool.sleep_lock);
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Blocks the calling thread until there may be work for it to do.
+/// @param self The index of the thread's deque, or PARALLEL_MAX_SLOTS.
+/// @param within If not NULL, only wake for ranges belonging to this loop or
+/// to a loop nested within it.
+/// @param loop The loop the thread is waiting on in parallel_for(), or NULL
+/// for an idle pool thread. The thread also wakes when the loop completes.
+static void sleep_until_work(size_t self, parallel_loop_t const *within, parallel_loop_t *loop)
+{
+    mutex_lock(&pool.sleep_lock);
+    atomic_add(&pool.sleepers, 1);
+    if (loop) atomic_add(&pool.waiters, 1);
+    if ((NULL == loop || loop->remaining > 0) && !work_available(self, within))
+    {
+        cond_wait(&pool.wake, &pool.sleep_lock);
+    }
+    if (loop) atomic_add(&pool.waiters, -1);
+    atomic_add(&pool.sleepers, -1);
+    mutex_unlock(&pool.sleep_lock);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Finds a range to run, first from the thread's own deque, then by stealing
+/// from the other deques.
+/// @param self The index of the thread's deque, or PARALLEL_MAX_SLOTS.
+/// @param floor The lowest index of the thread's own deque to take from.
+/// @param within If not NULL, only ranges belonging to this loop or to a loop
+/// nested within it are stolen from other threads.
+/// @param out On return, the range to run.
+/// @return true if a range was found.
+static bool find_work(size_t self, size_t floor, parallel_loop_t const *within, parallel_range_t *out)
+{
+    if (self < PARALLEL_MAX_SLOTS && deque_pop(&pool.deques[self], floor, out))
+        return true;
+
+    size_t count = active_slots();
+    for (size_t i = 1; i <= count; ++i)
+    {
+        size_t victim = (self + i) % count;
+        if (victim != self && deque_steal(&pool.deques[victim], within, out))
+            return true;
+    }
+    return false;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Runs a range of work items. The upper half of the range is repeatedly
+/// split off and pushed onto the thread's deque, where other threads can
+/// steal it, until a single item is left.
+static void run_range(size_t self, parallel_range_t const *range)
+{
+    parallel_loop_t *loop   = range->loop;
+    size_t           begin  = range->begin;
+    size_t           end    = range->end;
+    bool             pushed = false;
+
+    while (self < PARALLEL_MAX_SLOTS && end - begin > 1)
+    {
+        parallel_range_t upper;
+        upper.loop  = loop;
+        upper.begin = begin + (end - begin) / 2;
+        upper.end   = end;
+        if (!deque_push(&pool.deques[self], &upper))
+            break; // the deque is full; run the rest here.
+        end    = upper.begin;
+        pushed = true;
+    }
+    if (pushed) wake_workers();
+
+    parallel_loop_t *outer = current_loop;
+    current_loop = loop;
+    for (size_t i = begin; i < end; ++i)
+    {
+        loop->task(i, loop->context);
+    }
+    current_loop = outer;
+
+    // the loop may go out of scope as soon as remaining reaches zero.
+    if (0 == atomic_add(&loop->remaining, -(long) (end - begin)))
+        wake_waiters();
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static void worker_main(size_t slot)
+{
+    size_t idle = 0;
+    thread_slot = slot + 1;
+    for ( ; ; )
+    {
+        parallel_range_t range;
+        if (find_work(slot, 0, NULL, &range))
+        {
+            run_range(slot, &range);
+            idle = 0;
+        }
+        else if (++idle < PARALLEL_SPIN_COUNT)
+        {
+            yield_thread();
+        }
+        else
+        {
+            sleep_until_work(slot, NULL, NULL);
+            idle = 0;
+        }
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+#if CMN_IS_WINDOWS
+static unsigned __stdcall thread_main(void *argp)
+{
+    worker_main((size_t) argp);
+    return 0;
+}
+#else
+static void* thread_main(void *argp)
+{
+    worker_main((size_t) argp);
+    return NULL;
+}
+#endif
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Starts the pool threads, if they haven't been started already. The first
+/// caller starts them; concurrent callers wait until they are running.
+static void start_pool(void)
+{
+    if (2 == pool.state)
+    {
+        memory_barrier();
+        return;
+    }
+    if (!atomic_cas(&pool.state, 0, 1))
+    {
+        while (2 != pool.state) yield_thread();
+        memory_barrier();
+        return;
+    }
+
+    mutex_init(&pool.sleep_lock);
+    cond_init (&pool.wake);
+    for (size_t i = 0; i < PARALLEL_MAX_SLOTS; ++i)
+    {
+        mutex_init(&pool.deques[i].lock);
+        pool.deques[i].top    = 0;
+        pool.deques[i].bottom = 0;
+    }
+
+    // the calling thread counts as one of the workers.
+    size_t count   = parallel_worker_count() - 1;
+    size_t started = 0;
+#if CMN_IS_WINDOWS
+    for (size_t i = 0; i < count; ++i)
+    {
+        uintptr_t h = _beginthreadex(NULL, 0, thread_main, (void*) i, 0, NULL);
+        if (0 == h) break; // run with the threads we have.
+        CloseHandle((HANDLE) h);
+        started++;
+    }
+#else
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    for (size_t i = 0; i < count; ++i)
+    {
+        pthread_t thread;
+        if (pthread_create(&thread, &attr, thread_main, (void*) i) != 0)
+            break; // run with the threads we have.
+        started++;
+    }
+    pthread_attr_destroy(&attr);
+#endif
+    pool.worker_count = started;
+    pool.slot_count   = (long) started;
+    memory_barrier();
+    pool.state        = 2;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Retrieves the index of the deque owned by the calling thread, claiming
+/// one if necessary.
+/// @return The index of the deque, or PARALLEL_MAX_SLOTS if every deque has
+/// already been claimed by another thread.
+static size_t current_slot(void)
+{
+    if (0 == thread_slot)
+    {
+        size_t slot = (size_t) (atomic_add(&pool.slot_count, 1) - 1);
+        thread_slot = (slot < PARALLEL_MAX_SLOTS) ? slot + 1 : PARALLEL_MAX_SLOTS + 1;
+    }
+    return thread_slot - 1;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+size_t parallel_worker_count(void)
+{
+    static size_t worker_count = 0;
+    if (0 == worker_count)
+    {
+        size_t count = 1;
+#if CMN_IS_WINDOWS
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        count = (size_t) info.dwNumberOfProcessors;
+#else
+        long   n = sysconf(_SC_NPROCESSORS_ONLN);
+        count    = (n > 0) ? (size_t) n : 1;
+#endif
+        if (count < 1) count = 1;
+        if (count > PARALLEL_MAX_THREADS) count = PARALLEL_MAX_THREADS;
+        worker_count = count;
+    }
+    return worker_count;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+long parallel_atomic_add(long volatile *value, long amount)
+{
+    return atomic_add(value, amount);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void parallel_for(size_t count, parallel_task_fn task, void *context)
+{
+    if (count > 1 && parallel_worker_count() > 1)
+    {
+        start_pool();
+    }
+    if (count <= 1 || 0 == pool.worker_count || 2 != pool.state)
+    {
+        // there's no one to share the work with.
+        for (size_t i = 0; i < count; ++i)
+            task(i, context);
+        return;
+    }
+
+    parallel_loop_t  loop;
+    parallel_range_t range;
+    size_t           self  = current_slot();
+    size_t           floor = 0;
+    size_t           idle  = 0;
+
+    loop.parent     = current_loop;
+    loop.task       = task;
+    loop.context    = context;
+    loop.remaining  = (long) count;
+    range.loop      = &loop;
+    range.begin     = 0;
+    range.end       = count;
+    if (self < PARALLEL_MAX_SLOTS)
+    {
+        // ranges pushed below this index belong to enclosing loops.
+        floor = pool.deques[self].bottom;
+    }
+
+    // run our share of the items, then help with whatever is left until
+    // every item of this loop has completed. pool threads help with any
+    // work, but deeply nested waits and threads from outside of the pool
+    // only take ranges of this loop and the loops nested within it, so the
+    // stack doesn't grow without bound and a caller isn't kept waiting by
+    // unrelated work. once there is nothing to take, sleep until a range
+    // is pushed or the last item of the loop completes.
+    wait_depth++;
+    parallel_loop_t const *within = (self < pool.worker_count &&
+        wait_depth < PARALLEL_MAX_DEPTH) ? NULL : &loop;
+    run_range(self, &range);
+    while (loop.remaining > 0)
+    {
+        parallel_range_t work;
+        if (find_work(self, floor, within, &work))
+        {
+            run_range(self, &work);
+            idle = 0;
+        }
+        else if (++idle < PARALLEL_SPIN_COUNT)
+        {
+            yield_thread();
+        }
+        else
+        {
+            sleep_until_work(self, within, &loop);
+            idle = 0;
+        }
+    }
+    wait_depth--;
+    memory_barrier();
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/*/////////////////////////////////////////////////////////////////////////////
+//    $Id$
+///////////////////////////////////////////////////////////////////////////80*/
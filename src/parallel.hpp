@@ -0,0 +1,79 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Defines a minimal interface for running independent work items in
+/// parallel across all of the processors in the system. Work items are run by
+/// a work-stealing pool of threads shared by every caller, so loops nested
+/// within work items are spread across all processors as well.
+///////////////////////////////////////////////////////////////////////////80*/
+#ifndef TEXTURE_COMPILER_PARALLEL_HPP_INCLUDED
+#define TEXTURE_COMPILER_PARALLEL_HPP_INCLUDED
+
+/*////////////////
+//   Includes   //
+////////////////*/
+#include "commondefs.hpp"
+
+/*///////////////////////
+//   Namespace Begin   //
+///////////////////////*/
+
+/*////////////////////////////
+//   Forward Declarations   //
+////////////////////////////*/
+
+/*//////////////////////////////////
+//   Public Types and Functions   //
+//////////////////////////////////*/
+/// Define the maximum number of threads used to process work items.
+#ifndef PARALLEL_MAX_THREADS
+#define PARALLEL_MAX_THREADS    64U
+#endif /* !defined(PARALLEL_MAX_THREADS) */
+
+/// Define the maximum number of threads outside of the pool that can share
+/// work with the pool. Further threads run their work items on their own.
+#ifndef PARALLEL_MAX_CALLERS
+#define PARALLEL_MAX_CALLERS    64U
+#endif /* !defined(PARALLEL_MAX_CALLERS) */
+
+/// A function pointer type for a work item callback. The callback may be
+/// invoked concurrently from several threads, each with a different index.
+/// @param index The zero-based index of the work item to process.
+/// @param context Opaque application data passed to parallel_for().
+typedef void (CMN_CALL_C *parallel_task_fn)(size_t index, void *context);
+
+/// Determines the number of threads used to execute work items, which is the
+/// number of processors available in the system.
+/// @return The number of worker threads, at least 1.
+CMN_PUBLIC size_t parallel_worker_count(void);
+
+/// Atomically adds a value to a shared counter.
+/// @param value The counter to update.
+/// @param amount The value to add to the counter.
+/// @return The new value of the counter.
+CMN_PUBLIC long   parallel_atomic_add(long volatile *value, long amount);
+
+/// Executes a callback once for each index in [0, count), distributing the
+/// work items across all processors. The calling thread participates, and
+/// the function does not return until all work items have completed. While
+/// it waits, the calling thread helps with the items of this call and of the
+/// calls nested within them, and sleeps when there are none left to take.
+/// Pool threads that aren't deeply nested also help with other work. The pool
+/// threads are started on the first call and are shared by all callers, so
+/// nested loops and concurrent callers never start more threads than there
+/// are processors.
+/// @param count The number of work items.
+/// @param task The callback invoked for each work item.
+/// @param context Opaque application data passed through to @a task.
+CMN_PUBLIC void   parallel_for(
+    size_t           count,
+    parallel_task_fn task,
+    void            *context);
+
+/*/////////////////////
+//   Namespace End   //
+/////////////////////*/
+
+#endif /* TEXTURE_COMPILER_PARALLEL_HPP_INCLUDED */
+
+/*/////////////////////////////////////////////////////////////////////////////
+//    $Id$
+///////////////////////////////////////////////////////////////////////////80*/
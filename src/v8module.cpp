@@ -9,9 +9,16 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <sys/stat.h>
 #include <node.h>
+#include <node_buffer.h>
 #include <v8.h>
 #include "compiler.hpp"
+#include "compress.hpp"
+#include "container.hpp"
+#include "encoder.hpp"
+#include "hash.hpp"
+#include "parallel.hpp"
 
 /*//////////////////////////
 //   Using Declarations   //
@@ -37,6 +44,27 @@
 
 /*/////////////////////////////////////////////////////////////////////////80*/
 
+#define TILE_DEFAULT_BORDER     4   /// The default gutter around each tile.
+#define OUTPUT_WRITE_SIZE       (64U * 1024U * 1024U) /// Bytes per fwrite().
+#define NODE_BUFFER_MAX_LENGTH  0x3FFFFFFFU /// The largest node::Buffer.
+#define ENCODE_SPLIT_SIZE       (64U * 1024U * 1024U) /// Level 0 bytes encoded alone.
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+#if CMN_IS_WINDOWS
+    // the default stat structure has a 32-bit file size on Windows.
+    #define STAT_STRUCT         struct _stati64
+    #define STAT_FUNC           _stati64
+    // paths are case-insensitive on Windows.
+    #define PATH_COMPARE        _stricmp
+#else
+    #define STAT_STRUCT         struct stat
+    #define STAT_FUNC           stat
+    #define PATH_COMPARE        strcmp
+#endif
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
 enum texture_format_e
 {
     TEXTURE_FORMAT_UNKNOWN      = 0,
@@ -55,7 +83,32 @@ enum texture_format_e
     TEXTURE_FORMAT_3232_F       = 13, /// 'RG32F'
     TEXTURE_FORMAT_323232_F     = 14, /// 'RGB32F'
     TEXTURE_FORMAT_32323232_F   = 15, /// 'RGBA32F'
-    TEXTURE_FORMAT_COUNT        = 16,
+    TEXTURE_FORMAT_BC1          = 16, /// 'BC1' or 'DXT1'
+    TEXTURE_FORMAT_BC3          = 17, /// 'BC3' or 'DXT5'
+    TEXTURE_FORMAT_BC4          = 18, /// 'BC4' (default HEIGHT)
+    TEXTURE_FORMAT_BC5          = 19, /// 'BC5' (default NORMAL)
+    TEXTURE_FORMAT_ETC1         = 20, /// 'ETC1'
+    TEXTURE_FORMAT_ETC2_RGB8    = 21, /// 'ETC2' or 'ETC2_RGB8'
+    TEXTURE_FORMAT_ETC2_RGBA8   = 22, /// 'ETC2_RGBA8'
+    TEXTURE_FORMAT_PVRTC_2BPP   = 23, /// 'PVRTC_2BPP'
+    TEXTURE_FORMAT_PVRTC_4BPP   = 24, /// 'PVRTC_4BPP' or 'PVRTC'
+    TEXTURE_FORMAT_BC7          = 25, /// 'BC7'
+    TEXTURE_FORMAT_BC6H_UF16    = 26, /// 'BC6H' or 'BC6H_UF16'
+    TEXTURE_FORMAT_BC6H_SF16    = 27, /// 'BC6H_SF16'
+    TEXTURE_FORMAT_ASTC_4x4     = 28, /// 'ASTC_4x4' or 'ASTC'
+    TEXTURE_FORMAT_ASTC_6x6     = 29, /// 'ASTC_6x6'
+    TEXTURE_FORMAT_ASTC_8x8     = 30, /// 'ASTC_8x8'
+    TEXTURE_FORMAT_ETC1S        = 31, /// 'ETC1S' or 'UNIVERSAL' (RGB)
+    TEXTURE_FORMAT_ETC1S_RGBA   = 32, /// 'ETC1S_RGBA' or 'UNIVERSAL' (RGBA)
+    TEXTURE_FORMAT_RGB9E5       = 33, /// 'RGB9E5'
+    TEXTURE_FORMAT_R11G11B10F   = 34, /// 'R11G11B10F'
+    TEXTURE_FORMAT_RGB10A2      = 35, /// 'RGB10A2'
+    TEXTURE_FORMAT_RGBM         = 36, /// 'RGBM'
+    TEXTURE_FORMAT_RGBD         = 37, /// 'RGBD'
+    TEXTURE_FORMAT_16_I         = 38, /// 'R16'
+    TEXTURE_FORMAT_1616_I       = 39, /// 'RG16'
+    TEXTURE_FORMAT_16161616_I   = 40, /// 'RGBA16'
+    TEXTURE_FORMAT_COUNT        = 41,
     TEXTURE_FORMAT_FORCE_32BIT  = CMN_FORCE_32BIT
 };
 
@@ -120,6 +173,28 @@ enum texture_filter_e
 
 /*/////////////////////////////////////////////////////////////////////////80*/
 
+enum level_compression_e
+{
+    LEVEL_COMPRESSION_UNKNOWN   = 0,
+    LEVEL_COMPRESSION_NONE      = 1,  /// 'NONE' (default)
+    LEVEL_COMPRESSION_LZ4       = 2,  /// 'LZ4'
+    LEVEL_COMPRESSION_COUNT     = 3,
+    LEVEL_COMPRESSION_FORCE_32BIT = CMN_FORCE_32BIT
+};
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+enum level_order_e
+{
+    LEVEL_ORDER_UNKNOWN         = 0,
+    LEVEL_ORDER_LARGEST_FIRST   = 1,  /// 'LARGEST_FIRST' (default)
+    LEVEL_ORDER_SMALLEST_FIRST  = 2,  /// 'SMALLEST_FIRST'
+    LEVEL_ORDER_COUNT           = 3,
+    LEVEL_ORDER_FORCE_32BIT     = CMN_FORCE_32BIT
+};
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
 struct texture_compiler_args_t
 {
     char    *source_path;       /// The path of the input file.
@@ -136,6 +211,23 @@ struct texture_compiler_args_t
     bool     premultiplied;     /// Store with alpha premultiplied?
     bool     force_pow2;        /// Force to power-of-two dimensions?
     bool     build_mipmaps;     /// Do we build mipmaps for this texture?
+    bool     container;         /// Write an image::header_t before the data?
+    char    *quality;           /// One of the encoder_quality_e strings.
+    char    *compression;       /// One of the level_compression_e strings.
+    uint32_t chunk_size;        /// The uncompressed size of each chunk.
+    char    *level_order;       /// One of the level_order_e strings.
+    uint32_t level_alignment;   /// Byte alignment of each level (1 = none).
+    uint32_t tile_size;         /// Tile dimension in texels (0 = untiled.)
+    uint32_t tile_border;       /// Gutter around each tile, in texels.
+    float    hdr_range;         /// RGBM/RGBD range, or 0 to compute it.
+    float    target_psnr;       /// AUTO error budget in dB, or 0 for lossless.
+    bool     auto_compressed;   /// May AUTO choose block-compressed formats?
+    int32_t  selected_format;   /// The format chosen by AUTO, if any.
+    double   selected_psnr;     /// The PSNR of the chosen format, in dB.
+    char    *previous_hash;     /// The pixelsHash of the existing output.
+    double   previous_size;     /// The pixelsSize of the existing output.
+    char     pixels_hash[CONTENT_HASH_STRING_LENGTH + 1]; /// Output hash.
+    double   pixels_size;       /// The size of the output file, in bytes.
     uint32_t level_count;       /// The number of mipmap levels (0 = all).
     size_t   target_width;      /// The specific target width to force.
     size_t   target_height;     /// The specific target height to force.
@@ -157,9 +249,26 @@ static void init_compiler_args(texture_compiler_args_t *args)
         args->wrap_mode_s    = NULL;
         args->wrap_mode_t    = NULL;
         args->border_mode    = NULL;
+        args->quality        = NULL;
+        args->compression    = NULL;
+        args->chunk_size     = COMPRESS_DEFAULT_CHUNK_SIZE;
+        args->level_order    = NULL;
+        args->level_alignment = 1;
+        args->tile_size      = 0;
+        args->tile_border    = 0;
+        args->hdr_range      = 0.0f;
+        args->target_psnr    = 0.0f;
+        args->auto_compressed = true;
+        args->selected_format = TEXTURE_FORMAT_UNKNOWN;
+        args->selected_psnr  = 0.0;
+        args->previous_hash  = NULL;
+        args->previous_size  = 0.0;
+        args->pixels_hash[0] = 0;
+        args->pixels_size    = 0.0;
         args->flip_y         = false;
         args->premultiplied  = false;
         args->build_mipmaps  = false;
+        args->container      = false;
         args->level_count    = 0;
         args->target_width   = 0;
         args->target_height  = 0;
@@ -182,14 +291,28 @@ static void free_compiler_args(texture_compiler_args_t *args)
         SAFE_FREE(args->wrap_mode_s);
         SAFE_FREE(args->wrap_mode_t);
         SAFE_FREE(args->border_mode);
+        SAFE_FREE(args->quality);
+        SAFE_FREE(args->compression);
+        SAFE_FREE(args->level_order);
+        SAFE_FREE(args->previous_hash);
     }
 }
 
 /*/////////////////////////////////////////////////////////////////////////80*/
 
+/// Determines whether the format field requests automatic format selection,
+/// where unused channels are removed from the source image before the
+/// default format for the remaining channel count is chosen.
+static bool is_auto_format(char const *str)
+{
+    return (NULL != str && !strcmp(str, "AUTO"));
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
 static int32_t texture_format(char const *str, size_t channel_count)
 {
-    if (NULL == str || 0 == strlen(str))
+    if (NULL == str || 0 == strlen(str) || is_auto_format(str))
     {
         switch (channel_count)
         {
@@ -210,6 +333,9 @@ static int32_t texture_format(char const *str, size_t channel_count)
     if (!strcmp(str, "RGB8"))     return TEXTURE_FORMAT_888_I;
     if (!strcmp(str, "RGBA"))     return TEXTURE_FORMAT_8888_I;
     if (!strcmp(str, "RGBA8"))    return TEXTURE_FORMAT_8888_I;
+    if (!strcmp(str, "R16"))      return TEXTURE_FORMAT_16_I;
+    if (!strcmp(str, "RG16"))     return TEXTURE_FORMAT_1616_I;
+    if (!strcmp(str, "RGBA16"))   return TEXTURE_FORMAT_16161616_I;
     if (!strcmp(str, "R16F"))     return TEXTURE_FORMAT_16_F;
     if (!strcmp(str, "RG16F"))    return TEXTURE_FORMAT_1616_F;
     if (!strcmp(str, "RGB16F"))   return TEXTURE_FORMAT_161616_F;
@@ -218,6 +344,39 @@ static int32_t texture_format(char const *str, size_t channel_count)
     if (!strcmp(str, "RG32F"))    return TEXTURE_FORMAT_3232_F;
     if (!strcmp(str, "RGB32F"))   return TEXTURE_FORMAT_323232_F;
     if (!strcmp(str, "RGBA32F"))  return TEXTURE_FORMAT_32323232_F;
+    if (!strcmp(str, "RGB9E5"))     return TEXTURE_FORMAT_RGB9E5;
+    if (!strcmp(str, "R11G11B10F")) return TEXTURE_FORMAT_R11G11B10F;
+    if (!strcmp(str, "RGB10A2"))    return TEXTURE_FORMAT_RGB10A2;
+    if (!strcmp(str, "RGBM"))       return TEXTURE_FORMAT_RGBM;
+    if (!strcmp(str, "RGBD"))       return TEXTURE_FORMAT_RGBD;
+    if (!strcmp(str, "BC1"))      return TEXTURE_FORMAT_BC1;
+    if (!strcmp(str, "DXT1"))     return TEXTURE_FORMAT_BC1;
+    if (!strcmp(str, "BC3"))      return TEXTURE_FORMAT_BC3;
+    if (!strcmp(str, "DXT5"))     return TEXTURE_FORMAT_BC3;
+    if (!strcmp(str, "BC4"))      return TEXTURE_FORMAT_BC4;
+    if (!strcmp(str, "BC5"))      return TEXTURE_FORMAT_BC5;
+    if (!strcmp(str, "BC7"))      return TEXTURE_FORMAT_BC7;
+    if (!strcmp(str, "BC6H"))     return TEXTURE_FORMAT_BC6H_UF16;
+    if (!strcmp(str, "BC6H_UF16"))  return TEXTURE_FORMAT_BC6H_UF16;
+    if (!strcmp(str, "BC6H_SF16"))  return TEXTURE_FORMAT_BC6H_SF16;
+    if (!strcmp(str, "ETC1"))     return TEXTURE_FORMAT_ETC1;
+    if (!strcmp(str, "ETC2"))     return TEXTURE_FORMAT_ETC2_RGB8;
+    if (!strcmp(str, "ETC2_RGB8"))  return TEXTURE_FORMAT_ETC2_RGB8;
+    if (!strcmp(str, "ETC2_RGBA8")) return TEXTURE_FORMAT_ETC2_RGBA8;
+    if (!strcmp(str, "PVRTC"))      return TEXTURE_FORMAT_PVRTC_4BPP;
+    if (!strcmp(str, "PVRTC_2BPP")) return TEXTURE_FORMAT_PVRTC_2BPP;
+    if (!strcmp(str, "PVRTC_4BPP")) return TEXTURE_FORMAT_PVRTC_4BPP;
+    if (!strcmp(str, "ASTC"))       return TEXTURE_FORMAT_ASTC_4x4;
+    if (!strcmp(str, "ASTC_4x4"))   return TEXTURE_FORMAT_ASTC_4x4;
+    if (!strcmp(str, "ASTC_6x6"))   return TEXTURE_FORMAT_ASTC_6x6;
+    if (!strcmp(str, "ASTC_8x8"))   return TEXTURE_FORMAT_ASTC_8x8;
+    if (!strcmp(str, "ETC1S"))      return TEXTURE_FORMAT_ETC1S;
+    if (!strcmp(str, "ETC1S_RGBA")) return TEXTURE_FORMAT_ETC1S_RGBA;
+    if (!strcmp(str, "UNIVERSAL"))
+    {
+        // the intermediate format only carries alpha if the image has it.
+        return (4 == channel_count) ? TEXTURE_FORMAT_ETC1S_RGBA : TEXTURE_FORMAT_ETC1S;
+    }
     return TEXTURE_FORMAT_UNKNOWN;
 }
 
@@ -270,6 +429,29 @@ static int32_t texture_type(char const *str, size_t channel_count)
 
 /*/////////////////////////////////////////////////////////////////////////80*/
 
+/// Determines the output format for a texture. If no format is specified,
+/// height maps default to BC4 and normal maps default to BC5; otherwise the
+/// default depends on the number of channels in the source image. A format
+/// chosen by select_auto_format() takes precedence.
+static int32_t target_format(texture_compiler_args_t *args, size_t channel_count)
+{
+    char const *str = args->target_format;
+    if (TEXTURE_FORMAT_UNKNOWN != args->selected_format)
+        return args->selected_format;
+    if (NULL == str || 0 == strlen(str))
+    {
+        switch (texture_type(args->texture_type, channel_count))
+        {
+            case TEXTURE_TYPE_HEIGHT: return TEXTURE_FORMAT_BC4;
+            case TEXTURE_TYPE_NORMAL: return TEXTURE_FORMAT_BC5;
+            default:                  break;
+        }
+    }
+    return texture_format(str, channel_count);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
 static int32_t texture_wrap(char const *str)
 {
     if (NULL == str || 0 == strlen(str)) return TEXTURE_WRAP_CLAMP_TO_EDGE;
@@ -335,6 +517,37 @@ static int32_t border_sample_mode(char const *str)
 
 /*/////////////////////////////////////////////////////////////////////////80*/
 
+static int32_t encoder_quality(char const *str)
+{
+    if (NULL == str || 0 == strlen(str)) return ENCODER_QUALITY_NORMAL;
+    if (!strcmp(str, "FAST"))            return ENCODER_QUALITY_FAST;
+    if (!strcmp(str, "NORMAL"))          return ENCODER_QUALITY_NORMAL;
+    if (!strcmp(str, "HIGH"))            return ENCODER_QUALITY_HIGH;
+    return -1;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static int32_t level_compression(char const *str)
+{
+    if (NULL == str || 0 == strlen(str)) return LEVEL_COMPRESSION_NONE;
+    if (!strcmp(str, "NONE"))            return LEVEL_COMPRESSION_NONE;
+    if (!strcmp(str, "LZ4"))             return LEVEL_COMPRESSION_LZ4;
+    return LEVEL_COMPRESSION_UNKNOWN;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static int32_t level_order(char const *str)
+{
+    if (NULL == str || 0 == strlen(str))   return LEVEL_ORDER_LARGEST_FIRST;
+    if (!strcmp(str, "LARGEST_FIRST"))     return LEVEL_ORDER_LARGEST_FIRST;
+    if (!strcmp(str, "SMALLEST_FIRST"))    return LEVEL_ORDER_SMALLEST_FIRST;
+    return LEVEL_ORDER_UNKNOWN;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
 static void texture_format_bits_per_pixel(int32_t format, size_t *out_bpp)
 {
     switch (format)
@@ -346,6 +559,9 @@ static void texture_format_bits_per_pixel(int32_t format, size_t *out_bpp)
         case TEXTURE_FORMAT_88_I:       *out_bpp =  16; break;
         case TEXTURE_FORMAT_888_I:      *out_bpp =  24; break;
         case TEXTURE_FORMAT_8888_I:     *out_bpp =  32; break;
+        case TEXTURE_FORMAT_16_I:       *out_bpp =  16; break;
+        case TEXTURE_FORMAT_1616_I:     *out_bpp =  32; break;
+        case TEXTURE_FORMAT_16161616_I: *out_bpp =  64; break;
         case TEXTURE_FORMAT_16_F:       *out_bpp =  16; break;
         case TEXTURE_FORMAT_1616_F:     *out_bpp =  32; break;
         case TEXTURE_FORMAT_161616_F:   *out_bpp =  48; break;
@@ -354,12 +570,145 @@ static void texture_format_bits_per_pixel(int32_t format, size_t *out_bpp)
         case TEXTURE_FORMAT_3232_F:     *out_bpp =  64; break;
         case TEXTURE_FORMAT_323232_F:   *out_bpp =  96; break;
         case TEXTURE_FORMAT_32323232_F: *out_bpp = 128; break;
+        case TEXTURE_FORMAT_BC1:        *out_bpp =   4; break;
+        case TEXTURE_FORMAT_BC3:        *out_bpp =   8; break;
+        case TEXTURE_FORMAT_BC4:        *out_bpp =   4; break;
+        case TEXTURE_FORMAT_BC5:        *out_bpp =   8; break;
+        case TEXTURE_FORMAT_BC7:        *out_bpp =   8; break;
+        case TEXTURE_FORMAT_BC6H_UF16:  *out_bpp =   8; break;
+        case TEXTURE_FORMAT_BC6H_SF16:  *out_bpp =   8; break;
+        case TEXTURE_FORMAT_ETC1:       *out_bpp =   4; break;
+        case TEXTURE_FORMAT_ETC2_RGB8:  *out_bpp =   4; break;
+        case TEXTURE_FORMAT_ETC2_RGBA8: *out_bpp =   8; break;
+        case TEXTURE_FORMAT_PVRTC_2BPP: *out_bpp =   2; break;
+        case TEXTURE_FORMAT_PVRTC_4BPP: *out_bpp =   4; break;
+        case TEXTURE_FORMAT_ASTC_4x4:   *out_bpp =   8; break;
+        case TEXTURE_FORMAT_ASTC_6x6:   *out_bpp =   3; break; // 3.56
+        case TEXTURE_FORMAT_ASTC_8x8:   *out_bpp =   2; break;
+        case TEXTURE_FORMAT_ETC1S:      *out_bpp =   4; break;
+        case TEXTURE_FORMAT_ETC1S_RGBA: *out_bpp =   8; break;
+        case TEXTURE_FORMAT_RGB9E5:     *out_bpp =  32; break;
+        case TEXTURE_FORMAT_R11G11B10F: *out_bpp =  32; break;
+        case TEXTURE_FORMAT_RGB10A2:    *out_bpp =  32; break;
+        case TEXTURE_FORMAT_RGBM:       *out_bpp =  32; break;
+        case TEXTURE_FORMAT_RGBD:       *out_bpp =  32; break;
         default:                        *out_bpp =   0; break;
     }
 }
 
 /*/////////////////////////////////////////////////////////////////////////80*/
 
+static int32_t image_format(int32_t format)
+{
+    switch (format)
+    {
+        case TEXTURE_FORMAT_565_I:      return image::FORMAT_RGB565;
+        case TEXTURE_FORMAT_5551_I:     return image::FORMAT_RGBA5551;
+        case TEXTURE_FORMAT_4444_I:     return image::FORMAT_RGBA4444;
+        case TEXTURE_FORMAT_8_I:        return image::FORMAT_R8;
+        case TEXTURE_FORMAT_88_I:       return image::FORMAT_RG8;
+        case TEXTURE_FORMAT_888_I:      return image::FORMAT_RGB8;
+        case TEXTURE_FORMAT_8888_I:     return image::FORMAT_RGBA8;
+        case TEXTURE_FORMAT_16_I:       return image::FORMAT_R16;
+        case TEXTURE_FORMAT_1616_I:     return image::FORMAT_RG16;
+        case TEXTURE_FORMAT_16161616_I: return image::FORMAT_RGBA16;
+        case TEXTURE_FORMAT_16_F:       return image::FORMAT_R16F;
+        case TEXTURE_FORMAT_1616_F:     return image::FORMAT_RG16F;
+        case TEXTURE_FORMAT_161616_F:   return image::FORMAT_RGB16F;
+        case TEXTURE_FORMAT_16161616_F: return image::FORMAT_RGBA16F;
+        case TEXTURE_FORMAT_32_F:       return image::FORMAT_R32F;
+        case TEXTURE_FORMAT_3232_F:     return image::FORMAT_RG32F;
+        case TEXTURE_FORMAT_323232_F:   return image::FORMAT_RGB32F;
+        case TEXTURE_FORMAT_32323232_F: return image::FORMAT_RGBA32F;
+        case TEXTURE_FORMAT_BC1:        return image::FORMAT_BC1;
+        case TEXTURE_FORMAT_BC3:        return image::FORMAT_BC3;
+        case TEXTURE_FORMAT_BC4:        return image::FORMAT_BC4;
+        case TEXTURE_FORMAT_BC5:        return image::FORMAT_BC5;
+        case TEXTURE_FORMAT_BC7:        return image::FORMAT_BC7;
+        case TEXTURE_FORMAT_BC6H_UF16:  return image::FORMAT_BC6H_UF16;
+        case TEXTURE_FORMAT_BC6H_SF16:  return image::FORMAT_BC6H_SF16;
+        case TEXTURE_FORMAT_ASTC_4x4:   return image::FORMAT_ASTC_4x4;
+        case TEXTURE_FORMAT_ASTC_6x6:   return image::FORMAT_ASTC_6x6;
+        case TEXTURE_FORMAT_ASTC_8x8:   return image::FORMAT_ASTC_8x8;
+        case TEXTURE_FORMAT_ETC1S:      return image::FORMAT_ETC1S;
+        case TEXTURE_FORMAT_ETC1S_RGBA: return image::FORMAT_ETC1S_RGBA;
+        case TEXTURE_FORMAT_RGB9E5:     return image::FORMAT_RGB9E5;
+        case TEXTURE_FORMAT_R11G11B10F: return image::FORMAT_R11G11B10F;
+        case TEXTURE_FORMAT_RGB10A2:    return image::FORMAT_RGB10A2;
+        case TEXTURE_FORMAT_RGBM:       return image::FORMAT_RGBA8;
+        case TEXTURE_FORMAT_RGBD:       return image::FORMAT_RGBA8;
+        case TEXTURE_FORMAT_ETC1:       return image::FORMAT_ETC1;
+        case TEXTURE_FORMAT_ETC2_RGB8:  return image::FORMAT_ETC2_RGB8;
+        case TEXTURE_FORMAT_ETC2_RGBA8: return image::FORMAT_ETC2_RGBA8_EAC;
+        case TEXTURE_FORMAT_PVRTC_2BPP: return image::FORMAT_PVRTC1;
+        case TEXTURE_FORMAT_PVRTC_4BPP: return image::FORMAT_PVRTC2;
+        default:                        break;
+    }
+    return image::FORMAT_UNKNOWN;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Determines how far the values of a channel of a resampled mip-level may
+/// spread for the level to be stored as a single solid color. This is half of
+/// the smallest step of the target format, so storing the average changes no
+/// value by more than one step. Float and HDR formats need an exact match.
+static float constant_tolerance(int32_t format)
+{
+    switch (format)
+    {
+        case TEXTURE_FORMAT_16_I:
+        case TEXTURE_FORMAT_1616_I:
+        case TEXTURE_FORMAT_16161616_I: return 0.5f / 65535.0f;
+        case TEXTURE_FORMAT_RGB10A2:    return 0.5f / 1023.0f;
+        case TEXTURE_FORMAT_16_F:
+        case TEXTURE_FORMAT_1616_F:
+        case TEXTURE_FORMAT_161616_F:
+        case TEXTURE_FORMAT_16161616_F:
+        case TEXTURE_FORMAT_32_F:
+        case TEXTURE_FORMAT_3232_F:
+        case TEXTURE_FORMAT_323232_F:
+        case TEXTURE_FORMAT_32323232_F:
+        case TEXTURE_FORMAT_BC6H_UF16:
+        case TEXTURE_FORMAT_BC6H_SF16:
+        case TEXTURE_FORMAT_RGB9E5:
+        case TEXTURE_FORMAT_R11G11B10F:
+        case TEXTURE_FORMAT_RGBM:
+        case TEXTURE_FORMAT_RGBD:       return 0.0f;
+        default:                        break;
+    }
+    // every other format stores at most 8 bits per channel.
+    return 0.5f / 255.0f;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static int32_t image_attributes(
+    texture_compiler_args_t *args,
+    size_t                   width,
+    size_t                   height)
+{
+    int32_t  type  = texture_type(args->texture_type, 0);
+    int32_t  flags = image::basic_attributes(1, width, height, 1, 1);
+    switch  (type)
+    {
+        case TEXTURE_TYPE_HEIGHT:
+        case TEXTURE_TYPE_DISTANCE_FIELD:
+            flags |= image::ATTRIBUTES_HEIGHT;
+            break;
+        case TEXTURE_TYPE_NORMAL:
+            flags |= image::ATTRIBUTES_VECTOR;
+            break;
+        default:
+            flags |= image::ATTRIBUTES_COLOR;
+            break;
+    }
+    if (args->premultiplied) flags |= image::ATTRIBUTES_PREMULTIPLIED;
+    return flags;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
 static void level_byte_size(
     int32_t format,
     size_t  width,
@@ -370,7 +719,12 @@ static void level_byte_size(
     size_t bpp = 0;
     texture_format_bits_per_pixel(format, &bpp);
     *out_bpp   = bpp;
-    *out_size  = width * height * (bpp / 8);
+    if (image::is_compressed_format(image_format(format)))
+    {
+        // compressed levels are padded out to a whole number of blocks.
+        *out_size = image::miplevel_slice_size(image_format(format), width, height, 0);
+    }
+    else *out_size = width * height * (bpp / 8);
 }
 
 /*/////////////////////////////////////////////////////////////////////////80*/
@@ -378,6 +732,8 @@ static void level_byte_size(
 static void* level_descriptor(
     image::buffer_t *level,
     int32_t          format,
+    int32_t          quality,
+    float            hdr_range,
     size_t          *out_bpp,
     size_t          *out_size)
 {
@@ -393,6 +749,9 @@ static void* level_descriptor(
         case TEXTURE_FORMAT_88_I:       return buffer_to_pixels_8i (level, 2);
         case TEXTURE_FORMAT_888_I:      return buffer_to_pixels_8i (level, 3);
         case TEXTURE_FORMAT_8888_I:     return buffer_to_pixels_8i (level, 4);
+        case TEXTURE_FORMAT_16_I:       return buffer_to_pixels_16i(level, 1);
+        case TEXTURE_FORMAT_1616_I:     return buffer_to_pixels_16i(level, 2);
+        case TEXTURE_FORMAT_16161616_I: return buffer_to_pixels_16i(level, 4);
         case TEXTURE_FORMAT_16_F:       return buffer_to_pixels_16f(level, 1);
         case TEXTURE_FORMAT_1616_F:     return buffer_to_pixels_16f(level, 2);
         case TEXTURE_FORMAT_161616_F:   return buffer_to_pixels_16f(level, 3);
@@ -401,6 +760,28 @@ static void* level_descriptor(
         case TEXTURE_FORMAT_3232_F:     return buffer_to_pixels_32f(level, 2);
         case TEXTURE_FORMAT_323232_F:   return buffer_to_pixels_32f(level, 3);
         case TEXTURE_FORMAT_32323232_F: return buffer_to_pixels_32f(level, 4);
+        case TEXTURE_FORMAT_BC1:        return buffer_to_blocks_bc1(level, quality);
+        case TEXTURE_FORMAT_BC3:        return buffer_to_blocks_bc3(level, quality);
+        case TEXTURE_FORMAT_BC4:        return buffer_to_blocks_bc4(level, quality);
+        case TEXTURE_FORMAT_BC5:        return buffer_to_blocks_bc5(level, quality);
+        case TEXTURE_FORMAT_BC7:        return buffer_to_blocks_bc7(level, quality);
+        case TEXTURE_FORMAT_BC6H_UF16:  return buffer_to_blocks_bc6h_uf16(level, quality);
+        case TEXTURE_FORMAT_BC6H_SF16:  return buffer_to_blocks_bc6h_sf16(level, quality);
+        case TEXTURE_FORMAT_ETC1:       return buffer_to_blocks_etc1(level, quality);
+        case TEXTURE_FORMAT_ETC2_RGB8:  return buffer_to_blocks_etc2_rgb (level, quality);
+        case TEXTURE_FORMAT_ETC2_RGBA8: return buffer_to_blocks_etc2_rgba(level, quality);
+        case TEXTURE_FORMAT_PVRTC_2BPP: return buffer_to_blocks_pvrtc2(level, quality);
+        case TEXTURE_FORMAT_PVRTC_4BPP: return buffer_to_blocks_pvrtc4(level, quality);
+        case TEXTURE_FORMAT_ASTC_4x4:   return buffer_to_blocks_astc(level, 4, 4, quality);
+        case TEXTURE_FORMAT_ASTC_6x6:   return buffer_to_blocks_astc(level, 6, 6, quality);
+        case TEXTURE_FORMAT_ASTC_8x8:   return buffer_to_blocks_astc(level, 8, 8, quality);
+        case TEXTURE_FORMAT_ETC1S:      return buffer_to_blocks_etc1s(level, quality);
+        case TEXTURE_FORMAT_ETC1S_RGBA: return buffer_to_blocks_etc1s_rgba(level, quality);
+        case TEXTURE_FORMAT_RGB9E5:     return buffer_to_pixels_packed_rgb9e5(level);
+        case TEXTURE_FORMAT_R11G11B10F: return buffer_to_pixels_packed_r11g11b10f(level);
+        case TEXTURE_FORMAT_RGB10A2:    return buffer_to_pixels_packed_rgb10a2(level);
+        case TEXTURE_FORMAT_RGBM:       return buffer_to_pixels_rgbm(level, hdr_range);
+        case TEXTURE_FORMAT_RGBD:       return buffer_to_pixels_rgbd(level, hdr_range);
         default:                        break;
     }
     return NULL;
@@ -408,6 +789,308 @@ static void* level_descriptor(
 
 /*/////////////////////////////////////////////////////////////////////////80*/
 
+/// Converts a solid-color level to the target format by encoding a single
+/// pixel or block and replicating it, rather than encoding every block.
+/// @param level The level image data. Every pixel must have the same color.
+/// @param format One of the texture_format_e values.
+/// @param quality One of the encoder_quality_e values.
+/// @param hdr_range The range used by the RGBM and RGBD formats.
+/// @param out_bpp On return, stores the number of bits per-pixel.
+/// @param out_size On return, stores the size of the level data, in bytes.
+/// @return The level data. Free with free_pixels().
+static void* constant_level_descriptor(
+    image::buffer_t *level,
+    int32_t          format,
+    int32_t          quality,
+    float            hdr_range,
+    size_t          *out_bpp,
+    size_t          *out_size)
+{
+    int32_t ifmt   = image_format(format);
+    size_t  unit_w = 1;
+    size_t  unit_h = 1;
+    if (image::is_compressed_format(ifmt))
+    {
+        // PVRTC blocks depend on their neighbors, so encode it all.
+        if (!image::is_block_compressed_format(ifmt) &&
+            !image::is_astc_compressed_format(ifmt))
+            return level_descriptor(level, format, quality, hdr_range, out_bpp, out_size);
+        image::block_dimensions(ifmt, &unit_w, &unit_h);
+    }
+
+    // encode a single pixel or block of the level color.
+    image::buffer_t unit;
+    size_t  nc     = level->channel_count;
+    void   *memory = malloc(image::buffer_size(unit_w, unit_h, nc));
+    if (NULL == memory) return NULL;
+    image::buffer_init_with_memory(unit_w, unit_h, nc, memory, &unit);
+    for (size_t c = 0; c < nc; ++c)
+    {
+        float value = level->channels[c][0];
+        image::fill_channel(unit.channels[c], unit_w, unit_h, value);
+    }
+    size_t  bpp    = 0;
+    size_t  size   = 0;
+    void   *block  = level_descriptor(&unit, format, quality, hdr_range, &bpp, &size);
+    free(memory);
+    if (NULL == block) return NULL;
+
+    // replicate it across the level.
+    size_t   width  = level->channel_width;
+    size_t   height = level->channel_height;
+    level_byte_size(format, width, height, out_bpp, out_size);
+    uint8_t *pixels = (uint8_t*) malloc(*out_size);
+    if (pixels)
+    {
+        for (size_t ofs = 0; ofs < *out_size; ofs += size)
+            memcpy(pixels + ofs, block, size);
+    }
+    free_pixels(block);
+    return pixels;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// The candidate formats for AUTO with an error budget, in order of
+/// increasing size, indexed by channel count. Each list ends with the
+/// lossless 8-bit format, which is used if no smaller format is accurate
+/// enough.
+static int32_t const AUTO_CANDIDATES[5][5] = {
+    { TEXTURE_FORMAT_UNKNOWN },
+    { TEXTURE_FORMAT_BC4,    TEXTURE_FORMAT_8_I,    TEXTURE_FORMAT_UNKNOWN },
+    { TEXTURE_FORMAT_BC5,    TEXTURE_FORMAT_88_I,   TEXTURE_FORMAT_UNKNOWN },
+    { TEXTURE_FORMAT_BC1,    TEXTURE_FORMAT_565_I,  TEXTURE_FORMAT_888_I,
+      TEXTURE_FORMAT_UNKNOWN },
+    { TEXTURE_FORMAT_BC3,    TEXTURE_FORMAT_4444_I, TEXTURE_FORMAT_5551_I,
+      TEXTURE_FORMAT_8888_I, TEXTURE_FORMAT_UNKNOWN }
+};
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Decodes a BC5 block of a two-channel level for decode_blocks(), which
+/// reads the second channel from alpha as encoder_fetch_block() maps it.
+static void CMN_CALL_C decode_block_bc5_la(
+    void const      *data,
+    encoder_block_t *out_block)
+{
+    decode_block_bc5(data, out_block);
+    memcpy(out_block->texels[3], out_block->texels[1], sizeof(out_block->texels[3]));
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Encodes a level in a candidate format and measures the error of the
+/// result as read back by the GPU.
+/// @param level The level to encode.
+/// @param format One of the formats listed in AUTO_CANDIDATES.
+/// @param quality One of the encoder_quality_e values.
+/// @param scratch A buffer with the same dimensions and channel count as
+/// @a level, which receives the decoded values.
+/// @param out_psnr On return, the PSNR of the encoded level, in dB. This may
+/// be negative for HDR levels with values well above 1.0.
+/// @return true if the level was measured, or false if memory could not be
+/// allocated.
+static bool trial_psnr(
+    image::buffer_t *level,
+    int32_t          format,
+    int32_t          quality,
+    image::buffer_t *scratch,
+    double          *out_psnr)
+{
+    static size_t const bits_565 [4] = { 5, 6, 5, 0 };
+    static size_t const bits_4444[4] = { 4, 4, 4, 4 };
+    static size_t const bits_5551[4] = { 5, 5, 5, 1 };
+    static size_t const bits_8   [4] = { 8, 8, 8, 8 };
+    encoder_decode_fn   decode       = NULL;
+    size_t              block_size   = 8;
+    switch (format)
+    {
+        case TEXTURE_FORMAT_BC1:    decode = decode_block_bc1; break;
+        case TEXTURE_FORMAT_BC4:    decode = decode_block_bc4; break;
+        case TEXTURE_FORMAT_BC3:    decode = decode_block_bc3; block_size = 16; break;
+        case TEXTURE_FORMAT_BC5:    decode = decode_block_bc5_la; block_size = 16; break;
+        case TEXTURE_FORMAT_565_I:  quantize_buffer(level, bits_565,  scratch); break;
+        case TEXTURE_FORMAT_4444_I: quantize_buffer(level, bits_4444, scratch); break;
+        case TEXTURE_FORMAT_5551_I: quantize_buffer(level, bits_5551, scratch); break;
+        default:                    quantize_buffer(level, bits_8,    scratch); break;
+    }
+    if (decode)
+    {
+        size_t bpp    = 0;
+        size_t size   = 0;
+        void  *blocks = level_descriptor(level, format, quality, 0.0f, &bpp, &size);
+        if (NULL == blocks) return false;
+        decode_blocks(blocks, 4, 4, block_size, decode, scratch);
+        free_pixels(blocks);
+    }
+    *out_psnr = buffer_psnr(level, scratch);
+    return true;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Chooses the output format for AUTO with an error budget. The top level is
+/// trial-encoded in each candidate format, smallest first, and the first
+/// format that meets the budget is stored in args->selected_format.
+/// @param args The compiler arguments, with target_psnr set.
+/// @param level The top level of the texture.
+/// @return true if a format was selected, or false if memory could not be
+/// allocated.
+static bool select_auto_format(
+    texture_compiler_args_t *args,
+    image::buffer_t         *level)
+{
+    size_t   width    = level->channel_width;
+    size_t   height   = level->channel_height;
+    size_t   channels = level->channel_count;
+    int32_t  quality  = encoder_quality(args->quality);
+    void    *memory   = malloc(image::buffer_size(width, height, channels));
+    image::buffer_t scratch;
+    if (NULL == memory || channels < 1 || channels > 4)
+    {
+        free(memory);
+        return false;
+    }
+    image::buffer_init_with_memory(width, height, channels, memory, &scratch);
+
+    int32_t const *list = AUTO_CANDIDATES[channels];
+    for (size_t i = 0; list[i] != TEXTURE_FORMAT_UNKNOWN; ++i)
+    {
+        bool   last  = (list[i + 1] == TEXTURE_FORMAT_UNKNOWN);
+        bool   block = (list[i] == TEXTURE_FORMAT_BC1 ||
+                        list[i] == TEXTURE_FORMAT_BC3 ||
+                        list[i] == TEXTURE_FORMAT_BC4 ||
+                        list[i] == TEXTURE_FORMAT_BC5);
+        if (block && !args->auto_compressed)
+            continue;
+
+        double psnr = 0.0;
+        if (!trial_psnr(level, list[i], quality, &scratch, &psnr))
+        {
+            free(memory);
+            return false;
+        }
+        if (last || psnr >= (double) args->target_psnr)
+        {
+            args->selected_format = list[i];
+            args->selected_psnr   = psnr;
+            break;
+        }
+    }
+    free(memory);
+    return true;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+enum tile_state_e
+{
+    TILE_STATE_ENCODED          = 0,  /// The tile was encoded into a page.
+    TILE_STATE_CONSTANT         = 1,  /// The tile is a single solid color.
+    TILE_STATE_FAILED           = 2,  /// The tile could not be encoded.
+    TILE_STATE_FORCE_32BIT      = CMN_FORCE_32BIT
+};
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// The state shared by the threads splitting a row of tiles from a level.
+struct tile_job_t
+{
+    image::buffer_t *level;         /// The level being split into tiles.
+    size_t           row;           /// The row of tiles being processed.
+    size_t           tile_size;     /// The tile dimension, excluding gutters.
+    size_t           border;        /// The gutter around each tile.
+    int32_t          border_mode;   /// One of image::border_mode_e.
+    int32_t          format;        /// One of texture_format_e.
+    int32_t          quality;       /// One of encoder_quality_e.
+    float            hdr_range;     /// The range used by RGBM and RGBD.
+    int32_t         *state;         /// One tile_state_e per tile in the row.
+    void           **pages;         /// The encoded page for each tile.
+    float           *colors;        /// MAX_IMAGE_CHANNELS values per tile.
+    compile_progress_t *progress;   /// Checked for cancellation.
+};
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Copies a single tile and its gutter out of a level, and either encodes it
+/// into a page or, if it is a solid color, records the color instead. Tiles
+/// whose alpha channel is zero everywhere are treated as transparent black.
+static void CMN_CALL_C encode_tile(size_t index, void *context)
+{
+    tile_job_t      *job   = (tile_job_t*) context;
+    image::buffer_t *level = job->level;
+    size_t           nc    = level->channel_count;
+    size_t           page  = job->tile_size + job->border * 2;
+    float           *color = job->colors + index * MAX_IMAGE_CHANNELS;
+    ptrdiff_t        x     = (ptrdiff_t) (index    * job->tile_size) - (ptrdiff_t) job->border;
+    ptrdiff_t        y     = (ptrdiff_t) (job->row * job->tile_size) - (ptrdiff_t) job->border;
+    size_t           bpp   = 0;
+    size_t           size  = 0;
+    image::buffer_t  tile;
+
+    job->pages[index] = NULL;
+    job->state[index] = TILE_STATE_FAILED;
+    if (compile_cancelled(job->progress)) return;
+    void *memory = malloc(image::buffer_size(page, page, nc));
+    if (NULL == memory) return;
+    image::buffer_init_with_memory(page, page, nc, memory, &tile);
+    copy_region_with_border(&tile, level, x, y, job->border_mode);
+
+    if ((2 == nc || 4 == nc) &&
+        image::channel_maximum(tile.channels[nc - 1], page, page) <= 0.0f)
+    {
+        for (size_t c = 0; c < nc; ++c)
+            color[c] = 0.0f;
+        job->state[index] = TILE_STATE_CONSTANT;
+    }
+    else if (is_constant_buffer(&tile, color, 0.0f))
+    {
+        job->state[index] = TILE_STATE_CONSTANT;
+    }
+    else
+    {
+        job->pages[index] = level_descriptor(
+            &tile, job->format, job->quality, job->hdr_range, &bpp, &size);
+        if (job->pages[index]) job->state[index] = TILE_STATE_ENCODED;
+    }
+    free(memory);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Finds a color in the table of solid tile colors, adding it if necessary.
+/// @param table The table of colors, MAX_IMAGE_CHANNELS values per entry.
+/// @param count The number of entries in @a table. Updated on return.
+/// @param capacity The capacity of @a table, in entries. Updated on return.
+/// @param color The color to find, with @a channels values.
+/// @param channels The number of channels in @a color.
+/// @return The index of the color, or -1 if the table could not be grown.
+static ptrdiff_t tile_color_index(
+    float  **table,
+    size_t  *count,
+    size_t  *capacity,
+    float const *color,
+    size_t   channels)
+{
+    for (size_t i = 0; i < *count; ++i)
+    {
+        if (0 == memcmp(*table + i * MAX_IMAGE_CHANNELS, color, channels * sizeof(float)))
+            return (ptrdiff_t) i;
+    }
+    if (*count == *capacity)
+    {
+        size_t new_capacity = *capacity ? *capacity * 2 : 16;
+        float *new_table    = (float*) realloc(*table, new_capacity * MAX_IMAGE_CHANNELS * sizeof(float));
+        if (NULL == new_table) return -1;
+        *table    = new_table;
+        *capacity = new_capacity;
+    }
+    memcpy(*table + *count * MAX_IMAGE_CHANNELS, color, channels * sizeof(float));
+    return (ptrdiff_t) (*count)++;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
 #if 0
 static void  dump_data(char const *path, void const *data, size_t size)
 {
@@ -462,18 +1145,63 @@ static v8::Handle<v8::Value> gl_format_v8(
         case TEXTURE_FORMAT_1616_F:
         case TEXTURE_FORMAT_3232_F:
             return scope.Close(v8::String::New("LUMINANCE_ALPHA"));
+        case TEXTURE_FORMAT_16_I:
+            // EXT_texture_norm16 accepts only the RED, RG and RGBA formats.
+            return scope.Close(v8::String::New("RED"));
+        case TEXTURE_FORMAT_1616_I:
+            return scope.Close(v8::String::New("RG"));
         case TEXTURE_FORMAT_565_I:
         case TEXTURE_FORMAT_888_I:
         case TEXTURE_FORMAT_161616_F:
         case TEXTURE_FORMAT_323232_F:
+        case TEXTURE_FORMAT_RGB9E5:
+        case TEXTURE_FORMAT_R11G11B10F:
             return scope.Close(v8::String::New("RGB"));
         case TEXTURE_FORMAT_5551_I:
         case TEXTURE_FORMAT_4444_I:
         case TEXTURE_FORMAT_8888_I:
+        case TEXTURE_FORMAT_16161616_I:
         case TEXTURE_FORMAT_16161616_F:
         case TEXTURE_FORMAT_32323232_F:
+        case TEXTURE_FORMAT_RGB10A2:
+        case TEXTURE_FORMAT_RGBM:
+        case TEXTURE_FORMAT_RGBD:
             return scope.Close(v8::String::New("RGBA"));
-            return scope.Close(v8::String::New("RGBA"));
+        case TEXTURE_FORMAT_BC1:
+            return scope.Close(v8::String::New("COMPRESSED_RGB_S3TC_DXT1_EXT"));
+        case TEXTURE_FORMAT_BC3:
+            return scope.Close(v8::String::New("COMPRESSED_RGBA_S3TC_DXT5_EXT"));
+        case TEXTURE_FORMAT_BC4:
+            return scope.Close(v8::String::New("COMPRESSED_RED_RGTC1_EXT"));
+        case TEXTURE_FORMAT_BC5:
+            return scope.Close(v8::String::New("COMPRESSED_RED_GREEN_RGTC2_EXT"));
+        case TEXTURE_FORMAT_BC7:
+            return scope.Close(v8::String::New("COMPRESSED_RGBA_BPTC_UNORM_EXT"));
+        case TEXTURE_FORMAT_BC6H_UF16:
+            return scope.Close(v8::String::New("COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT_EXT"));
+        case TEXTURE_FORMAT_BC6H_SF16:
+            return scope.Close(v8::String::New("COMPRESSED_RGB_BPTC_SIGNED_FLOAT_EXT"));
+        case TEXTURE_FORMAT_ETC1:
+            return scope.Close(v8::String::New("COMPRESSED_RGB_ETC1_WEBGL"));
+        case TEXTURE_FORMAT_ETC2_RGB8:
+            return scope.Close(v8::String::New("COMPRESSED_RGB8_ETC2"));
+        case TEXTURE_FORMAT_ETC2_RGBA8:
+            return scope.Close(v8::String::New("COMPRESSED_RGBA8_ETC2_EAC"));
+        case TEXTURE_FORMAT_PVRTC_2BPP:
+            return scope.Close(v8::String::New("COMPRESSED_RGBA_PVRTC_2BPPV1_IMG"));
+        case TEXTURE_FORMAT_PVRTC_4BPP:
+            return scope.Close(v8::String::New("COMPRESSED_RGBA_PVRTC_4BPPV1_IMG"));
+        case TEXTURE_FORMAT_ASTC_4x4:
+            return scope.Close(v8::String::New("COMPRESSED_RGBA_ASTC_4x4_KHR"));
+        case TEXTURE_FORMAT_ASTC_6x6:
+            return scope.Close(v8::String::New("COMPRESSED_RGBA_ASTC_6x6_KHR"));
+        case TEXTURE_FORMAT_ASTC_8x8:
+            return scope.Close(v8::String::New("COMPRESSED_RGBA_ASTC_8x8_KHR"));
+        case TEXTURE_FORMAT_ETC1S:
+            // not a GL format; transcoded at load time.
+            return scope.Close(v8::String::New("ETC1S"));
+        case TEXTURE_FORMAT_ETC1S_RGBA:
+            return scope.Close(v8::String::New("ETC1S_RGBA"));
         default:
             break;
     }
@@ -525,7 +1253,13 @@ static v8::Handle<v8::Value> gl_data_type_v8(int32_t format)
         case TEXTURE_FORMAT_88_I:
         case TEXTURE_FORMAT_888_I:
         case TEXTURE_FORMAT_8888_I:
+        case TEXTURE_FORMAT_RGBM:
+        case TEXTURE_FORMAT_RGBD:
             return scope.Close(v8::String::New("UNSIGNED_BYTE"));
+        case TEXTURE_FORMAT_16_I:
+        case TEXTURE_FORMAT_1616_I:
+        case TEXTURE_FORMAT_16161616_I:
+            return scope.Close(v8::String::New("UNSIGNED_SHORT"));
         case TEXTURE_FORMAT_16_F:
         case TEXTURE_FORMAT_1616_F:
         case TEXTURE_FORMAT_161616_F:
@@ -536,6 +1270,30 @@ static v8::Handle<v8::Value> gl_data_type_v8(int32_t format)
         case TEXTURE_FORMAT_323232_F:
         case TEXTURE_FORMAT_32323232_F:
             return scope.Close(v8::String::New("FLOAT"));
+        case TEXTURE_FORMAT_RGB9E5:
+            return scope.Close(v8::String::New("UNSIGNED_INT_5_9_9_9_REV"));
+        case TEXTURE_FORMAT_R11G11B10F:
+            return scope.Close(v8::String::New("UNSIGNED_INT_10F_11F_11F_REV"));
+        case TEXTURE_FORMAT_RGB10A2:
+            return scope.Close(v8::String::New("UNSIGNED_INT_2_10_10_10_REV"));
+        case TEXTURE_FORMAT_BC1:
+        case TEXTURE_FORMAT_BC3:
+        case TEXTURE_FORMAT_BC4:
+        case TEXTURE_FORMAT_BC5:
+        case TEXTURE_FORMAT_BC7:
+        case TEXTURE_FORMAT_BC6H_UF16:
+        case TEXTURE_FORMAT_BC6H_SF16:
+        case TEXTURE_FORMAT_ETC1:
+        case TEXTURE_FORMAT_ETC2_RGB8:
+        case TEXTURE_FORMAT_ETC2_RGBA8:
+        case TEXTURE_FORMAT_PVRTC_2BPP:
+        case TEXTURE_FORMAT_PVRTC_4BPP:
+        case TEXTURE_FORMAT_ASTC_4x4:
+        case TEXTURE_FORMAT_ASTC_6x6:
+        case TEXTURE_FORMAT_ASTC_8x8:
+        case TEXTURE_FORMAT_ETC1S:
+        case TEXTURE_FORMAT_ETC1S_RGBA:
+            return scope.Close(v8::String::New("COMPRESSED"));
         default:
             break;
     }
@@ -544,6 +1302,73 @@ static v8::Handle<v8::Value> gl_data_type_v8(int32_t format)
 
 /*/////////////////////////////////////////////////////////////////////////80*/
 
+/// Returns the sized internal format required to upload packed and 16-bit
+/// normalized formats with texImage2D() in WebGL 2 or OpenGL ES 3, which do
+/// not accept the unsized internal formats with these data types.
+static v8::Handle<v8::Value> gl_internal_format_v8(int32_t format)
+{
+    v8::HandleScope scope;
+    switch (format)
+    {
+        case TEXTURE_FORMAT_RGB9E5:
+            return scope.Close(v8::String::New("RGB9_E5"));
+        case TEXTURE_FORMAT_R11G11B10F:
+            return scope.Close(v8::String::New("R11F_G11F_B10F"));
+        case TEXTURE_FORMAT_RGB10A2:
+            return scope.Close(v8::String::New("RGB10_A2"));
+        case TEXTURE_FORMAT_16_I:
+            return scope.Close(v8::String::New("R16_EXT"));
+        case TEXTURE_FORMAT_1616_I:
+            return scope.Close(v8::String::New("RG16_EXT"));
+        case TEXTURE_FORMAT_16161616_I:
+            return scope.Close(v8::String::New("RGBA16_EXT"));
+        default:
+            break;
+    }
+    return scope.Close(v8::Undefined());
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static v8::Handle<v8::Value> gl_extension_v8(int32_t format)
+{
+    v8::HandleScope scope;
+    switch (format)
+    {
+        case TEXTURE_FORMAT_BC1:
+        case TEXTURE_FORMAT_BC3:
+            return scope.Close(v8::String::New("WEBGL_compressed_texture_s3tc"));
+        case TEXTURE_FORMAT_BC4:
+        case TEXTURE_FORMAT_BC5:
+            return scope.Close(v8::String::New("EXT_texture_compression_rgtc"));
+        case TEXTURE_FORMAT_BC7:
+        case TEXTURE_FORMAT_BC6H_UF16:
+        case TEXTURE_FORMAT_BC6H_SF16:
+            return scope.Close(v8::String::New("EXT_texture_compression_bptc"));
+        case TEXTURE_FORMAT_ETC1:
+            return scope.Close(v8::String::New("WEBGL_compressed_texture_etc1"));
+        case TEXTURE_FORMAT_ETC2_RGB8:
+        case TEXTURE_FORMAT_ETC2_RGBA8:
+            return scope.Close(v8::String::New("WEBGL_compressed_texture_etc"));
+        case TEXTURE_FORMAT_PVRTC_2BPP:
+        case TEXTURE_FORMAT_PVRTC_4BPP:
+            return scope.Close(v8::String::New("WEBGL_compressed_texture_pvrtc"));
+        case TEXTURE_FORMAT_ASTC_4x4:
+        case TEXTURE_FORMAT_ASTC_6x6:
+        case TEXTURE_FORMAT_ASTC_8x8:
+            return scope.Close(v8::String::New("WEBGL_compressed_texture_astc"));
+        case TEXTURE_FORMAT_16_I:
+        case TEXTURE_FORMAT_1616_I:
+        case TEXTURE_FORMAT_16161616_I:
+            return scope.Close(v8::String::New("EXT_texture_norm16"));
+        default:
+            break;
+    }
+    return scope.Close(v8::Undefined());
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
 /// Extracts texture compiler arguments from an object passed from JavaScript.
 /// @param obj An object specifying the texture compiler arguments.
 /// @param obj.sourcePath A string specifying the path of the source file.
@@ -570,8 +1395,22 @@ static v8::Handle<v8::Value> v8_object_to_compiler_args(
     v8::Handle<v8::String>   magnifyFilter = v8::String::New("magnifyFilter");
     v8::Handle<v8::String>   premultiplied = v8::String::New("premultipliedAlpha");
     v8::Handle<v8::String>   forcePowerOf2 = v8::String::New("forcePowerOf2");
+    v8::Handle<v8::String>   forcePowerOfTwo = v8::String::New("forcePowerOfTwo");
     v8::Handle<v8::String>   buildMipmaps  = v8::String::New("buildMipmaps");
     v8::Handle<v8::String>   levelCount    = v8::String::New("levelCount");
+    v8::Handle<v8::String>   container     = v8::String::New("container");
+    v8::Handle<v8::String>   quality       = v8::String::New("quality");
+    v8::Handle<v8::String>   compression   = v8::String::New("compression");
+    v8::Handle<v8::String>   chunkSize     = v8::String::New("chunkSize");
+    v8::Handle<v8::String>   hdrRange      = v8::String::New("hdrRange");
+    v8::Handle<v8::String>   levelOrder    = v8::String::New("levelOrder");
+    v8::Handle<v8::String>   levelAlignment = v8::String::New("levelAlignment");
+    v8::Handle<v8::String>   targetPSNR    = v8::String::New("targetPSNR");
+    v8::Handle<v8::String>   autoCompressed = v8::String::New("autoCompressed");
+    v8::Handle<v8::String>   tileSize      = v8::String::New("tileSize");
+    v8::Handle<v8::String>   tileBorder    = v8::String::New("tileBorder");
+    v8::Handle<v8::String>   previousHash  = v8::String::New("previousHash");
+    v8::Handle<v8::String>   previousSize  = v8::String::New("previousSize");
 
     // source file path. this field is required.
     init_compiler_args(args);
@@ -598,6 +1437,66 @@ static v8::Handle<v8::Value> v8_object_to_compiler_args(
     if (obj->Has(target))
         args->texture_target = v8_string_to_utf8(obj->Get(target));
 
+    // encoder quality. this field must be validated later.
+    if (obj->Has(quality))
+        args->quality = v8_string_to_utf8(obj->Get(quality));
+
+    // level compression. this field must be validated later.
+    if (obj->Has(compression))
+        args->compression = v8_string_to_utf8(obj->Get(compression));
+
+    // uncompressed chunk size? this field is optional.
+    if (obj->Has(chunkSize))
+        args->chunk_size = obj->Get(chunkSize)->Uint32Value();
+    else
+        args->chunk_size = COMPRESS_DEFAULT_CHUNK_SIZE;
+
+    // level order. this field must be validated later.
+    if (obj->Has(levelOrder))
+        args->level_order = v8_string_to_utf8(obj->Get(levelOrder));
+
+    // level alignment? this field is optional.
+    if (obj->Has(levelAlignment))
+        args->level_alignment = obj->Get(levelAlignment)->Uint32Value();
+    else
+        args->level_alignment = 1;
+
+    // tile size? this field is optional; 0 writes whole levels.
+    if (obj->Has(tileSize))
+        args->tile_size = obj->Get(tileSize)->Uint32Value();
+    else
+        args->tile_size = 0;
+
+    // tile border? this field is optional.
+    if (obj->Has(tileBorder))
+        args->tile_border = obj->Get(tileBorder)->Uint32Value();
+    else
+        args->tile_border = TILE_DEFAULT_BORDER;
+
+    // hash and size of the existing output? these fields are optional.
+    if (obj->Has(previousHash) && obj->Get(previousHash)->IsString())
+        args->previous_hash = v8_string_to_utf8(obj->Get(previousHash));
+    if (obj->Has(previousSize))
+        args->previous_size = obj->Get(previousSize)->NumberValue();
+
+    // RGBM/RGBD range? this field is optional; 0 computes it.
+    if (obj->Has(hdrRange))
+        args->hdr_range = (float) obj->Get(hdrRange)->NumberValue();
+    else
+        args->hdr_range = 0.0f;
+
+    // AUTO error budget? this field is optional; 0 selects losslessly.
+    if (obj->Has(targetPSNR))
+        args->target_psnr = (float) obj->Get(targetPSNR)->NumberValue();
+    else
+        args->target_psnr = 0.0f;
+
+    // may AUTO use block compression? this field is optional.
+    if (obj->Has(autoCompressed))
+        args->auto_compressed = obj->Get(autoCompressed)->IsFalse() ? false : true;
+    else
+        args->auto_compressed = true;
+
     // border mode. this field is optional.
     if (obj->Has(borderMode))
         args->border_mode =v8_string_to_utf8(obj->Get(borderMode));
@@ -608,8 +1507,11 @@ static v8::Handle<v8::Value> v8_object_to_compiler_args(
     else
         args->flip_y = true;
 
-    // force power of two? this field is optional.
-    if (obj->Has(forcePowerOf2))
+    // force power of two? this field is optional. the command-line
+    // tool spells it 'forcePowerOfTwo', so accept either name.
+    if (obj->Has(forcePowerOfTwo))
+        args->force_pow2 = obj->Get(forcePowerOfTwo)->IsTrue() ? true : false;
+    else if (obj->Has(forcePowerOf2))
         args->force_pow2 = obj->Get(forcePowerOf2)->IsTrue() ? true : false;
     else
         args->force_pow2 = false;
@@ -626,6 +1528,12 @@ static v8::Handle<v8::Value> v8_object_to_compiler_args(
     else
         args->premultiplied = false;
 
+    // write an image container header? this field is optional.
+    if (obj->Has(container))
+        args->container = obj->Get(container)->IsTrue() ? true : false;
+    else
+        args->container = false;
+
     // maximum number of mip-levels? this field is optional.
     if (obj->Has(levelCount))
         args->level_count = obj->Get(levelCount)->Uint32Value();
@@ -679,118 +1587,907 @@ static v8::Handle<v8::Value> v8_object_to_compiler_args(
 
 /*/////////////////////////////////////////////////////////////////////////80*/
 
-static v8::Handle<v8::Value> validate_arguments(
+static char const* validate_arguments(
     texture_compiler_args_t *args,
     image::buffer_t         *source)
 {
-    v8::HandleScope   scope;
     bool   mipmaps  = args->build_mipmaps;
     size_t channels = source->channel_count;
     if (TEXTURE_TYPE_UNKNOWN == texture_type(args->texture_type, channels))
     {
-        return scope.Close(ex("The type field has an invalid value."));
+        return "The type field has an invalid value.";
     }
-    if (TEXTURE_FORMAT_UNKNOWN == texture_format(args->target_format, channels))
+    if (TEXTURE_FORMAT_UNKNOWN == target_format(args, channels))
     {
-        return scope.Close(ex("The format field has an invalid value."));
+        return "The format field has an invalid value.";
     }
     if (TEXTURE_TARGET_UNKNOWN == texture_target(args->texture_target))
     {
-        return scope.Close(ex("The target field has an invalid value."));
+        return "The target field has an invalid value.";
     }
     if (TEXTURE_WRAP_UNKNOWN == texture_wrap(args->wrap_mode_s))
     {
-        return scope.Close(ex("The wrapModeS field has an invalid value."));
+        return "The wrapModeS field has an invalid value.";
     }
     if (TEXTURE_WRAP_UNKNOWN == texture_wrap(args->wrap_mode_t))
     {
-        return scope.Close(ex("The wrapModeT field has an invalid value."));
+        return "The wrapModeT field has an invalid value.";
     }
     if (TEXTURE_FILTER_UNKNOWN == magnify_filter(args->magnify_filter))
     {
-        return scope.Close(ex("The magnifyFilter field has an invalid value."));
+        return "The magnifyFilter field has an invalid value.";
     }
     if (TEXTURE_FILTER_UNKNOWN == minify_filter(args->minify_filter, mipmaps))
     {
-        return scope.Close(ex("The minifyFilter field has an invalid value."));
+        return "The minifyFilter field has an invalid value.";
     }
-    return scope.Close(v8::Undefined());
+    if (encoder_quality(args->quality) < 0)
+    {
+        return "The quality field has an invalid value.";
+    }
+    if (LEVEL_COMPRESSION_UNKNOWN == level_compression(args->compression))
+    {
+        return "The compression field has an invalid value.";
+    }
+    if (!(args->hdr_range >= 0.0f))
+    {
+        return "The hdrRange field has an invalid value.";
+    }
+    if (!(args->target_psnr >= 0.0f))
+    {
+        return "The targetPSNR field has an invalid value.";
+    }
+    if (args->chunk_size < COMPRESS_MIN_CHUNK_SIZE ||
+        args->chunk_size > COMPRESS_MAX_CHUNK_SIZE)
+    {
+        return "The chunkSize field must be between 4096 and 16777216.";
+    }
+    if (args->container && LEVEL_COMPRESSION_NONE != level_compression(args->compression))
+    {
+        return "Compressed levels cannot be stored in a container.";
+    }
+    if (LEVEL_ORDER_UNKNOWN == level_order(args->level_order))
+    {
+        return "The levelOrder field has an invalid value.";
+    }
+    if (0 == args->level_alignment)
+    {
+        return "The levelAlignment field has an invalid value.";
+    }
+    if (args->container && (LEVEL_ORDER_LARGEST_FIRST != level_order(args->level_order) ||
+        args->level_alignment > 1))
+    {
+        return "Reordered or aligned levels cannot be stored in a container.";
+    }
+    if (args->tile_size > 0 && (args->container ||
+        LEVEL_COMPRESSION_NONE    != level_compression(args->compression) ||
+        LEVEL_ORDER_LARGEST_FIRST != level_order(args->level_order) ||
+        args->level_alignment > 1))
+    {
+        return "Tiled output cannot be combined with container, compression, levelOrder or levelAlignment.";
+    }
+    return NULL;
 }
 
 /*/////////////////////////////////////////////////////////////////////////80*/
 
-/// Outputs texture data to a raw file containing the pixel data for each mip-
-/// level of the texture, without any header information.
-/// @param target_path A string specifying the path and filename of the file
-/// to create and write with the raw pixel data.
-/// @param target_format One of the values of the texture_format_e enumeration
-/// specifying the target format for the texture pixel data.
-/// @param levels A V8 array object to be populated with objects describing
-/// each mip-level of the texture.
-/// @param outputs An object specifying the outputs from the texture compiler.
-/// @return undefined if the operation completes successfully; otherwise, an
-/// exception object is returned.
-static v8::Handle<v8::Value> v8_output_raw(
-    char const                 *target_path,
-    int32_t                     target_format,
-    v8::Handle<v8::Array>       levels,
-    texture_compiler_outputs_t *outputs)
+/// An output file that is written to a temporary path and hashed as it is
+/// written, so an unchanged output doesn't replace the existing file.
+struct output_file_t
 {
-    FILE  *file        = fopen(target_path, "wb");
-    size_t level_count = outputs->level_count;
-    size_t byte_offset = 0;
-    size_t byte_size   = 0;
-    v8::HandleScope  scope;
+    FILE    *file;              /// The temporary file being written.
+    char    *temp_path;         /// The path of the temporary file.
+    uint64_t hash;              /// The hash of the data written so far.
+    uint64_t size;              /// The number of bytes written so far.
+    bool     failed;            /// Did a write fail?
+};
 
-    // cache some property names so we don't create them repeatedly.
-    v8::Handle<v8::String> prop_byteOffset = v8::String::New("byteOffset");
-    v8::Handle<v8::String> prop_byteSize   = v8::String::New("byteSize");
-    v8::Handle<v8::String> prop_height     = v8::String::New("height");
-    v8::Handle<v8::String> prop_width      = v8::String::New("width");
+/*/////////////////////////////////////////////////////////////////////////80*/
 
-    // open the target file to write the raw pixel data.
-    if (NULL == file)
+static bool output_file_open(output_file_t *out, char const *target_path)
+{
+    size_t len     = strlen(target_path);
+    out->file      = NULL;
+    out->hash      = 0;
+    out->size      = 0;
+    out->failed    = false;
+    out->temp_path = (char*) malloc(len + 5);
+    if (NULL == out->temp_path) return false;
+    memcpy(out->temp_path, target_path, len);
+    memcpy(out->temp_path + len, ".tmp", 5);
+    if ((out->file = fopen(out->temp_path, "wb")) == NULL)
     {
-        return scope.Close(ex("Cannot create file targetPath."));
+        SAFE_FREE(out->temp_path);
+        return false;
     }
-    // write the raw pixel data and build a descriptor for each level.
-    for (size_t i = 0; i < level_count; ++i)
+    return true;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static void output_file_write(output_file_t *out, void const *data, size_t size)
+{
+    uint8_t const *p = (uint8_t const*) data;
+    out->hash  = content_hash(data, size, out->hash);
+    out->size += size;
+    while (size > 0 && !out->failed)
+    {
+        // some C runtimes fail on single writes of 2GB or more.
+        size_t n = CMN_MIN(size, (size_t) OUTPUT_WRITE_SIZE);
+        if (fwrite(p, 1, n, out->file) != n)
+            out->failed = true;
+        p    += n;
+        size -= n;
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static void output_file_pad(output_file_t *out, size_t count)
+{
+    static uint8_t const zeros[256] = { 0 };
+    while (count > 0)
     {
-        v8::Handle<v8::Object> desc   = v8::Object::New();
-        image::buffer_t       *data   = &outputs->level_data[i];
-        size_t                 width  = data->channel_width;
-        size_t                 height = data->channel_height;
-        size_t                 bpp    = 0;
+        size_t n = CMN_MIN(count, sizeof(zeros));
+        output_file_write(out, zeros, n);
+        count -= n;
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
 
-        // get the raw pixel data and write it to the file.
-        void *pixels = level_descriptor(data, target_format, &bpp, &byte_size);
-        if   (pixels)
+/// Closes and deletes the temporary file after an error.
+static void output_file_abort(output_file_t *out)
+{
+    if (out->file) fclose(out->file);
+    if (out->temp_path) remove(out->temp_path);
+    SAFE_FREE(out->temp_path);
+    out->file = NULL;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Closes the temporary file and replaces the target file with it, unless
+/// the hash and size of the new data match those recorded for the existing
+/// target file, and the existing file still has the recorded size.
+/// @param out The output file.
+/// @param args The texture compiler arguments. On return, the pixels_hash
+/// and pixels_size fields describe the output file.
+/// @return true if successful, or false if the data could not be written or
+/// the target could not be replaced.
+static bool output_file_commit(output_file_t *out, texture_compiler_args_t *args)
+{
+    STAT_STRUCT st;
+    bool        ok = true;
+    if (fclose(out->file) != 0 || out->failed)
+    {
+        // a partial file must never replace the target.
+        out->file = NULL;
+        output_file_abort(out);
+        return false;
+    }
+    out->file = NULL;
+    content_hash_string(out->hash, args->pixels_hash);
+    args->pixels_size = (double) out->size;
+    if (args->previous_hash && 0 == strcmp(args->previous_hash, args->pixels_hash) &&
+        args->previous_size == args->pixels_size &&
+        0 == STAT_FUNC(args->target_path, &st) && (double) st.st_size == args->pixels_size)
+    {
+        // leave the existing file, and its timestamp, alone.
+        remove(out->temp_path);
+    }
+    else
+    {
+#if CMN_IS_WINDOWS
+        // rename() won't replace an existing file on Windows.
+        remove(args->target_path);
+#endif
+        if (rename(out->temp_path, args->target_path) != 0)
         {
-            fwrite(pixels, byte_size, 1, file);
-            free_pixels(pixels);
+            remove(out->temp_path);
+            ok = false;
         }
-        else
+    }
+    SAFE_FREE(out->temp_path);
+    return ok;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Describes one mip-level as it was written to the output file. The writers
+/// fill these in without touching V8, and the metadata returned to JavaScript
+/// is built from them afterwards on the main thread.
+struct output_level_t
+{
+    size_t              width;          /// The width of the level, in pixels.
+    size_t              height;         /// The height of the level, in pixels.
+    uint64_t            byte_offset;    /// The offset of the stored data.
+    uint64_t            byte_size;      /// The size of the stored data.
+    uint64_t            uncompressed_size; /// Size before compression, or 0.
+    size_t              chunk_count;    /// The number of compressed chunks.
+    compressed_chunk_t *chunks;         /// Chunks, relative to byte_offset.
+    size_t              alias_of;       /// The level whose data is used.
+    char                hash[CONTENT_HASH_STRING_LENGTH + 1]; /// Data hash.
+    size_t              tiles_x;        /// The number of tiles across.
+    size_t              tiles_y;        /// The number of tiles down.
+    int32_t            *pages;          /// The page table, for tiled output.
+};
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Describes everything written to the output file.
+struct texture_output_t
+{
+    size_t              level_count;    /// The number of levels.
+    output_level_t     *levels;         /// Descriptions of each level.
+    size_t              page_size;      /// The page dimension, in texels.
+    size_t              page_byte_size; /// The size of each page, in bytes.
+    size_t              page_count;     /// The number of pages written.
+    size_t              color_count;    /// The number of tile colors.
+    float              *colors;         /// MAX_IMAGE_CHANNELS per tile color.
+};
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static bool texture_output_init(texture_output_t *out, size_t level_count)
+{
+    out->level_count    = 0;
+    out->page_size      = 0;
+    out->page_byte_size = 0;
+    out->page_count     = 0;
+    out->color_count    = 0;
+    out->colors         = NULL;
+    out->levels         = NULL;
+    if (0 == level_count) return true;
+    out->levels         = (output_level_t*) malloc(level_count * sizeof(output_level_t));
+    if (NULL == out->levels) return false;
+    out->level_count    = level_count;
+    for (size_t i = 0; i < level_count; ++i)
+    {
+        output_level_t *level    = &out->levels[i];
+        level->width             = 0;
+        level->height            = 0;
+        level->byte_offset       = 0;
+        level->byte_size         = 0;
+        level->uncompressed_size = 0;
+        level->chunk_count       = 0;
+        level->chunks            = NULL;
+        level->alias_of          = i;
+        level->hash[0]           = 0;
+        level->tiles_x           = 0;
+        level->tiles_y           = 0;
+        level->pages             = NULL;
+    }
+    return true;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static void texture_output_free(texture_output_t *out)
+{
+    for (size_t i = 0; i < out->level_count; ++i)
+    {
+        free(out->levels[i].chunks);
+        free(out->levels[i].pages);
+    }
+    SAFE_FREE(out->levels);
+    SAFE_FREE(out->colors);
+    out->level_count = 0;
+    out->color_count = 0;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// The state shared by the tasks converting each mip-level to the target
+/// format. The levels are independent, so a range of levels is converted at
+/// once.
+struct level_encode_job_t
+{
+    texture_compiler_outputs_t *outputs;    /// The compiled levels.
+    size_t                      first;      /// The first level of the range.
+    int32_t                     format;     /// The target texture format.
+    int32_t                     quality;    /// The encoder quality.
+    float                       hdr_range;  /// The RGBM and RGBD range.
+    void                      **pixels;     /// The converted data per level.
+    size_t                     *sizes;      /// The size of each level, in bytes.
+    compile_progress_t         *progress;   /// Receives a step per level.
+};
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Converts a single mip-level to the target format. Solid-color levels are
+/// encoded once per block and replicated.
+static void CMN_CALL_C encode_level(size_t offset, void *context)
+{
+    level_encode_job_t *job   = (level_encode_job_t*) context;
+    size_t              index = job->first + offset;
+    image::buffer_t    *data  = &job->outputs->level_data[index];
+    size_t              bpp   = 0;
+    if (compile_cancelled(job->progress)) return;
+    job->pixels[index] = (index >= job->outputs->constant_level) ?
+        constant_level_descriptor(data, job->format, job->quality, job->hdr_range, &bpp, &job->sizes[index]) :
+        level_descriptor(data, job->format, job->quality, job->hdr_range, &bpp, &job->sizes[index]);
+    compile_progress_step(job->progress);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Converts levels first through first + count - 1 to the target format in
+/// parallel, as a separate ENCODE stage.
+/// @return false if the compile was cancelled.
+static bool encode_levels(level_encode_job_t *job, size_t first, size_t count)
+{
+    compile_progress_begin(job->progress, COMPILE_STAGE_ENCODE, count);
+    job->first = first;
+    parallel_for(count, encode_level, job);
+    return !compile_cancelled(job->progress);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static void free_level_pixels(level_encode_job_t *job, size_t level_count)
+{
+    if (job->pixels)
+    {
+        for (size_t i = 0; i < level_count; ++i)
+            free_pixels(job->pixels[i]);
+    }
+    free(job->pixels);
+    free(job->sizes);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Outputs texture data to a raw file containing the pixel data for each mip-
+/// level of the texture. If args->container is set, the pixel data is preceded
+/// by an image::header_t so the file can be read back as an image container,
+/// and the level byte offsets account for the header. If args->compression is
+/// set, each level is split into chunks of args->chunk_size bytes which are
+/// compressed independently, and each level descriptor lists its chunks so a
+/// runtime can decompress a single level or chunk without the others. Levels
+/// that are byte-for-byte identical to the previously written level are not
+/// written again; their descriptor refers to the earlier data instead. If
+/// args->level_order is SMALLEST_FIRST, levels are written from the smallest
+/// to the largest, and each level starts on a multiple of
+/// args->level_alignment bytes. The levels array is always indexed by level.
+/// Each level descriptor has the hash of its stored data. The existing target
+/// file is left untouched if the new data hashes to args->previous_hash, or if
+/// the compile is cancelled. Levels are converted in parallel; if level 0 is
+/// larger than ENCODE_SPLIT_SIZE, it is converted and written separately from
+/// the other levels, to bound the amount of converted data held in memory.
+/// This function does not touch V8, so it can run on a worker thread.
+/// @param args The texture compiler arguments. The target_path field specifies
+/// the path and filename of the file to create and write.
+/// @param target_format One of the values of the texture_format_e enumeration
+/// specifying the target format for the texture pixel data.
+/// @param outputs An object specifying the outputs from the texture compiler.
+/// @param result The structure to populate with a description of each level
+/// written. It must have been initialized with texture_output_init().
+/// @param progress The progress of the compile, or NULL. Receives one step
+/// per level encoded and per level written, and is checked for cancellation
+/// between levels. When level 0 is converted separately, the ENCODE and
+/// WRITE stages are each reported twice.
+/// @return NULL if the operation completes successfully; otherwise, a string
+/// describing the error.
+static char const* output_raw(
+    texture_compiler_args_t    *args,
+    int32_t                     target_format,
+    texture_compiler_outputs_t *outputs,
+    texture_output_t           *result,
+    compile_progress_t         *progress)
+{
+    output_file_t      file;
+    level_encode_job_t job;
+    size_t   level_count = outputs->level_count;
+    uint64_t byte_offset = 0; // 64-bit, even where size_t is 32-bit.
+    size_t   byte_size   = 0;
+    int32_t  quality     = encoder_quality(args->quality);
+    int32_t  compress    = level_compression(args->compression);
+    bool     reverse     = LEVEL_ORDER_SMALLEST_FIRST == level_order(args->level_order);
+    size_t   alignment   = args->level_alignment;
+    float    range       = args->hdr_range;
+    size_t   pass_first  = 0;
+    size_t   pass_count  = level_count;
+
+    // the most recently written level, used to detect duplicate levels.
+    // level sizes are monotonic in either order, so only consecutive
+    // levels can match.
+    void  *last_pixels = NULL;
+    size_t last_size   = 0;
+    size_t last_index  = 0;
+
+    // a large texture is converted in two passes, level 0 and then the rest,
+    // in the order they are written. each pass is written before the next
+    // one is converted, so the converted data of level 0 and of the other
+    // levels is never held at the same time.
+    image::buffer_t *level_0 = &outputs->level_data[0];
+    uint64_t level_0_size = (uint64_t) level_0->channel_width *
+        level_0->channel_height * level_0->channel_count * sizeof(float);
+    if (level_count > 1 && level_0_size > ENCODE_SPLIT_SIZE)
+    {
+        pass_first = reverse ? 1 : 0;
+        pass_count = reverse ? level_count - 1 : 1;
+    }
+
+    // convert the levels of the first pass to the target format up front.
+    job.outputs   = outputs;
+    job.format    = target_format;
+    job.quality   = quality;
+    job.hdr_range = range;
+    job.progress  = progress;
+    job.pixels    = (void**)  malloc(level_count * sizeof(void*));
+    job.sizes     = (size_t*) malloc(level_count * sizeof(size_t));
+    if (NULL == job.pixels || NULL == job.sizes)
+    {
+        free(job.pixels);
+        free(job.sizes);
+        return "Out of memory.";
+    }
+    for (size_t i = 0; i < level_count; ++i)
+    {
+        job.pixels[i] = NULL;
+        job.sizes [i] = 0;
+    }
+    if (!encode_levels(&job, pass_first, pass_count))
+    {
+        free_level_pixels(&job, level_count);
+        return TEXTURE_COMPILER_CANCELLED;
+    }
+
+    // open the target file to write the raw pixel data. the data goes to
+    // a temporary file first, which replaces the target if it changed.
+    if (!output_file_open(&file, args->target_path))
+    {
+        free_level_pixels(&job, level_count);
+        return "Cannot create file targetPath.";
+    }
+    // write the image container header, if requested. all of the level
+    // dimensions are known, so the image data size is computed up front.
+    image::container_t info;
+    if (args->container)
+    {
+        image::header_t  header;
+        size_t           width   = level_0->channel_width;
+        size_t           height  = level_0->channel_height;
+        info.format      = image_format(target_format);
+        info.flags       = image_attributes(args, width, height);
+        info.items       = 1;
+        info.levels      = level_count;
+        info.width       = width;
+        info.height      = height;
+        info.slices      = 1;
+        info.image_size  = image::image_size(
+            info.format, info.flags, 1, width, height, 1, level_count);
+        info.atlas_size  = 0;
+        info.alloc_base  = NULL;
+        info.image_data  = NULL;
+        info.atlas_data  = NULL;
+        if (image::FORMAT_UNKNOWN == info.format)
+        {
+            free_level_pixels(&job, level_count);
+            output_file_abort(&file);
+            return "The format cannot be stored in a container.";
+        }
+        image::get_header(&info, &header);
+        output_file_write(&file, &header, sizeof(image::header_t));
+        byte_offset = sizeof(image::header_t);
+    }
+    // write the raw pixel data and record a descriptor for each level.
+    compile_progress_begin(progress, COMPILE_STAGE_WRITE, pass_count);
+    for (size_t n = 0; n < level_count; ++n)
+    {
+        size_t             i      = reverse ? level_count - 1 - n : n;
+        output_level_t    *desc   = &result->levels[i];
+        image::buffer_t   *data   = &outputs->level_data[i];
+        size_t             usize  = 0;
+        compressed_data_t  chunks;
+
+        if (compile_cancelled(progress))
+        {
+            free_pixels(last_pixels);
+            free_level_pixels(&job, level_count);
+            output_file_abort(&file);
+            return TEXTURE_COMPILER_CANCELLED;
+        }
+        if (n == pass_count)
+        {
+            // the first pass has been written; convert the second. levels
+            // 0 and 1 of a texture this large never have the same size, so
+            // the last level written can't match and is released first.
+            free_pixels(last_pixels);
+            last_pixels = NULL;
+            if (!encode_levels(&job, reverse ? 0 : 1, level_count - pass_count))
+            {
+                free_level_pixels(&job, level_count);
+                output_file_abort(&file);
+                return TEXTURE_COMPILER_CANCELLED;
+            }
+            compile_progress_begin(progress, COMPILE_STAGE_WRITE, level_count - pass_count);
+        }
+        desc->width  = data->channel_width;
+        desc->height = data->channel_height;
+
+        // take ownership of the converted pixel data.
+        void *pixels  = job.pixels[i];
+        byte_size     = job.sizes[i];
+        job.pixels[i] = NULL;
+        if   (NULL == pixels)
+        {
+            free_pixels(last_pixels);
+            free_level_pixels(&job, level_count);
+            output_file_abort(&file);
+            return "Cannot get pixel data for mip-level.";
+        }
+
+        // a level identical to the last one written refers to its data.
+        // the container format requires every level to be present.
+        if (!args->container && last_pixels && byte_size == last_size &&
+            0 == memcmp(pixels, last_pixels, byte_size))
         {
-            fclose(file); file = NULL;
-            return scope.Close(ex("Cannot get pixel data for mip-level."));
+            desc->alias_of = last_index;
+            free_pixels(pixels);
+            compile_progress_step(progress);
+            continue;
         }
 
-        // build an object describing the miplevel.
-        // not happy about having to force byte_offset and byte_size
-        // to 32-bit, but don't think it will be an issue in practice.
-        desc->Set(prop_width,      v8::Integer::NewFromUnsigned((uint32_t) width));
-        desc->Set(prop_height,     v8::Integer::NewFromUnsigned((uint32_t) height));
-        desc->Set(prop_byteOffset, v8::Integer::NewFromUnsigned((uint32_t) byte_offset));
-        desc->Set(prop_byteSize,   v8::Integer::NewFromUnsigned((uint32_t) byte_size));
+        // pad the file so the level starts on the requested boundary.
+        if (alignment > 1 && (byte_offset % alignment) != 0)
+        {
+            size_t padding = (size_t) (alignment - (byte_offset % alignment));
+            output_file_pad(&file, padding);
+            byte_offset   += padding;
+        }
 
-        // add it to the back of the descriptor array.
-        levels->Set((uint32_t)  i, desc);
+        // write it to the file, compressing it first if requested.
+        compressed_data_init(&chunks);
+        if (LEVEL_COMPRESSION_LZ4 == compress)
+        {
+            if (!compress_chunks(pixels, byte_size, args->chunk_size, &chunks))
+            {
+                free_pixels(pixels);
+                free_pixels(last_pixels);
+                free_level_pixels(&job, level_count);
+                output_file_abort(&file);
+                return "Cannot compress pixel data for mip-level.";
+            }
+            usize     = byte_size;
+            byte_size = chunks.data_size;
+            output_file_write(&file, chunks.data, byte_size);
+            content_hash_string(content_hash(chunks.data, byte_size, 0), desc->hash);
+        }
+        else
+        {
+            output_file_write(&file, pixels, byte_size);
+            content_hash_string(content_hash(pixels, byte_size, 0), desc->hash);
+        }
+        free_pixels(last_pixels);
+        last_pixels = pixels;
+        last_size   = usize ? usize : byte_size;
+        last_index  = i;
+
+        // record where the level was written. chunks whose data_size
+        // equals their source_size are stored as-is; all others must be
+        // decompressed. chunk offsets are relative to the level.
+        desc->byte_offset       = byte_offset;
+        desc->byte_size         = byte_size;
+        desc->uncompressed_size = usize;
+        if (LEVEL_COMPRESSION_NONE != compress)
+        {
+            desc->chunk_count = chunks.chunk_count;
+            desc->chunks      = chunks.chunks;
+            chunks.chunks     = NULL;
+        }
+        compressed_data_free(&chunks);
 
         // update the byte offset for the next level.
         byte_offset += byte_size;
+        compile_progress_step(progress);
     }
-    fclose(file); file = NULL;
-    return scope.Close(v8::Undefined());
+    free_pixels(last_pixels);
+    free_level_pixels(&job, level_count);
+    if (args->container && byte_offset != (uint64_t) sizeof(image::header_t) + info.image_size)
+    {
+        // the level sizes don't agree with image::miplevel_size(), so
+        // the header would describe the data incorrectly.
+        output_file_abort(&file);
+        return "Container image size does not match level data.";
+    }
+    if (!output_file_commit(&file, args))
+    {
+        return "Cannot write file targetPath.";
+    }
+    return NULL;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Outputs texture data to a raw file containing a pool of fixed-size pages,
+/// for use as a virtual texture. Each mip-level is split into tiles of
+/// args->tile_size texels, and each tile is padded with a gutter of
+/// args->tile_border texels taken from the neighboring tiles, or sampled
+/// using the border mode past the edges of the level, so that filtering at
+/// page edges matches filtering of the whole level. Tiles that are a single
+/// solid color, or fully transparent, are not written; their page table
+/// entry refers to an entry of the tile color table instead. Every page has
+/// the same size, so page N starts at byte offset N * pageByteSize. Tiles
+/// are extracted and encoded in parallel, one row of tiles at a time. Each
+/// level descriptor has the hash of its pages, and the existing target file
+/// is left untouched if the new data hashes to args->previous_hash, or if the
+/// compile is cancelled. This function does not touch V8, so it can run on a
+/// worker thread.
+/// @param args The texture compiler arguments. The target_path field specifies
+/// the path and filename of the file to create and write.
+/// @param target_format One of the values of the texture_format_e enumeration
+/// specifying the target format for the texture pixel data.
+/// @param outputs An object specifying the outputs from the texture compiler.
+/// @param result The structure to populate with the page table of each level,
+/// the page sizes and the tile color table. It must have been initialized
+/// with texture_output_init().
+/// @param progress The progress of the compile, or NULL. Receives one step
+/// per row of tiles, and is checked for cancellation before each tile.
+/// @return NULL if the operation completes successfully; otherwise, a string
+/// describing the error.
+static char const* output_tiled(
+    texture_compiler_args_t    *args,
+    int32_t                     target_format,
+    texture_compiler_outputs_t *outputs,
+    texture_output_t           *result,
+    compile_progress_t         *progress)
+{
+    int32_t ifmt           = image_format(target_format);
+    size_t  tile_size      = args->tile_size;
+    size_t  border         = args->tile_border;
+    size_t  page           = tile_size + border * 2;
+    size_t  channels       = outputs->channel_count;
+    size_t  unit_w         = 1;
+    size_t  unit_h         = 1;
+    size_t  bpp            = 0;
+    size_t  page_size      = 0;
+    size_t  page_count     = 0;
+    size_t  color_capacity = 0;
+    bool    failed         = false;
+    output_file_t file;
+
+    // pages are uploaded into a cache texture individually, so they must
+    // be made of whole blocks that don't depend on their neighbors.
+    if (image::is_compressed_format(ifmt))
+    {
+        if (image::is_pvrtc_compressed_format(ifmt))
+        {
+            return "PVRTC formats cannot be used for tiled output.";
+        }
+        image::block_dimensions(ifmt, &unit_w, &unit_h);
+        if ((page % unit_w) != 0 || (page % unit_h) != 0)
+        {
+            return "The tileSize plus twice the tileBorder must be a multiple of the block size.";
+        }
+    }
+    level_byte_size(target_format, page, page, &bpp, &page_size);
+
+    // each row of tiles of each level is one step of progress.
+    size_t row_count = 0;
+    for (size_t i = 0; i < outputs->level_count; ++i)
+    {
+        size_t height = outputs->level_data[i].channel_height;
+        row_count    += (height + tile_size - 1) / tile_size;
+    }
+    compile_progress_begin(progress, COMPILE_STAGE_ENCODE, row_count);
+
+    // open the target file to write the page pool.
+    if (!output_file_open(&file, args->target_path))
+    {
+        return "Cannot create file targetPath.";
+    }
+    for (size_t i = 0; i < outputs->level_count && !failed; ++i)
+    {
+        output_level_t  *desc    = &result->levels[i];
+        image::buffer_t *data    = &outputs->level_data[i];
+        size_t           width   = data->channel_width;
+        size_t           height  = data->channel_height;
+        size_t           tiles_x = (width  + tile_size - 1) / tile_size;
+        size_t           tiles_y = (height + tile_size - 1) / tile_size;
+        uint64_t         lhash   = 0;
+        tile_job_t       job;
+
+        job.level       = data;
+        job.row         = 0;
+        job.tile_size   = tile_size;
+        job.border      = border;
+        job.border_mode = border_sample_mode(args->border_mode);
+        job.format      = target_format;
+        job.quality     = encoder_quality(args->quality);
+        job.hdr_range   = args->hdr_range;
+        job.progress    = progress;
+        job.state       = (int32_t*) malloc(tiles_x * sizeof(int32_t));
+        job.pages       = (void**)   malloc(tiles_x * sizeof(void*));
+        job.colors      = (float*)   malloc(tiles_x * MAX_IMAGE_CHANNELS * sizeof(float));
+        desc->pages     = (int32_t*) malloc(tiles_x * tiles_y * sizeof(int32_t));
+        if (NULL == job.state || NULL == job.pages || NULL == job.colors || NULL == desc->pages)
+        {
+            free(job.colors);
+            free(job.pages);
+            free(job.state);
+            output_file_abort(&file);
+            return "Out of memory.";
+        }
+        desc->width   = width;
+        desc->height  = height;
+        desc->tiles_x = tiles_x;
+        desc->tiles_y = tiles_y;
+
+        // entries >= 0 are page indices. entries < 0 refer to entry
+        // (-entry - 1) of the tile color table.
+        for (size_t ty = 0; ty < tiles_y && !failed; ++ty)
+        {
+            if (i >= outputs->constant_level)
+            {
+                // every tile of a solid-color level is that color.
+                for (size_t tx = 0; tx < tiles_x; ++tx)
+                {
+                    float *color = job.colors + tx * MAX_IMAGE_CHANNELS;
+                    memcpy(color, outputs->constant_color, channels * sizeof(float));
+                    job.state[tx] = TILE_STATE_CONSTANT;
+                    job.pages[tx] = NULL;
+                }
+            }
+            else
+            {
+                job.row = ty;
+                parallel_for(tiles_x, encode_tile, &job);
+            }
+
+            // write the pages in order so page indices are deterministic.
+            for (size_t tx = 0; tx < tiles_x; ++tx)
+            {
+                ptrdiff_t entry = 0;
+                if (TILE_STATE_ENCODED == job.state[tx])
+                {
+                    output_file_write(&file, job.pages[tx], page_size);
+                    lhash = content_hash(job.pages[tx], page_size, lhash);
+                    entry = (ptrdiff_t) page_count++;
+                }
+                else if (TILE_STATE_CONSTANT == job.state[tx])
+                {
+                    float    *color = job.colors + tx * MAX_IMAGE_CHANNELS;
+                    ptrdiff_t index = tile_color_index(
+                        &result->colors, &result->color_count, &color_capacity, color, channels);
+                    if (index < 0) failed = true;
+                    entry = -index - 1;
+                }
+                else failed = true;
+                free_pixels(job.pages[tx]);
+                desc->pages[ty * tiles_x + tx] = (int32_t) entry;
+            }
+            compile_progress_step(progress);
+        }
+        content_hash_string(lhash, desc->hash);
+        free(job.colors);
+        free(job.pages);
+        free(job.state);
+    }
+    if (failed)
+    {
+        output_file_abort(&file);
+        return compile_cancelled(progress) ?
+            TEXTURE_COMPILER_CANCELLED : "Cannot get pixel data for tile.";
+    }
+    if (!output_file_commit(&file, args))
+    {
+        return "Cannot write file targetPath.";
+    }
+    result->page_size      = page;
+    result->page_byte_size = page_size;
+    result->page_count     = page_count;
+    return NULL;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Builds the V8 array describing each mip-level written by output_raw() or
+/// output_tiled().
+/// @param result The description of the levels written.
+/// @return A V8 array with one object per level, indexed by level.
+static v8::Handle<v8::Array> output_levels_to_v8(texture_output_t *result)
+{
+    v8::HandleScope        scope;
+    v8::Handle<v8::Array>  levels          = v8::Array::New((int) result->level_count);
+    v8::Handle<v8::String> prop_byteOffset = v8::String::New("byteOffset");
+    v8::Handle<v8::String> prop_byteSize   = v8::String::New("byteSize");
+    v8::Handle<v8::String> prop_height     = v8::String::New("height");
+    v8::Handle<v8::String> prop_width      = v8::String::New("width");
+    v8::Handle<v8::String> prop_chunks     = v8::String::New("chunks");
+    v8::Handle<v8::String> prop_uncompSize = v8::String::New("uncompressedSize");
+    v8::Handle<v8::String> prop_aliasOf    = v8::String::New("aliasOf");
+    v8::Handle<v8::String> prop_hash       = v8::String::New("hash");
+    v8::Handle<v8::String> prop_tilesX     = v8::String::New("tilesX");
+    v8::Handle<v8::String> prop_tilesY     = v8::String::New("tilesY");
+    v8::Handle<v8::String> prop_pages      = v8::String::New("pages");
+
+    for (size_t i = 0; i < result->level_count; ++i)
+    {
+        v8::Handle<v8::Object> desc  = v8::Object::New();
+        output_level_t        *level = &result->levels[i];
+        output_level_t        *data  = &result->levels[level->alias_of];
+        desc->Set(prop_width,  v8::Integer::NewFromUnsigned((uint32_t) level->width));
+        desc->Set(prop_height, v8::Integer::NewFromUnsigned((uint32_t) level->height));
+        if (level->pages)
+        {
+            // tiled output has a page table instead of a byte range.
+            size_t count = level->tiles_x * level->tiles_y;
+            v8::Handle<v8::Array> table = v8::Array::New((int) count);
+            for (size_t j = 0; j < count; ++j)
+                table->Set((uint32_t) j, v8::Integer::New(level->pages[j]));
+            desc->Set(prop_tilesX, v8::Integer::NewFromUnsigned((uint32_t) level->tiles_x));
+            desc->Set(prop_tilesY, v8::Integer::NewFromUnsigned((uint32_t) level->tiles_y));
+            desc->Set(prop_pages,  table);
+            desc->Set(prop_hash,   v8::String::New(level->hash));
+            levels->Set((uint32_t) i, desc);
+            continue;
+        }
+        // offsets and sizes are stored as numbers, which are exact up to
+        // 2^53 bytes. an aliased level refers to the data of an earlier one.
+        desc->Set(prop_byteOffset, v8::Number::New((double) data->byte_offset));
+        desc->Set(prop_byteSize,   v8::Number::New((double) data->byte_size));
+        desc->Set(prop_hash,       v8::String::New(data->hash));
+        if (data->chunks)
+        {
+            v8::Handle<v8::Array> table = v8::Array::New((int) data->chunk_count);
+            for (size_t j = 0;  j < data->chunk_count; ++j)
+            {
+                compressed_chunk_t    *chunk = &data->chunks[j];
+                v8::Handle<v8::Object> item  = v8::Object::New();
+                uint64_t               ofs   = data->byte_offset + chunk->data_offset;
+                item->Set(prop_byteOffset, v8::Number::New((double) ofs));
+                item->Set(prop_byteSize,   v8::Integer::NewFromUnsigned((uint32_t) chunk->data_size));
+                item->Set(prop_uncompSize, v8::Integer::NewFromUnsigned((uint32_t) chunk->source_size));
+                table->Set((uint32_t) j, item);
+            }
+            desc->Set(prop_uncompSize, v8::Number::New((double) data->uncompressed_size));
+            desc->Set(prop_chunks,     table);
+        }
+        if (level->alias_of != i)
+            desc->Set(prop_aliasOf, v8::Integer::NewFromUnsigned((uint32_t) level->alias_of));
+        levels->Set((uint32_t) i, desc);
+    }
+    return scope.Close(levels);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Builds the V8 object describing the page pool written by output_tiled().
+/// @param result The description of the pages written.
+/// @param args The texture compiler arguments.
+/// @param channels The number of channels in each tile color.
+/// @return A V8 object with the tile and page sizes, the number of pages and
+/// the tile color table.
+static v8::Handle<v8::Object> output_tiles_to_v8(
+    texture_output_t        *result,
+    texture_compiler_args_t *args,
+    size_t                   channels)
+{
+    v8::HandleScope        scope;
+    v8::Handle<v8::Object> tiles       = v8::Object::New();
+    v8::Handle<v8::Array>  color_table = v8::Array::New((int) result->color_count);
+
+    // colors are one value per channel in [0, 1] (or unclamped, for HDR
+    // images), the same as constantColor.
+    for (size_t i = 0; i < result->color_count; ++i)
+    {
+        v8::Handle<v8::Array> color = v8::Array::New((int) channels);
+        for (size_t c = 0; c < channels; ++c)
+        {
+            double value = (double) result->colors[i * MAX_IMAGE_CHANNELS + c];
+            color->Set((uint32_t) c, v8::Number::New(value));
+        }
+        color_table->Set((uint32_t) i, color);
+    }
+    tiles->Set(v8::String::New("tileSize"),     v8::Integer::NewFromUnsigned(args->tile_size));
+    tiles->Set(v8::String::New("tileBorder"),   v8::Integer::NewFromUnsigned(args->tile_border));
+    tiles->Set(v8::String::New("pageSize"),     v8::Integer::NewFromUnsigned((uint32_t) result->page_size));
+    tiles->Set(v8::String::New("pageByteSize"), v8::Number::New((double) result->page_byte_size));
+    tiles->Set(v8::String::New("pageCount"),    v8::Integer::NewFromUnsigned((uint32_t) result->page_count));
+    tiles->Set(v8::String::New("colors"),       color_table);
+    return scope.Close(tiles);
 }
 
 /*/////////////////////////////////////////////////////////////////////////80*/
@@ -812,118 +2509,1035 @@ static v8::Handle<v8::Object> output_to_v8_object(
     v8::Handle<v8::String> prop_magFilter  = v8::String::New("magFilter");
     v8::Handle<v8::String> prop_minFilter  = v8::String::New("minFilter");
     v8::Handle<v8::String> prop_hasMipmaps = v8::String::New("hasMipmaps");
+    v8::Handle<v8::String> prop_container  = v8::String::New("container");
+    v8::Handle<v8::String> prop_extension  = v8::String::New("extension");
+    v8::Handle<v8::String> prop_internal   = v8::String::New("internalFormat");
+    v8::Handle<v8::String> prop_hdrEncode  = v8::String::New("hdrEncoding");
+    v8::Handle<v8::String> prop_hdrRange   = v8::String::New("hdrRange");
+    v8::Handle<v8::String> prop_compress   = v8::String::New("compression");
+    v8::Handle<v8::String> prop_chunkSize  = v8::String::New("chunkSize");
+    v8::Handle<v8::String> prop_levelOrder = v8::String::New("levelOrder");
+    v8::Handle<v8::String> prop_levelAlign = v8::String::New("levelAlignment");
+    v8::Handle<v8::String> prop_constLevel = v8::String::New("constantLevel");
+    v8::Handle<v8::String> prop_psnr       = v8::String::New("psnr");
+    v8::Handle<v8::String> prop_constColor = v8::String::New("constantColor");
+    v8::Handle<v8::String> prop_pixHash    = v8::String::New("pixelsHash");
+    v8::Handle<v8::String> prop_pixSize    = v8::String::New("pixelsSize");
 
     char const *type_string      = args->texture_type;
-    char const *format_string    = args->target_format;
     char const *target_string    = args->texture_target;
     size_t      channels         = output->channel_count;
     bool        mipmaps          = output->level_count > 1;
-    int32_t     format           = texture_format(format_string, channels);
+    int32_t     format           = target_format(args, channels);
     metadata->Set(prop_type,       v8::String::New(args->texture_type));
     metadata->Set(prop_target,     gl_target_v8(target_string));
     metadata->Set(prop_format,     gl_format_v8(type_string, format));
     metadata->Set(prop_dataType,   gl_data_type_v8(format));
+    if (!gl_extension_v8(format)->IsUndefined())
+        metadata->Set(prop_extension, gl_extension_v8(format));
+    if (!gl_internal_format_v8(format)->IsUndefined())
+        metadata->Set(prop_internal,  gl_internal_format_v8(format));
+    if (TEXTURE_FORMAT_RGBM == format || TEXTURE_FORMAT_RGBD == format)
+    {
+        // the shader needs the range to decode the color values.
+        char const *encoding = (TEXTURE_FORMAT_RGBM == format) ? "RGBM" : "RGBD";
+        metadata->Set(prop_hdrEncode, v8::String::New(encoding));
+        metadata->Set(prop_hdrRange,  v8::Number::New((double) args->hdr_range));
+    }
     metadata->Set(prop_wrapS,      v8::String::New(args->wrap_mode_s));
     metadata->Set(prop_wrapT,      v8::String::New(args->wrap_mode_t));
     metadata->Set(prop_magFilter,  v8::String::New(args->magnify_filter));
     metadata->Set(prop_minFilter,  v8::String::New(args->minify_filter));
     metadata->Set(prop_hasMipmaps, mipmaps ? v8::True() : v8::False());
+    if (TEXTURE_FORMAT_UNKNOWN != args->selected_format)
+        metadata->Set(prop_psnr,      v8::Number::New(args->selected_psnr));
+    if (args->container)
+        metadata->Set(prop_container, v8::True());
+    if (LEVEL_ORDER_SMALLEST_FIRST == level_order(args->level_order))
+        metadata->Set(prop_levelOrder, v8::String::New("SMALLEST_FIRST"));
+    if (args->level_alignment > 1)
+        metadata->Set(prop_levelAlign, v8::Integer::NewFromUnsigned(args->level_alignment));
+    if (LEVEL_COMPRESSION_LZ4 == level_compression(args->compression))
+    {
+        metadata->Set(prop_compress,  v8::String::New("LZ4"));
+        metadata->Set(prop_chunkSize, v8::Integer::NewFromUnsigned(args->chunk_size));
+    }
+    if (output->constant_level < output->level_count)
+    {
+        // levels from constantLevel on are a single solid color, given as
+        // one value per channel in [0, 1] (or unclamped, for HDR images.)
+        v8::Handle<v8::Array> color = v8::Array::New((int) channels);
+        for (size_t i = 0; i < channels; ++i)
+        {
+            double value = (double) output->constant_color[i];
+            color->Set((uint32_t) i, v8::Number::New(value));
+        }
+        metadata->Set(prop_constLevel, v8::Integer::NewFromUnsigned((uint32_t) output->constant_level));
+        metadata->Set(prop_constColor, color);
+    }
+    metadata->Set(prop_pixHash,    v8::String::New(args->pixels_hash));
+    metadata->Set(prop_pixSize,    v8::Number::New(args->pixels_size));
     metadata->Set(prop_levels,     levels);
     return scope.Close(metadata);
 }
 
 /*/////////////////////////////////////////////////////////////////////////80*/
 
-v8::Handle<v8::Value> Compile(v8::Arguments const &args)
+/// Stores the state of a single texture compilation. A job is filled in from
+/// the V8 arguments on the main thread, compiled and written without V8 on
+/// any thread, and converted back to V8 metadata on the main thread.
+struct compile_job_t
 {
-    texture_compiler_args_t    tcarg;
-    texture_compiler_inputs_t  tcinp;
-    texture_compiler_outputs_t tcout;
-    image::buffer_t            image;
-    v8::HandleScope            scope;
-    v8::Local<v8::Object>      params = args[0]->ToObject();
+    texture_compiler_args_t      args;      /// The compiler arguments.
+    texture_compiler_outputs_t   outputs;   /// The compiled levels.
+    texture_output_t             result;    /// What was written to the file.
+    compile_progress_t           progress;  /// Progress and cancellation.
+    char const                  *error;     /// The error message, if any.
+    bool                         succeeded; /// Did the compilation succeed?
+    bool                         notifying; /// Is the notify handle open?
+    uint32_t                     id;        /// The id passed to cancel().
+    compile_job_t               *next;      /// The next in-flight job.
+    uv_work_t                    request;   /// The libuv thread pool request.
+    uv_async_t                   notify;    /// Wakes the main thread on progress.
+    v8::Persistent<v8::Function> callback;  /// The completion callback.
+    v8::Persistent<v8::Function> on_progress; /// The progress callback.
+};
 
-    // extract the arguments into something we can work with
-    // without V8; verify that required arguments are present.
-    v8::Handle<v8::Value> r1 = v8_object_to_compiler_args(params, &tcarg);
-    if (!r1->IsUndefined())
-    {
-        // an exception was thrown. return it.
-        free_compiler_args(&tcarg);
-        return scope.Close(v8::ThrowException(r1));
-    }
+/// The id of the next compileAsync() or compileBatch() request. Ids are
+/// only handed out and looked up on the main thread.
+static uint32_t         next_compile_id = 1;
 
-    // load the image from the specified source file.
-    if (!file_to_buffer(tcarg.source_path, &image))
-    {
-        free_compiler_args(&tcarg);
-        return scope.Close(ex("Cannot load file specified by sourcePath."));
-    }
+/// The list of in-flight compileAsync() requests, for cancel().
+static compile_job_t   *active_jobs     = NULL;
 
-    // validate the arguments against the image properties.
-    v8::Handle<v8::Value> r2 = validate_arguments(&tcarg, &image);
-    if (!r2->IsUndefined())
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static compile_job_t* compile_job_create(void)
+{
+    compile_job_t *job = (compile_job_t*) malloc(sizeof(compile_job_t));
+    if (job)
     {
-        // an exception was thrown. return it.
-        free_buffer(&image);
-        free_compiler_args(&tcarg);
-        return scope.Close(v8::ThrowException(r2));
+        init_compiler_args(&job->args);
+        texture_compiler_outputs_init(&job->outputs);
+        texture_output_init(&job->result, 0);
+        compile_progress_init(&job->progress, NULL, job);
+        job->error        = NULL;
+        job->succeeded    = false;
+        job->notifying    = false;
+        job->id           = 0;
+        job->next         = NULL;
+        job->request.data = job;
+        job->notify.data  = job;
+        job->callback     = v8::Persistent<v8::Function>();
+        job->on_progress  = v8::Persistent<v8::Function>();
     }
+    return job;
+}
 
-    // set up the inputs to the texture compiler.
-    texture_compiler_inputs_init(&tcinp);
-    texture_compiler_outputs_init(&tcout);
-    tcinp.input_image    = &image;
-    tcinp.border_mode    = border_sample_mode(tcarg.border_mode);
-    tcinp.target_width   = tcarg.target_width;
-    tcinp.target_height  = tcarg.target_height;
-    tcinp.maximum_levels = tcarg.level_count;
-    tcinp.build_mipmaps  = tcarg.build_mipmaps;
-    tcinp.force_pow2     = tcarg.force_pow2;
-    tcinp.premultiply_a  = tcarg.premultiplied;
-    tcinp.flip_y         = tcarg.flip_y;
+/*/////////////////////////////////////////////////////////////////////////80*/
 
-    // build the texture data.
-    if (!compile_texture(&tcinp, &tcout))
+/// Frees a job once its progress notification handle has been closed.
+static void compile_job_closed(uv_handle_t *handle)
+{
+    free(handle->data);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static void compile_job_delete(compile_job_t *job)
+{
+    if (job)
     {
-        free_compiler_args(&tcarg);
-        return scope.Close(v8::ThrowException(ex(tcout.error_message)));
+        if (!job->callback.IsEmpty())
+            job->callback.Dispose();
+        if (!job->on_progress.IsEmpty())
+            job->on_progress.Dispose();
+        texture_output_free(&job->result);
+        texture_compiler_outputs_free(&job->outputs);
+        free_compiler_args(&job->args);
+        if (job->notifying)
+        {
+            // libuv owns the handle until the close callback runs.
+            uv_close((uv_handle_t*) &job->notify, compile_job_closed);
+            return;
+        }
+        free(job);
     }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Removes a job from the list of in-flight jobs.
+static void compile_job_unlink(compile_job_t *job)
+{
+    compile_job_t **link = &active_jobs;
+    while (*link && *link != job)
+        link = &(*link)->next;
+    if (*link) *link = job->next;
+    job->next = NULL;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
 
-    // write the raw texture data.
-    size_t                 nlevels  = tcout.level_count;
-    size_t                 channels = tcout.channel_count;
-    int32_t                format   = texture_format(tcarg.target_format, channels);
-    char const            *target   = tcarg.target_path;
-    v8::Handle<v8::Array>  levels   = v8::Array::New((int) nlevels);
-    v8::Handle<v8::Value>  r3       = v8_output_raw(target, format, levels, &tcout);
-    if (!r3->IsUndefined())
+/// Creates the Error object passed to the callback of a failed job. The
+/// Error has a cancelled property set to true if the job was cancelled.
+static v8::Handle<v8::Value> compile_job_error(compile_job_t *job)
+{
+    v8::HandleScope       scope;
+    v8::Handle<v8::Value> error = ex(job->error);
+    if (job->error && 0 == strcmp(job->error, TEXTURE_COMPILER_CANCELLED))
     {
-        texture_compiler_outputs_free(&tcout);
-        free_buffer(&image);
-        free_compiler_args(&tcarg);
-        return scope.Close(v8::ThrowException(r3));
+        error->ToObject()->Set(v8::String::New("cancelled"), v8::True());
     }
+    return scope.Close(error);
+}
 
-    // build the object to return to JavaScript.
-    v8::Handle<v8::Object> metadata = output_to_v8_object(&tcarg, &tcout, levels);
-
-    // release resources that are no longer needed.
-    texture_compiler_outputs_free(&tcout);
-    free_buffer(&image);
-    free_compiler_args(&tcarg);
+/*/////////////////////////////////////////////////////////////////////////80*/
 
-    return scope.Close(metadata);
+/// Returns the name of a compile_stage_e value, as passed to JavaScript.
+static char const* compile_stage_name(int32_t stage)
+{
+    switch (stage)
+    {
+        case COMPILE_STAGE_LOAD:    return "LOAD";
+        case COMPILE_STAGE_RESIZE:  return "RESIZE";
+        case COMPILE_STAGE_MIPMAPS: return "MIPMAPS";
+        case COMPILE_STAGE_ENCODE:  return "ENCODE";
+        case COMPILE_STAGE_WRITE:   return "WRITE";
+        default:                    break;
+    }
+    return "UNKNOWN";
 }
 
 /*/////////////////////////////////////////////////////////////////////////80*/
 
-void init(v8::Handle<v8::Object> target)
+/// Loads the source image, builds the texture levels and writes the output
+/// file. This function does not touch V8, so it can run on a worker thread.
+/// @param job The job to run. On return, job->error is set if it failed.
+/// @return true if the texture was compiled and written successfully.
+static bool compile_job_run(compile_job_t *job)
 {
-    // publish our global functions:
+    texture_compiler_args_t    *tcarg = &job->args;
+    texture_compiler_outputs_t *tcout = &job->outputs;
+    texture_compiler_inputs_t   tcinp;
+    image::buffer_t             image;
+
+    // load the image from the specified source file.
+    compile_progress_begin(&job->progress, COMPILE_STAGE_LOAD, 1);
+    if (!file_to_buffer(tcarg->source_path, &image))
+    {
+        job->error = "Cannot load file specified by sourcePath.";
+        return false;
+    }
+    if (!compile_progress_step(&job->progress))
+    {
+        free_buffer(&image);
+        job->error = TEXTURE_COMPILER_CANCELLED;
+        return false;
+    }
+
+    // validate the arguments against the image properties.
+    if ((job->error = validate_arguments(tcarg, &image)) != NULL)
+    {
+        free_buffer(&image);
+        return false;
+    }
+
+    // drop an opaque alpha channel and identical color channels before
+    // any resampling is done, so every later stage touches less data.
+    if (is_auto_format(tcarg->target_format))
+        prune_channels(&image);
+
+    // set up the inputs to the texture compiler.
+    texture_compiler_inputs_init(&tcinp);
+    tcinp.input_image    = &image;
+    tcinp.border_mode    = border_sample_mode(tcarg->border_mode);
+    tcinp.target_width   = tcarg->target_width;
+    tcinp.target_height  = tcarg->target_height;
+    tcinp.maximum_levels = tcarg->level_count;
+    tcinp.build_mipmaps  = tcarg->build_mipmaps;
+    tcinp.force_pow2     = tcarg->force_pow2;
+    tcinp.premultiply_a  = tcarg->premultiplied;
+    tcinp.flip_y         = tcarg->flip_y;
+    tcinp.progress       = &job->progress;
+
+    // PVRTC is only defined for square, power-of-two textures.
+    int32_t request_fmt  = target_format(tcarg, image.channel_count);
+    if (TEXTURE_FORMAT_PVRTC_2BPP == request_fmt ||
+        TEXTURE_FORMAT_PVRTC_4BPP == request_fmt)
+    {
+        tcinp.force_pow2   = true;
+        tcinp.force_square = true;
+    }
+    tcinp.constant_tolerance = constant_tolerance(request_fmt);
+
+    // build the texture data.
+    if (!compile_texture(&tcinp, tcout))
+    {
+        free_buffer(&image);
+        job->error = tcout->error_message;
+        return false;
+    }
+    free_buffer(&image);
+
+    // AUTO with an error budget picks the smallest format whose error on
+    // the top level is within the budget.
+    if (is_auto_format(tcarg->target_format) && tcarg->target_psnr > 0.0f)
+    {
+        if (!select_auto_format(tcarg, &tcout->level_data[0]))
+        {
+            job->error = "Out of memory.";
+            return false;
+        }
+    }
+
+    // write the raw texture data. RGBM and RGBD default to a range that
+    // covers the brightest color in the image.
+    int32_t format = target_format(tcarg, tcout->channel_count);
+    if ((TEXTURE_FORMAT_RGBM == format || TEXTURE_FORMAT_RGBD == format) &&
+        (tcarg->hdr_range <= 0.0f))
+    {
+        tcarg->hdr_range = hdr_range(&tcout->level_data[0]);
+    }
+    if (!texture_output_init(&job->result, tcout->level_count))
+    {
+        job->error = "Out of memory.";
+        return false;
+    }
+    job->error = (tcarg->tile_size > 0) ?
+        output_tiled(tcarg, format, tcout, &job->result, &job->progress) :
+        output_raw  (tcarg, format, tcout, &job->result, &job->progress);
+    return (NULL == job->error);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Builds the object returned to JavaScript for a successful job.
+static v8::Handle<v8::Object> compile_job_metadata(compile_job_t *job)
+{
+    v8::HandleScope        scope;
+    v8::Handle<v8::Array>  levels   = output_levels_to_v8(&job->result);
+    v8::Handle<v8::Object> metadata = output_to_v8_object(&job->args, &job->outputs, levels);
+    if (job->args.tile_size > 0)
+    {
+        size_t channels = job->outputs.channel_count;
+        metadata->Set(
+            v8::String::New("tiles"),
+            output_tiles_to_v8(&job->result, &job->args, channels));
+    }
+    return scope.Close(metadata);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+v8::Handle<v8::Value> Compile(v8::Arguments const &args)
+{
+    v8::HandleScope       scope;
+    v8::Local<v8::Object> params = args[0]->ToObject();
+    compile_job_t        *job    = compile_job_create();
+    if (NULL == job)
+    {
+        return scope.Close(v8::ThrowException(ex("Out of memory.")));
+    }
+
+    // extract the arguments into something we can work with
+    // without V8; verify that required arguments are present.
+    v8::Handle<v8::Value> r1 = v8_object_to_compiler_args(params, &job->args);
+    if (!r1->IsUndefined())
+    {
+        // an exception was thrown. return it.
+        compile_job_delete(job);
+        return scope.Close(v8::ThrowException(r1));
+    }
+
+    // build the texture data and write it out.
+    if (!compile_job_run(job))
+    {
+        v8::Handle<v8::Value> r2 = ex(job->error);
+        compile_job_delete(job);
+        return scope.Close(v8::ThrowException(r2));
+    }
+
+    // build the object to return to JavaScript.
+    v8::Handle<v8::Object> metadata = compile_job_metadata(job);
+    compile_job_delete(job);
+    return scope.Close(metadata);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Receives progress from the compiler on a worker thread, and wakes the
+/// main thread to report it. libuv coalesces wake-ups that arrive before
+/// the main thread runs, so only the latest progress is reported.
+static void CMN_CALL_C compile_job_progress(
+    int32_t stage,
+    size_t  done,
+    size_t  total,
+    void   *context)
+{
+    compile_job_t *job = (compile_job_t*) context;
+    CMN_UNUSED(stage);
+    CMN_UNUSED(done);
+    CMN_UNUSED(total);
+    uv_async_send(&job->notify);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Invokes the progress callback of a compile job on the main thread. The
+/// signature of the async callback changed in libuv 1.0.
+#if UV_VERSION_MAJOR == 0
+static void compile_job_notify(uv_async_t *handle, int status)
+#else
+static void compile_job_notify(uv_async_t *handle)
+#endif
+{
+    v8::HandleScope        scope;
+    compile_job_t         *job = (compile_job_t*) handle->data;
+    v8::Handle<v8::Value>  argv[3];
+#if UV_VERSION_MAJOR == 0
+    CMN_UNUSED(status);
+#endif
+    if (job->on_progress.IsEmpty()) return;
+    argv[0] = v8::String::New(compile_stage_name(job->progress.stage));
+    argv[1] = v8::Number::New((double) job->progress.done);
+    argv[2] = v8::Number::New((double) job->progress.total);
+
+    v8::TryCatch try_catch;
+    job->on_progress->Call(v8::Context::GetCurrent()->Global(), 3, argv);
+    if (try_catch.HasCaught())
+    {
+        node::FatalException(try_catch);
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Runs a compile job on a libuv thread pool thread.
+static void compile_job_work(uv_work_t *request)
+{
+    compile_job_t *job = (compile_job_t*) request->data;
+    job->succeeded = compile_job_run(job);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Invokes the callback of a completed compile job on the main thread. The
+/// signature of the completion callback changed in libuv 0.10.
+#if UV_VERSION_MAJOR == 0 && UV_VERSION_MINOR < 10
+static void compile_job_done(uv_work_t *request)
+#else
+static void compile_job_done(uv_work_t *request, int status)
+#endif
+{
+    v8::HandleScope        scope;
+    compile_job_t         *job = (compile_job_t*) request->data;
+    v8::Handle<v8::Value>  argv[2];
+#if !(UV_VERSION_MAJOR == 0 && UV_VERSION_MINOR < 10)
+    CMN_UNUSED(status);
+#endif
+    if (job->succeeded)
+    {
+        argv[0] = v8::Null();
+        argv[1] = compile_job_metadata(job);
+    }
+    else
+    {
+        argv[0] = compile_job_error(job);
+        argv[1] = v8::Undefined();
+    }
+
+    // release the job before calling back, in case the callback throws.
+    v8::Local<v8::Function> callback = v8::Local<v8::Function>::New(job->callback);
+    compile_job_unlink(job);
+    compile_job_delete(job);
+
+    v8::TryCatch try_catch;
+    callback->Call(v8::Context::GetCurrent()->Global(), 2, argv);
+    if (try_catch.HasCaught())
+    {
+        node::FatalException(try_catch);
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Compiles a texture on the libuv thread pool. The source image is loaded,
+/// compiled and written on a worker thread, so the main thread can continue
+/// to process events, and several textures can be compiled at once.
+/// @param args[0] An object specifying the texture attributes, as for
+/// compile().
+/// @param args[1] A function(error, metadata) called on completion. Exactly
+/// one of error and metadata is set. If the compile was cancelled, error has
+/// a cancelled property set to true.
+/// @param args[2] An optional function(stage, done, total) called on the main
+/// thread as the compile progresses. stage is one of 'LOAD', 'RESIZE',
+/// 'MIPMAPS', 'ENCODE' or 'WRITE', and done counts up to total within it.
+/// @return The id of the compile, which can be passed to cancel(). Errors in
+/// the attributes object are thrown immediately.
+v8::Handle<v8::Value> CompileAsync(v8::Arguments const &args)
+{
+    v8::HandleScope scope;
+    if (args.Length() < 2 || !args[0]->IsObject() || !args[1]->IsFunction())
+    {
+        return scope.Close(v8::ThrowException(ex("Expected an attributes object and a callback function.")));
+    }
+    if (args.Length() > 2 && !args[2]->IsFunction() && !args[2]->IsUndefined())
+    {
+        return scope.Close(v8::ThrowException(ex("Expected the progress callback to be a function.")));
+    }
+
+    compile_job_t *job = compile_job_create();
+    if (NULL == job)
+    {
+        return scope.Close(v8::ThrowException(ex("Out of memory.")));
+    }
+
+    // copy the arguments out of V8; the worker thread can't touch them.
+    v8::Handle<v8::Value> r1 = v8_object_to_compiler_args(args[0]->ToObject(), &job->args);
+    if (!r1->IsUndefined())
+    {
+        compile_job_delete(job);
+        return scope.Close(v8::ThrowException(r1));
+    }
+    job->callback = v8::Persistent<v8::Function>::New(v8::Local<v8::Function>::Cast(args[1]));
+    if (args.Length() > 2 && args[2]->IsFunction())
+    {
+        uv_async_init(uv_default_loop(), &job->notify, compile_job_notify);
+        job->on_progress       = v8::Persistent<v8::Function>::New(v8::Local<v8::Function>::Cast(args[2]));
+        job->progress.callback = compile_job_progress;
+        job->notifying         = true;
+    }
+    job->id     = next_compile_id++;
+    job->next   = active_jobs;
+    active_jobs = job;
+    uv_queue_work(uv_default_loop(), &job->request, compile_job_work, compile_job_done);
+    return scope.Close(v8::Number::New((double) job->id));
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Stores the state of a batch of texture compilations. Every job in the
+/// batch is compiled from a single libuv thread pool request, with the jobs
+/// spread across all processors by parallel_for().
+struct compile_batch_t
+{
+    size_t                        job_count; /// The number of definitions.
+    compile_job_t               **jobs;      /// The jobs, or NULL if invalid.
+    uint32_t                      id;        /// The id passed to cancel().
+    compile_batch_t              *next;      /// The next in-flight batch.
+    uv_work_t                     request;   /// The libuv thread pool request.
+    v8::Persistent<v8::Array>     errors;    /// Per-item validation errors.
+    v8::Persistent<v8::Function>  callback;  /// The completion callback.
+};
+
+/// The list of in-flight compileBatch() requests, for cancel().
+static compile_batch_t *active_batches = NULL;
+
+/// Associates a target path with the index of the definition it came from,
+/// for finding definitions in a batch that would write the same file.
+struct batch_target_t
+{
+    char       *path;                   /// The resolved targetPath.
+    size_t      index;                  /// The index of the definition.
+};
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static compile_batch_t* compile_batch_create(size_t job_count)
+{
+    compile_batch_t *batch = (compile_batch_t*) malloc(sizeof(compile_batch_t));
+    if (NULL == batch) return NULL;
+    batch->jobs = (compile_job_t**) malloc((job_count > 0 ? job_count : 1) * sizeof(compile_job_t*));
+    if (NULL == batch->jobs)
+    {
+        free(batch);
+        return NULL;
+    }
+    for (size_t i = 0; i < job_count; ++i)
+        batch->jobs[i]  = NULL;
+    batch->job_count    = job_count;
+    batch->id           = 0;
+    batch->next         = NULL;
+    batch->request.data = batch;
+    batch->errors       = v8::Persistent<v8::Array>();
+    batch->callback     = v8::Persistent<v8::Function>();
+    return batch;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static void compile_batch_delete(compile_batch_t *batch)
+{
+    if (batch)
+    {
+        if (!batch->callback.IsEmpty())
+            batch->callback.Dispose();
+        if (!batch->errors.IsEmpty())
+            batch->errors.Dispose();
+        for (size_t i = 0; i < batch->job_count; ++i)
+            compile_job_delete(batch->jobs[i]);
+        free(batch->jobs);
+        free(batch);
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Resolves a target path to an absolute path, so that different spellings
+/// of the same file compare equal. On POSIX systems, the directory is passed
+/// through realpath() to resolve '.', '..' and symbolic links, and the file
+/// name, which may not exist yet, is appended. If the directory does not
+/// exist the path is returned unchanged; writing to it will fail anyway.
+/// @param path The target path.
+/// @return The resolved path, which must be freed with free(), or NULL if
+/// memory could not be allocated.
+static char* resolve_target_path(char const *path)
+{
+#if CMN_IS_WINDOWS
+    char *full = _fullpath(NULL, path, 0);
+    if (full) return full;
+#else
+    char const *slash = strrchr(path, '/');
+    char const *name  = slash ? slash + 1 : path;
+    size_t      dlen  = slash ? (size_t) (slash - path) : 0;
+    char       *dir   = (char*) malloc(dlen + 2);
+    char       *real  = NULL;
+    if (NULL == dir) return NULL;
+    if (NULL == slash) strcpy(dir, ".");
+    else if (0 == dlen) strcpy(dir, "/");
+    else
+    {
+        memcpy(dir, path, dlen);
+        dir[dlen] = 0;
+    }
+    real = realpath(dir, NULL);
+    free(dir);
+    if (real)
+    {
+        size_t rlen = strlen(real);
+        size_t nlen = strlen(name);
+        char  *full = (char*) malloc(rlen + nlen + 2);
+        if (full)
+        {
+            // realpath() returns "/" for the root, and no trailing '/'
+            // for anything else.
+            memcpy(full, real, rlen);
+            if (rlen > 0 && real[rlen - 1] != '/') full[rlen++] = '/';
+            memcpy(full + rlen, name, nlen + 1);
+        }
+        free(real);
+        return full;
+    }
+#endif
+    size_t len  = strlen(path);
+    char  *copy = (char*) malloc(len + 1);
+    if (copy) memcpy(copy, path, len + 1);
+    return copy;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static int compare_batch_target(void const *a, void const *b)
+{
+    batch_target_t const *ta = (batch_target_t const*) a;
+    batch_target_t const *tb = (batch_target_t const*) b;
+    int                   r  = PATH_COMPARE(ta->path, tb->path);
+    if (r != 0) return r;
+    return (ta->index < tb->index) ? -1 : ((ta->index > tb->index) ? 1 : 0);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Rejects definitions that would write the same file as an earlier one in
+/// the batch, since they would be written concurrently. Target paths are
+/// compared after resolve_target_path(), so 'a/b.pixels' and './a/b.pixels'
+/// are found to be the same file.
+/// @param batch The batch to check. Rejected jobs are removed from the batch.
+/// @param errors The array of per-item errors to update.
+/// @return false if memory could not be allocated.
+static bool reject_duplicate_targets(compile_batch_t *batch, v8::Handle<v8::Array> errors)
+{
+    batch_target_t *targets = (batch_target_t*) malloc((batch->job_count > 0 ? batch->job_count : 1) * sizeof(batch_target_t));
+    size_t          count   = 0;
+    bool            ok      = true;
+    if (NULL == targets) return false;
+    for (size_t i = 0; i < batch->job_count; ++i)
+    {
+        if (batch->jobs[i])
+        {
+            targets[count].path  = resolve_target_path(batch->jobs[i]->args.target_path);
+            targets[count].index = i;
+            if (NULL == targets[count].path)
+            {
+                ok = false;
+                break;
+            }
+            count++;
+        }
+    }
+    if (ok)
+    {
+        qsort(targets, count, sizeof(batch_target_t), compare_batch_target);
+        for (size_t i = 1; i < count; ++i)
+        {
+            if (0 == PATH_COMPARE(targets[i - 1].path, targets[i].path))
+            {
+                size_t index = targets[i].index;
+                errors->Set((uint32_t) index, ex("targetPath is used by an earlier texture in the batch."));
+                compile_job_delete(batch->jobs[index]);
+                batch->jobs[index] = NULL;
+            }
+        }
+    }
+    for (size_t i = 0; i < count; ++i)
+        free(targets[i].path);
+    free(targets);
+    return ok;
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Compiles a single job of a batch on one of the parallel_for() threads.
+static void CMN_CALL_C compile_batch_item(size_t index, void *context)
+{
+    compile_batch_t *batch = (compile_batch_t*) context;
+    compile_job_t   *job   = batch->jobs[index];
+    if (job) job->succeeded = compile_job_run(job);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Runs all of the jobs in a batch on a libuv thread pool thread. The work
+/// within each job shares the same threads, so idle processors help with
+/// the largest textures once the rest of the batch has finished.
+static void compile_batch_work(uv_work_t *request)
+{
+    compile_batch_t *batch = (compile_batch_t*) request->data;
+    parallel_for(batch->job_count, compile_batch_item, batch);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Invokes the callback of a completed batch on the main thread.
+#if UV_VERSION_MAJOR == 0 && UV_VERSION_MINOR < 10
+static void compile_batch_done(uv_work_t *request)
+#else
+static void compile_batch_done(uv_work_t *request, int status)
+#endif
+{
+    v8::HandleScope        scope;
+    compile_batch_t       *batch   = (compile_batch_t*) request->data;
+    v8::Local<v8::Array>   errors  = v8::Local<v8::Array>::New(batch->errors);
+    v8::Local<v8::Array>   results = v8::Array::New((int) batch->job_count);
+    bool                   failed  = false;
+    v8::Handle<v8::Value>  argv[2];
+#if !(UV_VERSION_MAJOR == 0 && UV_VERSION_MINOR < 10)
+    CMN_UNUSED(status);
+#endif
+    for (size_t i = 0; i < batch->job_count; ++i)
+    {
+        compile_job_t *job = batch->jobs[i];
+        if (job && job->succeeded)
+        {
+            errors->Set((uint32_t) i, v8::Null());
+            results->Set((uint32_t) i, compile_job_metadata(job));
+            continue;
+        }
+        if (job) errors->Set((uint32_t) i, compile_job_error(job));
+        results->Set((uint32_t) i, v8::Undefined());
+        failed = true;
+    }
+    argv[0] = failed ? v8::Handle<v8::Value>(errors) : v8::Handle<v8::Value>(v8::Null());
+    argv[1] = results;
+
+    // release the batch before calling back, in case the callback throws.
+    v8::Local<v8::Function> callback = v8::Local<v8::Function>::New(batch->callback);
+    compile_batch_t       **link     = &active_batches;
+    while (*link && *link != batch)
+        link = &(*link)->next;
+    if (*link) *link = batch->next;
+    compile_batch_delete(batch);
+
+    v8::TryCatch try_catch;
+    callback->Call(v8::Context::GetCurrent()->Global(), 2, argv);
+    if (try_catch.HasCaught())
+    {
+        node::FatalException(try_catch);
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Compiles a batch of textures on the libuv thread pool. All definitions
+/// are validated up-front, then the textures are loaded, compiled and written
+/// across all processors by the shared work-stealing thread pool. This avoids
+/// a round trip into JavaScript per texture and keeps every core busy.
+/// @param args[0] An array of objects specifying texture attributes, as for
+/// compile(). No two definitions may have the same targetPath.
+/// @param args[1] A function(errors, results) called when every texture in
+/// the batch has been processed. errors is null if all textures succeeded;
+/// otherwise it is an array with an Error or null for each definition.
+/// results is an array with the metadata of each texture, or undefined for
+/// those that failed. Textures not finished when the batch is cancelled
+/// fail with an Error whose cancelled property is true.
+/// @return The id of the batch, which can be passed to cancel().
+v8::Handle<v8::Value> CompileBatch(v8::Arguments const &args)
+{
+    v8::HandleScope scope;
+    if (args.Length() < 2 || !args[0]->IsArray() || !args[1]->IsFunction())
+    {
+        return scope.Close(v8::ThrowException(ex("Expected an array of attributes objects and a callback function.")));
+    }
+
+    v8::Local<v8::Array> items  = v8::Local<v8::Array>::Cast(args[0]);
+    v8::Local<v8::Array> errors = v8::Array::New((int) items->Length());
+    compile_batch_t     *batch  = compile_batch_create(items->Length());
+    if (NULL == batch)
+    {
+        return scope.Close(v8::ThrowException(ex("Out of memory.")));
+    }
+
+    // copy the arguments out of V8; the worker threads can't touch them.
+    // invalid definitions are reported through the callback.
+    for (size_t i = 0; i < batch->job_count; ++i)
+    {
+        v8::Local<v8::Value> item = items->Get((uint32_t) i);
+        if (!item->IsObject())
+        {
+            errors->Set((uint32_t) i, ex("Expected an attributes object."));
+            continue;
+        }
+        compile_job_t *job = compile_job_create();
+        if (NULL == job)
+        {
+            compile_batch_delete(batch);
+            return scope.Close(v8::ThrowException(ex("Out of memory.")));
+        }
+        v8::Handle<v8::Value> r1 = v8_object_to_compiler_args(item->ToObject(), &job->args);
+        if (!r1->IsUndefined())
+        {
+            errors->Set((uint32_t) i, r1);
+            compile_job_delete(job);
+            continue;
+        }
+        batch->jobs[i] = job;
+    }
+    if (!reject_duplicate_targets(batch, errors))
+    {
+        compile_batch_delete(batch);
+        return scope.Close(v8::ThrowException(ex("Out of memory.")));
+    }
+
+    batch->errors   = v8::Persistent<v8::Array>::New(errors);
+    batch->callback = v8::Persistent<v8::Function>::New(v8::Local<v8::Function>::Cast(args[1]));
+    batch->id       = next_compile_id++;
+    batch->next     = active_batches;
+    active_batches  = batch;
+    uv_queue_work(uv_default_loop(), &batch->request, compile_batch_work, compile_batch_done);
+    return scope.Close(v8::Number::New((double) batch->id));
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Requests cancellation of a compileAsync() or compileBatch() request. The
+/// compile stops at its next check, between levels, bands of rows or tiles,
+/// releases its buffers and deletes its temporary file, leaving any existing
+/// target file untouched. Its callback is still called, with an Error whose
+/// cancelled property is true. A texture that finishes before the check is
+/// written as usual.
+/// @param args[0] The id returned by compileAsync() or compileBatch().
+/// @return true if the request was found, or false if it has completed.
+v8::Handle<v8::Value> Cancel(v8::Arguments const &args)
+{
+    v8::HandleScope scope;
+    if (args.Length() < 1 || !args[0]->IsNumber())
+    {
+        return scope.Close(v8::ThrowException(ex("Expected a compile id.")));
+    }
+
+    uint32_t id = args[0]->Uint32Value();
+    for (compile_job_t *job = active_jobs; job != NULL; job = job->next)
+    {
+        if (job->id == id)
+        {
+            compile_cancel(&job->progress);
+            return scope.Close(v8::True());
+        }
+    }
+    for (compile_batch_t *batch = active_batches; batch != NULL; batch = batch->next)
+    {
+        if (batch->id == id)
+        {
+            for (size_t i = 0; i < batch->job_count; ++i)
+            {
+                if (batch->jobs[i]) compile_cancel(&batch->jobs[i]->progress);
+            }
+            return scope.Close(v8::True());
+        }
+    }
+    return scope.Close(v8::False());
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Tracks the node::Buffer objects referencing a mapped image container. The
+/// file is unmapped when the last buffer referencing it is garbage collected.
+struct container_view_t
+{
+    container_file_t file;              /// The mapped container file.
+    size_t           reference_count;   /// Number of live references.
+};
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static void container_view_release(char *data, void *hint)
+{
+    container_view_t *view = (container_view_t*) hint;
+    CMN_UNUSED(data);
+    if (view && --view->reference_count == 0)
+    {
+        container_file_close(&view->file);
+        free(view);
+    }
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+static v8::Handle<v8::Object> container_buffer_v8(
+    container_view_t *view,
+    void             *data,
+    size_t            size)
+{
+    v8::HandleScope scope;
+    node::Buffer   *buffer = node::Buffer::New(
+        (char*) data, size, container_view_release, view);
+    view->reference_count++;
+    return scope.Close(buffer->handle_);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+/// Maps an image container file written with the container option and
+/// returns its header fields along with a node::Buffer for each level that
+/// references the mapped file directly; no image data is copied. The file is
+/// unmapped once all of the level buffers have been garbage collected.
+/// @param args[0] A string specifying the path of the container file.
+/// @return An object describing the container and its levels.
+v8::Handle<v8::Value> OpenContainer(v8::Arguments const &args)
+{
+    v8::HandleScope scope;
+    if (args.Length() < 1 || !args[0]->IsString())
+    {
+        return scope.Close(v8::ThrowException(ex("Expected a path string.")));
+    }
+
+    char             *path = v8_string_to_utf8(args[0]);
+    container_view_t *view = (container_view_t*) malloc(sizeof(container_view_t));
+    if (NULL == view)
+    {
+        free(path);
+        return scope.Close(v8::ThrowException(ex("Out of memory.")));
+    }
+    if (!container_file_open(path, &view->file))
+    {
+        v8::Handle<v8::Value> error = ex(view->file.error_message);
+        free(view);
+        free(path);
+        return scope.Close(v8::ThrowException(error));
+    }
+    free(path);
+
+    // cache some property names so we don't create them repeatedly.
+    v8::Handle<v8::String> prop_item       = v8::String::New("item");
+    v8::Handle<v8::String> prop_face       = v8::String::New("face");
+    v8::Handle<v8::String> prop_level      = v8::String::New("level");
+    v8::Handle<v8::String> prop_width      = v8::String::New("width");
+    v8::Handle<v8::String> prop_height     = v8::String::New("height");
+    v8::Handle<v8::String> prop_slices     = v8::String::New("slices");
+    v8::Handle<v8::String> prop_byteOffset = v8::String::New("byteOffset");
+    v8::Handle<v8::String> prop_byteSize   = v8::String::New("byteSize");
+    v8::Handle<v8::String> prop_data       = v8::String::New("data");
+
+    // hold a reference while the buffers are created, so a collection
+    // that happens part-way through can't unmap the file underneath us.
+    image::container_t    *c      = &view->file.container;
+    size_t                 faces  = image::face_count(c->flags);
+    size_t                 index  = 0;
+    v8::Handle<v8::Array>  levels = v8::Array::New((int) (c->items * faces * c->levels));
+    view->reference_count = 1;
+    for (size_t i = 0; i < c->items; ++i)
+    {
+        for (size_t f = 0; f < faces; ++f)
+        {
+            for (size_t l = 0; l < c->levels; ++l)
+            {
+                v8::Handle<v8::Object> desc = v8::Object::New();
+                size_t                 ofs  = 0;
+                size_t                 size = 0;
+                void                  *data = container_level_data(
+                    &view->file, i, f, l, &ofs, &size);
+                desc->Set(prop_item,       v8::Integer::NewFromUnsigned((uint32_t) i));
+                desc->Set(prop_face,       v8::Integer::NewFromUnsigned((uint32_t) f));
+                desc->Set(prop_level,      v8::Integer::NewFromUnsigned((uint32_t) l));
+                desc->Set(prop_width,      v8::Integer::NewFromUnsigned((uint32_t) image::miplevel_width (c->width,  l)));
+                desc->Set(prop_height,     v8::Integer::NewFromUnsigned((uint32_t) image::miplevel_height(c->height, l)));
+                desc->Set(prop_slices,     v8::Integer::NewFromUnsigned((uint32_t) image::miplevel_slices(c->slices, l)));
+                desc->Set(prop_byteOffset, v8::Number::New((double) ofs));
+                desc->Set(prop_byteSize,   v8::Number::New((double) size));
+                // node::Buffer is limited to 1GB; larger levels must be
+                // read from the file using byteOffset and byteSize.
+                if (size <= NODE_BUFFER_MAX_LENGTH)
+                    desc->Set(prop_data,   container_buffer_v8(view, data, size));
+                levels->Set((uint32_t) index++, desc);
+            }
+        }
+    }
+
+    v8::Handle<v8::Object> result = v8::Object::New();
+    result->Set(v8::String::New("format"),    v8::Integer::New(c->format));
+    result->Set(v8::String::New("flags"),     v8::Integer::New(c->flags));
+    result->Set(v8::String::New("items"),     v8::Integer::NewFromUnsigned((uint32_t) c->items));
+    result->Set(v8::String::New("faces"),     v8::Integer::NewFromUnsigned((uint32_t) faces));
+    result->Set(v8::String::New("width"),     v8::Integer::NewFromUnsigned((uint32_t) c->width));
+    result->Set(v8::String::New("height"),    v8::Integer::NewFromUnsigned((uint32_t) c->height));
+    result->Set(v8::String::New("slices"),    v8::Integer::NewFromUnsigned((uint32_t) c->slices));
+    result->Set(v8::String::New("levelCount"),v8::Integer::NewFromUnsigned((uint32_t) c->levels));
+    result->Set(v8::String::New("imageSize"), v8::Number::New((double) c->image_size));
+    result->Set(v8::String::New("atlasSize"), v8::Number::New((double) c->atlas_size));
+    result->Set(v8::String::New("levels"),    levels);
+    if (c->atlas_size > 0)
+    {
+        result->Set(
+            v8::String::New("atlas"),
+            container_buffer_v8(view, c->atlas_data, c->atlas_size));
+    }
+
+    // release our reference; the buffers now keep the mapping alive.
+    container_view_release(NULL, view);
+    return scope.Close(result);
+}
+
+/*/////////////////////////////////////////////////////////////////////////80*/
+
+void init(v8::Handle<v8::Object> target)
+{
+    // publish our global functions:
     target->Set(
         v8::String::NewSymbol("compile"),
         v8::FunctionTemplate::New(Compile)->GetFunction());
+    target->Set(
+        v8::String::NewSymbol("compileAsync"),
+        v8::FunctionTemplate::New(CompileAsync)->GetFunction());
+    target->Set(
+        v8::String::NewSymbol("compileBatch"),
+        v8::FunctionTemplate::New(CompileBatch)->GetFunction());
+    target->Set(
+        v8::String::NewSymbol("cancel"),
+        v8::FunctionTemplate::New(Cancel)->GetFunction());
+    target->Set(
+        v8::String::NewSymbol("openContainer"),
+        v8::FunctionTemplate::New(OpenContainer)->GetFunction());
 }
 // @note: no semi-colon here intentionally.
 NODE_MODULE(texture_compiler, init)
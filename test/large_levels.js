@@ -0,0 +1,282 @@
+#!/usr/bin/env node
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Checks that aligned and reordered level offsets, including those
+/// of 4GB or more, survive the trip through the compiler, the output file
+/// and the level metadata. The source images are synthesized as tiny
+/// solid-color TGA files and scaled up with targetWidth and targetHeight, so
+/// no large image is needed on disk. The output files are written to the
+/// temporary directory and deleted. Set TEXC_LARGE_MEMORY_TESTS=1 to also run
+/// the tests with levels above 2^32, which write a file of over 4GB and need
+/// about 10GB of memory.
+///////////////////////////////////////////////////////////////////////////80*/
+var Assert     = require('assert');
+var Filesystem = require('fs');
+var Os         = require('os');
+var Path       = require('path');
+var Compiler   = require('../index');
+
+var FOUR_KB    = 4096;
+var FOUR_GB    = 4294967296;         // 2^32 bytes
+var TWO_GB     = 2147483648;         // 2^31 bytes
+var WRITE_SIZE = 64 * 1024 * 1024;   // OUTPUT_WRITE_SIZE in v8module.cpp
+var HEADER     = 64;                 // sizeof(image::header_t)
+var tempDir    = Os.tmpdir ? Os.tmpdir() : Os.tmpDir();
+
+/// Writes a 2x2 uncompressed TGA file with every pixel set to one color.
+/// @param path The path of the file to write.
+/// @param color An array of 1 (grayscale) or 4 (RGBA) byte values.
+function writeSolidTGA(path, color)
+{
+    var bpp    = color.length * 8;
+    var header = new Buffer(18);
+    var pixels = new Buffer(4 * color.length);
+    header.fill(0);
+    header[2]  = color.length === 1 ? 3 : 2; // grayscale : true-color
+    header.writeUInt16LE(2, 12);             // width
+    header.writeUInt16LE(2, 14);             // height
+    header[16] = bpp;
+    header[17] = color.length === 4 ? 0x28 : 0x20; // top-left, alpha bits
+    for (var i = 0; i < 4; ++i)
+    {
+        if (color.length === 4)
+        {
+            // TGA stores true-color pixels as BGRA.
+            pixels[i * 4 + 0] = color[2];
+            pixels[i * 4 + 1] = color[1];
+            pixels[i * 4 + 2] = color[0];
+            pixels[i * 4 + 3] = color[3];
+        }
+        else pixels[i] = color[0];
+    }
+    Filesystem.writeFileSync(path, Buffer.concat([header, pixels]));
+}
+
+/// Reads a range of bytes from a file at a (possibly 64-bit) position.
+function readAt(fd, position, length)
+{
+    var buffer = new Buffer(length);
+    var count  = Filesystem.readSync(fd, buffer, 0, length, position);
+    Assert.strictEqual(count, length, 'short read at '+position);
+    return buffer;
+}
+
+/// Checks that two RGBA8 pixels match within one step per channel. Scaling
+/// a solid color up and back down leaves a little rounding noise, which can
+/// move a value truncated to 8 bits onto the next lower step.
+function assertPixelNear(actual, expected, position)
+{
+    for (var i = 0; i < 4; ++i)
+    {
+        Assert.ok(Math.abs(actual[i] - expected[i]) <= 1, 'pixel mismatch at '+position+
+            ': '+actual.toString('hex')+' != '+expected.toString('hex'));
+    }
+}
+
+/// Deletes any files left behind by a test.
+function removeFiles(paths)
+{
+    paths.forEach(function (path)
+        {
+            try { Filesystem.unlinkSync(path); } catch (error) { /* empty */ }
+        });
+}
+
+/// Writes three small RGBA8 levels smallest-first, aligned to 4KB, and checks
+/// the level offsets, the zero-filled padding and the size of the file.
+function testSmallAlignedLevels()
+{
+    var source = Path.join(tempDir, 'texc_small_aligned.tga');
+    var target = Path.join(tempDir, 'texc_small_aligned.pixels');
+    var fd     = null;
+    writeSolidTGA(source, [0x10, 0x20, 0x30, 0xFF]);
+    try
+    {
+        var meta   = Compiler.compile({
+            sourcePath     : source,
+            targetPath     : target,
+            format         : 'RGBA8',
+            buildMipmaps   : true,
+            levelCount     : 3,
+            targetWidth    : 64,
+            targetHeight   : 32,
+            levelOrder     : 'SMALLEST_FIRST',
+            levelAlignment : FOUR_KB
+        });
+        var sizes  = [64 * 32 * 4, 32 * 16 * 4, 16 * 8 * 4];
+        var levels = meta.levels;
+        Assert.strictEqual(levels.length, 3);
+        Assert.strictEqual(levels[2].byteOffset, 0);
+        Assert.strictEqual(levels[1].byteOffset, FOUR_KB);
+        Assert.strictEqual(levels[0].byteOffset, FOUR_KB * 2);
+        for (var i = 0; i < 3; ++i)
+            Assert.strictEqual(levels[i].byteSize, sizes[i]);
+
+        var end    = levels[0].byteOffset + levels[0].byteSize;
+        Assert.strictEqual(meta.pixelsSize, end);
+        Assert.strictEqual(Filesystem.statSync(target).size, end);
+
+        // the padding after levels 2 and 1 is zero-filled, and the first and
+        // last pixel of each level hold the solid color.
+        fd = Filesystem.openSync(target, 'r');
+        var pixel = readAt(fd, 0, 4);
+        Assert.ok(pixel[3] !== 0, 'level 2 is empty');
+        for (var j = 0; j < 3; ++j)
+        {
+            var first = levels[j].byteOffset;
+            var last  = first + levels[j].byteSize - 4;
+            assertPixelNear(readAt(fd, first, 4), pixel, first);
+            assertPixelNear(readAt(fd, last,  4), pixel, last);
+        }
+        [[sizes[2], FOUR_KB], [FOUR_KB + sizes[1], FOUR_KB * 2]].forEach(function (gap)
+            {
+                var padding = readAt(fd, gap[0], gap[1] - gap[0]);
+                for (var k = 0; k < padding.length; ++k)
+                    Assert.strictEqual(padding[k], 0, 'padding at '+(gap[0] + k));
+            });
+    }
+    finally
+    {
+        if (fd !== null) Filesystem.closeSync(fd);
+        removeFiles([source, target, target+'.tmp']);
+    }
+}
+
+/// Writes three RGBA8 levels smallest-first, aligned to 2GB, so that level 1
+/// starts at 2^31 and level 0 at 2^32. Level 0 is 128MB, which takes two
+/// chunks of the chunked write path.
+function testAlignedLevels()
+{
+    var source = Path.join(tempDir, 'texc_large_aligned.tga');
+    var target = Path.join(tempDir, 'texc_large_aligned.pixels');
+    var fd     = null;
+    writeSolidTGA(source, [0x10, 0x20, 0x30, 0xFF]);
+    try
+    {
+        var meta   = Compiler.compile({
+            sourcePath     : source,
+            targetPath     : target,
+            format         : 'RGBA8',
+            buildMipmaps   : true,
+            levelCount     : 3,
+            targetWidth    : 8192,
+            targetHeight   : 4096,
+            levelOrder     : 'SMALLEST_FIRST',
+            levelAlignment : TWO_GB
+        });
+        var levels = meta.levels;
+        Assert.strictEqual(levels.length, 3);
+        Assert.strictEqual(levels[2].byteOffset, 0);
+        Assert.strictEqual(levels[1].byteOffset, TWO_GB);
+        Assert.strictEqual(levels[0].byteOffset, FOUR_GB);
+        Assert.strictEqual(levels[2].byteSize, 2048 * 1024 * 4);
+        Assert.strictEqual(levels[1].byteSize, 4096 * 2048 * 4);
+        Assert.strictEqual(levels[0].byteSize, 8192 * 4096 * 4);
+        Assert.ok(levels[0].byteSize > WRITE_SIZE);
+
+        var end    = levels[0].byteOffset + levels[0].byteSize;
+        Assert.strictEqual(meta.pixelsSize, end);
+        Assert.strictEqual(Filesystem.statSync(target).size, end);
+
+        // every level holds the same solid color. compare bytes past 2^32,
+        // on both sides of the first chunk boundary and at the very end,
+        // against the first pixel of the level written at offset 0.
+        fd = Filesystem.openSync(target, 'r');
+        var pixel = readAt(fd, 0, 4);
+        var spots = [
+            FOUR_GB,
+            FOUR_GB + WRITE_SIZE - 4,
+            FOUR_GB + WRITE_SIZE,
+            end - 4
+        ];
+        Assert.ok(pixel[3] !== 0, 'level 2 is empty');
+        spots.forEach(function (position)
+            {
+                assertPixelNear(readAt(fd, position, 4), pixel, position);
+            });
+        // the alignment padding before level 0 is zero-filled.
+        Assert.strictEqual(readAt(fd, FOUR_GB - 4, 4).readUInt32LE(0), 0);
+    }
+    finally
+    {
+        if (fd !== null) Filesystem.closeSync(fd);
+        removeFiles([source, target, target+'.tmp']);
+    }
+}
+
+/// Writes a 32768x32768 R32F container, whose level 0 is exactly 4GB, and
+/// reads it back with openContainer to check the header image_size and the
+/// level offsets above 2^32.
+function testLargeContainer()
+{
+    var source = Path.join(tempDir, 'texc_large_container.tga');
+    var target = Path.join(tempDir, 'texc_large_container.pixels');
+    var fd     = null;
+    writeSolidTGA(source, [0x80]);
+    try
+    {
+        var meta   = Compiler.compile({
+            sourcePath     : source,
+            targetPath     : target,
+            format         : 'R32F',
+            container      : true,
+            buildMipmaps   : true,
+            levelCount     : 3,
+            targetWidth    : 32768,
+            targetHeight   : 32768
+        });
+        var sizes  = [FOUR_GB, FOUR_GB / 4, FOUR_GB / 16];
+        var total  = sizes[0] + sizes[1] + sizes[2];
+        var levels = meta.levels;
+        Assert.strictEqual(levels[0].byteOffset, HEADER);
+        Assert.strictEqual(levels[1].byteOffset, HEADER + sizes[0]);
+        Assert.strictEqual(levels[2].byteOffset, HEADER + sizes[0] + sizes[1]);
+        for (var i = 0; i < 3; ++i)
+            Assert.strictEqual(levels[i].byteSize, sizes[i]);
+        Assert.strictEqual(meta.pixelsSize, HEADER + total);
+
+        var file = Compiler.openContainer(target);
+        Assert.strictEqual(file.imageSize,  total);
+        Assert.strictEqual(file.levelCount, 3);
+        for (var j = 0; j < 3; ++j)
+        {
+            Assert.strictEqual(file.levels[j].byteOffset, levels[j].byteOffset);
+            Assert.strictEqual(file.levels[j].byteSize,   levels[j].byteSize);
+        }
+        // levels over the node::Buffer limit have no data buffer.
+        Assert.ok(file.levels[0].data === undefined);
+        Assert.ok(file.levels[1].data === undefined);
+        Assert.strictEqual(file.levels[2].data.length, sizes[2]);
+
+        // the texel at the end of level 0 and the start of level 1 match
+        // the first texel of the mapped level 2. resampling a solid color
+        // leaves a little rounding noise, so compare within a tolerance.
+        fd = Filesystem.openSync(target, 'r');
+        var texel = file.levels[2].data.readFloatLE(0);
+        [HEADER + sizes[0] - 4, HEADER + sizes[0]].forEach(function (position)
+            {
+                var value = readAt(fd, position, 4).readFloatLE(0);
+                Assert.ok(Math.abs(value - texel) < 1e-5,
+                    'texel mismatch at '+position+': '+value+' != '+texel);
+            });
+    }
+    finally
+    {
+        if (fd !== null) Filesystem.closeSync(fd);
+        removeFiles([source, target, target+'.tmp']);
+    }
+}
+
+testSmallAlignedLevels();
+console.log('ok - smallest-first levels aligned to 4KB');
+if (process.env.TEXC_LARGE_MEMORY_TESTS === '1')
+{
+    testAlignedLevels();
+    console.log('ok - aligned levels at offsets of 2^31 and 2^32');
+    testLargeContainer();
+    console.log('ok - 4GB container level');
+}
+else
+{
+    console.log('skip - aligned levels at offsets of 2^31 and 2^32 (set TEXC_LARGE_MEMORY_TESTS=1)');
+    console.log('skip - 4GB container level (set TEXC_LARGE_MEMORY_TESTS=1)');
+}
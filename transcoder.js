@@ -0,0 +1,298 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implements a small runtime transcoder for the ETC1S intermediate
+/// format produced by the texture compiler (the `ETC1S`, `ETC1S_RGBA` and
+/// `UNIVERSAL` formats.) Each level is converted to a format supported by the
+/// GPU at load time, without access to the source pixels. This file has no
+/// dependencies and can be loaded in a browser or required from node.js.
+///////////////////////////////////////////////////////////////////////////80*/
+(function (exports)
+{
+    /// The intensity modifier tables for ETC1 color blocks, as [small, large].
+    var ETC_MODIFIERS = [
+        [  2,   8 ], [  5,  17 ], [  9,  29 ], [ 13,  42 ],
+        [ 18,  60 ], [ 24,  80 ], [ 33, 106 ], [ 47, 183 ]
+    ];
+
+    /// The ETC1 pixel indices in order of increasing intensity: -large,
+    /// -small, +small and +large.
+    var ETC_ORDER     = [3, 2, 0, 1];
+
+    /// The target formats that ETC1S data can be transcoded to, and the
+    /// number of bytes per 4x4 block of each.
+    var TARGET_BLOCK_SIZE = {
+        ETC1       : 8,
+        ETC1_ALPHA : 8,
+        BC1        : 8,
+        BC3        : 16
+    };
+
+    /// Clamps a value to the range [0, 255].
+    /// @param v The value to clamp.
+    /// @return The clamped value.
+    function clamp_255(v)
+    {
+        return (v < 0) ? 0 : ((v > 255) ? 255 : v);
+    }
+
+    /// Decodes the four palette colors and the per-pixel palette indices of an
+    /// ETC1S block. ETC1S blocks use differential mode with a zero delta and
+    /// the same modifier table in both halves.
+    /// @param src The source data.
+    /// @param offset The byte offset of the 8-byte block within @a src.
+    /// @param palette An array of four [r, g, b] arrays, indexed by ETC1 pixel
+    /// index, which is populated with the decoded colors.
+    /// @param index An array of 16 values, in row-major order, populated with
+    /// the ETC1 pixel index of each texel.
+    function decode_etc1s(src, offset, palette, index)
+    {
+        var table = ETC_MODIFIERS[src[offset + 3] >> 5];
+        var msb   = (src[offset + 4] << 8) | src[offset + 5];
+        var lsb   = (src[offset + 6] << 8) | src[offset + 7];
+        var base  = [0, 0, 0];
+        for (var c = 0; c < 3; ++c)
+        {
+            var q   = src[offset + c] >> 3;
+            base[c] = (q << 3) | (q >> 2);
+        }
+        for (var m = 0; m < 4; ++m)
+        {
+            var mod = table[m & 1] * ((m & 2) ? -1 : 1);
+            palette[m][0] = clamp_255(base[0] + mod);
+            palette[m][1] = clamp_255(base[1] + mod);
+            palette[m][2] = clamp_255(base[2] + mod);
+        }
+        // ETC1 numbers pixels down the columns; BCn numbers them across rows.
+        for (var y = 0; y < 4; ++y)
+        {
+            for (var x = 0; x < 4; ++x)
+            {
+                var k = x * 4 + y;
+                index[y * 4 + x] = (((msb >> k) & 1) << 1) | ((lsb >> k) & 1);
+            }
+        }
+    }
+
+    /// Finds the darkest and brightest palette entries used by a block.
+    /// @param index The per-texel ETC1 pixel indices.
+    /// @return An array [darkest, brightest] of ETC1 pixel indices.
+    function used_range(index)
+    {
+        var used = 0;
+        for (var i = 0; i < 16; ++i) used |= 1 << index[i];
+        var lo = 1, hi = 1;
+        for (var o = 0; o < 4; ++o)
+        {
+            if (used & (1 << ETC_ORDER[o])) { lo = ETC_ORDER[o]; break; }
+        }
+        for (var o = 3; o >= 0; --o)
+        {
+            if (used & (1 << ETC_ORDER[o])) { hi = ETC_ORDER[o]; break; }
+        }
+        return [lo, hi];
+    }
+
+    /// Quantizes an RGB color to RGB565.
+    function pack_565(c)
+    {
+        var r = Math.floor(c[0] * 31 / 255 + 0.5);
+        var g = Math.floor(c[1] * 63 / 255 + 0.5);
+        var b = Math.floor(c[2] * 31 / 255 + 0.5);
+        return (r << 11) | (g << 5) | b;
+    }
+
+    /// Expands an RGB565 color to 8 bits per channel.
+    function unpack_565(v)
+    {
+        var r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+        return [(r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2)];
+    }
+
+    /// Converts an ETC1S color block to a BC1 color block. The endpoints are
+    /// the darkest and brightest palette entries used by the block, and each
+    /// ETC1 palette entry is mapped to the nearest BC1 palette entry.
+    /// @param src The source data.
+    /// @param src_offset The byte offset of the ETC1S color block.
+    /// @param dst The destination buffer.
+    /// @param dst_offset The byte offset of the 8-byte BC1 block.
+    function etc1s_to_bc1(src, src_offset, dst, dst_offset)
+    {
+        var palette = [[0, 0, 0], [0, 0, 0], [0, 0, 0], [0, 0, 0]];
+        var index   = new Array(16);
+        decode_etc1s(src, src_offset, palette, index);
+
+        var range   = used_range(index);
+        var c0      = pack_565(palette[range[1]]);
+        var c1      = pack_565(palette[range[0]]);
+        var map     = [0, 0, 0, 0];
+        if (c0 !== c1)
+        {
+            // the brightest color packs to the larger value, which selects
+            // the four-color mode.
+            var e0  = unpack_565(c0);
+            var e1  = unpack_565(c1);
+            var bc  = [e0, e1, [0, 0, 0], [0, 0, 0]];
+            for (var c = 0; c < 3; ++c)
+            {
+                bc[2][c] = Math.floor((2 * e0[c] + e1[c]) / 3);
+                bc[3][c] = Math.floor((e0[c] + 2 * e1[c]) / 3);
+            }
+            for (var m = 0; m < 4; ++m)
+            {
+                var best = Infinity;
+                for (var k = 0; k < 4; ++k)
+                {
+                    var dr = palette[m][0] - bc[k][0];
+                    var dg = palette[m][1] - bc[k][1];
+                    var db = palette[m][2] - bc[k][2];
+                    var d  = dr * dr + dg * dg + db * db;
+                    if (d < best) { best = d; map[m] = k; }
+                }
+            }
+        }
+        var bits = 0;
+        for (var i = 15; i >= 0; --i)
+        {
+            bits = (bits * 4) + map[index[i]];
+        }
+        dst[dst_offset + 0] = c0 & 0xFF;
+        dst[dst_offset + 1] = c0 >> 8;
+        dst[dst_offset + 2] = c1 & 0xFF;
+        dst[dst_offset + 3] = c1 >> 8;
+        for (var b = 0; b < 4; ++b)
+        {
+            dst[dst_offset + 4 + b] = bits & 0xFF;
+            bits = Math.floor(bits / 256);
+        }
+    }
+
+    /// Converts an ETC1S alpha block to a BC3 interpolated alpha block. The
+    /// alpha value of each palette entry is the average of its RGB values.
+    /// @param src The source data.
+    /// @param src_offset The byte offset of the ETC1S alpha block.
+    /// @param dst The destination buffer.
+    /// @param dst_offset The byte offset of the 8-byte BC3 alpha block.
+    function etc1s_to_bc3_alpha(src, src_offset, dst, dst_offset)
+    {
+        var palette = [[0, 0, 0], [0, 0, 0], [0, 0, 0], [0, 0, 0]];
+        var index   = new Array(16);
+        var alpha   = [0, 0, 0, 0];
+        decode_etc1s(src, src_offset, palette, index);
+        for (var m = 0; m < 4; ++m)
+        {
+            var p    = palette[m];
+            alpha[m] = Math.floor((p[0] + p[1] + p[2] + 1) / 3);
+        }
+
+        var range = used_range(index);
+        var a0    = alpha[range[1]];
+        var a1    = alpha[range[0]];
+        var map   = [0, 0, 0, 0];
+        if (a0 > a1)
+        {
+            // eight-value mode: a0, a1 and six interpolated values.
+            var values = [a0, a1];
+            for (var k = 2; k < 8; ++k)
+            {
+                values[k] = Math.floor(((8 - k) * a0 + (k - 1) * a1) / 7);
+            }
+            for (var m = 0; m < 4; ++m)
+            {
+                var best = Infinity;
+                for (var k = 0; k < 8; ++k)
+                {
+                    var d = Math.abs(alpha[m] - values[k]);
+                    if (d < best) { best = d; map[m] = k; }
+                }
+            }
+        }
+        dst[dst_offset + 0] = a0;
+        dst[dst_offset + 1] = a1;
+        // 16 3-bit indices, packed little-endian in two 24-bit groups.
+        for (var g = 0; g < 2; ++g)
+        {
+            var bits = 0;
+            for (var i = 7; i >= 0; --i)
+            {
+                bits = (bits << 3) | map[index[g * 8 + i]];
+            }
+            dst[dst_offset + 2 + g * 3] = bits & 0xFF;
+            dst[dst_offset + 3 + g * 3] = (bits >> 8) & 0xFF;
+            dst[dst_offset + 4 + g * 3] = (bits >> 16) & 0xFF;
+        }
+    }
+
+    /// Determines whether ETC1S data can be transcoded to a given format.
+    /// @param target_format The name of the target format.
+    /// @return true if @a target_format is supported.
+    function supported(target_format)
+    {
+        return TARGET_BLOCK_SIZE.hasOwnProperty(target_format);
+    }
+
+    /// Transcodes one level of ETC1S data to a GPU block-compressed format.
+    /// @param data A Uint8Array (or node.js Buffer) containing the level data,
+    /// as described by the `byteOffset` and `byteSize` level metadata.
+    /// @param source_format The level format, either 'ETC1S' or 'ETC1S_RGBA'.
+    /// @param target_format One of 'ETC1', 'ETC1_ALPHA', 'BC1' or 'BC3'.
+    /// 'ETC1' returns the color blocks as-is, and 'ETC1_ALPHA' returns the
+    /// alpha blocks as an ETC1 texture, for use as a separate alpha texture.
+    /// @param width The width of the level, in pixels.
+    /// @param height The height of the level, in pixels.
+    /// @return A Uint8Array containing the transcoded level data.
+    function transcode(data, source_format, target_format, width, height)
+    {
+        var has_alpha  = (source_format === 'ETC1S_RGBA');
+        var src_stride = has_alpha ? 16 : 8;
+        var color      = has_alpha ?  8 : 0;
+        var blocks     = Math.ceil(width / 4) * Math.ceil(height / 4);
+        if (source_format !== 'ETC1S' && source_format !== 'ETC1S_RGBA')
+        {
+            throw new Error('Unsupported source format `'+source_format+'`.');
+        }
+        if (!supported(target_format))
+        {
+            throw new Error('Unsupported target format `'+target_format+'`.');
+        }
+        if (target_format === 'ETC1_ALPHA' && !has_alpha)
+        {
+            throw new Error('Source format `'+source_format+'` has no alpha.');
+        }
+
+        var dst_stride = TARGET_BLOCK_SIZE[target_format];
+        var dst        = new Uint8Array(blocks * dst_stride);
+        for (var i = 0; i < blocks; ++i)
+        {
+            var s = i * src_stride;
+            var d = i * dst_stride;
+            switch (target_format)
+            {
+                case 'ETC1':
+                    for (var b = 0; b < 8; ++b) dst[d + b] = data[s + color + b];
+                    break;
+                case 'ETC1_ALPHA':
+                    for (var b = 0; b < 8; ++b) dst[d + b] = data[s + b];
+                    break;
+                case 'BC1':
+                    etc1s_to_bc1(data, s + color, dst, d);
+                    break;
+                case 'BC3':
+                    if (has_alpha)
+                    {
+                        etc1s_to_bc3_alpha(data, s, dst, d);
+                    }
+                    else
+                    {
+                        // opaque: a0 = 255 with all indices selecting a0.
+                        dst[d] = 255;
+                        for (var b = 1; b < 8; ++b) dst[d + b] = 0;
+                    }
+                    etc1s_to_bc1(data, s + color, dst, d + 8);
+                    break;
+            }
+        }
+        return dst;
+    }
+
+    exports.supported = supported;
+    exports.transcode = transcode;
+})(typeof exports !== 'undefined' ? exports : (this.ETC1STranscoder = {}));